@@ -24,7 +24,7 @@ int main(void) {
 #else
   stdout_handle = 1;
 #endif
-  clogging_binary_init("binary_utf8_demo", "", LOG_LEVEL_INFO, stdout_handle);
+  clogging_binary_init("binary_utf8_demo", "", LOG_LEVEL_INFO, stdout_handle, NULL);
 
   /* Log ASCII text */
   LOG_INFO("Hello World!");
@@ -21,35 +21,19 @@
  * format. That is its possible that the user did not provide any
  * variable arguments and the format is the entier message.
  */
-#define LOG_ERROR(format, ...)                                           \
-  clogging_fd_logmsg(__func__, __LINE__, LOG_LEVEL_ERROR, format,     \
-                        ##__VA_ARGS__)
-#define LOG_WARN(format, ...)                                            \
-  clogging_fd_logmsg(__func__, __LINE__, LOG_LEVEL_WARN, format,      \
-                        ##__VA_ARGS__)
-#define LOG_INFO(format, ...)                                            \
-  clogging_fd_logmsg(__func__, __LINE__, LOG_LEVEL_INFO, format,      \
-                        ##__VA_ARGS__)
+#define LOG_ERROR(format, ...) FD_LOG_ERROR(format, ##__VA_ARGS__)
+#define LOG_WARN(format, ...) FD_LOG_WARN(format, ##__VA_ARGS__)
+#define LOG_INFO(format, ...) FD_LOG_INFO(format, ##__VA_ARGS__)
 
                         
-/* If DISABLE_DEBUG_LOGS is defined then the DEBUG logs are compiled out
- * and cannot be switched on dynamically. This is done to ensure that
- * production system have DEBUG logs compiled out and save critical
- * cycles which otherwise would be wasted in function call to basic_logmsg()
- * and then returning when log level is below DEBUG.
+/* Messages less severe than CLOGGING_MIN_LEVEL (see logging_common.h)
+ * are compiled out and cannot be switched on dynamically. This is done
+ * to ensure that production systems save the critical cycles otherwise
+ * spent checking the log level. Defining DISABLE_DEBUG_LOGS compiles out
+ * the DEBUG logs. If you want dynamicity then use INFO instead and set
+ * the log level to WARN, which can be changed to INFO dynamically anytime.
  */
-#ifndef DISABLE_DEBUG_LOGS
-#define LOG_DEBUG(format, ...)                                           \
-  clogging_fd_logmsg(__func__, __LINE__, LOG_LEVEL_DEBUG, format,     \
-                        ##__VA_ARGS__)
-#else
-/* If not verbose then dont even compile the DEBUG logs, which are typically
- * cpu intensive function calls in the critical path.
- * If you want dynamicity then use INFO instead and set the log level to
- * WARN, which can be changed to INFO dynamically anytime.
- */
-#define LOG_DEBUG(format, ...)
-#endif
+#define LOG_DEBUG(format, ...) FD_LOG_DEBUG(format, ##__VA_ARGS__)
 
 
 #endif /* CLOGGING_LOGGING_H */
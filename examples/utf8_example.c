@@ -19,18 +19,10 @@
  * format. That is its possible that the user did not provide any
  * variable arguments and the format is the entier message.
  */
-#define LOG_ERROR(format, ...)                                           \
-  clogging_basic_logmsg(__func__, __LINE__, LOG_LEVEL_ERROR, format,     \
-                        ##__VA_ARGS__)
-#define LOG_WARN(format, ...)                                            \
-  clogging_basic_logmsg(__func__, __LINE__, LOG_LEVEL_WARN, format,      \
-                        ##__VA_ARGS__)
-#define LOG_INFO(format, ...)                                            \
-  clogging_basic_logmsg(__func__, __LINE__, LOG_LEVEL_INFO, format,      \
-                        ##__VA_ARGS__)
-#define LOG_DEBUG(format, ...)                                           \
-  clogging_basic_logmsg(__func__, __LINE__, LOG_LEVEL_DEBUG, format,     \
-                        ##__VA_ARGS__)
+#define LOG_ERROR(format, ...) BASIC_LOG_ERROR(format, ##__VA_ARGS__)
+#define LOG_WARN(format, ...) BASIC_LOG_WARN(format, ##__VA_ARGS__)
+#define LOG_INFO(format, ...) BASIC_LOG_INFO(format, ##__VA_ARGS__)
+#define LOG_DEBUG(format, ...) BASIC_LOG_DEBUG(format, ##__VA_ARGS__)
 
 int main(void) {
   printf("UTF-8 Logging Example\n");
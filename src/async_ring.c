@@ -0,0 +1,614 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "async_ring.h"
+
+#include <stdatomic.h> /* atomic_load_explicit() and friends */
+#include <stdlib.h>    /* malloc(), free(), atexit() */
+#include <string.h>    /* memcpy() */
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>  /* CreateThread(), SRWLOCK, CONDITION_VARIABLE */
+#else
+#include <pthread.h>  /* pthread_create() and friends */
+#include <time.h>     /* clock_gettime(), nanosleep() */
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Every record starts with a header holding its length, the header
+ * and the record are padded so that the next header is 8 byte aligned.
+ * A header with ASYNC_PAD_MARKER means skip to the start of
+ * the ring because the next record did not fit at the end.
+ */
+#define ASYNC_HEADER_BYTES 8
+#define ASYNC_PAD_MARKER UINT32_MAX
+#define ASYNC_RECORD_BYTES(len)                                              \
+  ((((len) + ASYNC_HEADER_BYTES) + 7) & ~((size_t)7))
+
+/* keep producer and consumer owned fields on separate cache lines */
+#define ASYNC_CACHE_LINE 64
+
+/* how long the writer sleeps when there is nothing to do and when
+ * some consumer asked to be retried (say EAGAIN on a non-blocking fd).
+ */
+#define ASYNC_IDLE_WAIT_MS 100
+#define ASYNC_RETRY_WAIT_MS 5
+
+struct clogging_async_ring {
+  /* producer owned */
+  atomic_size_t head;
+  size_t reserve_head;
+  atomic_int in_flight; /* between reserve and commit, see shutdown */
+  char pad_producer[ASYNC_CACHE_LINE];
+
+  /* consumer owned */
+  atomic_size_t tail;
+  size_t offset; /* bytes of the record at tail already consumed */
+  char pad_consumer[ASYNC_CACHE_LINE];
+
+  size_t capacity;
+  size_t mask;
+  char *data;
+  void *ctx;
+  clogging_async_consume_fn fn;
+  atomic_uint_fast64_t drops;
+  atomic_uint_fast64_t truncations;
+  atomic_int released; /* owning thread is gone */
+  atomic_int orphaned; /* inherited across fork(), never drained */
+  clogging_async_ring_t **owner; /* cleared when the thread exits */
+
+  struct clogging_async_ring *next;        /* process wide registry */
+  struct clogging_async_ring *thread_next; /* rings of the owning thread */
+};
+
+enum async_state {
+  ASYNC_NOT_STARTED = 0,
+  ASYNC_RUNNING,
+  ASYNC_STOPPED
+};
+
+static _Atomic(clogging_async_ring_t *) g_async_rings = NULL;
+static atomic_int g_async_state = ASYNC_NOT_STARTED;
+static atomic_int g_async_stop_requested = 0;
+static atomic_int g_async_writer_sleeping = 0;
+static int g_async_atexit_registered = 0;
+
+#ifdef _WIN32
+static SRWLOCK g_async_lock = SRWLOCK_INIT;
+static CONDITION_VARIABLE g_async_cond = CONDITION_VARIABLE_INIT;
+static HANDLE g_async_thread = NULL;
+static INIT_ONCE g_async_key_once = INIT_ONCE_STATIC_INIT;
+static DWORD g_async_thread_key = FLS_OUT_OF_INDEXES;
+
+#define ASYNC_LOCK() AcquireSRWLockExclusive(&g_async_lock)
+#define ASYNC_UNLOCK() ReleaseSRWLockExclusive(&g_async_lock)
+#define ASYNC_SIGNAL() WakeConditionVariable(&g_async_cond)
+#else
+static pthread_mutex_t g_async_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_async_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t g_async_thread;
+static pthread_once_t g_async_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_async_thread_key;
+
+#define ASYNC_LOCK() pthread_mutex_lock(&g_async_lock)
+#define ASYNC_UNLOCK() pthread_mutex_unlock(&g_async_lock)
+#define ASYNC_SIGNAL() pthread_cond_signal(&g_async_cond)
+#endif
+
+/* must be called with g_async_lock held */
+static void async_wait_locked(int timeout_ms) {
+#ifdef _WIN32
+  SleepConditionVariableSRW(&g_async_cond, &g_async_lock, (DWORD)timeout_ms,
+                            0);
+#else
+  struct timespec deadline;
+
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec += 1;
+    deadline.tv_nsec -= 1000000000L;
+  }
+  pthread_cond_timedwait(&g_async_cond, &g_async_lock, &deadline);
+#endif
+}
+
+static void async_sleep_ms(int ms) {
+#ifdef _WIN32
+  Sleep((DWORD)ms);
+#else
+  struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000L};
+  nanosleep(&ts, NULL);
+#endif
+}
+
+static void async_wake_writer(void) {
+  if (atomic_load(&g_async_writer_sleeping)) {
+    ASYNC_LOCK();
+    ASYNC_SIGNAL();
+    ASYNC_UNLOCK();
+  }
+}
+
+static int async_ring_is_empty(clogging_async_ring_t *ring) {
+  return atomic_load_explicit(&ring->tail, memory_order_acquire) ==
+         atomic_load_explicit(&ring->head, memory_order_acquire);
+}
+
+/* Consume as many records from the ring as possible.
+ * *blocked is set when the consumer asked to be called again later.
+ */
+static size_t async_ring_drain(clogging_async_ring_t *ring, int *blocked) {
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  size_t done = 0;
+  size_t pos = 0;
+  uint32_t len = 0;
+
+  while (tail != head) {
+    pos = tail & ring->mask;
+    memcpy(&len, &ring->data[pos], sizeof(len));
+    if (len == ASYNC_PAD_MARKER) {
+      tail += ring->capacity - pos;
+      continue;
+    }
+    if (ring->fn(ring, ring->ctx, &ring->data[pos + ASYNC_HEADER_BYTES], len,
+                 &ring->offset) != 0) {
+      *blocked = 1;
+      break;
+    }
+    ring->offset = 0;
+    tail += ASYNC_RECORD_BYTES(len);
+    ++done;
+    /* hand the space back to the producer as soon as possible */
+    atomic_store_explicit(&ring->tail, tail, memory_order_release);
+  }
+  atomic_store_explicit(&ring->tail, tail, memory_order_release);
+  return done;
+}
+
+static void async_ring_unlink(clogging_async_ring_t *ring) {
+  clogging_async_ring_t *prev = NULL;
+  clogging_async_ring_t *cur = NULL;
+
+  ASYNC_LOCK();
+  cur = atomic_load(&g_async_rings);
+  while (cur != NULL && cur != ring) {
+    prev = cur;
+    cur = cur->next;
+  }
+  if (cur != NULL) {
+    if (prev == NULL) {
+      atomic_store(&g_async_rings, ring->next);
+    } else {
+      prev->next = ring->next;
+    }
+  }
+  ASYNC_UNLOCK();
+}
+
+/* Only the writer thread (or clogging_async_shutdown() once the writer
+ * is joined) walks the registry while draining, so rings can be freed
+ * here without any further synchronization. Registration only ever
+ * pushes at the head of the list.
+ */
+static size_t async_drain_all(int *blocked) {
+  clogging_async_ring_t *ring = atomic_load(&g_async_rings);
+  clogging_async_ring_t *next = NULL;
+  size_t done = 0;
+
+  while (ring != NULL) {
+    next = ring->next;
+    done += async_ring_drain(ring, blocked);
+    if (atomic_load(&ring->released) && async_ring_is_empty(ring)) {
+      async_ring_unlink(ring);
+      free(ring);
+    }
+    ring = next;
+  }
+  return done;
+}
+
+static int async_any_pending(void) {
+  clogging_async_ring_t *ring = atomic_load(&g_async_rings);
+
+  while (ring != NULL) {
+    if (!async_ring_is_empty(ring)) {
+      return 1;
+    }
+    ring = ring->next;
+  }
+  return 0;
+}
+
+static void async_writer_loop(void) {
+  size_t done = 0;
+  int blocked = 0;
+  int stop = 0;
+
+  for (;;) {
+    stop = atomic_load(&g_async_stop_requested);
+    blocked = 0;
+    done = async_drain_all(&blocked);
+    if (done > 0) {
+      continue;
+    }
+    if (stop) {
+      /* everything published before the stop request is written */
+      break;
+    }
+    ASYNC_LOCK();
+    atomic_store(&g_async_writer_sleeping, 1);
+    if (blocked) {
+      async_wait_locked(ASYNC_RETRY_WAIT_MS);
+    } else if (!async_any_pending() &&
+               !atomic_load(&g_async_stop_requested)) {
+      async_wait_locked(ASYNC_IDLE_WAIT_MS);
+    }
+    atomic_store(&g_async_writer_sleeping, 0);
+    ASYNC_UNLOCK();
+  }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI async_writer_main(LPVOID arg) {
+  (void)arg;
+  async_writer_loop();
+  return 0;
+}
+
+static void CALLBACK async_thread_exit(PVOID value) {
+  clogging_async_ring_t *ring = (clogging_async_ring_t *)value;
+  clogging_async_ring_t *next = NULL;
+
+  while (ring != NULL) {
+    /* the writer may free the ring as soon as it is released, so the
+     * thread has to forget about it first, in case it logs again from a
+     * later destructor (which is then written inline)
+     */
+    next = ring->thread_next;
+    if (ring->owner != NULL) {
+      *ring->owner = NULL;
+    }
+    atomic_store(&ring->released, 1);
+    ring = next;
+  }
+}
+
+static BOOL CALLBACK async_key_init(PINIT_ONCE once, PVOID param,
+                                    PVOID *context) {
+  (void)once;
+  (void)param;
+  (void)context;
+  g_async_thread_key = FlsAlloc(async_thread_exit);
+  return TRUE;
+}
+#else
+static void *async_writer_main(void *arg) {
+  (void)arg;
+  async_writer_loop();
+  return NULL;
+}
+
+static void async_thread_exit(void *value) {
+  clogging_async_ring_t *ring = (clogging_async_ring_t *)value;
+  clogging_async_ring_t *next = NULL;
+
+  while (ring != NULL) {
+    /* the writer may free the ring as soon as it is released, so the
+     * thread has to forget about it first, in case it logs again from a
+     * later destructor (which is then written inline)
+     */
+    next = ring->thread_next;
+    if (ring->owner != NULL) {
+      *ring->owner = NULL;
+    }
+    atomic_store(&ring->released, 1);
+    ring = next;
+  }
+}
+
+/* The writer thread does not exist in the child after fork(), and the
+ * rings inherited from the parent still hold records the parent is
+ * going to write. So forget about them and let the child start afresh.
+ */
+static void async_atfork_child(void) {
+  clogging_async_ring_t *ring = atomic_load(&g_async_rings);
+
+  while (ring != NULL) {
+    atomic_store(&ring->orphaned, 1);
+    ring = ring->next;
+  }
+  atomic_store(&g_async_rings, NULL);
+  pthread_mutex_init(&g_async_lock, NULL);
+  pthread_cond_init(&g_async_cond, NULL);
+  atomic_store(&g_async_writer_sleeping, 0);
+  atomic_store(&g_async_stop_requested, 0);
+  atomic_store(&g_async_state, ASYNC_NOT_STARTED);
+}
+
+static void async_key_init(void) {
+  pthread_key_create(&g_async_thread_key, async_thread_exit);
+  pthread_atfork(NULL, NULL, async_atfork_child);
+}
+#endif
+
+/* must be called with g_async_lock held */
+static int async_start_writer_locked(void) {
+  if (atomic_load(&g_async_state) == ASYNC_RUNNING) {
+    return 0;
+  }
+  atomic_store(&g_async_stop_requested, 0);
+#ifdef _WIN32
+  g_async_thread = CreateThread(NULL, 0, async_writer_main, NULL, 0, NULL);
+  if (g_async_thread == NULL) {
+    return -1;
+  }
+#else
+  if (pthread_create(&g_async_thread, NULL, async_writer_main, NULL) != 0) {
+    return -1;
+  }
+#endif
+  atomic_store(&g_async_state, ASYNC_RUNNING);
+  if (!g_async_atexit_registered) {
+    g_async_atexit_registered = 1;
+    atexit(clogging_async_shutdown);
+  }
+  return 0;
+}
+
+clogging_async_ring_t *
+clogging_async_ring_create(size_t capacity, clogging_async_consume_fn fn,
+                           const void *ctx, size_t ctx_len,
+                           clogging_async_ring_t **owner) {
+  clogging_async_ring_t *ring = NULL;
+  size_t ring_bytes = 64;
+  size_t ctx_bytes = (ctx_len + 7) & ~((size_t)7);
+
+  /* round up to a power of 2 so that positions can be masked */
+  while (ring_bytes < capacity) {
+    ring_bytes <<= 1;
+  }
+
+  ring = (clogging_async_ring_t *)malloc(sizeof(*ring) + ctx_bytes +
+                                         ring_bytes);
+  if (ring == NULL) {
+    return NULL;
+  }
+  atomic_init(&ring->head, 0);
+  ring->reserve_head = 0;
+  atomic_init(&ring->in_flight, 0);
+  atomic_init(&ring->tail, 0);
+  ring->offset = 0;
+  ring->capacity = ring_bytes;
+  ring->mask = ring_bytes - 1;
+  ring->ctx = (char *)(ring + 1);
+  ring->data = (char *)(ring + 1) + ctx_bytes;
+  ring->fn = fn;
+  atomic_init(&ring->drops, 0);
+  atomic_init(&ring->truncations, 0);
+  atomic_init(&ring->released, 0);
+  atomic_init(&ring->orphaned, 0);
+  ring->owner = owner;
+  ring->thread_next = NULL;
+  if (ctx_len > 0) {
+    memcpy(ring->ctx, ctx, ctx_len);
+  }
+
+#ifdef _WIN32
+  InitOnceExecuteOnce(&g_async_key_once, async_key_init, NULL, NULL);
+  if (g_async_thread_key != FLS_OUT_OF_INDEXES) {
+    ring->thread_next = (clogging_async_ring_t *)FlsGetValue(g_async_thread_key);
+    FlsSetValue(g_async_thread_key, ring);
+  }
+#else
+  pthread_once(&g_async_key_once, async_key_init);
+  ring->thread_next =
+      (clogging_async_ring_t *)pthread_getspecific(g_async_thread_key);
+  pthread_setspecific(g_async_thread_key, ring);
+#endif
+
+  ASYNC_LOCK();
+  ring->next = atomic_load(&g_async_rings);
+  atomic_store(&g_async_rings, ring);
+  if (async_start_writer_locked() < 0) {
+    /* records are written inline by the caller in this case */
+    atomic_store(&g_async_state, ASYNC_STOPPED);
+  }
+  ASYNC_UNLOCK();
+
+  return ring;
+}
+
+void *clogging_async_ring_ctx(clogging_async_ring_t *ring) {
+  return ring->ctx;
+}
+
+char *clogging_async_ring_reserve(clogging_async_ring_t *ring, size_t len,
+                                  int *status) {
+  size_t need = ASYNC_RECORD_BYTES(len);
+  size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  size_t tail = 0;
+  size_t pos = 0;
+  size_t pad = 0;
+  uint32_t marker = ASYNC_PAD_MARKER;
+
+  /* either clogging_async_shutdown() waits for the commit of this
+   * record, or this sees that the writer is stopping
+   */
+  atomic_store(&ring->in_flight, 1);
+  if (atomic_load(&g_async_state) != ASYNC_RUNNING ||
+      atomic_load_explicit(&ring->orphaned, memory_order_relaxed)) {
+    atomic_store_explicit(&ring->in_flight, 0, memory_order_release);
+    *status = CLOGGING_ASYNC_STOPPED;
+    return NULL;
+  }
+  /* a record must fit even after skipping the end of the ring */
+  if (need > ring->capacity / 2 || len >= ASYNC_PAD_MARKER) {
+    atomic_store_explicit(&ring->in_flight, 0, memory_order_release);
+    *status = CLOGGING_ASYNC_FULL;
+    return NULL;
+  }
+
+  tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  pos = head & ring->mask;
+  if (pos + need > ring->capacity) {
+    pad = ring->capacity - pos;
+  }
+  if (head + pad + need - tail > ring->capacity) {
+    atomic_store_explicit(&ring->in_flight, 0, memory_order_release);
+    *status = CLOGGING_ASYNC_FULL;
+    return NULL;
+  }
+  if (pad > 0) {
+    /* published along with the record in clogging_async_ring_commit() */
+    memcpy(&ring->data[pos], &marker, sizeof(marker));
+    head += pad;
+    pos = 0;
+  }
+  ring->reserve_head = head;
+  *status = CLOGGING_ASYNC_OK;
+  return &ring->data[pos + ASYNC_HEADER_BYTES];
+}
+
+void clogging_async_ring_commit(clogging_async_ring_t *ring, size_t len) {
+  size_t pos = ring->reserve_head & ring->mask;
+  uint32_t len32 = (uint32_t)len;
+
+  memcpy(&ring->data[pos], &len32, sizeof(len32));
+  atomic_store_explicit(&ring->head,
+                        ring->reserve_head + ASYNC_RECORD_BYTES(len),
+                        memory_order_release);
+  atomic_store_explicit(&ring->in_flight, 0, memory_order_release);
+  /* pairs with the writer publishing g_async_writer_sleeping before it
+   * looks at the rings one last time.
+   */
+  atomic_thread_fence(memory_order_seq_cst);
+  async_wake_writer();
+}
+
+void clogging_async_ring_abandon(clogging_async_ring_t *ring) {
+  atomic_store_explicit(&ring->in_flight, 0, memory_order_release);
+}
+
+int clogging_async_ring_push(clogging_async_ring_t *ring, const void *rec,
+                             size_t len) {
+  int status = CLOGGING_ASYNC_OK;
+  char *dst = clogging_async_ring_reserve(ring, len, &status);
+
+  if (dst == NULL) {
+    return status;
+  }
+  memcpy(dst, rec, len);
+  clogging_async_ring_commit(ring, len);
+  return CLOGGING_ASYNC_OK;
+}
+
+void clogging_async_ring_add_drops(clogging_async_ring_t *ring,
+                                   uint64_t count) {
+  atomic_fetch_add_explicit(&ring->drops, count, memory_order_relaxed);
+}
+
+uint64_t clogging_async_ring_get_drops(clogging_async_ring_t *ring) {
+  return (uint64_t)atomic_load_explicit(&ring->drops, memory_order_relaxed);
+}
+
+void clogging_async_ring_add_truncations(clogging_async_ring_t *ring,
+                                         uint64_t count) {
+  atomic_fetch_add_explicit(&ring->truncations, count, memory_order_relaxed);
+}
+
+uint64_t clogging_async_ring_get_truncations(clogging_async_ring_t *ring) {
+  return (uint64_t)atomic_load_explicit(&ring->truncations,
+                                        memory_order_relaxed);
+}
+
+int clogging_async_ring_flush(clogging_async_ring_t *ring, int timeout_ms) {
+  int waited_ms = 0;
+
+  while (!async_ring_is_empty(ring)) {
+    if (atomic_load(&g_async_state) != ASYNC_RUNNING) {
+      return -1;
+    }
+    if (timeout_ms >= 0 && waited_ms >= timeout_ms) {
+      return -1;
+    }
+    ASYNC_LOCK();
+    ASYNC_SIGNAL();
+    ASYNC_UNLOCK();
+    async_sleep_ms(1);
+    ++waited_ms;
+  }
+  return 0;
+}
+
+/* Only called once the writer is joined, see async_drain_all(). */
+static void async_wait_in_flight(void) {
+  clogging_async_ring_t *ring = atomic_load(&g_async_rings);
+
+  while (ring != NULL) {
+    while (atomic_load(&ring->in_flight)) {
+      async_sleep_ms(1);
+    }
+    ring = ring->next;
+  }
+}
+
+void clogging_async_shutdown(void) {
+  clogging_async_ring_t *ring = NULL;
+  clogging_async_ring_t *next = NULL;
+  int blocked = 0;
+
+  ASYNC_LOCK();
+  if (atomic_load(&g_async_state) != ASYNC_RUNNING) {
+    ASYNC_UNLOCK();
+    return;
+  }
+  /* new records are written inline from now on */
+  atomic_store(&g_async_state, ASYNC_STOPPED);
+  atomic_store(&g_async_stop_requested, 1);
+  ASYNC_SIGNAL();
+  ASYNC_UNLOCK();
+
+#ifdef _WIN32
+  WaitForSingleObject(g_async_thread, INFINITE);
+  CloseHandle(g_async_thread);
+  g_async_thread = NULL;
+#else
+  pthread_join(g_async_thread, NULL);
+#endif
+
+  /* wait for the records reserved before the writer was stopped, then
+   * pick up whatever was committed while the writer was on its way out
+   */
+  async_wait_in_flight();
+  (void)async_drain_all(&blocked);
+
+  ring = atomic_load(&g_async_rings);
+  while (ring != NULL) {
+    next = ring->next;
+    if (atomic_load(&ring->released)) {
+      async_ring_unlink(ring);
+      free(ring);
+    }
+    ring = next;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
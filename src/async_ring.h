@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifndef CLOGGING_ASYNC_RING_H
+#define CLOGGING_ASYNC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Per-thread single-producer/single-consumer record rings which are
+ * drained by one background writer thread.
+ *
+ * The logging thread which creates a ring is its only producer and the
+ * writer thread is its only consumer, so publishing a record costs a
+ * bounds check, a memcpy and a release store. All rings of the process
+ * are registered in one list which the writer walks round-robin.
+ *
+ * This is an internal building block of the logging backends and is
+ * not installed.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Return codes of clogging_async_ring_reserve() and
+ * clogging_async_ring_push().
+ */
+#define CLOGGING_ASYNC_OK 0
+#define CLOGGING_ASYNC_FULL (-1)    /* ring is full, record is dropped */
+#define CLOGGING_ASYNC_STOPPED (-2) /* writer is gone, write inline */
+
+typedef struct clogging_async_ring clogging_async_ring_t;
+
+/* Called from the writer thread for every record.
+ *
+ * ctx is the private copy made by clogging_async_ring_create(), rec/len
+ * is the record and *offset is the number of bytes of the record already
+ * consumed by an earlier call (non-zero after a partial write).
+ *
+ * Return 0 when the record is finished with (written or dropped) and 1
+ * when the writer should come back to the same record later.
+ */
+typedef int (*clogging_async_consume_fn)(clogging_async_ring_t *ring,
+                                         void *ctx, const char *rec,
+                                         size_t len, size_t *offset);
+
+/* The least capacity of a ring which takes records of up to len bytes,
+ * since a record must fit in half of it, see clogging_async_ring_reserve().
+ */
+#define CLOGGING_ASYNC_RING_BYTES_FOR(len) (2 * ((size_t)(len) + 16))
+
+/* Create a ring of (at least) capacity bytes for the calling thread and
+ * start the writer thread if it is not running yet.
+ *
+ * ctx_len bytes at ctx are copied into the ring, so the consumer can
+ * keep working on records of a thread which has already exited.
+ * The ring is released automatically when the calling thread exits,
+ * after setting *owner (the thread local pointer to it, if not NULL) to
+ * NULL, since the writer frees it from then on.
+ *
+ * Returns NULL on failure.
+ */
+clogging_async_ring_t *
+clogging_async_ring_create(size_t capacity, clogging_async_consume_fn fn,
+                           const void *ctx, size_t ctx_len,
+                           clogging_async_ring_t **owner);
+
+/* Get the private copy of the consumer context. */
+void *clogging_async_ring_ctx(clogging_async_ring_t *ring);
+
+/* Reserve len contiguous bytes for a record. On success the record is
+ * written in place and published with clogging_async_ring_commit().
+ * On failure NULL is returned and *status is set to CLOGGING_ASYNC_FULL
+ * or CLOGGING_ASYNC_STOPPED. A reservation which is never committed has
+ * to be handed back with clogging_async_ring_abandon().
+ *
+ * Only the thread which created the ring may call this.
+ */
+char *clogging_async_ring_reserve(clogging_async_ring_t *ring, size_t len,
+                                  int *status);
+
+/* Publish the record reserved last, shrinking it to len bytes (which
+ * must not be more than what was reserved).
+ */
+void clogging_async_ring_commit(clogging_async_ring_t *ring, size_t len);
+
+/* Abandon the record reserved last without publishing it. */
+void clogging_async_ring_abandon(clogging_async_ring_t *ring);
+
+/* Reserve, copy and commit in one go. Returns one of CLOGGING_ASYNC_*. */
+int clogging_async_ring_push(clogging_async_ring_t *ring, const void *rec,
+                             size_t len);
+
+/* Account for records the consumer could not deliver. */
+void clogging_async_ring_add_drops(clogging_async_ring_t *ring,
+                                   uint64_t count);
+
+/* Get the number of records the consumer could not deliver. */
+uint64_t clogging_async_ring_get_drops(clogging_async_ring_t *ring);
+
+/* Account for records the consumer had to cut short. */
+void clogging_async_ring_add_truncations(clogging_async_ring_t *ring,
+                                         uint64_t count);
+
+/* Get the number of records the consumer had to cut short. */
+uint64_t clogging_async_ring_get_truncations(clogging_async_ring_t *ring);
+
+/* Wait till every record published so far on the ring is consumed.
+ * Returns 0 when drained and -1 on timeout (timeout_ms < 0 waits forever).
+ */
+int clogging_async_ring_flush(clogging_async_ring_t *ring, int timeout_ms);
+
+/* Drain all the rings and stop the writer thread, including the records
+ * reserved before this is called and committed meanwhile. Rings which
+ * are still owned by live threads stay valid, but any further record is
+ * reported as CLOGGING_ASYNC_STOPPED so the caller writes it inline.
+ *
+ * This is registered with atexit() when the writer is started.
+ */
+void clogging_async_shutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOGGING_ASYNC_RING_H */
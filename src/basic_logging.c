@@ -11,6 +11,10 @@
 #endif
 
 #include "basic_logging.h"
+#include "log_arena.h"
+#include "log_clock.h"
+#include "log_level.h"
+#include "log_prefix.h"
 
 #include <stdarg.h>   /* va_start() and friends */
 #include <stdio.h>    /* fprintf() and friends */
@@ -55,21 +59,31 @@ static THREAD_LOCAL char g_progname[MAX_PROG_NAME_LEN] = {0};
 static THREAD_LOCAL char g_threadname[MAX_PROG_NAME_LEN] = {0};
 static THREAD_LOCAL char g_hostname[MAX_HOSTNAME_LEN] = {0};
 static THREAD_LOCAL int g_pid = 0;
-static THREAD_LOCAL enum LogLevel g_level = DEFAULT_LOG_LEVEL;
+/* exported for the level check of the log macros, see log_level.h */
+uint32_t clogging_basic_process_level = CLOGGING_LEVEL_WORD_INIT;
+THREAD_LOCAL uint32_t clogging_basic_thread_level = 0;
 /* Logging options */
 static THREAD_LOCAL clogging_log_options_t g_log_options = {
   .color = 0,
   .json = 0,
   .prefix_fields_flag = CLOGGING_PREFIX_DEFAULT
 };
+/* rendered at init from the names, pid and options above */
+static THREAD_LOCAL clogging_prefix_t g_prefix;
 /* safeguard calling init_logging multiple times */
 static THREAD_LOCAL int g_is_logging_initialized = 0;
 
+/* per-thread line buffer which grows up to max_line_bytes on demand */
+static THREAD_LOCAL clogging_arena_t g_arena;
+
 /* store the number of message dropped as a counter for
  * later statistics collection.
  */
 static THREAD_LOCAL uint64_t g_basic_num_msg_drops = 0;
 
+/* messages which were cut short to fit in max_line_bytes */
+static THREAD_LOCAL uint64_t g_basic_num_msg_truncations = 0;
+
 int clogging_basic_init(const char *progname,
                         const char *threadname,
                         enum LogLevel level, const clogging_log_options_t *opts) {
@@ -113,7 +127,8 @@ int clogging_basic_init(const char *progname,
 #else
   g_pid = (int)getpid();
 #endif
-  g_level = level;
+  clogging_level_set_thread(&clogging_basic_process_level,
+                            &clogging_basic_thread_level, level);
 
   /* Store logging options */
   if (opts != NULL) {
@@ -123,31 +138,104 @@ int clogging_basic_init(const char *progname,
     g_log_options.color = 0;
     g_log_options.json = 0;
     g_log_options.prefix_fields_flag = CLOGGING_PREFIX_DEFAULT;
+    g_log_options.async = 0;
+    g_log_options.deferred = 0;
+    g_log_options.clock_source = CLOGGING_CLOCK_REALTIME;
+    g_log_options.time_precision = CLOGGING_TIME_PRECISION_SEC;
+    g_log_options.max_line_bytes = 0;
   }
+  clogging_arena_init(&g_arena, g_log_options.max_line_bytes);
+  clogging_prefix_init(&g_prefix, &g_log_options, g_hostname, g_progname,
+                       g_threadname, g_pid);
 
   return 0;
 }
 
-void clogging_basic_set_loglevel(enum LogLevel level) { g_level = level; }
+void clogging_basic_set_loglevel(enum LogLevel level) {
+  clogging_level_set_thread(&clogging_basic_process_level,
+                            &clogging_basic_thread_level, level);
+}
+
+enum LogLevel clogging_basic_get_loglevel(void) {
+  return clogging_level_get(&clogging_basic_process_level,
+                            clogging_basic_thread_level);
+}
+
+void clogging_basic_set_process_loglevel(enum LogLevel level) {
+  clogging_level_set_process(&clogging_basic_process_level, level);
+}
 
-enum LogLevel clogging_basic_get_loglevel(void) { return g_level; }
+enum LogLevel clogging_basic_get_process_loglevel(void) {
+  return clogging_level_get_process(&clogging_basic_process_level);
+}
+
+/* Format the line in the arena of the calling thread, right after the
+ * header. A message which does not fit, either as formatted or once
+ * escaped for the JSON layout, grows the arena (up to max_line_bytes)
+ * and is formatted again.
+ *
+ * Returns the length of the line or -1 on error.
+ */
+static int basic_format_line(const char *time_str, int time_len,
+                             enum LogLevel level, const char *funcname,
+                             int linenum, const char *format, va_list ap) {
+  int size = clogging_arena_reserve(&g_arena, CLOGGING_ARENA_MIN_BYTES);
+  int new_size = 0;
+  int msg_room = 0;
+  int msg_needed = 0;
+  int pos = 0;
+  int len = 0;
+  int rc = 0;
+  va_list aq;
+
+  if (size < 0) {
+    return -1;
+  }
+  for (;;) {
+    pos = clogging_prefix_format_begin(&g_prefix, g_arena.buf, size,
+                                       time_str, time_len, level, funcname,
+                                       linenum, &msg_room);
+    va_copy(aq, ap);
+    rc = vsnprintf(&g_arena.buf[pos], (size_t)msg_room + 1, format, aq);
+    va_end(aq);
+    if (rc < 0) {
+      return -1;
+    }
+    if (rc <= msg_room) {
+      len = clogging_prefix_format_end(&g_prefix, g_arena.buf, size, pos, rc,
+                                       &msg_needed);
+      if (msg_needed <= msg_room) {
+        return len;
+      }
+    } else {
+      msg_needed = rc;
+    }
+    new_size = clogging_arena_reserve(&g_arena,
+                                      size + (msg_needed - msg_room));
+    if (new_size <= size) {
+      ++g_basic_num_msg_truncations;
+      if (rc > msg_room) {
+        len = clogging_prefix_format_end(&g_prefix, g_arena.buf, size, pos,
+                                         msg_room, &msg_needed);
+      }
+      return len;
+    }
+    size = new_size;
+  }
+}
 
 void clogging_basic_logmsg(const char *funcname, int linenum,
                            enum LogLevel level, const char *format, ...) {
-  /* ISO 8601 date and time format with sec */
-#define TIME_STR_LEN 26
-  const int time_str_len = TIME_STR_LEN;
-  char time_str[TIME_STR_LEN];
-#undef TIME_STR_LEN
-  time_t now;
+  /* ISO 8601 date and time format with the configured precision */
+  char time_str[CLOGGING_MAX_TIME_STR_LEN];
+  clogging_timestamp_t now;
+  int time_len = 0;
   int len = 0;
-  int rc = 0;
-  const char *level_str = 0;
-  char msg[MAX_LOG_MSG_LEN];
   va_list ap;
 
   /* ignore logs which are filtered out */
-  if (level > g_level) {
+  if (clogging_level_filtered_out(&level, &clogging_basic_process_level,
+                                  clogging_basic_thread_level)) {
     return;
   }
 
@@ -156,9 +244,10 @@ void clogging_basic_logmsg(const char *funcname, int linenum,
     return;
   }
 
-  time(&now);
-  len = time_to_cstr(&now, time_str, time_str_len);
-  if (len < 0) {
+  clogging_clock_now(g_log_options.clock_source, &now);
+  time_len = clogging_timestamp_to_cstr(&now, g_log_options.time_precision,
+                                        time_str, (int)sizeof(time_str));
+  if (time_len < 0) {
     /* huh! I'd like to crash at this point but
      * lets just log the message, which is a must.
      */
@@ -166,165 +255,32 @@ void clogging_basic_logmsg(const char *funcname, int linenum,
     return;
   }
 
-  level_str = get_log_level_as_cstring(level);
-
   va_start(ap, format);
-  rc = vsnprintf(msg, MAX_LOG_MSG_LEN, format, ap);
-  if (rc < 0) {
+  len = basic_format_line(time_str, time_len, level, funcname, linenum,
+                          format, ap);
+  va_end(ap);
+  if (len < 0) {
     /* cannot recover from this one, so lets just ignore it
      * for now rather than logging it somewhere.
      */
     ++g_basic_num_msg_drops;
     return;
   }
-  va_end(ap);
 
-  /* JSON format output if enabled */
-  if (g_log_options.json) {
-    if (g_log_options.prefix_fields_flag == CLOGGING_PREFIX_DEFAULT) {
-      /* optimization for default setting */
-      rc = fprintf(stderr,
-                   "{\"timestamp\":\"%s\", \"hostname\":\"%s\", \"progname\":\"%s\", \"threadname\":\"%s\", \"pid\":%d, \"level\":\"%s\", \"funcname\":\"%s\", \"linenum\":%d, \"message\":\"%s\"}\n",
-                   time_str, g_hostname, g_progname, g_threadname, g_pid, level_str, funcname, linenum, msg);
-    } else {
-      /* Build JSON object: {"timestamp":"...", "hostname":"...", ...} */
-      char json_line[1024] = {0};
-      int json_pos = 0;
-      
-      /* Start JSON object */
-      json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, "{");
-      
-      /* Add timestamp if enabled */
-      if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_TIMESTAMP) {
-        json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, "\"timestamp\":\"%s\"", time_str);
-      }
-      
-      /* Add hostname if enabled */
-      if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_HOSTNAME) {
-        if (json_pos > 1) json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, ",");
-        json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, "\"hostname\":\"%s\"", g_hostname);
-      }
-      
-      /* Add program name if enabled */
-      if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_PROGNAME) {
-        if (json_pos > 1) json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, ",");
-        json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, "\"progname\":\"%s\"", g_progname);
-      }
-      
-      /* Add thread name if enabled (along with PID or as separate field) */
-      if ((g_log_options.prefix_fields_flag & CLOGGING_PREFIX_PID) ||
-          (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_PROGNAME)) {
-        if (json_pos > 1) json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, ",");
-        json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, "\"threadname\":\"%s\"", g_threadname);
-      }
-      
-      /* Add PID if enabled */
-      if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_PID) {
-        if (json_pos > 1) json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, ",");
-        json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, "\"pid\":%d", g_pid);
-      }
-      
-      /* Add log level if enabled */
-      if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_LOGLEVEL) {
-        if (json_pos > 1) json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, ",");
-        json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, "\"level\":\"%s\"", level_str);
-      }
-      
-      /* Add function name if enabled */
-      if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_FUNCNAME) {
-        if (json_pos > 1) json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, ",");
-        json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, "\"funcname\":\"%s\"", funcname);
-      }
-      
-      /* Add line number if enabled */
-      if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_LINENUM) {
-        if (json_pos > 1) json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, ",");
-        json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, "\"linenum\":%d", linenum);
-      }
-      
-      /* Add message */
-      if (json_pos > 1) json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, ",");
-      json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, "\"message\":\"%s\"", msg);
-      
-      /* Close JSON object */
-      json_pos += snprintf(json_line + json_pos, sizeof(json_line) - json_pos, "}");
-      
-      rc = fprintf(stderr, "%s\n", json_line);
-    }
-  } else {
-    /* <HEADER> <MESSAGE>
-     *	<HEADER> = <TIMESTAMP> <HOSTNAME>
-     *	<MESSAGE> = <TAG> <LEVEL> <CONTENT>
-     *		<TAG> = <PROGRAM><THREAD>[<PID>]
-     *		<LEVEL> = DEBUG | INFO | WARNING | ERROR
-     *		<CONTENT> = <FUNCTION/MODULE>: <APPLICATION_MESSAGE>
-     */
-    if (g_log_options.prefix_fields_flag == CLOGGING_PREFIX_DEFAULT) {
-      /* optimization for default setting */
-      rc = fprintf(stderr, "%s %s %s%s[%d] %s %s(%d): %s\n", time_str, g_hostname,
-                   g_progname, g_threadname, g_pid, level_str, funcname, linenum,
-                   msg);
-    } else {
-      /* Build prefix based on prefix_fields_flag */
-      char prefix[512] = {0};
-      int prefix_len = 0;
-      
-      if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_TIMESTAMP) {
-        prefix_len += snprintf(prefix + prefix_len, sizeof(prefix) - prefix_len, "%s ", time_str);
-      }
-      if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_HOSTNAME) {
-        prefix_len += snprintf(prefix + prefix_len, sizeof(prefix) - prefix_len, "%s ", g_hostname);
-      }
-      if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_PROGNAME) {
-        prefix_len += snprintf(prefix + prefix_len, sizeof(prefix) - prefix_len, "%s", g_progname);
-      }
-      if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_PID) {
-        prefix_len += snprintf(prefix + prefix_len, sizeof(prefix) - prefix_len, "%s[%d]", g_threadname, g_pid);
-      } else if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_PROGNAME) {
-        prefix_len += snprintf(prefix + prefix_len, sizeof(prefix) - prefix_len, "%s", g_threadname);
-      }
-      if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_LOGLEVEL) {
-        prefix_len += snprintf(prefix + prefix_len, sizeof(prefix) - prefix_len, " %s", level_str);
-      }
-      
-      char content_prefix[128] = {0};
-      int content_len = 0;
-      if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_FUNCNAME) {
-        content_len += snprintf(content_prefix + content_len, sizeof(content_prefix) - content_len, "%s", funcname);
-      }
-      if (g_log_options.prefix_fields_flag & CLOGGING_PREFIX_LINENUM) {
-        content_len += snprintf(content_prefix + content_len, sizeof(content_prefix) - content_len, "(%d)", linenum);
-      }
-      
-      if (prefix_len > 0) {
-        if (content_len > 0) {
-          rc = fprintf(stderr, "%s %s: %s\n", prefix, content_prefix, msg);
-        } else {
-          rc = fprintf(stderr, "%s %s\n", prefix, msg);
-        }
-      } else {
-        if (content_len > 0) {
-          rc = fprintf(stderr, "%s: %s\n", content_prefix, msg);
-        } else {
-          rc = fprintf(stderr, "%s\n", msg);
-        }
-      }
-    }
-  }
-  
-  /* ignore the error if it's there */
-  if (rc < 0) {
+  if (fwrite(g_arena.buf, 1, (size_t)len, stderr) != (size_t)len) {
+    /* ignore the error if it's there */
     ++g_basic_num_msg_drops;
   }
-  /* Note that when less number of characters are written, even then
-   * we dont keep track of that.
-   */
 }
 
 uint64_t clogging_basic_get_num_dropped_messages(void) {
   return g_basic_num_msg_drops;
 }
 
+uint64_t clogging_basic_get_num_truncated_messages(void) {
+  return g_basic_num_msg_truncations;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,6 +9,8 @@
 #ifndef CLOGGING_BASIC_LOGGING_H
 #define CLOGGING_BASIC_LOGGING_H
 
+#include "log_filter.h"
+#include "log_ratelimit.h"
 #include "logging_common.h"
 
 #include <stdint.h>
@@ -48,18 +50,35 @@ int clogging_basic_init(const char *progname,
                         const char *threadname,
                         enum LogLevel level, const clogging_log_options_t *opts);
 
-/*
+/* Set the log level of the calling thread, which overrides the one of
+ * the process until clogging_basic_set_process_loglevel() is called
+ * again. clogging_basic_init() sets it too.
+ *
  * It is a MT safe implementation.
  */
 void clogging_basic_set_loglevel(enum LogLevel level);
 
-/* Get the current log level.
+/* Get the current log level of the calling thread.
  *
  * Irrespective of LOGGING_WITH_THREAD_LOCAL_STORAGE this method
  * will do an atomic read, which is MT safe.
  */
 enum LogLevel clogging_basic_get_loglevel(void);
 
+/* Set the log level of every thread of the process, including those
+ * which set their own before, say to drop all of them from DEBUG to WARN
+ * at once. Each thread follows it from its next message on, until it
+ * sets its own level again.
+ *
+ * It is a MT safe implementation.
+ */
+void clogging_basic_set_process_loglevel(enum LogLevel level);
+
+/* Get the log level of the process, see
+ * clogging_basic_set_process_loglevel().
+ */
+enum LogLevel clogging_basic_get_process_loglevel(void);
+
 /* This will fail if init_logging() is not invoked earlier.
  * There is an additional cost to validating the initiatized state
  * but its worth the check.
@@ -78,11 +97,109 @@ enum LogLevel clogging_basic_get_loglevel(void);
 void clogging_basic_logmsg(const char *funcname, int linenum,
                            enum LogLevel level, const char *format, ...);
 
+/* Whether a message of level would be logged by the current thread.
+ *
+ * The levels are exported, so that this is inlined into the caller as
+ * one relaxed load of the level of the process and a read of the one of
+ * the thread, see clogging_level_of(). Windows cannot import thread
+ * local data from a DLL, so there it calls clogging_basic_get_loglevel().
+ * Levels less severe than CLOGGING_MIN_LEVEL are never enabled.
+ */
+#ifdef _WIN32
+#define CLOGGING_BASIC_LEVEL() ((int)clogging_basic_get_loglevel())
+#else
+extern uint32_t clogging_basic_process_level;
+extern __thread uint32_t clogging_basic_thread_level;
+#define CLOGGING_BASIC_LEVEL()                                                \
+  clogging_level_of(&clogging_basic_process_level,                            \
+                    clogging_basic_thread_level)
+#endif /* _WIN32 */
+#define CLOGGING_BASIC_LEVEL_ENABLED(level)                                   \
+  ((level) <= CLOGGING_MIN_LEVEL && (int)(level) <= CLOGGING_BASIC_LEVEL())
+
+/* The same for a call site, whose filter (see log_filter.h) overrides
+ * the level of the thread, with site the static word of its cache.
+ */
+#define CLOGGING_BASIC_SITE_ENABLED(site, level)                              \
+  ((level) <= CLOGGING_MIN_LEVEL &&                                           \
+   (int)(level) <= CLOGGING_FILTER_LEVEL((site), CLOGGING_BASIC_LEVEL()))
+
+/* Log with clogging_basic_logmsg() only when level is enabled, so that
+ * neither the call nor the arguments are evaluated when it is not.
+ * Arguments with side effects are therefore not evaluated either.
+ */
+#define CLOGGING_BASIC_LOG(level, format, ...)                                \
+  do {                                                                        \
+    static uint32_t clogging_filter_site_;                                    \
+    if (CLOGGING_BASIC_SITE_ENABLED(&clogging_filter_site_, level)) {         \
+      clogging_basic_logmsg(__func__, __LINE__,                               \
+                            CLOGGING_CHECKED_LEVEL(level), format,            \
+                            ##__VA_ARGS__);                                   \
+    }                                                                         \
+  } while (0)
+
+#define BASIC_LOG_ERROR(format, ...)                                          \
+  CLOGGING_KEEP_ERROR(                                                        \
+      CLOGGING_BASIC_LOG(LOG_LEVEL_ERROR, format, ##__VA_ARGS__))
+#define BASIC_LOG_WARN(format, ...)                                           \
+  CLOGGING_KEEP_WARN(                                                         \
+      CLOGGING_BASIC_LOG(LOG_LEVEL_WARN, format, ##__VA_ARGS__))
+#define BASIC_LOG_INFO(format, ...)                                           \
+  CLOGGING_KEEP_INFO(                                                         \
+      CLOGGING_BASIC_LOG(LOG_LEVEL_INFO, format, ##__VA_ARGS__))
+#define BASIC_LOG_DEBUG(format, ...)                                          \
+  CLOGGING_KEEP_DEBUG(                                                        \
+      CLOGGING_BASIC_LOG(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__))
+
+/* CLOGGING_BASIC_LOG() of at most burst messages at once from the call
+ * site and per_second more each second, checked before the arguments are
+ * evaluated. The next message logged tells how many were suppressed in
+ * between, so format has to be a string literal, see log_ratelimit.h.
+ */
+#define CLOGGING_BASIC_LOG_RATELIMITED(level, burst, per_second, format, ...) \
+  do {                                                                        \
+    static uint32_t clogging_filter_site_;                                    \
+    static clogging_ratelimit_t clogging_ratelimit_;                          \
+    uint32_t clogging_suppressed_ = 0;                                        \
+    if (CLOGGING_BASIC_SITE_ENABLED(&clogging_filter_site_, level) &&         \
+        clogging_ratelimit_allow(&clogging_ratelimit_, (burst), (per_second), \
+                                 &clogging_suppressed_)) {                    \
+      if (clogging_suppressed_ == 0) {                                        \
+        clogging_basic_logmsg(__func__, __LINE__,                             \
+                              CLOGGING_CHECKED_LEVEL(level), format,          \
+                              ##__VA_ARGS__);                                 \
+      } else {                                                                \
+        clogging_basic_logmsg(__func__, __LINE__,                             \
+                              CLOGGING_CHECKED_LEVEL(level),                  \
+                              format CLOGGING_SUPPRESSED_FORMAT,              \
+                              ##__VA_ARGS__, clogging_suppressed_);           \
+      }                                                                       \
+    }                                                                         \
+  } while (0)
+
+#define BASIC_LOG_ERROR_RATELIMITED(burst, per_second, format, ...)           \
+  CLOGGING_KEEP_ERROR(CLOGGING_BASIC_LOG_RATELIMITED(                         \
+      LOG_LEVEL_ERROR, burst, per_second, format, ##__VA_ARGS__))
+#define BASIC_LOG_WARN_RATELIMITED(burst, per_second, format, ...)            \
+  CLOGGING_KEEP_WARN(CLOGGING_BASIC_LOG_RATELIMITED(                          \
+      LOG_LEVEL_WARN, burst, per_second, format, ##__VA_ARGS__))
+#define BASIC_LOG_INFO_RATELIMITED(burst, per_second, format, ...)            \
+  CLOGGING_KEEP_INFO(CLOGGING_BASIC_LOG_RATELIMITED(                          \
+      LOG_LEVEL_INFO, burst, per_second, format, ##__VA_ARGS__))
+#define BASIC_LOG_DEBUG_RATELIMITED(burst, per_second, format, ...)           \
+  CLOGGING_KEEP_DEBUG(CLOGGING_BASIC_LOG_RATELIMITED(                         \
+      LOG_LEVEL_DEBUG, burst, per_second, format, ##__VA_ARGS__))
+
 /* Get the number of messages dropped due to overload or
  * internal errors.
  */
 uint64_t clogging_basic_get_num_dropped_messages(void);
 
+/* Get the number of messages which were cut short because the line
+ * would have been longer than max_line_bytes of the options.
+ */
+uint64_t clogging_basic_get_num_truncated_messages(void);
+
 #ifdef __cplusplus
 }
 #endif
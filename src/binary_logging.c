@@ -11,6 +11,10 @@
 #endif
 
 #include "binary_logging.h"
+#include "log_arena.h"
+#include "log_clock.h"
+#include "log_level.h"
+#include "shm_ring.h"
 
 /* Cross-platform endianness detection */
 #if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && defined(__ORDER_BIG_ENDIAN__)
@@ -70,11 +74,15 @@ Windows header to exclude less commonly used APIs, including the old winsock.h:
 #endif
 
 #include <stdarg.h>   /* va_start() and friends */
+#include <stdatomic.h> /* atomic_fetch_add() and friends */
 #include <stddef.h>   /* ptrdiff_t */
+#include <limits.h>   /* INT_MAX */
 #include <stdio.h>    /* dprintf() and friends */
+#include <stdlib.h>   /* atoi() */
 #include <string.h>   /* strlen() */
 #include <sys/types.h>
 #include <time.h>   /* time() */
+#include <wchar.h>  /* wint_t */
 #include <sys/types.h>
 
 #define MAX_PROG_NAME_LEN 40
@@ -102,12 +110,58 @@ static THREAD_LOCAL int g_binary_threadname_length = 0;
 static THREAD_LOCAL char g_binary_hostname[MAX_HOSTNAME_LEN] = {0};
 static THREAD_LOCAL int g_binary_hostname_length = 0;
 static THREAD_LOCAL int g_binary_pid = 0;
-static THREAD_LOCAL enum LogLevel g_binary_level = DEFAULT_LOG_LEVEL;
+/* exported for the level check of the log macros, see log_level.h */
+uint32_t clogging_binary_process_level = CLOGGING_LEVEL_WORD_INIT;
+THREAD_LOCAL uint32_t clogging_binary_thread_level = 0;
 #ifdef _WIN32
 static THREAD_LOCAL clogging_handle_t g_binary_handle = {CLOGGING_HANDLE_TYPE_CRT, {.crt_fd = 2}};
 #else
 static THREAD_LOCAL clogging_handle_t g_binary_handle = 2; /* stderr fd is default as 2 */
 #endif
+/* Logging options, only the clock related ones apply to binary logging */
+static THREAD_LOCAL clogging_log_options_t g_binary_log_options = {
+  .clock_source = CLOGGING_CLOCK_REALTIME,
+  .time_precision = CLOGGING_TIME_PRECISION_SEC
+};
+/* CLOGGING_BINARY_VERSION_* of the frames and records written */
+static THREAD_LOCAL int g_binary_version = CLOGGING_BINARY_VERSION_1;
+/* or'ed with the version when multi-byte values are stored in the byte
+ * order of the host, as told by the CLOGGING_BINARY_FRAME_STREAM frame.
+ */
+#define BINARY_NATIVE_ENDIAN 0x100
+#define BINARY_VERSION_OF(encoding) ((encoding) & 0xff)
+/* or'ed with the version when put_arg_data() may refer to the arguments
+ * instead of copying them
+ */
+#define BINARY_ZERO_COPY 0x200
+/* or'ed with the version when a record which does not fit goes out as
+ * CLOGGING_BINARY_FRAME_CONTINUATION frames, see binary_flush_chunk()
+ */
+#define BINARY_CHUNKED 0x400
+/* or'ed with the version when strings of more than 15 bits keep their
+ * whole length, as the arguments captured for
+ * clogging_binary_render_arguments() do
+ */
+#define BINARY_LONG_STRINGS 0x800
+/* the version and byte order the fields are stored with, see put_uint() */
+static THREAD_LOCAL int g_binary_encoding = CLOGGING_BINARY_VERSION_1;
+/* the last stream id handed out in this process, see g_binary_stream_id */
+static atomic_uint_least32_t g_binary_last_stream_id = 0;
+/* pid in the upper 32 bits and a number unique within the process in the
+ * lower ones, so streams of processes sharing a ring are told apart too
+ */
+static THREAD_LOCAL uint64_t g_binary_stream_id = 0;
+/* with delta_timestamps, nanoseconds since the Epoch of the last record
+ * or TIMEBASE frame written, which the next <timestamp> is a delta from
+ */
+static THREAD_LOCAL int64_t g_binary_last_ns = 0;
+static THREAD_LOCAL int g_binary_has_timebase = 0;
+/* the time of the record being built, see binary_prepare() */
+static THREAD_LOCAL int64_t g_binary_record_ns = 0;
+/* 0 while the frames of binary_start_stream() have not all gone out */
+static THREAD_LOCAL int g_binary_stream_started = 0;
+/* when set records are published here instead of writing to g_binary_handle */
+static THREAD_LOCAL clogging_shm_ring_t *g_binary_shm_ring = NULL;
 /* safeguard calling init_logging multiple times */
 static THREAD_LOCAL int g_binary_is_logging_initialized = 0;
 
@@ -125,6 +179,63 @@ static THREAD_LOCAL char g_binary_previous_message[TOTAL_MSG_BYTES];
  */
 static THREAD_LOCAL uint64_t g_binary_num_msg_drops = 0;
 
+/* Long string and blob arguments are not copied into the store when the
+ * records go to a handle, but written from where they are with
+ * clogging_handle_writev(), see put_arg_data().
+ */
+struct binary_segment {
+  ssize_t offset; /* of the store where the argument goes */
+  const char *data;
+  size_t len;
+};
+#define MAX_BINARY_SEGMENTS ((CLOGGING_MAX_IOVECS - 1) / 2)
+/* shorter arguments are cheaper to copy than to write separately */
+#define ZERO_COPY_MIN_BYTES 256
+/* <length> <header> <stream id> <chunk index> <last> of a CONTINUATION
+ * frame, in either version
+ */
+#define MAX_CHUNK_HEADER_BYTES (2 + 1 + 10 + 5 + 2)
+/* the largest <length> of a frame, which is 16 bits */
+#define MAX_FRAME_LENGTH 0xffff
+/* the records leave room for the header of a CONTINUATION frame should
+ * they become one, whatever the length of a text line
+ */
+#define MAX_RECORD_BYTES (MAX_FRAME_LENGTH - MAX_CHUNK_HEADER_BYTES)
+static THREAD_LOCAL struct binary_segment g_binary_segments[MAX_BINARY_SEGMENTS];
+static THREAD_LOCAL int g_binary_num_segments = 0;
+static THREAD_LOCAL size_t g_binary_segment_bytes = 0;
+/* the unsent rest of a partially written record with segments, which is
+ * in place of g_binary_previous_message when g_binary_retry_in_arena
+ */
+static THREAD_LOCAL clogging_arena_t g_binary_retry = {NULL, 0, 0, NULL};
+static THREAD_LOCAL int g_binary_retry_in_arena = 0;
+
+/* the number of CONTINUATION frames written of the record being built,
+ * which is 0 while it still fits in a frame of its own
+ */
+static THREAD_LOCAL uint32_t g_binary_chunk_index = 0;
+/* a CONTINUATION frame for a ring, which needs it in one piece */
+static THREAD_LOCAL char g_binary_chunk[MAX_CHUNK_HEADER_BYTES +
+                                        TOTAL_MSG_BYTES];
+
+/* the last site id handed out, so the first site is 1 */
+static atomic_uint_least32_t g_binary_last_site_id = 0;
+/* bitmap of the site ids this thread has written a SITE frame for */
+static THREAD_LOCAL clogging_arena_t g_binary_sites_sent = {NULL, 0, 0, NULL};
+
+/* an interned format, see CLOGGING_BINARY_FRAME_FORMAT */
+struct binary_format_entry {
+  const char *format;
+  uint32_t id;
+};
+/* the last format id handed out, so the first format is 1 */
+static atomic_uint_least32_t g_binary_last_format_id = 0;
+/* open addressing table of the formats this thread has interned, keyed by
+ * their address, see binary_format_slots() for its size.
+ */
+static THREAD_LOCAL clogging_arena_t g_binary_formats = {NULL, 0, 0, NULL};
+static THREAD_LOCAL int g_binary_num_formats = 0;
+
 enum length_specifier {
   LS_NONE = 0,
   LS_H,
@@ -140,9 +251,53 @@ enum length_specifier {
 #define PCOPY_DATA_TYPE(store, offsetptr, llval, bytes)                        \
   PCOPY_DATA_TYPE_ #bytes(store, offsetptr, llval)
 
+/* The largest scalar argument is a long double, which is stored as
+ * <type> <0x80|size> <value>.
+ */
+#define MAX_SCALAR_ARG_BYTES (2 + sizeof(long double))
+
+/* Read an integer argument of a conversion with lspecifier, with va_arg()
+ * of its own promoted type, say int for "%d", "%hd" and "%hhd". Only the
+ * low bytes of it are stored, see put_arg_integer().
+ */
+#define VA_ARG_INTEGER(ap, lspecifier, is_signed)                             \
+  ((lspecifier) == LS_L                                                       \
+       ? ((is_signed) ? (unsigned long long)va_arg(ap, long)                  \
+                      : (unsigned long long)va_arg(ap, unsigned long))        \
+   : (lspecifier) == LS_LL                                                    \
+       ? ((is_signed) ? (unsigned long long)va_arg(ap, long long)             \
+                      : va_arg(ap, unsigned long long))                       \
+   : (lspecifier) == LS_J                                                     \
+       ? ((is_signed) ? (unsigned long long)va_arg(ap, intmax_t)              \
+                      : (unsigned long long)va_arg(ap, uintmax_t))            \
+   : (lspecifier) == LS_Z ? (unsigned long long)va_arg(ap, size_t)            \
+   : (lspecifier) == LS_T ? (unsigned long long)va_arg(ap, ptrdiff_t)         \
+   : (is_signed)          ? (unsigned long long)va_arg(ap, int)               \
+                          : (unsigned long long)va_arg(ap, unsigned int))
+
+/* precisions of the arguments, see parse_arg_precisions() */
+#define ARG_PRECISION_NONE (-1)
+#define ARG_PRECISION_STAR (-2) /* given by the argument before */
+
 /* function prototypes */
-static ssize_t fill_variable_arguments(char *store, ssize_t offset, const char *format,
-                                       va_list ap);
+static ssize_t fill_variable_arguments(char *store, ssize_t offset,
+                                       ssize_t capacity, const char *format,
+                                       int version, va_list ap);
+static ssize_t fill_typed_arguments(char *store, ssize_t offset,
+                                    ssize_t capacity, const uint8_t *desc,
+                                    const char *format, int version,
+                                    va_list ap);
+static uint32_t parse_arg_precisions(const char *format, long *precisions,
+                                     char *conversions);
+static int binary_flush_chunk(char *store, ssize_t *offset);
+static int binary_flush_previous(void);
+static int binary_write_segments(const char *head, size_t head_len,
+                                 const char *store, ssize_t from,
+                                 ssize_t offset);
+static void copy_big_endian_raw(char *store, ssize_t *offset, const void *src,
+                                size_t bytes);
+static void put_raw(char *store, ssize_t *offset, const void *src,
+                    size_t bytes, int version);
 
 /* Think about an optimized approach instead of using this generic
  * implementation in the future.
@@ -187,9 +342,392 @@ int portable_copy(char *store, ssize_t *offset, unsigned long long val,
   return 0;
 }
 
-int clogging_binary_init(const char *progname,
-                         const char *threadname,
-                         enum LogLevel level, clogging_handle_t handle) {
+/* Same as portable_copy() but in the byte order of the host, so each
+ * value is a single store.
+ */
+static int native_copy(char *store, ssize_t *offset, unsigned long long val,
+                       ssize_t bytes) {
+  uint8_t u8 = (uint8_t)val;
+  uint16_t u16 = (uint16_t)val;
+  uint32_t u32 = (uint32_t)val;
+  uint64_t u64 = (uint64_t)val;
+
+  switch (bytes) {
+  case 1: /* 8 bits */
+    memcpy(&store[*offset], &u8, sizeof(u8));
+    break;
+  case 2: /* 16 bits */
+    memcpy(&store[*offset], &u16, sizeof(u16));
+    break;
+  case 4: /* 32 bits */
+    memcpy(&store[*offset], &u32, sizeof(u32));
+    break;
+  case 8: /* 64 bits */
+    memcpy(&store[*offset], &u64, sizeof(u64));
+    break;
+  default:
+    return -1;
+  }
+  *offset += bytes;
+  return 0;
+}
+
+/* unsigned LEB128, 7 bits at a time starting with the lowest */
+static void put_varint(char *store, ssize_t *offset, unsigned long long val) {
+  while (val >= 0x80) {
+    store[(*offset)++] = (char)((val & 0x7f) | 0x80);
+    val >>= 7;
+  }
+  store[(*offset)++] = (char)val;
+}
+
+/* Store the unsigned integer val of bytes bytes as <0x80|bytes>
+ * <big-endian value> in CLOGGING_BINARY_VERSION_1 (in host byte order
+ * with BINARY_NATIVE_ENDIAN) and as a varint in CLOGGING_BINARY_VERSION_2.
+ */
+static int put_uint(char *store, ssize_t *offset, unsigned long long val,
+                    int bytes, int version) {
+  if (BINARY_VERSION_OF(version) == CLOGGING_BINARY_VERSION_2) {
+    put_varint(store, offset, val);
+    return 0;
+  }
+  store[(*offset)++] = 0x80 | bytes;
+  if (version & BINARY_NATIVE_ENDIAN) {
+    return native_copy(store, offset, val, bytes);
+  }
+  return portable_copy(store, offset, val, bytes);
+}
+
+/* Store the length of len bytes, which is 15-bit big-endian in
+ * CLOGGING_BINARY_VERSION_1 and a varint in CLOGGING_BINARY_VERSION_2.
+ */
+static void put_length(char *store, ssize_t *offset, size_t len,
+                       int version) {
+  if (BINARY_VERSION_OF(version) == CLOGGING_BINARY_VERSION_2) {
+    put_varint(store, offset, len);
+  } else {
+    store[(*offset)++] = 0x00 | ((len >> 8) & 0x7f);
+    store[(*offset)++] = len & 0x00ff;
+  }
+}
+
+/* Store len bytes of s preceded by their length, see put_length(). */
+static void put_bytes(char *store, ssize_t *offset, const char *s,
+                      size_t len, int version) {
+  put_length(store, offset, len, version);
+  memcpy(&store[*offset], s, len);
+  *offset += len;
+}
+
+/* Store an integer argument of bytes bytes, which is <type> <0x80|bytes>
+ * <big-endian value> in CLOGGING_BINARY_VERSION_1, and the tag
+ * CLOGGING_BINARY_ARG_DESC(type, bytes) followed by the zigzag varint of
+ * the value sign extended from bytes in CLOGGING_BINARY_VERSION_2. So
+ * small values take a byte whether they are signed or not, and the
+ * decoder gets the bits of the value back by cutting it to bytes again.
+ */
+static int put_arg_integer(char *store, ssize_t *offset,
+                           unsigned long long val, int bytes, int version) {
+  int shift = 64 - 8 * bytes;
+  long long sval = 0;
+
+  if (BINARY_VERSION_OF(version) != CLOGGING_BINARY_VERSION_2) {
+    store[(*offset)++] = BINARY_LOG_VAR_ARG_INTEGER & 0x00ff;
+    return put_uint(store, offset, val, bytes, version);
+  }
+  if (bytes < 1 || bytes > 8) {
+    return -1;
+  }
+  store[(*offset)++] = CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_INTEGER,
+                                                bytes);
+  /* sign extend, then zigzag */
+  sval = (long long)(val << shift) >> shift;
+  put_varint(store, offset,
+             ((unsigned long long)sval << 1) ^ (unsigned long long)(sval >> 63));
+  return 0;
+}
+
+/* Store the type and size of an argument which is copied as is, that is
+ * <type> <0x80|bytes> in CLOGGING_BINARY_VERSION_1 and the tag
+ * CLOGGING_BINARY_ARG_DESC(type, bytes) in CLOGGING_BINARY_VERSION_2.
+ */
+static void put_arg_tag(char *store, ssize_t *offset, enum VarArgType type,
+                        int bytes, int version) {
+  if (BINARY_VERSION_OF(version) == CLOGGING_BINARY_VERSION_2) {
+    store[(*offset)++] = CLOGGING_BINARY_ARG_DESC(type, bytes);
+    return;
+  }
+  store[(*offset)++] = type & 0x00ff;
+  store[(*offset)++] = 0x80 | bytes;
+}
+
+/* Make room for an argument of MAX_SCALAR_ARG_BYTES at most at offset.
+ *
+ * Returns -1 when it does not fit within capacity bytes of the store or
+ * makes the record longer than MAX_RECORD_BYTES, unless BINARY_CHUNKED
+ * lets what is in the store go out as a CONTINUATION frame first.
+ */
+static int reserve_scalar_arg(char *store, ssize_t *offset,
+                              ssize_t capacity, int version) {
+  if (*offset + (ssize_t)MAX_SCALAR_ARG_BYTES <= capacity &&
+      (size_t)*offset + g_binary_segment_bytes + MAX_SCALAR_ARG_BYTES <=
+          MAX_RECORD_BYTES) {
+    return 0;
+  }
+  if (!(version & BINARY_CHUNKED)) {
+    return -1;
+  }
+  return binary_flush_chunk(store, offset);
+}
+
+/* Store the <type> and length of a string or blob argument of len bytes.
+ * In CLOGGING_BINARY_VERSION_1 the length of one of more than 15 bits,
+ * which only BINARY_CHUNKED and BINARY_LONG_STRINGS allow, is <0x80|4>
+ * <length>.
+ */
+static void put_arg_head(char *store, ssize_t *offset, enum VarArgType type,
+                         size_t len, int version) {
+  if (BINARY_VERSION_OF(version) == CLOGGING_BINARY_VERSION_2) {
+    store[(*offset)++] = CLOGGING_BINARY_ARG_DESC(type, 0);
+    put_length(store, offset, len, version);
+    return;
+  }
+  store[(*offset)++] = type & 0x00ff;
+  if (len > 0x7fff) {
+    put_uint(store, offset, len, sizeof(uint32_t), version);
+  } else {
+    put_length(store, offset, len, version);
+  }
+}
+
+/* Store a string or blob argument which does not fit, the same way as
+ * put_arg_data() but copied a piece at a time between the CONTINUATION
+ * frames it takes.
+ */
+static int put_arg_chunked(char *store, ssize_t *offset, ssize_t capacity,
+                           enum VarArgType type, const char *s, size_t len,
+                           int version) {
+  size_t room = 0;
+  size_t n = 0;
+
+  if (len > UINT32_MAX ||
+      reserve_scalar_arg(store, offset, capacity, version) < 0) {
+    return -1;
+  }
+  put_arg_head(store, offset, type, len, version);
+  while (len > 0) {
+    room = (size_t)(capacity - *offset);
+    if (room > MAX_RECORD_BYTES - (size_t)*offset - g_binary_segment_bytes) {
+      room = MAX_RECORD_BYTES - (size_t)*offset - g_binary_segment_bytes;
+    }
+    if (room == 0) {
+      if (binary_flush_chunk(store, offset) < 0) {
+        return -1;
+      }
+      continue;
+    }
+    n = (len < room) ? len : room;
+    memcpy(&store[*offset], s, n);
+    *offset += n;
+    s += n;
+    len -= n;
+  }
+  return 0;
+}
+
+/* Store a string or blob argument of len bytes at s, which is <type>
+ * <15-bit big-endian length> <bytes> in CLOGGING_BINARY_VERSION_1 and
+ * the tag CLOGGING_BINARY_ARG_DESC(type, 0) <varint length> <bytes> in
+ * CLOGGING_BINARY_VERSION_2, see put_arg_head().
+ *
+ * With BINARY_ZERO_COPY a long one is not copied into the store, which
+ * only gets its type and length, but is added to g_binary_segments for
+ * binary_finish_record() to write it from s.
+ *
+ * Returns -1 when it does not fit within capacity bytes of the store or
+ * makes the record longer than MAX_RECORD_BYTES, unless BINARY_CHUNKED
+ * lets it go out with put_arg_chunked().
+ */
+static int put_arg_data(char *store, ssize_t *offset, ssize_t capacity,
+                        enum VarArgType type, const char *s, size_t len,
+                        int version) {
+  int zero_copy = (version & BINARY_ZERO_COPY) && len >= ZERO_COPY_MIN_BYTES &&
+                  g_binary_num_segments < MAX_BINARY_SEGMENTS;
+  /* <type> and a length of 5 bytes at most */
+  size_t in_store = 6 + (zero_copy ? 0 : len);
+  struct binary_segment *seg = NULL;
+
+  if (*offset + (ssize_t)in_store > capacity ||
+      (size_t)*offset + g_binary_segment_bytes + 6 + len > MAX_RECORD_BYTES) {
+    if (!(version & BINARY_CHUNKED)) {
+      return -1;
+    }
+    return put_arg_chunked(store, offset, capacity, type, s, len, version);
+  }
+  put_arg_head(store, offset, type, len, version);
+  if (!zero_copy) {
+    memcpy(&store[*offset], s, len);
+    *offset += len;
+    return 0;
+  }
+  seg = &g_binary_segments[g_binary_num_segments++];
+  seg->offset = *offset;
+  seg->data = s;
+  seg->len = len;
+  g_binary_segment_bytes += len;
+  return 0;
+}
+
+/* Write a frame which is not a log record, see CLOGGING_BINARY_FRAME_*,
+ * after the rest of the previous one. The rest of a partial write is
+ * kept for binary_flush_previous() as for a record, so that the frames
+ * after it are not written into the middle of it.
+ *
+ * Returns 0 when the frame is written or its rest is kept, and -1 when
+ * it is dropped.
+ */
+static int write_frame(char *store, ssize_t offset) {
+  ssize_t len = offset - 2;
+
+  store[0] = (len >> 8) & 0x00ff;
+  store[1] = (len & 0x00ff);
+  if (g_binary_shm_ring != NULL) {
+    if (clogging_shm_ring_write(g_binary_shm_ring, store, offset) < 0) {
+      ++g_binary_num_msg_drops;
+      return -1;
+    }
+    return 0;
+  }
+  /* copied to g_binary_retry when partially written */
+  if (binary_flush_previous() < 0 ||
+      binary_write_segments(NULL, 0, store, 0, offset) < 0) {
+    ++g_binary_num_msg_drops;
+    return -1;
+  }
+  return 0;
+}
+
+/* <length> <header> <clock source> <precision>
+ *   [<ticks per sec> <base ticks> <base sec> <base nsec>]
+ *
+ * The calibration is only present for CLOGGING_CLOCK_TSC.
+ */
+static int write_clock_frame(void) {
+  char store[64];
+  ssize_t offset = 2;
+  clogging_tsc_calibration_t cal;
+
+  store[offset++] = CLOGGING_BINARY_FRAME_HEADER(g_binary_version,
+                                                 CLOGGING_BINARY_FRAME_CLOCK);
+  put_uint(store, &offset, g_binary_log_options.clock_source, 1,
+           g_binary_encoding);
+  put_uint(store, &offset, g_binary_log_options.time_precision, 1,
+           g_binary_encoding);
+  if (g_binary_log_options.clock_source == CLOGGING_CLOCK_TSC) {
+    (void)clogging_clock_get_tsc_calibration(&cal);
+    put_uint(store, &offset, cal.ticks_per_sec, sizeof(cal.ticks_per_sec),
+             g_binary_encoding);
+    put_uint(store, &offset, cal.base_ticks, sizeof(cal.base_ticks),
+             g_binary_encoding);
+    put_uint(store, &offset, (unsigned long long)cal.base_sec,
+             sizeof(cal.base_sec), g_binary_encoding);
+    put_uint(store, &offset, cal.base_nsec, sizeof(cal.base_nsec),
+             g_binary_encoding);
+  }
+  return write_frame(store, offset);
+}
+
+/* <length> <header> <byte order>
+ *
+ * Written first when native_endian is set in the options.
+ */
+static int write_stream_frame(void) {
+  char store[8];
+  ssize_t offset = 2;
+
+  store[offset++] = CLOGGING_BINARY_FRAME_HEADER(g_binary_version,
+                                                 CLOGGING_BINARY_FRAME_STREAM);
+  put_uint(store, &offset,
+           IS_LITTLE_ENDIAN ? CLOGGING_BINARY_LITTLE_ENDIAN
+                            : CLOGGING_BINARY_BIG_ENDIAN,
+           1, g_binary_encoding);
+  return write_frame(store, offset);
+}
+
+/* <length> <header> <stream id> <hostname> <progname> <threadname> <pid>
+ *
+ * Written at the start of the stream when intern_identity is set in the
+ * options.
+ */
+static int write_identity_frame(void) {
+  char store[TOTAL_MSG_BYTES];
+  ssize_t offset = 2;
+
+  store[offset++] = CLOGGING_BINARY_FRAME_HEADER(
+      g_binary_version, CLOGGING_BINARY_FRAME_IDENTITY);
+  put_uint(store, &offset, g_binary_stream_id, sizeof(g_binary_stream_id),
+           g_binary_encoding);
+  put_bytes(store, &offset, g_binary_hostname, g_binary_hostname_length,
+            g_binary_encoding);
+  put_bytes(store, &offset, g_binary_progname, g_binary_progname_length,
+            g_binary_encoding);
+  put_bytes(store, &offset, g_binary_threadname, g_binary_threadname_length,
+            g_binary_encoding);
+  put_uint(store, &offset, (unsigned int)g_binary_pid, sizeof(g_binary_pid),
+           g_binary_encoding);
+  return write_frame(store, offset);
+}
+
+/* Anything but whole seconds of CLOCK_REALTIME needs a CLOCK frame
+ * to be decoded, the default keeps the stream as it always was.
+ */
+static int needs_clock_frame(void) {
+  /* nanosecond deltas say it all */
+  if (g_binary_log_options.delta_timestamps) {
+    return 0;
+  }
+  return g_binary_log_options.clock_source != CLOGGING_CLOCK_REALTIME ||
+         g_binary_log_options.time_precision != CLOGGING_TIME_PRECISION_SEC;
+}
+
+/* Write the frames a decoder needs before the first record, and forget
+ * the sites and formats sent so far so that they are sent again. When
+ * one of the frames is dropped g_binary_stream_started is left 0, and
+ * binary_prepare() starts the stream again before the next record.
+ */
+static void binary_start_stream(void) {
+  int rc = 0;
+
+  if (g_binary_sites_sent.buf != NULL) {
+    memset(g_binary_sites_sent.buf, 0, g_binary_sites_sent.size);
+  }
+  if (g_binary_formats.buf != NULL) {
+    memset(g_binary_formats.buf, 0, g_binary_formats.size);
+  }
+  g_binary_num_formats = 0;
+  /* the first record of the stream is preceded by a TIMEBASE frame */
+  g_binary_has_timebase = 0;
+
+  /* tell the decoder the byte order before anything else */
+  if (g_binary_log_options.native_endian) {
+    rc |= write_stream_frame();
+  }
+  /* tell the decoder how to read the timestamps before the first record */
+  if (rc == 0 && needs_clock_frame()) {
+    rc |= write_clock_frame();
+  }
+  /* and who the records without an identity of their own are from */
+  if (rc == 0 && g_binary_log_options.intern_identity) {
+    rc |= write_identity_frame();
+  }
+  g_binary_stream_started = (rc == 0);
+}
+
+/* records go to handle unless ring is not NULL */
+static int binary_init_sink(const char *progname, const char *threadname,
+                            enum LogLevel level, clogging_handle_t handle,
+                            clogging_shm_ring_t *ring,
+                            const clogging_log_options_t *opts) {
   if (g_binary_is_logging_initialized > 0) {
     fprintf(stderr, "logging is already initialized for current thread or in the"
                     " process of initialization.\n");
@@ -233,169 +771,925 @@ int clogging_binary_init(const char *progname,
   #else
     g_binary_pid = (int)getpid();
   #endif
-  g_binary_level = level;
+  clogging_level_set_thread(&clogging_binary_process_level,
+                            &clogging_binary_thread_level, level);
   g_binary_handle = handle;
+  g_binary_shm_ring = ring;
+  clogging_arena_init(&g_binary_sites_sent, CLOGGING_MAX_LINE_BYTES);
+  clogging_arena_init(&g_binary_formats, CLOGGING_MAX_LINE_BYTES);
+  clogging_arena_init(&g_binary_retry, CLOGGING_MAX_LINE_BYTES);
+
+  if (opts != NULL) {
+    g_binary_log_options = *opts;
+  }
+  if (g_binary_log_options.time_precision > CLOGGING_TIME_PRECISION_NS) {
+    g_binary_log_options.time_precision = CLOGGING_TIME_PRECISION_NS;
+  }
+  g_binary_version =
+      (g_binary_log_options.binary_version == CLOGGING_BINARY_VERSION_2)
+          ? CLOGGING_BINARY_VERSION_2
+          : CLOGGING_BINARY_VERSION_1;
+  g_binary_encoding = g_binary_version;
+  if (g_binary_log_options.native_endian) {
+    g_binary_encoding |= BINARY_NATIVE_ENDIAN;
+  }
+  if (ring == NULL) {
+    /* a ring takes a copy of the record anyway */
+    g_binary_encoding |= BINARY_ZERO_COPY;
+  }
+  if (g_binary_log_options.chunk_records) {
+    g_binary_encoding |= BINARY_CHUNKED;
+  }
+  if (g_binary_log_options.delta_timestamps) {
+    /* the deltas are per stream, so the records need its id */
+    g_binary_log_options.intern_identity = 1;
+  }
+  if (g_binary_log_options.clock_source == CLOGGING_CLOCK_TSC &&
+      clogging_clock_get_tsc_calibration(NULL) < 0) {
+    /* records carry wall clock time then */
+    g_binary_log_options.clock_source = CLOGGING_CLOCK_REALTIME;
+  }
 
+  g_binary_stream_id =
+      ((uint64_t)(uint32_t)g_binary_pid << 32) |
+      (uint32_t)(atomic_fetch_add(&g_binary_last_stream_id, 1) + 1);
+
+  binary_start_stream();
   return 0;
 }
 
-void clogging_binary_set_loglevel(enum LogLevel level) {
-  g_binary_level = level;
+int clogging_binary_init(const char *progname,
+                         const char *threadname,
+                         enum LogLevel level, clogging_handle_t handle,
+                         const clogging_log_options_t *opts) {
+  return binary_init_sink(progname, threadname, level, handle, NULL, opts);
 }
 
-enum LogLevel clogging_binary_get_loglevel(void) { return g_binary_level; }
-
-void clogging_binary_logmsg(const char *filename, const char *funcname,
-                            int linenum, enum LogLevel level,
-                            const char *format, ...) {
-  time_t now;
-  ssize_t remaining_bytes = 0;
-  ssize_t len = 0;
-  int rc = 0;
-  va_list ap;
-  char *store = g_binary_previous_message;
-  ssize_t offset = 0;
-  ssize_t bytes_written = 0;
-  int filenamelen = strlen(filename) & 0x7f;
-  int funcnamelen = strlen(funcname) & 0x7f;
-
-  /* ignore logs which are filtered out */
-  if (level > g_binary_level) {
-    return;
+int clogging_binary_init_shm(const char *progname, const char *threadname,
+                             enum LogLevel level, clogging_shm_ring_t *ring,
+                             const clogging_log_options_t *opts) {
+  if (ring == NULL) {
+    fprintf(stderr, "shared memory ring is NULL\n");
+    return -1;
   }
+  return binary_init_sink(progname, threadname, level,
+                          CLOGGING_INVALID_HANDLE, ring, opts);
+}
 
-  if (g_binary_is_logging_initialized <= 0) {
-    fprintf(stderr, "logging is not initialized yet\n");
-    ++g_binary_num_msg_drops;
+void clogging_binary_restart_stream(void) {
+  if (g_binary_is_logging_initialized == 0) {
     return;
   }
+  /* the rest of a partially written record means nothing to the new
+   * receiver
+   */
+  g_binary_previous_message_bytes = 0;
+  g_binary_previous_message_offset = 0;
+  g_binary_retry_in_arena = 0;
+  binary_start_stream();
+}
+
+void clogging_binary_set_loglevel(enum LogLevel level) {
+  clogging_level_set_thread(&clogging_binary_process_level,
+                            &clogging_binary_thread_level, level);
+}
+
+enum LogLevel clogging_binary_get_loglevel(void) {
+  return clogging_level_get(&clogging_binary_process_level,
+                            clogging_binary_thread_level);
+}
+
+void clogging_binary_set_process_loglevel(enum LogLevel level) {
+  clogging_level_set_process(&clogging_binary_process_level, level);
+}
+
+enum LogLevel clogging_binary_get_process_loglevel(void) {
+  return clogging_level_get_process(&clogging_binary_process_level);
+}
+
+/* Retry the rest of a record which was partially written to the handle
+ * earlier, since nothing else can go out before it.
+ *
+ * Returns 0 when there is nothing left of it, or -1 when the current
+ * message has to be dropped.
+ */
+static int binary_flush_previous(void) {
+  ssize_t remaining_bytes = 0;
+  ssize_t len = 0;
 
   remaining_bytes =
       (g_binary_previous_message_bytes - g_binary_previous_message_offset);
-  if (remaining_bytes > 0) {
-    len = clogging_handle_write(g_binary_handle,
-                &g_binary_previous_message[g_binary_previous_message_offset],
-                remaining_bytes);
-    if (len <= 0) {
-      /* cannot write a thing, so drop the current message,
-       * but still keep the previous message since
-       * the size is already written (and keep it for
-       * another try later).
-       */
-      ++g_binary_num_msg_drops;
-      return;
-    }
-    if (len < remaining_bytes) {
-      g_binary_previous_message_offset += len;
-      /* since this time as well it was partial write
-       * so new message can anyway not be written.
-       * There is no other option other than dropping the
-       * current message.
-       */
-      ++g_binary_num_msg_drops;
-      return;
-    } else {
-      /* previous message is written completely */
-      g_binary_previous_message_bytes = 0;
-      g_binary_previous_message_offset = 0;
-    }
+  if (remaining_bytes <= 0) {
+    return 0;
+  }
+  len = clogging_handle_write(g_binary_handle,
+              (g_binary_retry_in_arena ? g_binary_retry.buf
+                                       : g_binary_previous_message) +
+                  g_binary_previous_message_offset,
+              remaining_bytes);
+  if (len <= 0) {
+    /* cannot write a thing, so drop the current message,
+     * but still keep the previous message since
+     * the size is already written (and keep it for
+     * another try later).
+     */
+    return -1;
+  }
+  if (len < remaining_bytes) {
+    g_binary_previous_message_offset += len;
+    /* since this time as well it was partial write
+     * so new message can anyway not be written.
+     * There is no other option other than dropping the
+     * current message.
+     */
+    return -1;
   }
+  /* previous message is written completely */
+  g_binary_previous_message_bytes = 0;
+  g_binary_previous_message_offset = 0;
+  g_binary_retry_in_arena = 0;
+  return 0;
+}
 
-  /* <length> <timestamp> <hostname> <progname>
-   * <threadname> <pid> <loglevel> <file> <func> <linenum>
-   * [<arg1>, <arg2>, ...] */
+/* Fill <timestamp> <hostname> <progname> <threadname> <pid> at offset,
+ * which all the records start with, or <timestamp> <stream id> with
+ * intern_identity, and return the offset after them or -1 when the
+ * message has to be dropped. With delta_timestamps the <timestamp> is a
+ * varint of the nanoseconds since the last record or TIMEBASE frame.
+ */
+static ssize_t binary_put_record_prefix(char *store, ssize_t offset) {
+  time_t now;
+  clogging_timestamp_t ts;
+  uint64_t ticks = 0;
+  int rc = 0;
 
-  /* first two bytes are used to store the overall length */
-  offset = 2;
-  /* number of seconds since the Epoch, 1970-01-01 00:00:00 +0000 (UTC)
-   */
-  now = time(NULL);
-  if (now == ((time_t)-1)) {
-    /* cannot write a thing, so drop the current message
+  if (g_binary_log_options.delta_timestamps) {
+    /* nanoseconds since the last record, binary_prepare() read the clock */
+    put_varint(store, &offset, (uint64_t)(g_binary_record_ns - g_binary_last_ns));
+  } else if (needs_clock_frame()) {
+    /* raw ticks for CLOGGING_CLOCK_TSC and otherwise the number of
+     * time_precision units since the Epoch, as told by the CLOCK frame.
      */
-    ++g_binary_num_msg_drops;
-    return;
+    if (g_binary_log_options.clock_source == CLOGGING_CLOCK_TSC) {
+      ticks = clogging_clock_read_ticks();
+    } else {
+      clogging_clock_now(g_binary_log_options.clock_source, &ts);
+      ticks = (uint64_t)clogging_timestamp_to_units(
+          &ts, g_binary_log_options.time_precision);
+    }
+    rc = put_uint(store, &offset, ticks, sizeof(ticks), g_binary_encoding);
+  } else {
+    /* number of seconds since the Epoch, 1970-01-01 00:00:00 +0000 (UTC)
+     */
+    now = time(NULL);
+    if (now == ((time_t)-1)) {
+      /* cannot write a thing, so drop the current message
+       */
+      return -1;
+    }
+    rc = put_uint(store, &offset, now, sizeof(now), g_binary_encoding);
   }
-  store[offset++] = 0x80 | sizeof(now);
-  rc = portable_copy(store, &offset, now, sizeof(now));
   if (rc < 0) {
     /* cannot write a thing, so drop the current message
      */
-    ++g_binary_num_msg_drops;
-    return;
+    return -1;
+  }
+  if (g_binary_log_options.intern_identity) {
+    /* the rest is in the IDENTITY frame */
+    put_uint(store, &offset, g_binary_stream_id, sizeof(g_binary_stream_id),
+             g_binary_encoding);
+    return offset;
   }
-  store[offset++] = 0x00 | ((g_binary_hostname_length >> 8) & 0x007f);
-  store[offset++] = g_binary_hostname_length & 0x00ff;
-  memcpy(&store[offset], g_binary_hostname, g_binary_hostname_length);
-  offset += g_binary_hostname_length;
-  store[offset++] = 0x00 | ((g_binary_progname_length >> 8) & 0x007f);
-  store[offset++] = g_binary_progname_length & 0x00ff;
-  memcpy(&store[offset], g_binary_progname, g_binary_progname_length);
-  offset += g_binary_progname_length;
-  store[offset++] = 0x00 | ((g_binary_threadname_length >> 8) & 0x007f);
-  store[offset++] = g_binary_threadname_length & 0x00ff;
-  memcpy(&store[offset], g_binary_threadname, g_binary_threadname_length);
-  offset += g_binary_threadname_length;
-  store[offset++] = 0x80 | sizeof(g_binary_pid);
-  rc = portable_copy(store, &offset, g_binary_pid, sizeof(g_binary_pid));
-  store[offset++] = 0x80 | sizeof(g_binary_level);
-  rc = portable_copy(store, &offset, g_binary_level, sizeof(g_binary_level));
-  store[offset++] = 0x00 | ((filenamelen >> 8) & 0x007f);
-  store[offset++] = filenamelen & 0x00ff;
-  memcpy(&store[offset], filename, filenamelen);
-  offset += filenamelen;
-  store[offset++] = 0x00 | ((funcnamelen >> 8) & 0x007f);
-  store[offset++] = funcnamelen & 0x00ff;
-  memcpy(&store[offset], funcname, funcnamelen);
-  offset += funcnamelen;
-  store[offset++] = 0x80 | sizeof(linenum);
-  rc = portable_copy(store, &offset, linenum, sizeof(linenum));
+  put_bytes(store, &offset, g_binary_hostname, g_binary_hostname_length,
+            g_binary_encoding);
+  put_bytes(store, &offset, g_binary_progname, g_binary_progname_length,
+            g_binary_encoding);
+  put_bytes(store, &offset, g_binary_threadname, g_binary_threadname_length,
+            g_binary_encoding);
+  put_uint(store, &offset, (unsigned int)g_binary_pid, sizeof(g_binary_pid),
+           g_binary_encoding);
+  return offset;
+}
 
-  /* process format and store msg accordingly */
-  va_start(ap, format);
-  offset = fill_variable_arguments(store, offset, format, ap);
-  va_end(ap);
+/* Fill everything of the record but the length and the arguments, that is
+ * <timestamp> <hostname> <progname> <threadname> <pid> <loglevel> <file>
+ * <func> <linenum>, followed by <format id> in a FORMAT_RECORD frame unless
+ * format_id is 0, and return the offset of the arguments or -1 when the
+ * message has to be dropped.
+ */
+static ssize_t binary_begin_record(char *store, const char *filename,
+                                   const char *funcname, int linenum,
+                                   uint32_t format_id) {
+  ssize_t offset = 2;
+  int filenamelen = strlen(filename) & 0x7f;
+  int funcnamelen = strlen(funcname) & 0x7f;
+
+  /* first two bytes are used to store the overall length */
+  if (format_id != 0) {
+    store[offset++] = CLOGGING_BINARY_FRAME_HEADER(
+        g_binary_version, CLOGGING_BINARY_FRAME_FORMAT_RECORD);
+  } else if (g_binary_version == CLOGGING_BINARY_VERSION_2 ||
+             g_binary_log_options.delta_timestamps) {
+    /* a varint <timestamp> cannot tell a record from a frame */
+    store[offset++] = CLOGGING_BINARY_FRAME_HEADER(
+        g_binary_version, CLOGGING_BINARY_FRAME_MESSAGE);
+  }
+  offset = binary_put_record_prefix(store, offset);
   if (offset < 0) {
-    /* format processing failed, drop the message */
-    ++g_binary_num_msg_drops;
-    return;
+    return -1;
   }
-
+  put_uint(store, &offset, clogging_binary_get_loglevel(),
+           sizeof(enum LogLevel), g_binary_encoding);
+  put_bytes(store, &offset, filename, filenamelen, g_binary_encoding);
+  put_bytes(store, &offset, funcname, funcnamelen, g_binary_encoding);
+  put_uint(store, &offset, (unsigned int)linenum, sizeof(linenum),
+           g_binary_encoding);
+  if (format_id != 0) {
+    put_uint(store, &offset, format_id, sizeof(format_id), g_binary_encoding);
+  }
+  return offset;
+}
+
+/* Write head_len bytes of head followed by the store from byte from up
+ * to offset, along with the arguments in g_binary_segments in their
+ * places, in a single clogging_handle_writev(). Only the unsent rest of
+ * a partial write is copied, to g_binary_retry.
+ *
+ * Returns -1 when nothing can be written, and 0 when everything is
+ * written or the rest of it is left to binary_flush_previous().
+ */
+static int binary_write_segments(const char *head, size_t head_len,
+                                 const char *store, ssize_t from,
+                                 ssize_t offset) {
+  clogging_iovec_t iov[2 * MAX_BINARY_SEGMENTS + 2];
+  ssize_t total = (ssize_t)head_len + (offset - from) +
+                  (ssize_t)g_binary_segment_bytes;
+  ssize_t written = 0;
+  size_t skip = 0;
+  char *tail = NULL;
+  int cnt = 0;
+  int i = 0;
+
+  if (head_len > 0) {
+    iov[cnt].base = head;
+    iov[cnt++].len = head_len;
+  }
+  for (i = 0; i < g_binary_num_segments; ++i) {
+    iov[cnt].base = store + from;
+    iov[cnt++].len = (size_t)(g_binary_segments[i].offset - from);
+    iov[cnt].base = g_binary_segments[i].data;
+    iov[cnt++].len = g_binary_segments[i].len;
+    from = g_binary_segments[i].offset;
+  }
+  iov[cnt].base = store + from;
+  iov[cnt++].len = (size_t)(offset - from);
+
+  written = clogging_handle_writev(g_binary_handle, iov, cnt);
+  if (written < 0) {
+    return -1;
+  }
+  if (written == total) {
+    return 0;
+  }
+  /* the arguments may be gone by the time the rest is retried */
+  if (clogging_arena_reserve(&g_binary_retry, (int)(total - written)) <
+      total - written) {
+    /* the stream is broken either way */
+    return -1;
+  }
+  tail = g_binary_retry.buf;
+  skip = (size_t)written;
+  for (i = 0; i < cnt; ++i) {
+    if (skip >= iov[i].len) {
+      skip -= iov[i].len;
+      continue;
+    }
+    memcpy(tail, (const char *)iov[i].base + skip, iov[i].len - skip);
+    tail += iov[i].len - skip;
+    skip = 0;
+  }
+  g_binary_retry_in_arena = 1;
+  g_binary_previous_message_offset = 0;
+  g_binary_previous_message_bytes = total - written;
+  return 0;
+}
+
+/* Write the store from byte 2 up to offset, which is what it holds of
+ * the record being built, along with g_binary_segments, as its next
+ * CONTINUATION frame, or its last one when last is set.
+ *
+ * Returns -1 when the frame is dropped, which leaves the rest of the
+ * record nowhere to go.
+ */
+static int binary_write_chunk(const char *store, ssize_t offset, int last) {
+  char head[MAX_CHUNK_HEADER_BYTES];
+  ssize_t head_len = 2;
+  ssize_t len = 0;
+  int rc = 0;
+
+  /* the rest of the previous frame goes first */
+  if (binary_flush_previous() < 0) {
+    return -1;
+  }
+  head[head_len++] = CLOGGING_BINARY_FRAME_HEADER(
+      g_binary_version, CLOGGING_BINARY_FRAME_CONTINUATION);
+  put_uint(head, &head_len, g_binary_stream_id, sizeof(g_binary_stream_id),
+           g_binary_encoding);
+  put_uint(head, &head_len, g_binary_chunk_index,
+           sizeof(g_binary_chunk_index), g_binary_encoding);
+  put_uint(head, &head_len, last, 1, g_binary_encoding);
+  len = head_len - 2 + (offset - 2) + (ssize_t)g_binary_segment_bytes;
+  head[0] = (len >> 8) & 0x00ff;
+  head[1] = (len & 0x00ff);
+  ++g_binary_chunk_index;
+
+  if (g_binary_shm_ring != NULL) {
+    /* no segments, a ring takes a copy of the frame anyway */
+    memcpy(g_binary_chunk, head, (size_t)head_len);
+    memcpy(&g_binary_chunk[head_len], &store[2], (size_t)(offset - 2));
+    return (clogging_shm_ring_write(g_binary_shm_ring, g_binary_chunk,
+                                    head_len + offset - 2) < 0)
+               ? -1
+               : 0;
+  }
+  rc = binary_write_segments(head, (size_t)head_len, store, 2, offset);
+  g_binary_num_segments = 0;
+  g_binary_segment_bytes = 0;
+  return rc;
+}
+
+/* Make room in the store for the rest of the record being built, which
+ * does not fit in a frame of its own, by writing what it holds as a
+ * CONTINUATION frame.
+ *
+ * Returns -1 when the record has to be dropped.
+ */
+static int binary_flush_chunk(char *store, ssize_t *offset) {
+  if (binary_write_chunk(store, *offset, 0) < 0) {
+    return -1;
+  }
+  *offset = 2;
+  return 0;
+}
+
+/* Fill the length of the record of offset bytes and write it out.
+ *
+ * Returns -1 when the record is dropped, and 0 when it is written or
+ * the rest of it is left to binary_flush_previous().
+ */
+static int binary_finish_record(char *store, ssize_t offset) {
+  ssize_t len = 0;
+  ssize_t bytes_written = 0;
+  int rc = 0;
+
   /* now that the total length is known so lets fill the
    * size of the payload (without the bytes occupied
    * by the length itself).
    */
   /* encode the length in big-endian format */
   /* offset includes the size of length itself so subtract that. */
-  len = offset - 2;
+  len = offset - 2 + (ssize_t)g_binary_segment_bytes;
   store[0] = (len >> 8) & 0x00ff;
   store[1] = (len & 0x00ff);
 
+  if (g_binary_chunk_index > 0) {
+    /* the rest of a record which did not fit in a frame */
+    rc = binary_write_chunk(store, offset, 1);
+    g_binary_chunk_index = 0;
+    if (rc < 0) {
+      ++g_binary_num_msg_drops;
+    }
+    return rc;
+  }
+
+  if (g_binary_num_segments > 0) {
+    rc = binary_write_segments(NULL, 0, store, 0, offset);
+    g_binary_num_segments = 0;
+    g_binary_segment_bytes = 0;
+    if (rc < 0) {
+      ++g_binary_num_msg_drops;
+    }
+    return rc;
+  }
+
+  if (g_binary_shm_ring != NULL) {
+    /* never partial, the record either makes it or is dropped */
+    if (clogging_shm_ring_write(g_binary_shm_ring, store, offset) < 0) {
+      ++g_binary_num_msg_drops;
+      return -1;
+    }
+    return 0;
+  }
+
   bytes_written = clogging_handle_write(g_binary_handle, store, offset);
   if (bytes_written < 0) {
     /* just ignore stuff because we cannot write a
      * single bit.
      */
     ++g_binary_num_msg_drops;
+    return -1;
+  } else if (bytes_written < offset) {
+    /* the rest is retried from where the write stopped */
+    g_binary_previous_message_offset = bytes_written;
+    g_binary_previous_message_bytes = offset;
+  } else {
+    g_binary_previous_message_offset = 0;
+    g_binary_previous_message_bytes = 0;
+  }
+  return 0;
+}
+
+/* Same as binary_finish_record() for a record or TIMEBASE frame, which
+ * the next <timestamp> is a delta from with delta_timestamps.
+ */
+static int binary_finish_timed_record(char *store, ssize_t offset) {
+  if (binary_finish_record(store, offset) < 0) {
+    return -1;
+  }
+  g_binary_last_ns = g_binary_record_ns;
+  return 0;
+}
+
+/* <length> <header> <stream id> <sec> <nsec> */
+static int binary_write_timebase_frame(char *store,
+                                       const clogging_timestamp_t *ts) {
+  ssize_t offset = 2;
+
+  store[offset++] = CLOGGING_BINARY_FRAME_HEADER(
+      g_binary_version, CLOGGING_BINARY_FRAME_TIMEBASE);
+  put_uint(store, &offset, g_binary_stream_id, sizeof(g_binary_stream_id),
+           g_binary_encoding);
+  put_uint(store, &offset, (uint64_t)ts->sec, sizeof(ts->sec),
+           g_binary_encoding);
+  put_uint(store, &offset, ts->nsec, sizeof(ts->nsec), g_binary_encoding);
+  return binary_finish_timed_record(store, offset);
+}
+
+/* Get ready to log a message into store: write the rest of the previous
+ * record, and with delta_timestamps read the clock for the record and
+ * write a TIMEBASE frame first when the delta would not be short or
+ * there is none yet (or the clock went back).
+ *
+ * Returns 0 when the message can be built in store, or -1 when it has to
+ * be dropped.
+ */
+static int binary_prepare(char *store) {
+  clogging_timestamp_t ts;
+
+  /* anything left of a message dropped while being built */
+  g_binary_num_segments = 0;
+  g_binary_segment_bytes = 0;
+  g_binary_chunk_index = 0;
+  if (binary_flush_previous() < 0) {
+    return -1;
+  }
+  if (!g_binary_stream_started) {
+    /* the records cannot be decoded without the frames of the stream */
+    binary_start_stream();
+    if (!g_binary_stream_started || g_binary_previous_message_bytes > 0) {
+      return -1;
+    }
+  }
+  if (!g_binary_log_options.delta_timestamps) {
+    return 0;
+  }
+  clogging_clock_now(g_binary_log_options.clock_source, &ts);
+  g_binary_record_ns = clogging_timestamp_to_units(
+      &ts, CLOGGING_TIME_PRECISION_NS);
+  if (g_binary_has_timebase && g_binary_record_ns >= g_binary_last_ns &&
+      g_binary_record_ns - g_binary_last_ns <
+          CLOGGING_BINARY_TIMEBASE_INTERVAL_NS) {
+    return 0;
+  }
+  if (binary_write_timebase_frame(store, &ts) < 0) {
+    /* the delta would be from a base the decoder never heard of */
+    return -1;
+  }
+  g_binary_has_timebase = 1;
+  if (g_binary_previous_message_bytes > 0) {
+    /* the rest of the TIMEBASE frame is still in the store */
+    return -1;
+  }
+  return 0;
+}
+
+/* Store s with put_bytes(), cut short to what fits within capacity bytes
+ * of the store.
+ */
+static ssize_t put_frame_string(char *store, ssize_t offset,
+                                ssize_t capacity, const char *s) {
+  size_t s_len = strlen(s) & 0x7fff; /* max len of 15 bits */
+
+  /* the length takes 2 bytes at most in either version */
+  if (offset + 2 + (ssize_t)s_len > capacity) {
+    s_len = (capacity > offset + 2) ? (size_t)(capacity - offset - 2) : 0;
+  }
+  put_bytes(store, &offset, s, s_len, g_binary_encoding);
+  return offset;
+}
+
+/* Get the number of slots of g_binary_formats, a power of 2. */
+static int binary_format_slots(void) {
+  int slots = 1;
+
+  if (g_binary_formats.buf == NULL) {
+    return 0;
+  }
+  while (slots * 2 * (int)sizeof(struct binary_format_entry) <=
+         g_binary_formats.size) {
+    slots *= 2;
+  }
+  return slots;
+}
+
+static size_t binary_format_hash(const char *format) {
+  /* the low bits of an address are mostly alignment */
+  return (size_t)(((uint64_t)(uintptr_t)format * 0x9e3779b97f4a7c15ULL) >>
+                  32);
+}
+
+/* Get the id this thread interned format with, or 0 when it has not. */
+static uint32_t binary_format_lookup(const char *format) {
+  struct binary_format_entry *table =
+      (struct binary_format_entry *)g_binary_formats.buf;
+  int slots = binary_format_slots();
+  size_t i = 0;
+
+  if (slots == 0) {
+    return 0;
+  }
+  i = binary_format_hash(format) & (slots - 1);
+  while (table[i].format != NULL) {
+    if (table[i].format == format) {
+      return table[i].id;
+    }
+    i = (i + 1) & (slots - 1);
+  }
+  return 0;
+}
+
+static void binary_format_put(struct binary_format_entry *table, int slots,
+                              const char *format, uint32_t id) {
+  size_t i = binary_format_hash(format) & (slots - 1);
+
+  while (table[i].format != NULL) {
+    i = (i + 1) & (slots - 1);
+  }
+  table[i].format = format;
+  table[i].id = id;
+}
+
+/* Remember that format is interned as id, growing the table when it is
+ * three quarters full. A thread which runs out of room interns the
+ * formats it cannot remember every time instead.
+ */
+static void binary_format_insert(const char *format, uint32_t id) {
+  struct binary_format_entry *old_table = NULL;
+  int old_slots = binary_format_slots();
+  int old_size = g_binary_formats.size;
+  int slots = 0;
+  int i = 0;
+
+  if ((g_binary_num_formats + 1) * 4 > old_slots * 3) {
+    if (old_slots > 0) {
+      old_table = (struct binary_format_entry *)malloc((size_t)old_size);
+      if (old_table == NULL) {
+        return;
+      }
+      memcpy(old_table, g_binary_formats.buf, (size_t)old_size);
+    }
+    if (clogging_arena_reserve(&g_binary_formats,
+                               (old_size > 0) ? old_size * 2
+                                              : CLOGGING_ARENA_MIN_BYTES) >
+        old_size) {
+      memset(g_binary_formats.buf, 0, g_binary_formats.size);
+      slots = binary_format_slots();
+      for (i = 0; i < old_slots; ++i) {
+        if (old_table[i].format != NULL) {
+          binary_format_put((struct binary_format_entry *)g_binary_formats.buf,
+                            slots, old_table[i].format, old_table[i].id);
+        }
+      }
+    }
+    free(old_table);
+  }
+  slots = binary_format_slots();
+  if ((g_binary_num_formats + 1) * 4 > slots * 3) {
+    return;
+  }
+  binary_format_put((struct binary_format_entry *)g_binary_formats.buf, slots,
+                    format, id);
+  ++g_binary_num_formats;
+}
+
+/* Get the id of format in *id, writing its FORMAT frame first when this
+ * thread has not interned it yet.
+ *
+ * Returns -1 when the message has to be dropped.
+ */
+static int binary_intern_format(char *store, const char *format,
+                                uint32_t *id) {
+  ssize_t offset = 2;
+
+  *id = binary_format_lookup(format);
+  if (*id != 0) {
+    return 0;
+  }
+  *id = atomic_fetch_add_explicit(&g_binary_last_format_id, 1,
+                                  memory_order_relaxed) + 1;
+
+  /* <length> <header> <format id> <format> */
+  store[offset++] = CLOGGING_BINARY_FRAME_HEADER(g_binary_version,
+                                                 CLOGGING_BINARY_FRAME_FORMAT);
+  put_uint(store, &offset, *id, sizeof(*id), g_binary_encoding);
+  offset = put_frame_string(store, offset, TOTAL_MSG_BYTES, format);
+  if (binary_finish_record(store, offset) < 0) {
+    /* the record would refer to a format the decoder never heard of */
+    return -1;
+  }
+  binary_format_insert(format, *id);
+  /* the rest of the FORMAT frame is still in the store */
+  return (g_binary_previous_message_bytes > 0) ? -1 : 0;
+}
+
+/* The record of clogging_binary_logmsg(), followed by a blob argument
+ * when blob is not NULL.
+ */
+static void binary_log_message(const char *filename, const char *funcname,
+                               int linenum, enum LogLevel level,
+                               const void *blob, size_t blob_len,
+                               const char *format, va_list ap) {
+  char *store = g_binary_previous_message;
+  ssize_t offset = 0;
+  uint32_t format_id = 0;
+
+  /* ignore logs which are filtered out */
+  if (clogging_level_filtered_out(&level, &clogging_binary_process_level,
+                                  clogging_binary_thread_level)) {
+    return;
+  }
+
+  if (g_binary_is_logging_initialized <= 0) {
+    fprintf(stderr, "logging is not initialized yet\n");
+    ++g_binary_num_msg_drops;
+    return;
+  }
+
+  if (binary_prepare(store) < 0) {
+    ++g_binary_num_msg_drops;
+    return;
+  }
+
+  if (g_binary_log_options.intern_formats &&
+      binary_intern_format(store, format, &format_id) < 0) {
+    ++g_binary_num_msg_drops;
+    return;
+  }
+
+  /* <length> <timestamp> <hostname> <progname>
+   * <threadname> <pid> <loglevel> <file> <func> <linenum>
+   * [<arg1>, <arg2>, ...] */
+  offset = binary_begin_record(store, filename, funcname, linenum, format_id);
+  if (offset < 0) {
+    ++g_binary_num_msg_drops;
+    return;
+  }
+
+  /* process format and store msg accordingly */
+  offset = fill_variable_arguments(store, offset, TOTAL_MSG_BYTES, format,
+                                   g_binary_encoding, ap);
+  if (offset < 0) {
+    /* format processing failed, drop the message */
+    ++g_binary_num_msg_drops;
+    return;
+  }
+  if (blob != NULL &&
+      ((blob_len > 0x7fff && /* max len of 15 bits */
+        !(g_binary_encoding & BINARY_CHUNKED)) ||
+       put_arg_data(store, &offset, TOTAL_MSG_BYTES, BINARY_LOG_VAR_ARG_BLOB,
+                    (const char *)blob, blob_len, g_binary_encoding) < 0)) {
+    ++g_binary_num_msg_drops;
+    return;
+  }
+
+  (void)binary_finish_timed_record(store, offset);
+}
+
+void clogging_binary_logmsg(const char *filename, const char *funcname,
+                            int linenum, enum LogLevel level,
+                            const char *format, ...) {
+  va_list ap;
+
+  va_start(ap, format);
+  binary_log_message(filename, funcname, linenum, level, NULL, 0, format, ap);
+  va_end(ap);
+}
+
+void clogging_binary_log_blob(const char *filename, const char *funcname,
+                              int linenum, enum LogLevel level,
+                              const void *blob, size_t blob_len,
+                              const char *format, ...) {
+  va_list ap;
+
+  va_start(ap, format);
+  binary_log_message(filename, funcname, linenum, level,
+                     (blob != NULL) ? blob : "", blob_len, format, ap);
+  va_end(ap);
+}
+
+void clogging_binary_log_typed(const char *filename, const char *funcname,
+                               int linenum, enum LogLevel level,
+                               const uint8_t *desc, const char *format, ...) {
+  va_list ap;
+  char *store = g_binary_previous_message;
+  ssize_t offset = 0;
+  uint32_t format_id = 0;
+
+  /* ignore logs which are filtered out */
+  if (clogging_level_filtered_out(&level, &clogging_binary_process_level,
+                                  clogging_binary_thread_level)) {
+    return;
+  }
+
+  if (g_binary_is_logging_initialized <= 0) {
+    fprintf(stderr, "logging is not initialized yet\n");
+    ++g_binary_num_msg_drops;
+    return;
+  }
+
+  if (binary_prepare(store) < 0) {
+    ++g_binary_num_msg_drops;
+    return;
+  }
+
+  if (g_binary_log_options.intern_formats &&
+      binary_intern_format(store, format, &format_id) < 0) {
+    ++g_binary_num_msg_drops;
+    return;
+  }
+
+  offset = binary_begin_record(store, filename, funcname, linenum, format_id);
+  if (offset < 0) {
+    ++g_binary_num_msg_drops;
+    return;
+  }
+
+  /* the arguments are told by desc, so format is not even looked at */
+  va_start(ap, format);
+  offset = fill_typed_arguments(store, offset, TOTAL_MSG_BYTES, desc, format,
+                                g_binary_encoding, ap);
+  va_end(ap);
+  if (offset < 0) {
+    ++g_binary_num_msg_drops;
+    return;
+  }
+
+  (void)binary_finish_timed_record(store, offset);
+}
+
+/* Get the id of site, numbering it when it logs for the first time. */
+static uint32_t binary_site_id(const clogging_binary_site_t *site) {
+  uint_least32_t id = atomic_load_explicit(site->id, memory_order_acquire);
+  uint_least32_t new_id = 0;
+
+  if (id != 0) {
+    return (uint32_t)id;
+  }
+  new_id = atomic_fetch_add_explicit(&g_binary_last_site_id, 1,
+                                     memory_order_relaxed) + 1;
+  /* another thread may have numbered it meanwhile, its id wins then */
+  if (atomic_compare_exchange_strong_explicit(site->id, &id, new_id,
+                                              memory_order_acq_rel,
+                                              memory_order_acquire)) {
+    id = new_id;
+  }
+  return (uint32_t)id;
+}
+
+/* Tell whether this thread has written the SITE frame of id already,
+ * remembering that it has when mark is set. A thread with too many sites
+ * to keep track of simply writes the SITE frame each time.
+ */
+static int binary_site_sent(uint32_t id, int mark) {
+  int byte = (int)(id >> 3);
+  int old_size = g_binary_sites_sent.size;
+  int size = 0;
+
+  if (byte >= old_size) {
+    if (!mark) {
+      return 0;
+    }
+    size = clogging_arena_reserve(&g_binary_sites_sent, byte + 1);
+    if (size <= byte) {
+      return 0;
+    }
+    memset(g_binary_sites_sent.buf + old_size, 0, size - old_size);
+  }
+  if (mark) {
+    g_binary_sites_sent.buf[byte] |= (char)(1 << (id & 7));
+  }
+  return (g_binary_sites_sent.buf[byte] >> (id & 7)) & 1;
+}
+
+/* <length> <header> <site id> <loglevel> <file> <func> <linenum> <format> */
+static int binary_write_site_frame(char *store,
+                                   const clogging_binary_site_t *site,
+                                   uint32_t id) {
+  ssize_t offset = 2;
+  /* leave room for <linenum> and the <format> length after <func> */
+  ssize_t names_capacity = TOTAL_MSG_BYTES - (1 + sizeof(site->linenum)) - 2;
+
+  store[offset++] = CLOGGING_BINARY_FRAME_HEADER(g_binary_version,
+                                                 CLOGGING_BINARY_FRAME_SITE);
+  put_uint(store, &offset, id, sizeof(id), g_binary_encoding);
+  put_uint(store, &offset, site->level, sizeof(site->level), g_binary_encoding);
+  offset = put_frame_string(store, offset, names_capacity, site->filename);
+  offset = put_frame_string(store, offset, names_capacity, site->funcname);
+  put_uint(store, &offset, (unsigned int)site->linenum, sizeof(site->linenum),
+           g_binary_encoding);
+  offset = put_frame_string(store, offset, TOTAL_MSG_BYTES, site->format);
+  return binary_finish_record(store, offset);
+}
+
+void clogging_binary_log_site(const clogging_binary_site_t *site, ...) {
+  va_list ap;
+  char *store = g_binary_previous_message;
+  ssize_t offset = 0;
+  uint32_t id = 0;
+
+  /* only called by the BINARY_LOG macros, which checked the level along
+   * with the filters
+   */
+  if (g_binary_is_logging_initialized <= 0) {
+    fprintf(stderr, "logging is not initialized yet\n");
+    ++g_binary_num_msg_drops;
+    return;
+  }
+
+  if (binary_prepare(store) < 0) {
+    ++g_binary_num_msg_drops;
+    return;
+  }
+
+  id = binary_site_id(site);
+  if (!binary_site_sent(id, 0)) {
+    if (binary_write_site_frame(store, site, id) < 0) {
+      /* the record would refer to a site the decoder never heard of */
+      ++g_binary_num_msg_drops;
+      return;
+    }
+    (void)binary_site_sent(id, 1);
+    if (g_binary_previous_message_bytes > 0) {
+      /* the rest of the SITE frame is still in the store */
+      ++g_binary_num_msg_drops;
+      return;
+    }
+  }
+
+  /* <length> <header> <timestamp> <hostname> <progname> <threadname> <pid>
+   * <site id> [<arg1>, <arg2>, ...] */
+  store[2] = CLOGGING_BINARY_FRAME_HEADER(g_binary_version,
+                                          CLOGGING_BINARY_FRAME_RECORD);
+  offset = binary_put_record_prefix(store, 3);
+  if (offset < 0) {
+    ++g_binary_num_msg_drops;
+    return;
+  }
+  put_uint(store, &offset, id, sizeof(id), g_binary_encoding);
+
+  va_start(ap, site);
+  offset = fill_typed_arguments(store, offset, TOTAL_MSG_BYTES, site->desc,
+                                site->format, g_binary_encoding, ap);
+  va_end(ap);
+  if (offset < 0) {
+    ++g_binary_num_msg_drops;
     return;
-  } else if (bytes_written < offset) {
-    g_binary_previous_message_offset = offset - bytes_written;
-    g_binary_previous_message_bytes = offset;
-  } else {
-    g_binary_previous_message_offset = 0;
-    g_binary_previous_message_bytes = 0;
   }
+
+  (void)binary_finish_timed_record(store, offset);
 }
 
 uint64_t clogging_binary_get_num_dropped_messages(void) {
   return g_binary_num_msg_drops;
 }
 
+ssize_t clogging_binary_capture_arguments(char *store, ssize_t offset,
+                                          ssize_t capacity,
+                                          const char *format, va_list ap) {
+  /* the renderer only knows CLOGGING_BINARY_VERSION_1 */
+  return fill_variable_arguments(store, offset, capacity, format,
+                                 CLOGGING_BINARY_VERSION_1 |
+                                     BINARY_LONG_STRINGS,
+                                 ap);
+}
+
 /* return the modified offset back to the caller indicating
- * the number of bytes written in the store
+ * the number of bytes written in the store, or -1 when the
+ * arguments do not fit within capacity bytes of the store.
  */
-static ssize_t fill_variable_arguments(char *store, ssize_t offset, const char *format,
-                                       va_list ap) {
+static ssize_t fill_variable_arguments(char *store, ssize_t offset,
+                                       ssize_t capacity, const char *format,
+                                       int version, va_list ap) {
   long double ldbl = (long double)0.0;
   double dbl = 0.0;
   unsigned long long llval = 0LLU;
@@ -405,9 +1699,10 @@ static ssize_t fill_variable_arguments(char *store, ssize_t offset, const char *
   char *tmp_s = NULL;
   void *tmp_p = NULL;
   int *tmp_n = NULL;
+  const char *nul = NULL;
+  long precision = -1; /* of the conversion, when given */
   int rc = 0;
-  int i = 0;
-  char *tmp_d = NULL;
+  int bytes = 0;
 
   /* TODO FIXME cross validate that the format specifier
    * contains the same number of specifiers as the variable arguments.
@@ -421,6 +1716,7 @@ static ssize_t fill_variable_arguments(char *store, ssize_t offset, const char *
       }
       /* else */
       is_type_specifier = 1;
+      precision = -1;
       ++tmp;
       continue;
     }
@@ -429,25 +1725,19 @@ static ssize_t fill_variable_arguments(char *store, ssize_t offset, const char *
      */
     switch (*tmp) {
     case 'c': /* char */
-      /* need a cast here since va_arg only
-      takes fully promoted types */
-      llval = va_arg(ap, unsigned long long);
-      store[offset++] = BINARY_LOG_VAR_ARG_INTEGER & 0x00ff;
+      if (reserve_scalar_arg(store, &offset, capacity, version) < 0) {
+        return -1;
+      }
+      /* of the promoted type, int, or wint_t for %lc */
       if (lspecifier == LS_L) {
-        /* store the size in bytes before the value */
-        store[offset] = 0x80 | sizeof(int);
-        ++offset;
-        rc = portable_copy(store, &offset, llval, sizeof(int));
-        if (rc < 0) {
-          return -1;
-        }
-        /* offset is automatically updated */
+        llval = (unsigned long long)va_arg(ap, wint_t);
       } else {
-        /* store the size in bytes before the value */
-        store[offset] = 0x80 | 1;
-        ++offset;
-        store[offset] = llval & 0x00ff;
-        ++offset;
+        llval = (unsigned long long)va_arg(ap, int);
+      }
+      bytes = (lspecifier == LS_L) ? (int)sizeof(int) : 1;
+      rc = put_arg_integer(store, &offset, llval, bytes, version);
+      if (rc < 0) {
+        return -1;
       }
       is_type_specifier = 0;
       lspecifier = LS_NONE;
@@ -458,70 +1748,31 @@ static ssize_t fill_variable_arguments(char *store, ssize_t offset, const char *
     case 'X': /* unsigned */
     case 'd':
     case 'i': /* int */
-      llval = va_arg(ap, unsigned long long);
-      store[offset++] = BINARY_LOG_VAR_ARG_INTEGER & 0x00ff;
+      if (reserve_scalar_arg(store, &offset, capacity, version) < 0) {
+        return -1;
+      }
+      llval = VA_ARG_INTEGER(ap, lspecifier, *tmp == 'd' || *tmp == 'i');
+      /* the size of the value follows the length specifier */
       if (lspecifier == LS_HH) {
-        /* store the size in bytes before the value */
-        store[offset] = 0x80 | 1;
-        ++offset;
-        store[offset] = llval & 0x00ff;
-        ++offset;
+        bytes = 1;
       } else if (lspecifier == LS_H) {
-        /* store the size in bytes before the value */
-        store[offset] = 0x80 | sizeof(short int);
-        ++offset;
-        rc = portable_copy(store, &offset, llval, sizeof(short int));
-        if (rc < 0) {
-          return -1;
-        }
+        bytes = sizeof(short int);
       } else if (lspecifier == LS_L) {
-        /* store the size in bytes before the value */
-        store[offset] = 0x80 | sizeof(long int);
-        ++offset;
-        rc = portable_copy(store, &offset, llval, sizeof(long int));
-        if (rc < 0) {
-          return -1;
-        }
+        bytes = sizeof(long int);
       } else if (lspecifier == LS_LL) {
-        /* store the size in bytes before the value */
-        store[offset] = 0x80 | sizeof(long long int);
-        ++offset;
-        rc = portable_copy(store, &offset, llval, sizeof(long long int));
-        if (rc < 0) {
-          return -1;
-        }
+        bytes = sizeof(long long int);
       } else if (lspecifier == LS_J) {
-        /* store the size in bytes before the value */
-        store[offset] = 0x80 | sizeof(intmax_t);
-        ++offset;
-        rc = portable_copy(store, &offset, llval, sizeof(intmax_t));
-        if (rc < 0) {
-          return -1;
-        }
+        bytes = sizeof(intmax_t);
       } else if (lspecifier == LS_Z) {
-        /* store the size in bytes before the value */
-        store[offset] = 0x80 | sizeof(size_t);
-        ++offset;
-        rc = portable_copy(store, &offset, llval, sizeof(size_t));
-        if (rc < 0) {
-          return -1;
-        }
+        bytes = sizeof(size_t);
       } else if (lspecifier == LS_T) {
-        /* store the size in bytes before the value */
-        store[offset] = 0x80 | sizeof(ptrdiff_t);
-        ++offset;
-        rc = portable_copy(store, &offset, llval, sizeof(ptrdiff_t));
-        if (rc < 0) {
-          return -1;
-        }
+        bytes = sizeof(ptrdiff_t);
       } else {
-        /* store the size in bytes before the value */
-        store[offset] = 0x80 | sizeof(int);
-        ++offset;
-        rc = portable_copy(store, &offset, llval, sizeof(int));
-        if (rc < 0) {
-          return -1;
-        }
+        bytes = sizeof(int);
+      }
+      rc = put_arg_integer(store, &offset, llval, bytes, version);
+      if (rc < 0) {
+        return -1;
       }
       is_type_specifier = 0;
       lspecifier = LS_NONE;
@@ -547,105 +1798,74 @@ static ssize_t fill_variable_arguments(char *store, ssize_t offset, const char *
   * | binary128|Quadruple  | 2    | 113    | −16382| +16383| 34.02    | 4931.77   |
   * +----------+-----------+------+--------+-------+-------+----------+-----------+
   * */
-      store[offset++] = BINARY_LOG_VAR_ARG_DOUBLE & 0x00ff;
+      if (reserve_scalar_arg(store, &offset, capacity, version) < 0) {
+        return -1;
+      }
+      /* big-endian unless BINARY_NATIVE_ENDIAN */
       if (lspecifier == LS_CAP_L) {
         ldbl = va_arg(ap, long double);
-        /* store the size in bytes before the value */
-        store[offset] = 0x80 | sizeof(long double);
-        ++offset;
-        /* always store in big-endian format */
-#if IS_LITTLE_ENDIAN
-        tmp_d = (char *)&ldbl;
-        i = sizeof(long double) - 1;
-        while (i >= 0) {
-          store[offset++] = tmp_d[i] & 0x00ff;
-          --i;
-        }
-#else /* ?IS_LITTLE_ENDIAN */
-        memcpy(&store[offset], &ldbl, sizeof(long double));
-        offset += sizeof(long double);
-#endif /* IS_LITTLE_ENDIAN */
+        put_arg_tag(store, &offset, BINARY_LOG_VAR_ARG_DOUBLE,
+                    sizeof(long double), version);
+        put_raw(store, &offset, &ldbl, sizeof(long double), version);
       } else {
         dbl = va_arg(ap, double);
-        /* store the size in bytes before the value */
-        store[offset] = 0x80 | sizeof(double);
-        ++offset;
-        /* always store in big-endian format */
-#if IS_LITTLE_ENDIAN
-        tmp_d = (char *)&dbl;
-        i = sizeof(double) - 1;
-        while (i >= 0) {
-          store[offset++] = tmp_d[i] & 0x00ff;
-          --i;
-        }
-#else /* ?IS_LITTLE_ENDIAN */
-        memcpy(&store[offset], &dbl, sizeof(double));
-        offset += sizeof(double);
-#endif /* IS_LITTLE_ENDIAN */
+        put_arg_tag(store, &offset, BINARY_LOG_VAR_ARG_DOUBLE, sizeof(double),
+                    version);
+        put_raw(store, &offset, &dbl, sizeof(double), version);
       }
       is_type_specifier = 0;
       lspecifier = LS_NONE;
       break;
     case 's': /* char* */
-      /* TODO FIXME, alternatively why not use
-       * writev() instead of copying the contents of the
-       * string into private buffer?
-       * This approach is optimal though results into
-       * an issue with partial write, which can be
-       * complex to fix.
+      /* long strings are written from where they are with writev()
+       * rather than copied, see put_arg_data()
        */
       tmp_s = va_arg(ap, char *);
+      if (tmp_s == NULL) {
+        /* same as what printf() family prints */
+        tmp_s = "(null)";
+      }
 
-      store[offset++] = BINARY_LOG_VAR_ARG_STRING & 0x00ff;
-
-      /* There is a chance that things can crash if the
-       * string is not null terminated.
-       * TODO FIXME add a mechanism to restict
-       * to a maximum size if going out of bounds.
+      /* with a precision, as in "%.*s", at most that many bytes are
+       * read, so the string need not be null terminated
        */
-      size_t s_len = strlen(tmp_s);
+      size_t s_len = 0;
+      if (precision >= 0) {
+        nul = (const char *)memchr(tmp_s, '\0', (size_t)precision);
+        s_len = (nul != NULL) ? (size_t)(nul - tmp_s) : (size_t)precision;
+      } else {
+        s_len = strlen(tmp_s);
+      }
       /* store the size in bytes before the value */
       /* TODO FIXME the size of the string cannot be
        * greater than 2^15-1, which is a large
        * value so should not matter but something
        * which should be documented.
        */
-      s_len = s_len & 0x7fff; /* max len of 15 bits */
-      store[offset++] = 0x00 | ((s_len >> 8) & 0x7f);
-      store[offset++] = s_len & 0x00ff;
-      /* TODO FIXME validate whether the contents will
-       * fit in the store. At present lets assume that
-       * there is no issue with size and continue
-       * at all places.
-       */
+      if (!(version & (BINARY_CHUNKED | BINARY_LONG_STRINGS))) {
+        s_len = s_len & 0x7fff; /* max len of 15 bits */
+      }
       /* copy but dont include '\0' character at the end */
-      memcpy(&store[offset], tmp_s, s_len);
-      offset += s_len;
+      if (put_arg_data(store, &offset, capacity, BINARY_LOG_VAR_ARG_STRING,
+                       tmp_s, s_len, version) < 0) {
+        return -1;
+      }
       is_type_specifier = 0;
       lspecifier = LS_NONE;
       break;
     case 'p': /* void* */
+      if (reserve_scalar_arg(store, &offset, capacity, version) < 0) {
+        return -1;
+      }
       tmp_p = va_arg(ap, void *);
-      store[offset++] = BINARY_LOG_VAR_ARG_POINTER & 0x00ff;
       /* The idea is to print the address stored within
        * tmp_p for logging rather than access the
        * contents there.
        */
-      /* store the size in bytes before the value */
-      store[offset] = 0x80 | sizeof(tmp_p);
-      ++offset;
-      /* always store in big-endian */
-#if IS_LITTLE_ENDIAN
-      tmp_d = (char *)&tmp_p;
-      i = sizeof(tmp_p) - 1;
-      while (i >= 0) {
-        store[offset++] = tmp_d[i] & 0x00ff;
-        --i;
-      }
-#else /* ?IS_LITTLE_ENDIAN */
-      memcpy(&store[offset], &tmp_p, sizeof(tmp_p));
-      offset += sizeof(tmp_p);
-#endif /* IS_LITTLE_ENDIAN */
+      put_arg_tag(store, &offset, BINARY_LOG_VAR_ARG_POINTER, sizeof(tmp_p),
+                  version);
+      /* big-endian unless BINARY_NATIVE_ENDIAN */
+      put_raw(store, &offset, &tmp_p, sizeof(tmp_p), version);
       is_type_specifier = 0;
       lspecifier = LS_NONE;
       break;
@@ -663,21 +1883,33 @@ static ssize_t fill_variable_arguments(char *store, ssize_t offset, const char *
     case '.': /* special case when precision is specified */
       if (*(tmp + 1) == '*') {
         /* user supplied %.* which specifies
-         * that width is specified as variable
-         * argument.
-         */
-        (void)va_arg(ap, int);  /* width */
-        /* TODO FIXME, shouldn't we care. Maybe
-         * later. Ideally we should be passing
-         * that as with other variable arguments,
-         * but lets not do it now.
+         * that precision is specified as variable
+         * argument. It bounds a string, which is
+         * stored with just that many bytes, and is
+         * not stored itself. A negative one is
+         * taken as if it were omitted.
          */
+        precision = va_arg(ap, int);
         ++tmp;
         /* already preocessed within this
          * block
          */
+      } else {
+        precision = 0;
+        while (*(tmp + 1) >= '0' && *(tmp + 1) <= '9') {
+          if (precision < INT_MAX / 10) {
+            precision = 10 * precision + (*(tmp + 1) - '0');
+          }
+          ++tmp;
+        }
       }
       break;
+    case '*':
+      /* width specified as variable argument, which
+       * only pads and is not stored
+       */
+      (void)va_arg(ap, int);
+      break;
     case '%':
       /* no type specifier because user said %% */
       is_type_specifier = 0;
@@ -731,6 +1963,600 @@ static ssize_t fill_variable_arguments(char *store, ssize_t offset, const char *
   return offset;
 }
 
+/* Copy bytes of the value at src in big-endian format, which is how the
+ * doubles and pointers are stored.
+ */
+static void copy_big_endian_raw(char *store, ssize_t *offset, const void *src,
+                                size_t bytes) {
+#if IS_LITTLE_ENDIAN
+  const char *tmp_d = (const char *)src;
+  size_t i = bytes;
+
+  while (i > 0) {
+    --i;
+    store[(*offset)++] = tmp_d[i] & 0x00ff;
+  }
+#else /* ?IS_LITTLE_ENDIAN */
+  memcpy(&store[*offset], src, bytes);
+  *offset += bytes;
+#endif /* IS_LITTLE_ENDIAN */
+}
+
+/* Copy bytes of the value at src, which is a double or a pointer, in
+ * big-endian format unless BINARY_NATIVE_ENDIAN is set in version.
+ */
+static void put_raw(char *store, ssize_t *offset, const void *src,
+                    size_t bytes, int version) {
+  if (version & BINARY_NATIVE_ENDIAN) {
+    memcpy(&store[*offset], src, bytes);
+    *offset += bytes;
+    return;
+  }
+  copy_big_endian_raw(store, offset, src, bytes);
+}
+
+/* Same as fill_variable_arguments() but the arguments are told by desc
+ * (see CLOGGING_BINARY_ARG_DESC), so each of them is read with va_arg()
+ * of its own promoted type and stored as is. The format is only looked
+ * at when it has a precision or a '*', for the strings bounded by a
+ * precision and the '*' arguments, which are not stored either, or when
+ * there are pointers. The C type of a pointer does not tell a string
+ * from an address, so its conversion does: "%p" of a char * is stored
+ * as a POINTER and "%s" of an unsigned char * as a STRING.
+ */
+static ssize_t fill_typed_arguments(char *store, ssize_t offset,
+                                    ssize_t capacity, const uint8_t *desc,
+                                    const char *format, int version,
+                                    va_list ap) {
+  long precisions[CLOGGING_BINARY_MAX_ARGS + 1];
+  char conversions[CLOGGING_BINARY_MAX_ARGS + 1];
+  int has_precisions = 0;
+  int has_pointers = 0;
+  int type = 0;
+  uint32_t stars = 0;
+  long star = -1;
+  int nargs = desc[0];
+  int i = 0;
+  int bytes = 0;
+  unsigned long long llval = 0LLU;
+  double dbl = 0.0;
+  long double ldbl = (long double)0.0;
+  void *tmp_p = NULL;
+  const char *tmp_s = NULL;
+  const char *nul = NULL;
+  size_t s_len = 0;
+
+  if (nargs > CLOGGING_BINARY_MAX_ARGS) {
+    return -1;
+  }
+  for (i = 1; i <= nargs; ++i) {
+    type = CLOGGING_BINARY_ARG_TYPE_OF(desc[i]);
+    if (type == BINARY_LOG_VAR_ARG_STRING ||
+        type == BINARY_LOG_VAR_ARG_POINTER) {
+      has_pointers = 1;
+    }
+  }
+  if (has_pointers || strchr(format, '.') != NULL ||
+      strchr(format, '*') != NULL) {
+    stars = parse_arg_precisions(format, precisions, conversions);
+    has_precisions = 1;
+  }
+  for (i = 1; i <= nargs; ++i) {
+    bytes = CLOGGING_BINARY_ARG_SIZE_OF(desc[i]);
+    type = CLOGGING_BINARY_ARG_TYPE_OF(desc[i]);
+    if ((stars & (1U << i)) && type == BINARY_LOG_VAR_ARG_INTEGER) {
+      /* a '*' takes an int */
+      star = (long)(int)va_arg(ap, unsigned int);
+      continue;
+    }
+    if (has_pointers && type == BINARY_LOG_VAR_ARG_STRING &&
+        conversions[i] == 'p') {
+      type = BINARY_LOG_VAR_ARG_POINTER;
+    } else if (has_pointers && type == BINARY_LOG_VAR_ARG_POINTER &&
+               conversions[i] == 's') {
+      type = BINARY_LOG_VAR_ARG_STRING;
+    }
+    switch (type) {
+    case BINARY_LOG_VAR_ARG_INTEGER:
+      if (reserve_scalar_arg(store, &offset, capacity, version) < 0) {
+        return -1;
+      }
+      /* anything narrower than int is promoted to int */
+      if (bytes <= (int)sizeof(int)) {
+        llval = va_arg(ap, unsigned int);
+      } else {
+        llval = va_arg(ap, unsigned long long);
+      }
+      if (put_arg_integer(store, &offset, llval, bytes, version) < 0) {
+        return -1;
+      }
+      break;
+    case BINARY_LOG_VAR_ARG_DOUBLE:
+      if (reserve_scalar_arg(store, &offset, capacity, version) < 0) {
+        return -1;
+      }
+      if (bytes == (int)sizeof(double)) {
+        /* float is promoted to double */
+        dbl = va_arg(ap, double);
+        put_arg_tag(store, &offset, BINARY_LOG_VAR_ARG_DOUBLE, sizeof(double),
+                    version);
+        put_raw(store, &offset, &dbl, sizeof(double), version);
+      } else {
+        ldbl = va_arg(ap, long double);
+        put_arg_tag(store, &offset, BINARY_LOG_VAR_ARG_DOUBLE,
+                    sizeof(long double), version);
+        put_raw(store, &offset, &ldbl, sizeof(long double), version);
+      }
+      break;
+    case BINARY_LOG_VAR_ARG_POINTER:
+      if (reserve_scalar_arg(store, &offset, capacity, version) < 0) {
+        return -1;
+      }
+      tmp_p = va_arg(ap, void *);
+      put_arg_tag(store, &offset, BINARY_LOG_VAR_ARG_POINTER, sizeof(tmp_p),
+                  version);
+      put_raw(store, &offset, &tmp_p, sizeof(tmp_p), version);
+      break;
+    case BINARY_LOG_VAR_ARG_STRING:
+      tmp_s = va_arg(ap, const char *);
+      if (tmp_s == NULL) {
+        /* same as what printf() family prints */
+        tmp_s = "(null)";
+      }
+      if (!has_precisions || precisions[i] == ARG_PRECISION_NONE ||
+          (precisions[i] == ARG_PRECISION_STAR && star < 0)) {
+        s_len = strlen(tmp_s);
+      } else {
+        s_len = (size_t)((precisions[i] == ARG_PRECISION_STAR) ? star
+                                                               : precisions[i]);
+        nul = (const char *)memchr(tmp_s, '\0', s_len);
+        if (nul != NULL) {
+          s_len = (size_t)(nul - tmp_s);
+        }
+      }
+      if (!(version & BINARY_CHUNKED)) {
+        s_len = s_len & 0x7fff; /* max len of 15 bits */
+      }
+      if (put_arg_data(store, &offset, capacity, BINARY_LOG_VAR_ARG_STRING,
+                       tmp_s, s_len, version) < 0) {
+        return -1;
+      }
+      break;
+    default:
+      return -1;
+    }
+  }
+  return offset;
+}
+
+/* A single conversion specification of a printf() format, say "%-08.3lld" */
+struct format_spec {
+  const char *start; /* points at '%' */
+  size_t len;        /* bytes till and including the conversion */
+  char conversion;
+  enum length_specifier lspecifier;
+  int width_star;     /* width comes from an argument */
+  int precision_star; /* precision comes from an argument */
+  long precision;     /* ARG_PRECISION_NONE when not given */
+};
+
+/* Parse the conversion specification starting at p (pointing at '%')
+ * and return the position right after it, or NULL when the format
+ * ends before the conversion.
+ */
+static const char *parse_format_spec(const char *p, struct format_spec *spec) {
+  const char *tmp = p + 1;
+
+  spec->start = p;
+  spec->width_star = 0;
+  spec->precision_star = 0;
+  spec->precision = ARG_PRECISION_NONE;
+  spec->lspecifier = LS_NONE;
+
+  /* flags */
+  while (*tmp == '-' || *tmp == '+' || *tmp == ' ' || *tmp == '#' ||
+         *tmp == '0' || *tmp == '\'') {
+    ++tmp;
+  }
+  /* width */
+  if (*tmp == '*') {
+    spec->width_star = 1;
+    ++tmp;
+  }
+  while (*tmp >= '0' && *tmp <= '9') {
+    ++tmp;
+  }
+  /* precision */
+  if (*tmp == '.') {
+    ++tmp;
+    if (*tmp == '*') {
+      spec->precision_star = 1;
+      spec->precision = ARG_PRECISION_STAR;
+      ++tmp;
+    } else {
+      spec->precision = 0;
+    }
+    while (*tmp >= '0' && *tmp <= '9') {
+      if (spec->precision < INT_MAX / 10) {
+        spec->precision = 10 * spec->precision + (*tmp - '0');
+      }
+      ++tmp;
+    }
+  }
+  /* length */
+  switch (*tmp) {
+  case 'h':
+    ++tmp;
+    spec->lspecifier = LS_H;
+    if (*tmp == 'h') {
+      ++tmp;
+      spec->lspecifier = LS_HH;
+    }
+    break;
+  case 'l':
+    ++tmp;
+    spec->lspecifier = LS_L;
+    if (*tmp == 'l') {
+      ++tmp;
+      spec->lspecifier = LS_LL;
+    }
+    break;
+  case 'j':
+    ++tmp;
+    spec->lspecifier = LS_J;
+    break;
+  case 'z':
+    ++tmp;
+    spec->lspecifier = LS_Z;
+    break;
+  case 't':
+    ++tmp;
+    spec->lspecifier = LS_T;
+    break;
+  case 'L':
+    ++tmp;
+    spec->lspecifier = LS_CAP_L;
+    break;
+  default:
+    break;
+  }
+  if (*tmp == '\0') {
+    return NULL;
+  }
+  spec->conversion = *tmp;
+  ++tmp;
+  spec->len = (size_t)(tmp - p);
+  return tmp;
+}
+
+/* Fill precisions[i] with the precision of the string which is argument
+ * i (1 for the first) of format, ARG_PRECISION_NONE when it has none,
+ * conversions[i] with its conversion ('\0' for a '*'), and return the
+ * bitmap of the arguments which are a '*'.
+ */
+static uint32_t parse_arg_precisions(const char *format, long *precisions,
+                                     char *conversions) {
+  struct format_spec spec;
+  const char *tmp = format;
+  uint32_t stars = 0;
+  int arg = 0;
+
+  for (arg = 0; arg <= CLOGGING_BINARY_MAX_ARGS; ++arg) {
+    precisions[arg] = ARG_PRECISION_NONE;
+    conversions[arg] = '\0';
+  }
+  arg = 0;
+  while ((tmp = strchr(tmp, '%')) != NULL && arg < CLOGGING_BINARY_MAX_ARGS) {
+    if (tmp[1] == '%') {
+      tmp += 2;
+      continue;
+    }
+    tmp = parse_format_spec(tmp, &spec);
+    if (tmp == NULL) {
+      break;
+    }
+    if (spec.width_star && arg < CLOGGING_BINARY_MAX_ARGS) {
+      stars |= 1U << ++arg;
+    }
+    if (spec.precision_star && arg < CLOGGING_BINARY_MAX_ARGS) {
+      stars |= 1U << ++arg;
+    }
+    if (arg < CLOGGING_BINARY_MAX_ARGS) {
+      ++arg;
+      conversions[arg] = spec.conversion;
+      if (spec.conversion == 's') {
+        precisions[arg] = spec.precision;
+      }
+    }
+  }
+  return stars;
+}
+
+int clogging_binary_can_render(const char *format) {
+  struct format_spec spec;
+  const char *tmp = format;
+
+  while ((tmp = strchr(tmp, '%')) != NULL) {
+    if (tmp[1] == '%') {
+      tmp += 2;
+      continue;
+    }
+    tmp = parse_format_spec(tmp, &spec);
+    /* a '*' is not captured, but the string it bounds is */
+    if (tmp == NULL || spec.width_star ||
+        (spec.precision_star && spec.conversion != 's')) {
+      return 0;
+    }
+    switch (spec.conversion) {
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+    case 'a': case 'A': case 'p':
+      break;
+    case 'c':
+    case 's':
+      /* wide characters are not captured */
+      if (spec.lspecifier != LS_NONE) {
+        return 0;
+      }
+      break;
+    default:
+      /* %n and anything unknown */
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Read <0x80|size> or the 15 bit big-endian length of a string, or the
+ * <0x80|4> <length> of a longer one, see put_arg_head().
+ */
+static int read_captured_length(const char *args, size_t args_len, int type,
+                                size_t *offset, size_t *bytes) {
+  size_t i = 0;
+
+  if (*offset >= args_len) {
+    return -1;
+  }
+  if (args[*offset] & 0x80) {
+    *bytes = args[*offset] & 0x7f;
+    *offset += 1;
+    if (type == BINARY_LOG_VAR_ARG_STRING) {
+      if (*bytes != sizeof(uint32_t) || *offset + *bytes > args_len) {
+        return -1;
+      }
+      *bytes = 0;
+      for (i = 0; i < sizeof(uint32_t); ++i) {
+        *bytes = (*bytes << 8) | (args[(*offset)++] & 0x00ff);
+      }
+    }
+  } else {
+    if (*offset + 1 >= args_len) {
+      return -1;
+    }
+    *bytes = ((size_t)(args[*offset] & 0x7f) << 8) |
+             (args[*offset + 1] & 0x00ff);
+    *offset += 2;
+  }
+  if (*offset + *bytes > args_len) {
+    return -1;
+  }
+  return 0;
+}
+
+/* inverse of portable_copy() */
+static unsigned long long read_big_endian(const char *src, size_t bytes) {
+  unsigned long long val = 0;
+  size_t i = 0;
+
+  for (i = 0; i < bytes; ++i) {
+    val = (val << 8) | (src[i] & 0x00ff);
+  }
+  return val;
+}
+
+/* doubles, long doubles and pointers are stored as big-endian copies of
+ * their memory representation.
+ */
+static void read_big_endian_raw(const char *src, size_t bytes, void *dst) {
+#if IS_LITTLE_ENDIAN
+  char *d = (char *)dst;
+  size_t i = 0;
+
+  for (i = 0; i < bytes; ++i) {
+    d[i] = src[bytes - 1 - i];
+  }
+#else /* ?IS_LITTLE_ENDIAN */
+  memcpy(dst, src, bytes);
+#endif /* IS_LITTLE_ENDIAN */
+}
+
+#define MAX_SPEC_LEN 32
+
+/* Render the captured string s of bytes (which is not '\0' terminated)
+ * for spec_str, a "%s" with digits for the width or precision, or a '*'
+ * for the precision, at most, by bounding it with a precision of its own
+ * instead of copying it.
+ */
+static int render_string(char *out, size_t outlen, const char *spec_str,
+                         const char *s, size_t bytes) {
+  char spec[MAX_SPEC_LEN + 4];
+  const char *dot = strchr(spec_str, '.');
+  size_t head = (dot != NULL) ? (size_t)(dot - spec_str) : strlen(spec_str) - 1;
+  int precision = (bytes < INT_MAX) ? (int)bytes : INT_MAX;
+
+  /* "%.*s" was bounded when captured */
+  if (dot != NULL && dot[1] != '*' && atoi(dot + 1) < precision) {
+    precision = atoi(dot + 1);
+  }
+  memcpy(spec, spec_str, head);
+  memcpy(&spec[head], ".*s", 4);
+  return snprintf(out, outlen, spec, precision, s);
+}
+
+int clogging_binary_render_arguments(char *out, size_t outlen,
+                                     const char *format, const char *args,
+                                     size_t args_len) {
+  char spec_str[MAX_SPEC_LEN];
+  struct format_spec spec;
+  const char *tmp = format;
+  const char *next = NULL;
+  size_t argoff = 0;
+  size_t bytes = 0;
+  size_t total = 0;
+  size_t pos = 0;
+  size_t n = 0;
+  int type = 0;
+  int rc = 0;
+  unsigned long long llval = 0;
+  long long sllval = 0;
+  double dbl = 0.0;
+  long double ldbl = 0.0L;
+  void *ptr = NULL;
+
+  if (outlen == 0) {
+    return -1;
+  }
+  while (*tmp != '\0') {
+    if (*tmp != '%' || tmp[1] == '%') {
+      /* literal text, "%%" is a literal '%' */
+      if (*tmp == '%') {
+        ++tmp;
+        n = 1;
+      } else {
+        next = strchr(tmp, '%');
+        n = (next == NULL) ? strlen(tmp) : (size_t)(next - tmp);
+      }
+      if (pos + 1 < outlen) {
+        size_t room = outlen - 1 - pos;
+        memcpy(&out[pos], tmp, n < room ? n : room);
+      }
+      total += n;
+      tmp += n;
+      pos = total < outlen ? total : outlen - 1;
+      continue;
+    }
+    next = parse_format_spec(tmp, &spec);
+    if (next == NULL || spec.len >= MAX_SPEC_LEN) {
+      return -1;
+    }
+    memcpy(spec_str, spec.start, spec.len);
+    spec_str[spec.len] = '\0';
+    tmp = next;
+
+    if (argoff >= args_len) {
+      return -1;
+    }
+    type = args[argoff++] & 0x00ff;
+    if (read_captured_length(args, args_len, type, &argoff, &bytes) < 0) {
+      return -1;
+    }
+
+    switch (spec.conversion) {
+    case 'c':
+      llval = read_big_endian(&args[argoff], bytes);
+      rc = snprintf(&out[pos], outlen - pos, spec_str, (int)llval);
+      break;
+    case 'd':
+    case 'i':
+      llval = read_big_endian(&args[argoff], bytes);
+      /* sign extend to 64 bits */
+      if (bytes > 0 && bytes < sizeof(llval) &&
+          (llval >> (8 * bytes - 1)) & 1) {
+        llval |= ~0ULL << (8 * bytes);
+      }
+      sllval = (long long)llval;
+      switch (spec.lspecifier) {
+      case LS_L:
+        rc = snprintf(&out[pos], outlen - pos, spec_str, (long)sllval);
+        break;
+      case LS_LL:
+        rc = snprintf(&out[pos], outlen - pos, spec_str, sllval);
+        break;
+      case LS_J:
+        rc = snprintf(&out[pos], outlen - pos, spec_str, (intmax_t)sllval);
+        break;
+      case LS_Z:
+        rc = snprintf(&out[pos], outlen - pos, spec_str, (ssize_t)sllval);
+        break;
+      case LS_T:
+        rc = snprintf(&out[pos], outlen - pos, spec_str, (ptrdiff_t)sllval);
+        break;
+      default:
+        rc = snprintf(&out[pos], outlen - pos, spec_str, (int)sllval);
+        break;
+      }
+      break;
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+      llval = read_big_endian(&args[argoff], bytes);
+      switch (spec.lspecifier) {
+      case LS_L:
+        rc = snprintf(&out[pos], outlen - pos, spec_str, (unsigned long)llval);
+        break;
+      case LS_LL:
+        rc = snprintf(&out[pos], outlen - pos, spec_str, llval);
+        break;
+      case LS_J:
+        rc = snprintf(&out[pos], outlen - pos, spec_str, (uintmax_t)llval);
+        break;
+      case LS_Z:
+      case LS_T:
+        rc = snprintf(&out[pos], outlen - pos, spec_str, (size_t)llval);
+        break;
+      default:
+        rc = snprintf(&out[pos], outlen - pos, spec_str, (unsigned int)llval);
+        break;
+      }
+      break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      if (spec.lspecifier == LS_CAP_L && bytes == sizeof(ldbl)) {
+        read_big_endian_raw(&args[argoff], bytes, &ldbl);
+        rc = snprintf(&out[pos], outlen - pos, spec_str, ldbl);
+      } else if (bytes == sizeof(dbl)) {
+        read_big_endian_raw(&args[argoff], bytes, &dbl);
+        rc = snprintf(&out[pos], outlen - pos, spec_str, dbl);
+      } else {
+        return -1;
+      }
+      break;
+    case 'p':
+      if (bytes != sizeof(ptr)) {
+        return -1;
+      }
+      read_big_endian_raw(&args[argoff], bytes, &ptr);
+      rc = snprintf(&out[pos], outlen - pos, spec_str, ptr);
+      break;
+    case 's':
+      if (type != BINARY_LOG_VAR_ARG_STRING) {
+        return -1;
+      }
+      rc = render_string(&out[pos], outlen - pos, spec_str, &args[argoff],
+                         bytes);
+      break;
+    default:
+      return -1;
+    }
+    if (rc < 0) {
+      return -1;
+    }
+    argoff += bytes;
+    total += (size_t)rc;
+    pos = total < outlen ? total : outlen - 1;
+  }
+  out[pos] = '\0';
+  return (int)total;
+#undef MAX_SPEC_LEN
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,8 +9,13 @@
 #ifndef CLOGGING_BINARY_LOGGING_H
 #define CLOGGING_BINARY_LOGGING_H
 
+#include "log_filter.h"
+#include "log_ratelimit.h"
 #include "logging_common.h"
+#include "log_clock.h"
+#include "shm_ring.h"
 
+#include <stdarg.h>
 #include <stdint.h>
 
 /* UTF-8 ENCODING NOTICE:
@@ -29,11 +34,136 @@
 extern "C" {
 #endif
 
+/* Besides log records the stream carries frames, which are told apart by
+ * the first byte after <length>. A log record always starts with the
+ * size of its timestamp (0x80 | size), while a frame starts with the
+ * header (version << 4) | type, which is below 0x80.
+ *
+ * The version is the encoding of the fields, picked with binary_version
+ * of the options:
+ *
+ * CLOGGING_BINARY_VERSION_1 (the default) stores an integer as
+ *   <0x80|size> <big-endian value>, a string as <15-bit big-endian
+ *   length> <bytes>, and an argument as <VarArgType> followed by the
+ *   integer or string, or by <0x80|size> <big-endian bytes> for doubles
+ *   and pointers.
+ * CLOGGING_BINARY_VERSION_2 stores an integer as an unsigned LEB128
+ *   varint, a string as <varint length> <bytes>, and an argument as the
+ *   tag CLOGGING_BINARY_ARG_DESC(type, size) followed by the zigzag varint
+ *   of an integer sign extended from size bytes, <varint length> <bytes>
+ *   of a string, or size big-endian bytes of a double or pointer. Every
+ *   log record is a frame as well, CLOGGING_BINARY_FRAME_MESSAGE for the
+ *   plain records of clogging_binary_logmsg().
+ */
+#define CLOGGING_BINARY_VERSION_1 1
+#define CLOGGING_BINARY_VERSION_2 2
+/* version of the frames of the default encoding */
+#define CLOGGING_BINARY_FRAME_VERSION CLOGGING_BINARY_VERSION_1
+#define CLOGGING_BINARY_FRAME_HEADER(version, type) (((version) << 4) | (type))
+#define CLOGGING_BINARY_FRAME_VERSION_OF(header) (((header) >> 4) & 0x07)
+#define CLOGGING_BINARY_FRAME_TYPE_OF(header) ((header) & 0x0f)
+#define CLOGGING_BINARY_IS_FRAME(first_byte) (((first_byte) & 0x80) == 0)
+
+/* <clock source> <time precision>
+ *   [<ticks per sec> <base ticks> <base sec> <base nsec>]
+ * with the calibration (clogging_tsc_calibration_t) for CLOGGING_CLOCK_TSC.
+ * Each field is <0x80|size> <big-endian value>.
+ */
+#define CLOGGING_BINARY_FRAME_CLOCK 1
+
+/* <site id> <loglevel> <file> <func> <linenum> <format>
+ * announces a call site of the BINARY_LOG_* macros (see
+ * clogging_binary_site_t) before the first RECORD frame referring to it.
+ * The <site id> and the integers are <0x80|size> <big-endian value> and
+ * the strings are <15-bit big-endian length> <bytes>.
+ */
+#define CLOGGING_BINARY_FRAME_SITE 2
+
+/* <timestamp> <hostname> <progname> <threadname> <pid> <site id>
+ *   [<arg1>, <arg2>, ...]
+ * is a log record of the BINARY_LOG_* macros, which is the same as what
+ * clogging_binary_logmsg() writes but with the <site id> of the SITE
+ * frame in place of <loglevel> <file> <func> <linenum>.
+ */
+#define CLOGGING_BINARY_FRAME_RECORD 3
+
+/* <format id> <format>
+ * interns a format of clogging_binary_logmsg() with intern_formats set in
+ * the options, before the first FORMAT_RECORD frame referring to it.
+ */
+#define CLOGGING_BINARY_FRAME_FORMAT 4
+
+/* <timestamp> <hostname> <progname> <threadname> <pid> <loglevel> <file>
+ *   <func> <linenum> <format id> [<arg1>, <arg2>, ...]
+ * is a log record of clogging_binary_logmsg() with intern_formats set,
+ * which is the plain record followed by the <format id> of its FORMAT
+ * frame.
+ */
+#define CLOGGING_BINARY_FRAME_FORMAT_RECORD 5
+
+/* <timestamp> <hostname> <progname> <threadname> <pid> <loglevel> <file>
+ *   <func> <linenum> [<arg1>, <arg2>, ...]
+ * is the plain log record of clogging_binary_logmsg() in
+ * CLOGGING_BINARY_VERSION_2, where it needs a header as well.
+ */
+#define CLOGGING_BINARY_FRAME_MESSAGE 6
+
+/* <byte order>
+ * is written first with native_endian set in the options, and tells that
+ * the multi-byte values which follow are in the byte order of the
+ * producer, one of CLOGGING_BINARY_*_ENDIAN, rather than big-endian. That
+ * is every integer of CLOGGING_BINARY_VERSION_1 and the doubles and
+ * pointers of either version. The lengths of records and strings, and the
+ * varints of CLOGGING_BINARY_VERSION_2, are the same in both, so only a
+ * decoder on a host of the other byte order has to swap anything.
+ */
+#define CLOGGING_BINARY_FRAME_STREAM 7
+#define CLOGGING_BINARY_BIG_ENDIAN 0
+#define CLOGGING_BINARY_LITTLE_ENDIAN 1
+
+/* <stream id> <hostname> <progname> <threadname> <pid>
+ * is written at the start of the stream of a thread with intern_identity
+ * set in the options, and from then on its records (of any kind) carry
+ * <timestamp> <stream id> in place of <timestamp> <hostname> <progname>
+ * <threadname> <pid>. The <stream id> is 8 bytes, the pid in the upper 32
+ * bits and a number unique within the process in the lower ones.
+ */
+#define CLOGGING_BINARY_FRAME_IDENTITY 8
+
+/* <stream id> <sec> <nsec>
+ * is the wall clock time of the stream with delta_timestamps set in the
+ * options. The <timestamp> of every record of the stream is then an
+ * unsigned varint (in either version) of the nanoseconds since its last
+ * record or TIMEBASE frame, whichever came last, so a record which comes
+ * within a millisecond of the previous one takes 3 bytes for it at most.
+ * A TIMEBASE frame is written before the first record and again when a
+ * delta would be CLOGGING_BINARY_TIMEBASE_INTERVAL_NS or more, or the
+ * clock went back. See binary_reader.h to get the times back.
+ */
+#define CLOGGING_BINARY_FRAME_TIMEBASE 9
+#define CLOGGING_BINARY_TIMEBASE_INTERVAL_NS 1000000000LL
+
+/* <stream id> <chunk index> <last> <bytes>
+ * carries a piece of a record too large for a frame of its own, with
+ * chunk_records set in the options. The <bytes> of the frames of a record,
+ * numbered by <chunk index> from 0 and with <last> 1 in the last one, put
+ * together are the record without its <length>, which can be longer
+ * than 65535 bytes. It may hold strings and blobs of more than 32767
+ * bytes, whose length is <0x80|4> <length> in CLOGGING_BINARY_VERSION_1.
+ * The frames of a record follow each other within the stream of its
+ * thread (see CLOGGING_BINARY_FRAME_IDENTITY for the <stream id>), a
+ * record with a frame missing is to be dropped. See binary_reader.h to
+ * put the records back together.
+ */
+#define CLOGGING_BINARY_FRAME_CONTINUATION 10
+
 enum VarArgType {
   BINARY_LOG_VAR_ARG_INTEGER = 0,
   BINARY_LOG_VAR_ARG_DOUBLE = 1,
   BINARY_LOG_VAR_ARG_POINTER = 2,
-  BINARY_LOG_VAR_ARG_STRING = 3
+  BINARY_LOG_VAR_ARG_STRING = 3,
+  /* raw bytes, stored the same way as a string */
+  BINARY_LOG_VAR_ARG_BLOB = 4
 };
 
 /*
@@ -53,10 +183,64 @@ enum VarArgType {
  *
  * progname is of maximum length of UINT8_MAX bytes including null terminator.
  * threadname is of maximum length of UINT8_MAX bytes including null terminator.
+ *
+ * opts can be NULL for the defaults. Only clock_source, time_precision,
+ * intern_formats, intern_identity, delta_timestamps, binary_version,
+ * native_endian and chunk_records apply to binary logging. With
+ * anything but CLOGGING_CLOCK_REALTIME and CLOGGING_TIME_PRECISION_SEC a
+ * CLOCK frame is written first (see CLOGGING_BINARY_FRAME_CLOCK) and the
+ * <timestamp> of the records is 8 bytes of either raw ticks
+ * (CLOGGING_CLOCK_TSC) or time_precision units since the Epoch. All the
+ * threads writing to the same handle should use the same clock options,
+ * binary_version, native_endian, intern_identity and delta_timestamps.
+ *
+ * With intern_formats set, the records of clogging_binary_logmsg() are
+ * FORMAT_RECORD frames, which refer to the format of the message by the
+ * id of a FORMAT frame written the first time the thread logs with that
+ * format (told apart by its address), so the stream can be decoded
+ * without knowing the formats up front.
+ *
+ * With native_endian set, a STREAM frame is written before anything else
+ * (see CLOGGING_BINARY_FRAME_STREAM) and values are stored with plain
+ * copies in the byte order of the host instead of being swapped to
+ * big-endian one byte at a time.
+ *
+ * With intern_identity set, an IDENTITY frame is written at the start of
+ * the stream (see CLOGGING_BINARY_FRAME_IDENTITY) and the records refer
+ * to it by a stream id instead of repeating the names and the pid.
+ *
+ * With delta_timestamps set, which implies intern_identity, the records
+ * carry nanoseconds since the previous record of the thread instead of a
+ * timestamp of their own (see CLOGGING_BINARY_FRAME_TIMEBASE), the clock
+ * is read from clock_source and time_precision does not apply. Every
+ * record is a frame then, plain records being MESSAGE frames.
+ *
+ * With chunk_records set, a record whose arguments do not fit in the
+ * per-thread store, or in a frame, is written as CONTINUATION frames of
+ * about a kilobyte each (see CLOGGING_BINARY_FRAME_CONTINUATION) instead
+ * of being dropped, and strings and blobs are no longer cut to 32767
+ * bytes.
  */
 int clogging_binary_init(const char *progname,
                         const char *threadname,
-                         enum LogLevel level, clogging_handle_t handle);
+                         enum LogLevel level, clogging_handle_t handle,
+                         const clogging_log_options_t *opts);
+
+/* Same as clogging_binary_init() but the records are published to the
+ * shared memory ring (see shm_ring.h) instead of being written to a
+ * handle, so logging a message makes no system call at all.
+ *
+ * Every record is exactly what clogging_binary_init() writes to a handle,
+ * that is <length> <payload>, and is read back whole by the reader with
+ * clogging_shm_ring_read(). A record which does not fit in the ring is
+ * dropped and counted in clogging_binary_get_num_dropped_messages().
+ *
+ * The ring can be shared by all the threads of the process and by the
+ * children forked after it was created or which opened it by name.
+ */
+int clogging_binary_init_shm(const char *progname, const char *threadname,
+                             enum LogLevel level, clogging_shm_ring_t *ring,
+                             const clogging_log_options_t *opts);
 
 /* Backward compatibility macro for old int-based API.
  * Converts int fd to clogging_handle_t automatically.
@@ -65,17 +249,62 @@ int clogging_binary_init(const char *progname,
   clogging_binary_init((progname), (progname_len), (threadname), (threadname_len), (level), \
                        clogging_create_handle_from_fd(fd))
 
-/*
+/* Start the stream of the current thread over, after the handle was
+ * reconnected or the file behind it rotated (say with dup2()), so that a
+ * receiver of the new stream can decode it from there: the STREAM, CLOCK
+ * and IDENTITY frames are written again, and so are the TIMEBASE, SITE
+ * and FORMAT frames before the next record which needs them. The rest of
+ * a partially written record is discarded.
+ */
+void clogging_binary_restart_stream(void);
+
+/* Set the log level of the calling thread, which overrides the one of
+ * the process until clogging_binary_set_process_loglevel() is called
+ * again. clogging_binary_init() sets it too.
+ *
  * It is a MT safe implementation.
  */
 void clogging_binary_set_loglevel(enum LogLevel level);
 
-/* Get the current log level.
+/* Get the current log level of the calling thread.
  *
  * It is MT safe.
  */
 enum LogLevel clogging_binary_get_loglevel(void);
 
+/* Set the log level of every thread of the process, including those
+ * which set their own before. See clogging_basic_set_process_loglevel().
+ *
+ * It is MT safe.
+ */
+void clogging_binary_set_process_loglevel(enum LogLevel level);
+
+/* Get the log level of the process. */
+enum LogLevel clogging_binary_get_process_loglevel(void);
+
+/* Whether a message of level would be logged by the current thread,
+ * which the BINARY_LOG_* macros check before anything else. See
+ * CLOGGING_BASIC_LEVEL_ENABLED() in basic_logging.h.
+ */
+#ifdef _WIN32
+#define CLOGGING_BINARY_LEVEL() ((int)clogging_binary_get_loglevel())
+#else
+extern uint32_t clogging_binary_process_level;
+extern __thread uint32_t clogging_binary_thread_level;
+#define CLOGGING_BINARY_LEVEL()                                               \
+  clogging_level_of(&clogging_binary_process_level,                           \
+                    clogging_binary_thread_level)
+#endif /* _WIN32 */
+#define CLOGGING_BINARY_LEVEL_ENABLED(level)                                  \
+  ((level) <= CLOGGING_MIN_LEVEL && (int)(level) <= CLOGGING_BINARY_LEVEL())
+
+/* The same for a call site, whose filter (see log_filter.h) overrides
+ * the level of the thread, with site the static word of its cache.
+ */
+#define CLOGGING_BINARY_SITE_ENABLED(site, level)                             \
+  ((level) <= CLOGGING_MIN_LEVEL &&                                           \
+   (int)(level) <= CLOGGING_FILTER_LEVEL((site), CLOGGING_BINARY_LEVEL()))
+
 /* This will fail if clogging_binary_init() is not invoked earlier.
  * There is an additional cost to validating the initiatized state
  * but its worth the check.
@@ -86,8 +315,14 @@ enum LogLevel clogging_binary_get_loglevel(void);
  * <threadname> <pid> <loglevel> <file> <func> <linenum>
  * [<arg1>, <arg2>, ...]
  *
+ * or the CLOGGING_BINARY_FRAME_FORMAT_RECORD frame with intern_formats.
+ *
  * Note: Multi-byte fields are encoded in big-endian format.
  *
+ * A string with a precision, say "%.*s" with the length of a slice of a
+ * buffer, is stored with at most that many bytes, so it need not be
+ * '\0' terminated. The '*' arguments themselves are not stored.
+ *
  * It is a MT safe implementation.
  *
  */
@@ -95,11 +330,327 @@ void clogging_binary_logmsg(const char *filename, const char *funcname,
                             int linenum, enum LogLevel level,
                             const char *format, ...);
 
+/* Same as clogging_binary_logmsg() with blob_len bytes of blob (at most
+ * 32767 unless chunk_records is set) appended to the arguments as a BINARY_LOG_VAR_ARG_BLOB, which
+ * is <type> <length> <bytes> just like a string.
+ *
+ * When logging to a handle, strings and blobs of a few hundred bytes or
+ * more are not copied but written from where they are along with the
+ * rest of the record with clogging_handle_writev(). Only the unsent rest
+ * of a partially written record is copied, for it to be retried by the
+ * next message.
+ */
+void clogging_binary_log_blob(const char *filename, const char *funcname,
+                              int linenum, enum LogLevel level,
+                              const void *blob, size_t blob_len,
+                              const char *format, ...);
+
+/* Argument descriptors of the BINARY_LOG_* macros below.
+ *
+ * Each call site has a static array with the number of arguments
+ * followed by one descriptor byte for each of them, holding the
+ * VarArgType and the size of the value. It is worked out from the types
+ * of the arguments at compile time, so the record is encoded without
+ * looking at the format.
+ */
+#define CLOGGING_BINARY_ARG_DESC(type, size)                                  \
+  ((uint8_t)(((type) << 5) | (size)))
+#define CLOGGING_BINARY_ARG_TYPE_OF(desc) (((desc) >> 5) & 0x07)
+#define CLOGGING_BINARY_ARG_SIZE_OF(desc) ((desc) & 0x1f)
+#define CLOGGING_BINARY_MAX_ARGS 16
+
+#if defined(__GNUC__)
+#define CLOGGING_PRINTF_FORMAT(format_index, first_arg)                       \
+  __attribute__((format(printf, format_index, first_arg)))
+#else
+#define CLOGGING_PRINTF_FORMAT(format_index, first_arg)
+#endif
+
+/* Same as clogging_binary_logmsg() but the arguments are described by
+ * desc (see CLOGGING_BINARY_ARG_DESC) instead of format, which is only
+ * there for the compiler to check. Unlike the RECORD frames of the
+ * BINARY_LOG_* macros each record stands on its own.
+ *
+ * The record is exactly what clogging_binary_logmsg() writes, except
+ * that the size of an integer follows the type of the argument rather
+ * than the length modifier of the format, say 4 bytes for 'x' with
+ * "%c" since a character constant is an int in C.
+ */
+void clogging_binary_log_typed(const char *filename, const char *funcname,
+                               int linenum, enum LogLevel level,
+                               const uint8_t *desc, const char *format, ...)
+    CLOGGING_PRINTF_FORMAT(6, 7);
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L &&               \
+    !defined(__STDC_NO_ATOMICS__) && !defined(__cplusplus)
+#include <stdatomic.h>
+typedef atomic_uint_least32_t clogging_binary_site_id_t;
+#else
+/* only ever touched by the library, which is built as C11 */
+typedef uint_least32_t clogging_binary_site_id_t;
+#endif
+
+/* A call site of the BINARY_LOG_* macros, which is a static constant of
+ * the expansion, so everything but the arguments is known up front.
+ *
+ * The site is numbered when it logs for the first time and each thread
+ * announces it with a SITE frame before its first RECORD frame, see
+ * CLOGGING_BINARY_FRAME_SITE and CLOGGING_BINARY_FRAME_RECORD. The ids,
+ * like those of FORMAT frames, are unique within a process only, so a
+ * decoder of a ring shared by processes tells them apart by <pid>.
+ */
+typedef struct clogging_binary_site {
+  clogging_binary_site_id_t *id; /* 0 until numbered */
+  enum LogLevel level;
+  const char *filename;
+  const char *funcname;
+  int linenum;
+  const char *format;
+  const uint8_t *desc; /* see CLOGGING_BINARY_ARG_DESC */
+} clogging_binary_site_t;
+
+/* Log a RECORD frame of site with the arguments described by site->desc.
+ * Use the BINARY_LOG_* macros rather than calling this directly.
+ */
+void clogging_binary_log_site(const clogging_binary_site_t *site, ...);
+
+/* Never called, only lets the compiler check the arguments of a site. */
+static inline void clogging_binary_check_format(const char *format, ...)
+    CLOGGING_PRINTF_FORMAT(1, 2);
+static inline void clogging_binary_check_format(const char *format, ...) {
+  (void)format;
+}
+
+/* number of arguments after format, up to CLOGGING_BINARY_MAX_ARGS + 1 */
+#define CLOGGING_BINARY_ARGC(format, ...)                                     \
+  CLOGGING_BINARY_ARGC_(format, ##__VA_ARGS__, 17, 16, 15, 14, 13, 12, 11,    \
+                        10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define CLOGGING_BINARY_ARGC_(format, a1, a2, a3, a4, a5, a6, a7, a8, a9,     \
+                              a10, a11, a12, a13, a14, a15, a16, a17, n,      \
+                              ...)                                            \
+  n
+
+/* BINARY_LOG_ERROR(format, ...) and friends log with
+ * clogging_binary_log_site() when built as C11 (or later), and fall
+ * back to clogging_binary_logmsg() otherwise, say in C++. The format
+ * must be a string literal and at most CLOGGING_BINARY_MAX_ARGS
+ * arguments are supported.
+ */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L &&               \
+    !defined(__STDC_NO_ATOMICS__) && !defined(__cplusplus)
+
+#define CLOGGING_BINARY_DESC_OF(x)                                            \
+  _Generic((x),                                                               \
+      _Bool: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_INTEGER, 1),         \
+      char: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_INTEGER, 1),          \
+      signed char: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_INTEGER, 1),   \
+      unsigned char: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_INTEGER, 1), \
+      short: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_INTEGER,             \
+                                      sizeof(short)),                         \
+      unsigned short: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_INTEGER,    \
+                                               sizeof(short)),                \
+      int: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_INTEGER, sizeof(int)), \
+      unsigned int: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_INTEGER,      \
+                                             sizeof(int)),                    \
+      long: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_INTEGER,              \
+                                     sizeof(long)),                           \
+      unsigned long: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_INTEGER,     \
+                                              sizeof(long)),                  \
+      long long: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_INTEGER,         \
+                                          sizeof(long long)),                 \
+      unsigned long long: CLOGGING_BINARY_ARG_DESC(                           \
+          BINARY_LOG_VAR_ARG_INTEGER, sizeof(long long)),                     \
+      float: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_DOUBLE,              \
+                                      sizeof(double)),                        \
+      double: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_DOUBLE,             \
+                                       sizeof(double)),                       \
+      long double: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_DOUBLE,        \
+                                            sizeof(long double)),             \
+      char *: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_STRING, 0),         \
+      const char *: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_STRING, 0),   \
+      default: CLOGGING_BINARY_ARG_DESC(BINARY_LOG_VAR_ARG_POINTER,           \
+                                        sizeof(void *)))
+
+#define CLOGGING_BINARY_CAT(a, b) CLOGGING_BINARY_CAT_(a, b)
+#define CLOGGING_BINARY_CAT_(a, b) a##b
+
+/* ", <desc of a1>, <desc of a2>, ..." for the arguments after format */
+#define CLOGGING_BINARY_DESCS(format, ...)                                    \
+  CLOGGING_BINARY_CAT(CLOGGING_BINARY_DESCS_,                                 \
+                      CLOGGING_BINARY_ARGC(format, ##__VA_ARGS__))            \
+  (format, ##__VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_0(f)
+#define CLOGGING_BINARY_DESCS_1(f, a) , CLOGGING_BINARY_DESC_OF(a)
+#define CLOGGING_BINARY_DESCS_2(f, a, ...)                                    \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_1(f, __VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_3(f, a, ...)                                    \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_2(f, __VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_4(f, a, ...)                                    \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_3(f, __VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_5(f, a, ...)                                    \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_4(f, __VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_6(f, a, ...)                                    \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_5(f, __VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_7(f, a, ...)                                    \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_6(f, __VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_8(f, a, ...)                                    \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_7(f, __VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_9(f, a, ...)                                    \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_8(f, __VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_10(f, a, ...)                                   \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_9(f, __VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_11(f, a, ...)                                   \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_10(f, __VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_12(f, a, ...)                                   \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_11(f, __VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_13(f, a, ...)                                   \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_12(f, __VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_14(f, a, ...)                                   \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_13(f, __VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_15(f, a, ...)                                   \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_14(f, __VA_ARGS__)
+#define CLOGGING_BINARY_DESCS_16(f, a, ...)                                   \
+  , CLOGGING_BINARY_DESC_OF(a) CLOGGING_BINARY_DESCS_15(f, __VA_ARGS__)
+
+/* log without checking the level, which the caller did */
+#define CLOGGING_BINARY_EMIT(level, format, ...)                              \
+  do {                                                                        \
+    static const uint8_t clogging_binary_desc_[] = {                          \
+        CLOGGING_BINARY_ARGC(format, ##__VA_ARGS__)                           \
+        CLOGGING_BINARY_DESCS(format, ##__VA_ARGS__)};                        \
+    static clogging_binary_site_id_t clogging_binary_site_id_;                \
+    static const clogging_binary_site_t clogging_binary_site_ = {             \
+        &clogging_binary_site_id_, (level), __FILE__, __func__, __LINE__,     \
+        format, clogging_binary_desc_};                                       \
+    if (0) {                                                                  \
+      clogging_binary_check_format(format, ##__VA_ARGS__);                    \
+    }                                                                         \
+    clogging_binary_log_site(&clogging_binary_site_, ##__VA_ARGS__);          \
+  } while (0)
+
+/* a record which stands on its own, see clogging_binary_log_typed() */
+#define CLOGGING_BINARY_LOG_TYPED(level, format, ...)                         \
+  do {                                                                        \
+    static const uint8_t clogging_binary_desc_[] = {                          \
+        CLOGGING_BINARY_ARGC(format, ##__VA_ARGS__)                           \
+        CLOGGING_BINARY_DESCS(format, ##__VA_ARGS__)};                        \
+    static uint32_t clogging_filter_site_;                                    \
+    if (CLOGGING_BINARY_SITE_ENABLED(&clogging_filter_site_, level)) {        \
+      clogging_binary_log_typed(__FILE__, __func__, __LINE__,                 \
+                                CLOGGING_CHECKED_LEVEL(level),                \
+                                clogging_binary_desc_, format,                \
+                                ##__VA_ARGS__);                               \
+    }                                                                         \
+  } while (0)
+
+#else /* ?C11 */
+
+#define CLOGGING_BINARY_EMIT(level, format, ...)                              \
+  clogging_binary_logmsg(__FILE__, __func__, __LINE__,                        \
+                         CLOGGING_CHECKED_LEVEL(level), format, ##__VA_ARGS__)
+#define CLOGGING_BINARY_LOG_TYPED(level, format, ...)                         \
+  CLOGGING_BINARY_LOG(level, format, ##__VA_ARGS__)
+
+#endif /* C11 */
+
+#define CLOGGING_BINARY_LOG(level, format, ...)                               \
+  do {                                                                        \
+    static uint32_t clogging_filter_site_;                                    \
+    if (CLOGGING_BINARY_SITE_ENABLED(&clogging_filter_site_, level)) {        \
+      CLOGGING_BINARY_EMIT(level, format, ##__VA_ARGS__);                     \
+    }                                                                         \
+  } while (0)
+
+/* CLOGGING_BINARY_LOG() of at most burst messages at once from the call
+ * site and per_second more each second, see CLOGGING_FD_LOG_RATELIMITED()
+ * in fd_logging.h. The count of the suppressed messages is one more
+ * argument, so at most CLOGGING_BINARY_MAX_ARGS - 1 are supported, which
+ * is checked at compile time.
+ */
+#define CLOGGING_BINARY_LOG_RATELIMITED(level, burst, per_second, format,     \
+                                        ...)                                  \
+  do {                                                                        \
+    (void)sizeof(char[CLOGGING_BINARY_ARGC(format, ##__VA_ARGS__) <          \
+                              CLOGGING_BINARY_MAX_ARGS                        \
+                          ? 1                                                 \
+                          : -1]);                                             \
+    static uint32_t clogging_filter_site_;                                    \
+    static clogging_ratelimit_t clogging_ratelimit_;                          \
+    uint32_t clogging_suppressed_ = 0;                                        \
+    if (CLOGGING_BINARY_SITE_ENABLED(&clogging_filter_site_, level) &&        \
+        clogging_ratelimit_allow(&clogging_ratelimit_, (burst), (per_second), \
+                                 &clogging_suppressed_)) {                    \
+      if (clogging_suppressed_ == 0) {                                        \
+        CLOGGING_BINARY_EMIT(level, format, ##__VA_ARGS__);                   \
+      } else {                                                                \
+        CLOGGING_BINARY_EMIT(level, format CLOGGING_SUPPRESSED_FORMAT,        \
+                             ##__VA_ARGS__, clogging_suppressed_);            \
+      }                                                                       \
+    }                                                                         \
+  } while (0)
+
+#define BINARY_LOG_ERROR(format, ...)                                         \
+  CLOGGING_KEEP_ERROR(                                                        \
+      CLOGGING_BINARY_LOG(LOG_LEVEL_ERROR, format, ##__VA_ARGS__))
+#define BINARY_LOG_WARN(format, ...)                                          \
+  CLOGGING_KEEP_WARN(                                                         \
+      CLOGGING_BINARY_LOG(LOG_LEVEL_WARN, format, ##__VA_ARGS__))
+#define BINARY_LOG_INFO(format, ...)                                          \
+  CLOGGING_KEEP_INFO(                                                         \
+      CLOGGING_BINARY_LOG(LOG_LEVEL_INFO, format, ##__VA_ARGS__))
+#define BINARY_LOG_DEBUG(format, ...)                                         \
+  CLOGGING_KEEP_DEBUG(                                                        \
+      CLOGGING_BINARY_LOG(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__))
+
+#define BINARY_LOG_ERROR_RATELIMITED(burst, per_second, format, ...)          \
+  CLOGGING_KEEP_ERROR(CLOGGING_BINARY_LOG_RATELIMITED(                        \
+      LOG_LEVEL_ERROR, burst, per_second, format, ##__VA_ARGS__))
+#define BINARY_LOG_WARN_RATELIMITED(burst, per_second, format, ...)           \
+  CLOGGING_KEEP_WARN(CLOGGING_BINARY_LOG_RATELIMITED(                         \
+      LOG_LEVEL_WARN, burst, per_second, format, ##__VA_ARGS__))
+#define BINARY_LOG_INFO_RATELIMITED(burst, per_second, format, ...)           \
+  CLOGGING_KEEP_INFO(CLOGGING_BINARY_LOG_RATELIMITED(                         \
+      LOG_LEVEL_INFO, burst, per_second, format, ##__VA_ARGS__))
+#define BINARY_LOG_DEBUG_RATELIMITED(burst, per_second, format, ...)          \
+  CLOGGING_KEEP_DEBUG(CLOGGING_BINARY_LOG_RATELIMITED(                        \
+      LOG_LEVEL_DEBUG, burst, per_second, format, ##__VA_ARGS__))
+
 /* Get the number of messages dropped due to overload or
  * internal errors.
  */
 uint64_t clogging_binary_get_num_dropped_messages(void);
 
+/* Serialize the variable arguments of format into store starting at
+ * offset, exactly as clogging_binary_logmsg() encodes them in the
+ * [<arg1>, <arg2>, ...] part of a record.
+ *
+ * Returns the offset after the last argument, or -1 when the arguments
+ * do not fit within capacity bytes of the store.
+ */
+ssize_t clogging_binary_capture_arguments(char *store, ssize_t offset,
+                                          ssize_t capacity,
+                                          const char *format, va_list ap);
+
+/* Check whether every argument of format is captured faithfully by
+ * clogging_binary_capture_arguments(), so that it can be rendered back
+ * to text with clogging_binary_render_arguments().
+ * This is not the case for a '*' width, a '*' precision of anything but
+ * a string, %n and wide characters.
+ *
+ * Returns 1 when it can be rendered and 0 otherwise.
+ */
+int clogging_binary_can_render(const char *format);
+
+/* Render arguments captured by clogging_binary_capture_arguments() with
+ * format into out, with the same result and return value as vsnprintf()
+ * had it been called with the original arguments.
+ *
+ * Returns -1 when the arguments do not match the format.
+ */
+int clogging_binary_render_arguments(char *out, size_t outlen,
+                                     const char *format, const char *args,
+                                     size_t args_len);
+
 #ifdef __cplusplus
 }
 #endif
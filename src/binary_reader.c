@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "binary_reader.h"
+
+#include <stdlib.h> /* realloc(), free() */
+#include <string.h> /* memset(), memcpy() */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* first number of streams to allocate room for */
+#define MIN_READER_STREAMS 8
+
+/* position in the payload being decoded */
+struct reader_cursor {
+  const unsigned char *buf;
+  size_t len;
+  size_t pos;
+  int version;
+  int byte_order;
+};
+
+static int read_varint(struct reader_cursor *cur, uint64_t *val) {
+  int shift = 0;
+
+  *val = 0;
+  while (cur->pos < cur->len && shift < 64) {
+    unsigned char b = cur->buf[cur->pos++];
+
+    *val |= (uint64_t)(b & 0x7f) << shift;
+    if ((b & 0x80) == 0) {
+      return 0;
+    }
+    shift += 7;
+  }
+  return -1;
+}
+
+/* <0x80|size> <value> in CLOGGING_BINARY_VERSION_1, in the byte order of
+ * the producer, and a varint in CLOGGING_BINARY_VERSION_2
+ */
+static int read_uint(struct reader_cursor *cur, uint64_t *val) {
+  size_t bytes = 0;
+  size_t i = 0;
+
+  if (cur->version == CLOGGING_BINARY_VERSION_2) {
+    return read_varint(cur, val);
+  }
+  if (cur->pos >= cur->len || (cur->buf[cur->pos] & 0x80) == 0) {
+    return -1;
+  }
+  bytes = cur->buf[cur->pos++] & 0x7f;
+  if (bytes > sizeof(*val) || cur->pos + bytes > cur->len) {
+    return -1;
+  }
+  *val = 0;
+  for (i = 0; i < bytes; ++i) {
+    if (cur->byte_order == CLOGGING_BINARY_LITTLE_ENDIAN) {
+      *val |= (uint64_t)cur->buf[cur->pos + i] << (8 * i);
+    } else {
+      *val = (*val << 8) | cur->buf[cur->pos + i];
+    }
+  }
+  cur->pos += bytes;
+  return 0;
+}
+
+static clogging_binary_reader_stream_t *
+find_stream(clogging_binary_reader_t *reader, uint64_t stream_id) {
+  int i = 0;
+
+  for (i = 0; i < reader->num_streams; ++i) {
+    if (reader->streams[i].stream_id == stream_id) {
+      return &reader->streams[i];
+    }
+  }
+  return NULL;
+}
+
+static clogging_binary_reader_stream_t *
+add_stream(clogging_binary_reader_t *reader, uint64_t stream_id) {
+  clogging_binary_reader_stream_t *streams = NULL;
+  int max_streams = 0;
+
+  if (reader->num_streams == reader->max_streams) {
+    max_streams = (reader->max_streams > 0) ? 2 * reader->max_streams
+                                            : MIN_READER_STREAMS;
+    streams = (clogging_binary_reader_stream_t *)realloc(
+        reader->streams, (size_t)max_streams * sizeof(*streams));
+    if (streams == NULL) {
+      return NULL;
+    }
+    reader->streams = streams;
+    reader->max_streams = max_streams;
+  }
+  memset(&reader->streams[reader->num_streams], 0,
+         sizeof(reader->streams[reader->num_streams]));
+  reader->streams[reader->num_streams].stream_id = stream_id;
+  return &reader->streams[reader->num_streams++];
+}
+
+void clogging_binary_reader_init(clogging_binary_reader_t *reader) {
+  memset(reader, 0, sizeof(*reader));
+  reader->byte_order = CLOGGING_BINARY_BIG_ENDIAN;
+}
+
+void clogging_binary_reader_free(clogging_binary_reader_t *reader) {
+  int i = 0;
+
+  for (i = 0; i < reader->num_streams; ++i) {
+    free(reader->streams[i].chunks);
+  }
+  free(reader->streams);
+  clogging_binary_reader_init(reader);
+}
+
+/* <stream id> <sec> <nsec> */
+static int feed_timebase(clogging_binary_reader_t *reader,
+                         struct reader_cursor *cur) {
+  clogging_binary_reader_stream_t *stream = NULL;
+  clogging_timestamp_t ts;
+  uint64_t stream_id = 0;
+  uint64_t sec = 0;
+  uint64_t nsec = 0;
+
+  if (read_uint(cur, &stream_id) < 0 || read_uint(cur, &sec) < 0 ||
+      read_uint(cur, &nsec) < 0) {
+    return -1;
+  }
+  stream = find_stream(reader, stream_id);
+  if (stream == NULL) {
+    stream = add_stream(reader, stream_id);
+    if (stream == NULL) {
+      return -1;
+    }
+  }
+  ts.sec = (int64_t)sec;
+  ts.nsec = (uint32_t)nsec;
+  stream->last_ns = clogging_timestamp_to_units(&ts, CLOGGING_TIME_PRECISION_NS);
+  stream->has_timebase = 1;
+  return 0;
+}
+
+/* <timestamp> <stream id> ... where <timestamp> is the delta */
+static int feed_record(clogging_binary_reader_t *reader,
+                       struct reader_cursor *cur, uint64_t *stream_id,
+                       clogging_timestamp_t *ts) {
+  clogging_binary_reader_stream_t *stream = NULL;
+  uint64_t delta = 0;
+
+  if (read_varint(cur, &delta) < 0 || read_uint(cur, stream_id) < 0) {
+    return 0;
+  }
+  stream = find_stream(reader, *stream_id);
+  if (stream == NULL || !stream->has_timebase) {
+    /* not a stream with delta_timestamps, or its TIMEBASE was lost */
+    return 0;
+  }
+  stream->last_ns += (int64_t)delta;
+  clogging_timestamp_from_units(stream->last_ns, CLOGGING_TIME_PRECISION_NS,
+                                ts);
+  return 1;
+}
+
+static int feed_payload(clogging_binary_reader_t *reader,
+                        const unsigned char *buf, size_t len, int chunks,
+                        uint64_t *stream_id, clogging_timestamp_t *ts);
+
+/* <stream id> <chunk index> <last> <bytes>, which are appended to what
+ * the stream has of its record so far, and make the record when last
+ */
+static int feed_chunk(clogging_binary_reader_t *reader,
+                      struct reader_cursor *cur, uint64_t *stream_id,
+                      clogging_timestamp_t *ts) {
+  clogging_binary_reader_stream_t *stream = NULL;
+  uint64_t id = 0;
+  uint64_t index = 0;
+  uint64_t last = 0;
+  size_t bytes = 0;
+  size_t size = 0;
+  char *chunks = NULL;
+
+  reader->record = NULL;
+  reader->record_len = 0;
+  if (read_uint(cur, &id) < 0 || read_uint(cur, &index) < 0 ||
+      read_uint(cur, &last) < 0) {
+    return -1;
+  }
+  stream = find_stream(reader, id);
+  if (stream == NULL) {
+    stream = add_stream(reader, id);
+    if (stream == NULL) {
+      return -1;
+    }
+  }
+  if (index == 0) {
+    stream->chunks_len = 0;
+  } else if (index != stream->next_chunk) {
+    /* a piece went missing, and so did the record */
+    stream->next_chunk = 0;
+    return 0;
+  }
+
+  bytes = cur->len - cur->pos;
+  if (stream->chunks_len + bytes > stream->chunks_size) {
+    size = (stream->chunks_size > 0) ? stream->chunks_size : bytes;
+    while (size < stream->chunks_len + bytes) {
+      size *= 2;
+    }
+    chunks = (char *)realloc(stream->chunks, size);
+    if (chunks == NULL) {
+      return -1;
+    }
+    stream->chunks = chunks;
+    stream->chunks_size = size;
+  }
+  memcpy(&stream->chunks[stream->chunks_len], &cur->buf[cur->pos], bytes);
+  stream->chunks_len += bytes;
+  stream->next_chunk = (uint32_t)index + 1;
+  if (!last) {
+    return 0;
+  }
+
+  stream->next_chunk = 0;
+  reader->record = stream->chunks;
+  reader->record_len = stream->chunks_len;
+  return feed_payload(reader, (const unsigned char *)stream->chunks,
+                      stream->chunks_len, 0, stream_id, ts);
+}
+
+/* Feed the payload of a record or frame, which is a CONTINUATION frame
+ * only when chunks is set.
+ */
+static int feed_payload(clogging_binary_reader_t *reader,
+                        const unsigned char *buf, size_t len, int chunks,
+                        uint64_t *stream_id, clogging_timestamp_t *ts) {
+  struct reader_cursor cur;
+  int header = 0;
+  uint64_t order = 0;
+
+  if (len < 1) {
+    return -1;
+  }
+  cur.buf = buf;
+  cur.len = len;
+  cur.pos = 0;
+  cur.byte_order = reader->byte_order;
+  header = cur.buf[cur.pos];
+  if (!CLOGGING_BINARY_IS_FRAME(header)) {
+    /* a plain record has a timestamp of its own */
+    return 0;
+  }
+  ++cur.pos;
+  cur.version = CLOGGING_BINARY_FRAME_VERSION_OF(header);
+
+  switch (CLOGGING_BINARY_FRAME_TYPE_OF(header)) {
+  case CLOGGING_BINARY_FRAME_STREAM:
+    if (read_uint(&cur, &order) < 0) {
+      return -1;
+    }
+    reader->byte_order = (int)order;
+    return 0;
+  case CLOGGING_BINARY_FRAME_TIMEBASE:
+    return feed_timebase(reader, &cur);
+  case CLOGGING_BINARY_FRAME_MESSAGE:
+  case CLOGGING_BINARY_FRAME_RECORD:
+  case CLOGGING_BINARY_FRAME_FORMAT_RECORD:
+    return feed_record(reader, &cur, stream_id, ts);
+  case CLOGGING_BINARY_FRAME_CONTINUATION:
+    /* the pieces of a record are not in pieces themselves */
+    return chunks ? feed_chunk(reader, &cur, stream_id, ts) : -1;
+  default:
+    return 0;
+  }
+}
+
+int clogging_binary_reader_feed(clogging_binary_reader_t *reader,
+                                const char *rec, size_t len,
+                                uint64_t *stream_id,
+                                clogging_timestamp_t *ts) {
+  if (len < 3) {
+    return -1;
+  }
+  reader->record = rec + 2;
+  reader->record_len = len - 2;
+  return feed_payload(reader, (const unsigned char *)rec + 2, len - 2, 1,
+                      stream_id, ts);
+}
+
+#ifdef __cplusplus
+}
+#endif
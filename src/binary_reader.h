@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifndef CLOGGING_BINARY_READER_H
+#define CLOGGING_BINARY_READER_H
+
+#include "binary_logging.h"
+#include "log_clock.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Decoder side of the binary log streams.
+ *
+ * Feed every record read from a stream (or a shared memory ring), in the
+ * order it was read, to clogging_binary_reader_feed(). The reader keeps
+ * what the frames tell about the streams, and gives back the wall clock
+ * time of the records of the streams written with delta_timestamps,
+ * which only carry the nanoseconds since the previous record of their
+ * stream (see CLOGGING_BINARY_FRAME_TIMEBASE). It also puts back together
+ * the records split into CONTINUATION frames (see
+ * CLOGGING_BINARY_FRAME_CONTINUATION).
+ *
+ * A reader is not MT safe, use one per stream being read.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* what the reader keeps of a stream */
+typedef struct {
+  uint64_t stream_id;
+  /* time of the last record or TIMEBASE frame */
+  int64_t last_ns;
+  int has_timebase;
+  /* the pieces of a record in CONTINUATION frames so far */
+  char *chunks;
+  size_t chunks_len;
+  size_t chunks_size;
+  uint32_t next_chunk;
+} clogging_binary_reader_stream_t;
+
+typedef struct {
+  /* CLOGGING_BINARY_*_ENDIAN of the producer, see
+   * CLOGGING_BINARY_FRAME_STREAM
+   */
+  int byte_order;
+  clogging_binary_reader_stream_t *streams;
+  int num_streams;
+  int max_streams;
+  /* the record fed last without its <length>, put back together from
+   * its CONTINUATION frames when it came in pieces, or NULL after a piece
+   * which is not the last one. It is valid until the next feed.
+   */
+  const char *record;
+  size_t record_len;
+} clogging_binary_reader_t;
+
+void clogging_binary_reader_init(clogging_binary_reader_t *reader);
+
+/* Release what the reader allocated, it can be initialized again. */
+void clogging_binary_reader_free(clogging_binary_reader_t *reader);
+
+/* Feed rec, a whole <length> <payload> of len bytes as read from the
+ * stream. The record, or frame, it makes is then in reader->record.
+ *
+ * Returns 1 for a record of a stream with delta_timestamps, with its
+ * stream id in stream_id and its time in ts, 0 for a frame (or a record
+ * of a stream without a TIMEBASE frame) which has no time to give, and
+ * -1 when rec is malformed or memory runs out. The last CONTINUATION
+ * frame of a record counts as the record.
+ */
+int clogging_binary_reader_feed(clogging_binary_reader_t *reader,
+                                const char *rec, size_t len,
+                                uint64_t *stream_id,
+                                clogging_timestamp_t *ts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOGGING_BINARY_READER_H */
@@ -11,10 +11,17 @@
 #endif
 
 #include "fd_logging.h"
+#include "async_ring.h"
+#include "binary_logging.h" /* clogging_binary_capture_arguments() */
+#include "log_arena.h"
+#include "log_clock.h"
+#include "log_level.h"
+#include "log_prefix.h"
 
 #include <errno.h>    /* errno */
 #include <stdarg.h>   /* va_start() and friends */
 #include <stdio.h>    /* fprintf() and friends */
+#include <stdlib.h>   /* calloc(), free() */
 #include <string.h>   /* strerror_r() */
 #include <sys/stat.h> /* fstat() */
 #include <sys/types.h>
@@ -65,43 +72,331 @@ extern "C" {
 #define THREAD_LOCAL __thread
 #endif
 
-static THREAD_LOCAL char g_fd_progname[MAX_PROG_NAME_LEN] = {0};
-static THREAD_LOCAL char g_fd_threadname[MAX_PROG_NAME_LEN] = {0};
-static THREAD_LOCAL char g_fd_hostname[MAX_HOSTNAME_LEN] = {0};
-static THREAD_LOCAL int g_fd_pid = 0;
-static THREAD_LOCAL enum LogLevel g_fd_level = DEFAULT_LOG_LEVEL;
+/* Everything which goes into a log line besides the message itself.
+ * This is kept together so that a copy of it can travel with the ring
+ * of the thread in deferred mode, see fd_format_begin().
+ */
+struct fd_format_ctx {
+  char progname[MAX_PROG_NAME_LEN];
+  char threadname[MAX_PROG_NAME_LEN];
+  char hostname[MAX_HOSTNAME_LEN];
+  int pid;
+  int prefix_length; /* 1 when prefix length to log entry */
+  int max_line_bytes; /* resolved from options.max_line_bytes */
+  /* Logging options */
+  clogging_log_options_t options;
+  /* rendered from the fields above at init */
+  clogging_prefix_t prefix;
+};
+
+static THREAD_LOCAL struct fd_format_ctx g_fd_format = {
+  .options = {
+    .color = 0,
+    .json = 0,
+    .prefix_fields_flag = CLOGGING_PREFIX_DEFAULT
+  }
+};
+/* exported for the level check of the log macros, see log_level.h */
+uint32_t clogging_fd_process_level = CLOGGING_LEVEL_WORD_INIT;
+THREAD_LOCAL uint32_t clogging_fd_thread_level = 0;
 #ifdef _WIN32
 static THREAD_LOCAL clogging_handle_t g_fd_handle = {CLOGGING_HANDLE_TYPE_CRT, {.crt_fd = 2}};
 #else
 static THREAD_LOCAL clogging_handle_t g_fd_handle = 2; /* stderr fd is default as 2 */
 #endif
-static THREAD_LOCAL int g_fd_prefix_length = 0; /* 1 when prefix length to log
-                                               entry */
-/* Logging options */
-static THREAD_LOCAL clogging_log_options_t g_fd_log_options = {
-  .color = 0,
-  .json = 0,
-  .prefix_fields_flag = CLOGGING_PREFIX_DEFAULT
-};
 /* safeguard calling init_logging multiple times */
 static THREAD_LOCAL int g_fd_is_logging_initialized = 0;
 
-#define TOTAL_MSG_BYTES 1024
-/* optimization by having only one instance per thread instead of
- * stack allocation all the time.
+/* Lines are formatted in a buffer of the thread which is only as large
+ * as the longest line so far (up to max_line_bytes), rather than
+ * having the largest possible line in the thread local storage of every
+ * thread.
  */
-static THREAD_LOCAL char g_fd_total_message[TOTAL_MSG_BYTES];
-
-/* account for partial write */
-static THREAD_LOCAL int g_fd_previous_message_offset = 0;
-static THREAD_LOCAL int g_fd_previous_message_bytes = 0;
-static THREAD_LOCAL char g_fd_previous_message[TOTAL_MSG_BYTES];
+static THREAD_LOCAL clogging_arena_t g_fd_arena;
 
 /* store the number of message dropped as a counter for
  * later statistics collection.
  */
 static THREAD_LOCAL uint64_t g_fd_num_msg_drops = 0;
 
+/* messages which were cut short to fit in max_line_bytes */
+static THREAD_LOCAL uint64_t g_fd_num_msg_truncations = 0;
+
+/* ring drained by the background writer in async mode, NULL otherwise */
+static THREAD_LOCAL clogging_async_ring_t *g_fd_ring = NULL;
+
+/* What the writer thread needs to know about the owner of a ring. It is
+ * followed by a buffer of format.max_line_bytes in which the writer
+ * renders deferred records, see fd_async_line().
+ */
+struct fd_async_ctx {
+  clogging_handle_t handle;
+  int deferred;
+  struct fd_format_ctx format;
+  /* length of the rendered record, kept across partial writes */
+  int line_len;
+};
+
+static char *fd_async_line(struct fd_async_ctx *actx) {
+  return (char *)(actx + 1);
+}
+
+/* Deferred records start with this header. The arguments captured by
+ * clogging_binary_capture_arguments() follow for FD_RECORD_DEFERRED and
+ * the already formatted message (without '\0') for FD_RECORD_TEXT.
+ */
+enum fd_record_kind {
+  FD_RECORD_TEXT = 0,
+  FD_RECORD_DEFERRED = 1
+};
+
+struct fd_deferred_header {
+  clogging_timestamp_t ts;
+  const char *funcname;
+  const char *format;
+  int linenum;
+  int level;
+  int kind;
+};
+
+/* Formats which clogging_binary_render_arguments() cannot reproduce are
+ * formatted right away, and this direct-mapped cache remembers the
+ * outcome of the check for the format strings seen by this thread.
+ */
+#define FD_FORMAT_CACHE_SIZE 64
+struct fd_format_cache_entry {
+  const char *format;
+  int deferrable;
+};
+static THREAD_LOCAL struct fd_format_cache_entry
+    g_fd_format_cache[FD_FORMAT_CACHE_SIZE];
+
+static int fd_is_deferrable(const char *format) {
+  struct fd_format_cache_entry *entry =
+      &g_fd_format_cache[((uintptr_t)format >> 3) % FD_FORMAT_CACHE_SIZE];
+
+  if (entry->format != format) {
+    entry->format = format;
+    entry->deferrable = clogging_binary_can_render(format);
+  }
+  return entry->deferrable;
+}
+
+/* Begin one log line in store (of size bytes) with everything which
+ * goes before the message, including room for the length field when
+ * fctx asks for one. The message is then formatted straight into store
+ * at the returned offset, up to *msg_room bytes, and the line is
+ * completed with fd_format_end().
+ *
+ * These are shared between the calling thread and the writer thread,
+ * which formats deferred records on behalf of the thread owning the
+ * ring, so they must only look at fctx and never at the thread local
+ * state.
+ *
+ * Returns the offset of the message or -1 on error.
+ */
+static int fd_format_begin(const struct fd_format_ctx *fctx, char *store,
+                           int size, const clogging_timestamp_t *ts,
+                           enum LogLevel level,
+                           const char *funcname, int linenum,
+                           int *msg_room) {
+  /* ISO 8601 date and time format with the configured precision */
+  char time_str[CLOGGING_MAX_TIME_STR_LEN];
+  int time_len = 0;
+  int msg_offset = 0;
+  int pos = 0;
+
+  time_len = clogging_timestamp_to_cstr(ts, fctx->options.time_precision,
+                                        time_str, (int)sizeof(time_str));
+  if (time_len < 0) {
+    return -1;
+  }
+
+  if (fctx->prefix_length) {
+    /* add a length field when the
+     * fd is not a regular file.
+     */
+    msg_offset = 2;
+  }
+
+  /* leave the first two bytes for size */
+  pos = clogging_prefix_format_begin(&fctx->prefix, &store[msg_offset],
+                                     size - msg_offset, time_str, time_len,
+                                     level, funcname, linenum, msg_room);
+  return msg_offset + pos;
+}
+
+/* Complete the line begun by fd_format_begin() once the msg_len bytes of
+ * the message are at offset pos of store. *msg_needed is set as by
+ * clogging_prefix_format_end().
+ *
+ * Returns the number of bytes to write.
+ */
+static int fd_format_end(const struct fd_format_ctx *fctx, char *store,
+                         int size, int pos, int msg_len, int *msg_needed) {
+  int msg_offset = fctx->prefix_length ? 2 : 0;
+  int len = clogging_prefix_format_end(&fctx->prefix, &store[msg_offset],
+                                       size - msg_offset, pos - msg_offset,
+                                       msg_len, msg_needed);
+
+  /* Note that the null character at the end is not part of the len */
+  /* encode the length in big-endian format */
+  if (fctx->prefix_length) {
+    store[0] = (len >> 8) & 0x00ff;
+    store[1] = (len & 0x00ff);
+  }
+  return len + msg_offset;
+}
+
+/* Turn a deferred record into a log line in fd_async_line(), just like
+ * clogging_fd_logmsg() would have done in the calling thread. *truncated
+ * is set when the message did not fit in the line.
+ */
+static int fd_render_deferred(struct fd_async_ctx *actx, const char *rec,
+                              size_t len, int *truncated) {
+  struct fd_deferred_header hdr;
+  char *line = fd_async_line(actx);
+  int size = actx->format.max_line_bytes;
+  size_t payload = len - sizeof(hdr);
+  int msg_room = 0;
+  int msg_needed = 0;
+  int pos = 0;
+  int rc = 0;
+
+  memcpy(&hdr, rec, sizeof(hdr));
+  pos = fd_format_begin(&actx->format, line, size, &hdr.ts,
+                        (enum LogLevel)hdr.level, hdr.funcname, hdr.linenum,
+                        &msg_room);
+  if (pos < 0) {
+    return -1;
+  }
+  if (hdr.kind == FD_RECORD_DEFERRED) {
+    rc = clogging_binary_render_arguments(&line[pos], (size_t)msg_room + 1,
+                                          hdr.format, &rec[sizeof(hdr)],
+                                          payload);
+    if (rc < 0) {
+      return -1;
+    }
+  } else {
+    rc = (int)payload;
+    memcpy(&line[pos], &rec[sizeof(hdr)],
+           (rc > msg_room) ? (size_t)msg_room : payload);
+  }
+  *truncated = (rc > msg_room);
+  if (rc > msg_room) {
+    rc = msg_room;
+  }
+  rc = fd_format_end(&actx->format, line, size, pos, rc, &msg_needed);
+  if (msg_needed > msg_room) {
+    *truncated = 1;
+  }
+  return rc;
+}
+
+/* Runs in the writer thread. Unlike the inline path a partially written
+ * record is completed later, since the writer is the only one writing
+ * to the handle on behalf of this thread.
+ */
+static int fd_async_consume(clogging_async_ring_t *ring, void *ctx,
+                            const char *rec, size_t len, size_t *offset) {
+  struct fd_async_ctx *actx = (struct fd_async_ctx *)ctx;
+  ssize_t bytes_sent = 0;
+  int truncated = 0;
+
+  if (actx->deferred) {
+    if (*offset == 0) {
+      actx->line_len = fd_render_deferred(actx, rec, len, &truncated);
+      if (actx->line_len < 0) {
+        clogging_async_ring_add_drops(ring, 1);
+        return 0;
+      }
+      if (truncated) {
+        clogging_async_ring_add_truncations(ring, 1);
+      }
+    }
+    /* from now on it is all about writing the rendered line */
+    rec = fd_async_line(actx);
+    len = (size_t)actx->line_len;
+  }
+  while (*offset < len) {
+    bytes_sent = clogging_handle_write(actx->handle, &rec[*offset],
+                                       len - *offset);
+    if (bytes_sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+#ifdef EWOULDBLOCK
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+#else
+      if (errno == EAGAIN) {
+#endif
+        return 1;
+      }
+      clogging_async_ring_add_drops(ring, 1);
+      return 0;
+    }
+    *offset += (size_t)bytes_sent;
+  }
+  return 0;
+}
+
+/* Publish the record for the writer without formatting anything beyond
+ * capturing the arguments, which is all that is left on the hot path.
+ *
+ * Returns one of CLOGGING_ASYNC_*.
+ */
+static int fd_defer_message(const clogging_timestamp_t *ts,
+                            enum LogLevel level,
+                            const char *funcname, int linenum,
+                            const char *format, va_list ap) {
+  struct fd_deferred_header hdr;
+  int max_bytes = g_fd_format.max_line_bytes;
+  ssize_t end = -1;
+  int status = CLOGGING_ASYNC_OK;
+  int rc = 0;
+  va_list aq;
+  char *rec = clogging_async_ring_reserve(g_fd_ring,
+                                          sizeof(hdr) + (size_t)max_bytes,
+                                          &status);
+
+  if (rec == NULL) {
+    return status;
+  }
+  hdr.ts = *ts;
+  hdr.funcname = funcname;
+  hdr.format = format;
+  hdr.linenum = linenum;
+  hdr.level = (int)level;
+  hdr.kind = FD_RECORD_DEFERRED;
+
+  if (fd_is_deferrable(format)) {
+    va_copy(aq, ap);
+    end = clogging_binary_capture_arguments(rec, (ssize_t)sizeof(hdr),
+                                            (ssize_t)sizeof(hdr) + max_bytes,
+                                            format, aq);
+    va_end(aq);
+  }
+  if (end < 0) {
+    /* too large or not renderable later, so format it right away */
+    hdr.kind = FD_RECORD_TEXT;
+    va_copy(aq, ap);
+    rc = vsnprintf(&rec[sizeof(hdr)], (size_t)max_bytes, format, aq);
+    va_end(aq);
+    if (rc < 0) {
+      clogging_async_ring_abandon(g_fd_ring);
+      return CLOGGING_ASYNC_FULL;
+    }
+    /* the writer counts it as truncated when it renders the line */
+    if (rc >= max_bytes) {
+      rc = max_bytes - 1;
+    }
+    end = (ssize_t)sizeof(hdr) + rc;
+  }
+  memcpy(rec, &hdr, sizeof(hdr));
+  clogging_async_ring_commit(g_fd_ring, (size_t)end);
+  return CLOGGING_ASYNC_OK;
+}
+
 int clogging_fd_init(const char *progname,
                      const char *threadname,
                      enum LogLevel level, clogging_handle_t handle,
@@ -126,74 +421,179 @@ int clogging_fd_init(const char *progname,
    */
   (void)get_log_level_as_cstring(LOG_LEVEL_ERROR);
 
-  clogging_strtcpy(g_fd_progname, progname, clogging_str_capsize_u8(progname));
-  clogging_strtcpy(g_fd_threadname, threadname, clogging_str_capsize_u8(threadname));
+  clogging_strtcpy(g_fd_format.progname, progname, clogging_str_capsize_u8(progname));
+  clogging_strtcpy(g_fd_format.threadname, threadname, clogging_str_capsize_u8(threadname));
 #ifdef _WIN32
   {
     DWORD size = MAX_HOSTNAME_LEN;
-    if (!GetComputerNameExA(ComputerNameDnsHostname, g_fd_hostname, &size)) {
-      clogging_strtcpy(g_fd_hostname, "unknown", size);
+    if (!GetComputerNameExA(ComputerNameDnsHostname, g_fd_format.hostname, &size)) {
+      clogging_strtcpy(g_fd_format.hostname, "unknown", size);
     }
   }
 #else
-  int rc = gethostname(g_fd_hostname, MAX_HOSTNAME_LEN);
+  int rc = gethostname(g_fd_format.hostname, MAX_HOSTNAME_LEN);
   if (rc < 0) {
-    clogging_strtcpy(g_fd_hostname, "unknown", MAX_HOSTNAME_LEN);
+    clogging_strtcpy(g_fd_format.hostname, "unknown", MAX_HOSTNAME_LEN);
   }
 #endif
 #ifdef _WIN32
-  g_fd_pid = (int)GetCurrentProcessId();
+  g_fd_format.pid = (int)GetCurrentProcessId();
 #else
-  g_fd_pid = (int)getpid();
+  g_fd_format.pid = (int)getpid();
 #endif
-  g_fd_level = level;
+  clogging_level_set_thread(&clogging_fd_process_level,
+                            &clogging_fd_thread_level, level);
   g_fd_handle = handle;
 
   /* Store logging options */
   if (opts != NULL) {
-    g_fd_log_options = *opts;
+    g_fd_format.options = *opts;
   } else {
     /* Use defaults */
-    g_fd_log_options.color = 0;
-    g_fd_log_options.json = 0;
-    g_fd_log_options.prefix_fields_flag = CLOGGING_PREFIX_DEFAULT;
+    g_fd_format.options.color = 0;
+    g_fd_format.options.json = 0;
+    g_fd_format.options.prefix_fields_flag = CLOGGING_PREFIX_DEFAULT;
+    g_fd_format.options.async = 0;
+    g_fd_format.options.deferred = 0;
+    g_fd_format.options.clock_source = CLOGGING_CLOCK_REALTIME;
+    g_fd_format.options.time_precision = CLOGGING_TIME_PRECISION_SEC;
+    g_fd_format.options.max_line_bytes = 0;
   }
+  g_fd_format.max_line_bytes =
+      clogging_arena_max_bytes(g_fd_format.options.max_line_bytes);
+  clogging_arena_init(&g_fd_arena, g_fd_format.options.max_line_bytes);
+  clogging_prefix_init(&g_fd_format.prefix, &g_fd_format.options,
+                       g_fd_format.hostname, g_fd_format.progname,
+                       g_fd_format.threadname, g_fd_format.pid);
 
   /* determine the type of handle and set prefix length accordingly */
   if (clogging_handle_is_socket(handle) == 1) {
-    g_fd_prefix_length = 1;
+    g_fd_format.prefix_length = 1;
   } else if (clogging_handle_is_pipe(handle) == 1) {
-    g_fd_prefix_length = 1;
+    g_fd_format.prefix_length = 1;
   } else {
-    g_fd_prefix_length = 0;
+    g_fd_format.prefix_length = 0;
+  }
+
+  /* deferred formatting is done by the writer thread */
+  if (g_fd_format.options.async || g_fd_format.options.deferred) {
+    /* the line buffer of the writer only matters in deferred mode */
+    size_t ctx_len = sizeof(struct fd_async_ctx) +
+                     (g_fd_format.options.deferred
+                          ? (size_t)g_fd_format.max_line_bytes
+                          : 0);
+    struct fd_async_ctx *actx = (struct fd_async_ctx *)calloc(1, ctx_len);
+    /* big enough for a record of the longest line */
+    size_t ring_bytes = CLOGGING_ASYNC_RING_BYTES_FOR(
+        sizeof(struct fd_deferred_header) +
+        (size_t)g_fd_format.max_line_bytes);
+
+    if (ring_bytes < CLOGGING_FD_ASYNC_RING_BYTES) {
+      ring_bytes = CLOGGING_FD_ASYNC_RING_BYTES;
+    }
+
+    if (actx != NULL) {
+      actx->handle = handle;
+      actx->deferred = g_fd_format.options.deferred;
+      actx->format = g_fd_format;
+      g_fd_ring = clogging_async_ring_create(ring_bytes, fd_async_consume,
+                                             actx, ctx_len, &g_fd_ring);
+      free(actx);
+    }
+    if (g_fd_ring == NULL) {
+      fprintf(stderr, "cannot create the async ring, logging inline\n");
+    }
   }
 
   return 0;
 }
 
-void clogging_fd_set_loglevel(enum LogLevel level) { g_fd_level = level; }
+/* Format the line in the arena of the calling thread, right after the
+ * header. A message which does not fit, either as formatted or once
+ * escaped for the JSON layout, grows the arena (up to max_line_bytes)
+ * and is formatted again.
+ *
+ * Returns the number of bytes to write or -1 on error.
+ */
+static int fd_format_inline(const clogging_timestamp_t *ts,
+                            enum LogLevel level, const char *funcname,
+                            int linenum, const char *format, va_list ap) {
+  int size = clogging_arena_reserve(&g_fd_arena, CLOGGING_ARENA_MIN_BYTES);
+  int new_size = 0;
+  int msg_room = 0;
+  int msg_needed = 0;
+  int pos = 0;
+  int len = 0;
+  int rc = 0;
+  va_list aq;
+
+  if (size < 0) {
+    return -1;
+  }
+  for (;;) {
+    pos = fd_format_begin(&g_fd_format, g_fd_arena.buf, size, ts, level,
+                          funcname, linenum, &msg_room);
+    if (pos < 0) {
+      return -1;
+    }
+    va_copy(aq, ap);
+    rc = vsnprintf(&g_fd_arena.buf[pos], (size_t)msg_room + 1, format, aq);
+    va_end(aq);
+    if (rc < 0) {
+      return -1;
+    }
+    if (rc <= msg_room) {
+      len = fd_format_end(&g_fd_format, g_fd_arena.buf, size, pos, rc,
+                          &msg_needed);
+      if (msg_needed <= msg_room) {
+        return len;
+      }
+    } else {
+      msg_needed = rc;
+    }
+    new_size = clogging_arena_reserve(&g_fd_arena,
+                                      size + (msg_needed - msg_room));
+    if (new_size <= size) {
+      ++g_fd_num_msg_truncations;
+      if (rc > msg_room) {
+        len = fd_format_end(&g_fd_format, g_fd_arena.buf, size, pos,
+                            msg_room, &msg_needed);
+      }
+      return len;
+    }
+    size = new_size;
+  }
+}
+
+void clogging_fd_set_loglevel(enum LogLevel level) {
+  clogging_level_set_thread(&clogging_fd_process_level,
+                            &clogging_fd_thread_level, level);
+}
+
+enum LogLevel clogging_fd_get_loglevel(void) {
+  return clogging_level_get(&clogging_fd_process_level,
+                            clogging_fd_thread_level);
+}
+
+void clogging_fd_set_process_loglevel(enum LogLevel level) {
+  clogging_level_set_process(&clogging_fd_process_level, level);
+}
 
-enum LogLevel clogging_fd_get_loglevel(void) { return g_fd_level; }
+enum LogLevel clogging_fd_get_process_loglevel(void) {
+  return clogging_level_get_process(&clogging_fd_process_level);
+}
 
 void clogging_fd_logmsg(const char *funcname, int linenum, enum LogLevel level,
                         const char *format, ...) {
-  /* ISO 8601 date and time format with sec */
-#define TIME_STR_LEN 26
-  const int time_str_len = TIME_STR_LEN;
-  char time_str[TIME_STR_LEN];
-#undef TIME_STR_LEN
-  time_t now;
-  int remaining_bytes = 0;
+  clogging_timestamp_t now;
   int len = 0;
   int rc = 0;
-  const char *level_str = 0;
-  char msg[MAX_LOG_MSG_LEN];
   va_list ap;
   ssize_t bytes_sent = 0;
-  int msg_offset = 0;
 
   /* ignore logs which are filtered out */
-  if (level > g_fd_level) {
+  if (clogging_level_filtered_out(&level, &clogging_fd_process_level,
+                                  clogging_fd_thread_level)) {
     return;
   }
 
@@ -203,230 +603,57 @@ void clogging_fd_logmsg(const char *funcname, int linenum, enum LogLevel level,
     return;
   }
 
-  remaining_bytes =
-      (g_fd_previous_message_bytes - g_fd_previous_message_offset);
-  if (len > 0) {
-    len = (int)clogging_handle_write(g_fd_handle, &g_fd_previous_message[g_fd_previous_message_offset],
-                                      remaining_bytes);
-    if (len <= 0) {
-      /* cannot write a thing, so drop the current message
-       */
-      ++g_fd_num_msg_drops;
-      return;
-    }
-    if (len < remaining_bytes) {
-      g_fd_previous_message_offset += len;
-      /* since this time as well it was partial write
-       * so new message can anyway not be written.
-       * There is no other option other than dropping the
-       * current message.
-       */
-      ++g_fd_num_msg_drops;
+  clogging_clock_now(g_fd_format.options.clock_source, &now);
+
+  va_start(ap, format);
+  if (g_fd_ring != NULL && g_fd_format.options.deferred) {
+    rc = fd_defer_message(&now, level, funcname, linenum, format, ap);
+    if (rc != CLOGGING_ASYNC_STOPPED) {
+      va_end(ap);
+      if (rc == CLOGGING_ASYNC_FULL) {
+        ++g_fd_num_msg_drops;
+      }
       return;
-    } else {
-      /* previous message is written completely */
-      g_fd_previous_message_bytes = 0;
-      g_fd_previous_message_offset = 0;
     }
+    /* else the writer is gone, so format and write it inline */
   }
-
-  time(&now);
-  len = time_to_cstr(&now, time_str, time_str_len);
+  len = fd_format_inline(&now, level, funcname, linenum, format, ap);
+  va_end(ap);
   if (len < 0) {
-    /* huh! I'd like to crash at this point but
-     * lets just log the message, which is a must.
-     */
-    ++g_fd_num_msg_drops;
-    return;
-  }
-
-  level_str = get_log_level_as_cstring(level);
-
-  va_start(ap, format);
-  rc = vsnprintf(msg, MAX_LOG_MSG_LEN, format, ap);
-  if (rc < 0) {
     /* cannot recover from this one, so lets just ignore it
      * for now rather than logging it somewhere.
      */
     ++g_fd_num_msg_drops;
     return;
   }
-  va_end(ap);
-
-  if (g_fd_prefix_length) {
-    /* add a length field when the
-     * fd is not a regular file.
-     */
-    msg_offset = 2;
-  }
-
-  /* JSON format output if enabled */
-  if (g_fd_log_options.json) {
-
-    if (g_fd_log_options.prefix_fields_flag == CLOGGING_PREFIX_DEFAULT) {
-      /* optimization for default setting */
-      len = snprintf(&g_fd_total_message[msg_offset], TOTAL_MSG_BYTES - msg_offset,
-                     "{\"timestamp\":\"%s\", \"hostname\":\"%s\", \"progname\":\"%s\", \"threadname\":\"%s\", \"pid\":%d, \"level\":\"%s\", \"funcname\":\"%s\", \"linenum\":%d, \"message\":\"%s\"}\n",
-                     time_str, g_fd_hostname, g_fd_progname, g_fd_threadname, g_fd_pid, level_str, funcname, linenum, msg);
-    } else {
-      /* Build JSON object: {"timestamp":"...", "hostname":"...", ...} */
-      int json_pos = msg_offset;
-      
-      /* Start JSON object */
-      json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, "{");
-      
-      /* Add timestamp if enabled */
-      if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_TIMESTAMP) {
-        json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, "\"timestamp\":\"%s\"", time_str);
-      }
-      
-      /* Add hostname if enabled */
-      if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_HOSTNAME) {
-        if (json_pos > (msg_offset + 1)) json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, ",");
-        json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, "\"hostname\":\"%s\"", g_fd_hostname);
-      }
-      
-      /* Add program name if enabled */
-      if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_PROGNAME) {
-        if (json_pos > (msg_offset + 1)) json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, ",");
-        json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, "\"progname\":\"%s\"", g_fd_progname);
-      }
-      
-      /* Add thread name if enabled (along with PID or as separate field) */
-      if ((g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_PID) ||
-          (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_PROGNAME)) {
-        if (json_pos > (msg_offset + 1)) json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, ",");
-        json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, "\"threadname\":\"%s\"", g_fd_threadname);
-      }
-      
-      /* Add PID if enabled */
-      if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_PID) {
-        if (json_pos > (msg_offset + 1)) json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, ",");
-        json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, "\"pid\":%d", g_fd_pid);
-      }
-      
-      /* Add log level if enabled */
-      if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_LOGLEVEL) {
-        if (json_pos > (msg_offset + 1)) json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, ",");
-        json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, "\"level\":\"%s\"", level_str);
-      }
-      
-      /* Add function name if enabled */
-      if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_FUNCNAME) {
-        if (json_pos > (msg_offset + 1)) json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, ",");
-        json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, "\"funcname\":\"%s\"", funcname);
-      }
-      
-      /* Add line number if enabled */
-      if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_LINENUM) {
-        if (json_pos > (msg_offset + 1)) json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, ",");
-        json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, "\"linenum\":%d", linenum);
-      }
-      
-      /* Add message */
-      if (json_pos > (msg_offset + 1)) json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, ",");
-      json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, "\"message\":\"%s\"", msg);
-      
-      /* Close JSON object */
-      json_pos += snprintf(&g_fd_total_message[json_pos], TOTAL_MSG_BYTES - json_pos, "}\n");
-      
-      len = json_pos - msg_offset;
+  if (g_fd_ring != NULL) {
+    rc = clogging_async_ring_push(g_fd_ring, g_fd_arena.buf, len);
+    if (rc == CLOGGING_ASYNC_OK) {
+      return;
     }
-  } else {
-    /* <HEADER> <MESSAGE>
-     *	<HEADER> = <TIMESTAMP> <HOSTNAME>
-     *	<MESSAGE> = <TAG> <LEVEL> <CONTENT>
-     *		<TAG> = <PROGRAM><THREAD>[<PID>]
-     *		<LEVEL> = DEBUG | INFO | WARNING | ERROR
-     *		<CONTENT> = <FUNCTION/MODULE>: <APPLICATION_MESSAGE>
-     */
-    if (g_fd_log_options.prefix_fields_flag == CLOGGING_PREFIX_DEFAULT) {
-      /* optimization for default setting */
-      len = snprintf(&g_fd_total_message[msg_offset], TOTAL_MSG_BYTES - msg_offset,
-                     "%s %s %s%s[%d] %s %s(%d): %s\n", time_str, g_fd_hostname,
-                     g_fd_progname, g_fd_threadname, g_fd_pid, level_str, funcname,
-                     linenum, msg);
-    } else {
-      /* Build prefix based on prefix_fields_flag */
-      char prefix[512] = {0};
-      int prefix_len = 0;
-      
-      if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_TIMESTAMP) {
-        prefix_len += snprintf(prefix + prefix_len, sizeof(prefix) - prefix_len, "%s ", time_str);
-      }
-      if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_HOSTNAME) {
-        prefix_len += snprintf(prefix + prefix_len, sizeof(prefix) - prefix_len, "%s ", g_fd_hostname);
-      }
-      if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_PROGNAME) {
-        prefix_len += snprintf(prefix + prefix_len, sizeof(prefix) - prefix_len, "%s", g_fd_progname);
-      }
-      if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_PID) {
-        prefix_len += snprintf(prefix + prefix_len, sizeof(prefix) - prefix_len, "%s[%d]", g_fd_threadname, g_fd_pid);
-      } else if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_PROGNAME) {
-        prefix_len += snprintf(prefix + prefix_len, sizeof(prefix) - prefix_len, "%s", g_fd_threadname);
-      }
-      if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_LOGLEVEL) {
-        prefix_len += snprintf(prefix + prefix_len, sizeof(prefix) - prefix_len, " %s", level_str);
-      }
-      
-      char content_prefix[128] = {0};
-      int content_len = 0;
-      if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_FUNCNAME) {
-        content_len += snprintf(content_prefix + content_len, sizeof(content_prefix) - content_len, "%s", funcname);
-      }
-      if (g_fd_log_options.prefix_fields_flag & CLOGGING_PREFIX_LINENUM) {
-        content_len += snprintf(content_prefix + content_len, sizeof(content_prefix) - content_len, "(%d)", linenum);
-      }
-      
-      /* leave the first two bytes for size */
-      if (prefix_len > 0) {
-        if (content_len > 0) {
-          len = snprintf(&g_fd_total_message[msg_offset], TOTAL_MSG_BYTES - msg_offset,
-                        "%s %s: %s\n", prefix, content_prefix, msg);
-        } else {
-          len = snprintf(&g_fd_total_message[msg_offset], TOTAL_MSG_BYTES - msg_offset,
-                        "%s %s\n", prefix, msg);
-        }
-      } else {
-        if (content_len > 0) {
-          len = snprintf(&g_fd_total_message[msg_offset], TOTAL_MSG_BYTES - msg_offset,
-                        "%s: %s\n", content_prefix, msg);
-        } else {
-          len = snprintf(&g_fd_total_message[msg_offset], TOTAL_MSG_BYTES - msg_offset,
-                        "%s\n", msg);
-        }
-      }
+    if (rc == CLOGGING_ASYNC_FULL) {
+      ++g_fd_num_msg_drops;
+      return;
     }
+    /* else the writer is gone, so write it inline */
   }
-  
-  if (len < 0) {
-    /* there is nothing much we can do, so return.  */
-    ++g_fd_num_msg_drops;
-    return;
-  }
-  /* Note that the null character at the end is not part of the len */
-  /* encode the length in big-endian format */
-  if (g_fd_prefix_length) {
-    g_fd_total_message[0] = (len >> 8) & 0x00ff;
-    g_fd_total_message[1] = (len & 0x00ff);
-  }
-  bytes_sent = clogging_handle_write(g_fd_handle, g_fd_total_message, len + msg_offset);
+  bytes_sent = clogging_handle_write(g_fd_handle, g_fd_arena.buf, len);
 #if VERBOSE
   if (bytes_sent < 0) {
     int err = errno;
     char errmsg[256];
     strerror_r(err, errmsg, sizeof(errmsg));
-    fprintf(stderr, "%s%s: write() failed, e=%d, errmsg=[%s]\n", g_fd_progname,
-            g_fd_threadname, err, errmsg);
+    fprintf(stderr, "%s%s: write() failed, e=%d, errmsg=[%s]\n", g_fd_format.progname,
+            g_fd_format.threadname, err, errmsg);
     ++g_fd_num_msg_drops;
-  } else if (bytes_sent != (len + msg_offset)) {
+  } else if (bytes_sent != len) {
     fprintf(stderr, "%s%s: could write only %d out of %d bytes\n",
-      g_fd_progname, g_fd_threadname, bytes_sent, len + msg_offset);
+      g_fd_format.progname, g_fd_format.threadname, bytes_sent, len);
   } else {
-    fprintf(stderr, "%s%s: success\n", g_fd_progname, g_fd_threadname);
+    fprintf(stderr, "%s%s: success\n", g_fd_format.progname, g_fd_format.threadname);
   }
 #else
-  if (bytes_sent < 0 || bytes_sent != (len + msg_offset)) {
+  if (bytes_sent < 0 || bytes_sent != len) {
     /* cannot write a thing, so drop the current message
      */
     ++g_fd_num_msg_drops;
@@ -436,9 +663,29 @@ void clogging_fd_logmsg(const char *funcname, int linenum, enum LogLevel level,
 }
 
 uint64_t clogging_fd_get_num_dropped_messages(void) {
+  if (g_fd_ring != NULL) {
+    return g_fd_num_msg_drops + clogging_async_ring_get_drops(g_fd_ring);
+  }
   return g_fd_num_msg_drops;
 }
 
+uint64_t clogging_fd_get_num_truncated_messages(void) {
+  if (g_fd_ring != NULL) {
+    return g_fd_num_msg_truncations +
+           clogging_async_ring_get_truncations(g_fd_ring);
+  }
+  return g_fd_num_msg_truncations;
+}
+
+int clogging_fd_flush(int timeout_ms) {
+  if (g_fd_ring == NULL) {
+    return 0;
+  }
+  return clogging_async_ring_flush(g_fd_ring, timeout_ms);
+}
+
+void clogging_fd_async_shutdown(void) { clogging_async_shutdown(); }
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,10 +9,15 @@
 #ifndef CLOGGING_FD_LOGGING_H
 #define CLOGGING_FD_LOGGING_H
 
+#include "log_filter.h"
+#include "log_ratelimit.h"
 #include "logging_common.h"
 
 #include <stdint.h>
 
+/* Least size of the per-thread ring in async mode, see clogging_fd_init() */
+#define CLOGGING_FD_ASYNC_RING_BYTES (64 * 1024)
+
 /* UTF-8 ENCODING NOTICE:
  * When compiled with CLOGGING_USE_UTF8_STRINGS, all string parameters
  * (progname, threadname, format strings, etc.) MUST be valid UTF-8.
@@ -49,6 +54,23 @@ extern "C" {
  * 
  * opts is a pointer to clogging_log_options_t structure that configures logging behavior
  * (color output, JSON/JSONL format, prefix fields). Can be NULL to use defaults.
+ *
+ * When opts->async is set the calling thread gets its own ring of
+ * CLOGGING_FD_ASYNC_RING_BYTES bytes, or more so that it takes two lines
+ * of max_line_bytes of the options. clogging_fd_logmsg() then only
+ * formats the record and copies it into the ring, while a single
+ * background writer thread (shared by all the threads) drains the rings
+ * to their handles. A record which does not fit in the ring is dropped
+ * and counted, so a slow handle never blocks the logging thread.
+ *
+ * When opts->deferred is set (which implies async) even the formatting
+ * moves to the writer thread. clogging_fd_logmsg() only copies the raw
+ * arguments into the ring (in the encoding of binary logging) and the
+ * writer renders them to the very same text or JSON line. Formats which
+ * cannot be captured faithfully ('*' width/precision, %n, wide chars)
+ * or arguments which do not fit are formatted right away instead.
+ * IMPORTANT: the format and funcname are kept by reference, so they must
+ * be string literals (or otherwise outlive the writer thread) in this mode.
  */
 int clogging_fd_init(const char *progname,
                      const char *threadname,
@@ -62,18 +84,31 @@ int clogging_fd_init(const char *progname,
   clogging_fd_init((progname), (progname_len), (threadname), (threadname_len), (level), \
                    clogging_create_handle_from_fd(fd))
 
-/*
+/* Set the log level of the calling thread, which overrides the one of
+ * the process until clogging_fd_set_process_loglevel() is called again.
+ * clogging_fd_init() sets it too.
+ *
  * It is a MT safe implementation.
  */
 void clogging_fd_set_loglevel(enum LogLevel level);
 
-/* Get the current log level.
+/* Get the current log level of the calling thread.
  *
  * Irrespective of LOGGING_WITH_THREAD_LOCAL_STORAGE this method
  * will do an atomic read, which is MT safe.
  */
 enum LogLevel clogging_fd_get_loglevel(void);
 
+/* Set the log level of every thread of the process, including those
+ * which set their own before. See clogging_basic_set_process_loglevel().
+ *
+ * It is a MT safe implementation.
+ */
+void clogging_fd_set_process_loglevel(enum LogLevel level);
+
+/* Get the log level of the process. */
+enum LogLevel clogging_fd_get_process_loglevel(void);
+
 /* This will fail if init_logging() is not invoked earlier.
  * There is an additional cost to validating the initiatized state
  * but its worth the check.
@@ -101,11 +136,125 @@ enum LogLevel clogging_fd_get_loglevel(void);
 void clogging_fd_logmsg(const char *funcname, int linenum, enum LogLevel level,
                         const char *format, ...);
 
+/* Whether a message of level would be logged by the current thread,
+ * see CLOGGING_BASIC_LEVEL_ENABLED().
+ */
+#ifdef _WIN32
+#define CLOGGING_FD_LEVEL() ((int)clogging_fd_get_loglevel())
+#else
+extern uint32_t clogging_fd_process_level;
+extern __thread uint32_t clogging_fd_thread_level;
+#define CLOGGING_FD_LEVEL()                                                   \
+  clogging_level_of(&clogging_fd_process_level,                               \
+                    clogging_fd_thread_level)
+#endif /* _WIN32 */
+#define CLOGGING_FD_LEVEL_ENABLED(level)                                      \
+  ((level) <= CLOGGING_MIN_LEVEL && (int)(level) <= CLOGGING_FD_LEVEL())
+
+/* The same for a call site, whose filter (see log_filter.h) overrides
+ * the level of the thread, with site the static word of its cache.
+ */
+#define CLOGGING_FD_SITE_ENABLED(site, level)                                 \
+  ((level) <= CLOGGING_MIN_LEVEL &&                                           \
+   (int)(level) <= CLOGGING_FILTER_LEVEL((site), CLOGGING_FD_LEVEL()))
+
+/* Log with clogging_fd_logmsg() only when level is enabled, without
+ * evaluating the arguments otherwise.
+ */
+#define CLOGGING_FD_LOG(level, format, ...)                                   \
+  do {                                                                        \
+    static uint32_t clogging_filter_site_;                                    \
+    if (CLOGGING_FD_SITE_ENABLED(&clogging_filter_site_, level)) {            \
+      clogging_fd_logmsg(__func__, __LINE__, CLOGGING_CHECKED_LEVEL(level),   \
+                         format, ##__VA_ARGS__);                              \
+    }                                                                         \
+  } while (0)
+
+#define FD_LOG_ERROR(format, ...)                                             \
+  CLOGGING_KEEP_ERROR(                                                        \
+      CLOGGING_FD_LOG(LOG_LEVEL_ERROR, format, ##__VA_ARGS__))
+#define FD_LOG_WARN(format, ...)                                              \
+  CLOGGING_KEEP_WARN(                                                         \
+      CLOGGING_FD_LOG(LOG_LEVEL_WARN, format, ##__VA_ARGS__))
+#define FD_LOG_INFO(format, ...)                                              \
+  CLOGGING_KEEP_INFO(                                                         \
+      CLOGGING_FD_LOG(LOG_LEVEL_INFO, format, ##__VA_ARGS__))
+#define FD_LOG_DEBUG(format, ...)                                             \
+  CLOGGING_KEEP_DEBUG(                                                        \
+      CLOGGING_FD_LOG(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__))
+
+/* CLOGGING_FD_LOG() of at most burst messages at once from the call
+ * site and per_second more each second, checked before the arguments are
+ * evaluated. The next message logged tells how many were suppressed in
+ * between, so format has to be a string literal, see log_ratelimit.h.
+ */
+#define CLOGGING_FD_LOG_RATELIMITED(level, burst, per_second, format, ...)    \
+  do {                                                                        \
+    static uint32_t clogging_filter_site_;                                    \
+    static clogging_ratelimit_t clogging_ratelimit_;                          \
+    uint32_t clogging_suppressed_ = 0;                                        \
+    if (CLOGGING_FD_SITE_ENABLED(&clogging_filter_site_, level) &&            \
+        clogging_ratelimit_allow(&clogging_ratelimit_, (burst), (per_second), \
+                                 &clogging_suppressed_)) {                    \
+      if (clogging_suppressed_ == 0) {                                        \
+        clogging_fd_logmsg(__func__, __LINE__,                                \
+                           CLOGGING_CHECKED_LEVEL(level), format,             \
+                           ##__VA_ARGS__);                                    \
+      } else {                                                                \
+        clogging_fd_logmsg(__func__, __LINE__,                                \
+                           CLOGGING_CHECKED_LEVEL(level),                     \
+                           format CLOGGING_SUPPRESSED_FORMAT, ##__VA_ARGS__,  \
+                           clogging_suppressed_);                             \
+      }                                                                       \
+    }                                                                         \
+  } while (0)
+
+#define FD_LOG_ERROR_RATELIMITED(burst, per_second, format, ...)              \
+  CLOGGING_KEEP_ERROR(CLOGGING_FD_LOG_RATELIMITED(                            \
+      LOG_LEVEL_ERROR, burst, per_second, format, ##__VA_ARGS__))
+#define FD_LOG_WARN_RATELIMITED(burst, per_second, format, ...)               \
+  CLOGGING_KEEP_WARN(CLOGGING_FD_LOG_RATELIMITED(                             \
+      LOG_LEVEL_WARN, burst, per_second, format, ##__VA_ARGS__))
+#define FD_LOG_INFO_RATELIMITED(burst, per_second, format, ...)               \
+  CLOGGING_KEEP_INFO(CLOGGING_FD_LOG_RATELIMITED(                             \
+      LOG_LEVEL_INFO, burst, per_second, format, ##__VA_ARGS__))
+#define FD_LOG_DEBUG_RATELIMITED(burst, per_second, format, ...)              \
+  CLOGGING_KEEP_DEBUG(CLOGGING_FD_LOG_RATELIMITED(                            \
+      LOG_LEVEL_DEBUG, burst, per_second, format, ##__VA_ARGS__))
+
 /* Get the number of messages dropped due to overload or
  * internal errors.
+ *
+ * In async mode this includes the messages the writer thread could not
+ * write to the handle of the current thread.
  */
 uint64_t clogging_fd_get_num_dropped_messages(void);
 
+/* Get the number of messages which were cut short because the line
+ * would have been longer than max_line_bytes of the options.
+ *
+ * In deferred mode this includes the messages the writer thread
+ * rendered for the current thread.
+ */
+uint64_t clogging_fd_get_num_truncated_messages(void);
+
+/* Wait till the writer thread has written every message logged so far
+ * by the current thread. This is a no-op unless the thread was
+ * initialized in async mode.
+ *
+ * Returns 0 on success and -1 when the messages could not be drained
+ * within timeout_ms milliseconds (a negative value waits forever).
+ */
+int clogging_fd_flush(int timeout_ms);
+
+/* Write all the pending async messages of all the threads and stop the
+ * background writer thread. Messages logged afterwards are written
+ * inline by the logging thread.
+ *
+ * This is done automatically at exit() as well.
+ */
+void clogging_fd_async_shutdown(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "json_escape.h"
+
+#include <stdint.h>
+#include <string.h> /* memcpy(), memset() */
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_HAVE_SSE2 1
+#include <emmintrin.h> /* _mm_loadu_si128() and friends */
+#endif
+
+/* AVX2 is picked at runtime, so the library still runs on CPUs without
+ * it when it is not built for them with -mavx2.
+ */
+#if defined(JSON_HAVE_SSE2) && defined(__GNUC__) &&                          \
+    (defined(__x86_64__) || defined(__i386__))
+#define JSON_HAVE_AVX2 1
+#include <immintrin.h> /* _mm256_loadu_si256() and friends */
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define JSON_HAVE_NEON 1
+#include <arm_neon.h> /* vld1q_u8() and friends */
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h> /* _BitScanForward() */
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(JSON_HAVE_SSE2) && !defined(JSON_HAVE_NEON)
+/* Copies what it scanned to dst unless it is NULL, the vector versions
+ * below may copy bytes beyond the returned index, but never more than
+ * len bytes.
+ */
+static size_t scan_scalar(const char *s, size_t len, char *dst) {
+  size_t i = 0;
+
+  for (i = 0; i < len; ++i) {
+    unsigned char c = (unsigned char)s[i];
+
+    if (c < 0x20 || c == '"' || c == '\\') {
+      break;
+    }
+    if (dst != NULL) {
+      dst[i] = s[i];
+    }
+  }
+  return i;
+}
+#endif
+
+#if defined(JSON_HAVE_SSE2) || defined(JSON_HAVE_NEON)
+/* index of the lowest set bit of a non-zero mask */
+static int first_bit(uint64_t mask) {
+#ifdef _MSC_VER
+  unsigned long index = 0;
+#if defined(_M_X64) || defined(_M_ARM64)
+  _BitScanForward64(&index, mask);
+#else
+  if (!_BitScanForward(&index, (unsigned long)mask)) {
+    _BitScanForward(&index, (unsigned long)(mask >> 32));
+    index += 32;
+  }
+#endif
+  return (int)index;
+#else
+  return __builtin_ctzll(mask);
+#endif
+}
+#endif
+
+#ifdef JSON_HAVE_SSE2
+/* bit mask of the bytes of the 16 at s which must be escaped */
+static int block_sse2(const char *s, char *dst) {
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1f);
+  __m128i v = _mm_loadu_si128((const __m128i *)(const void *)s);
+  /* min(v, 0x1f) == v for the control characters */
+  __m128i found = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+      _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+
+  if (dst != NULL) {
+    _mm_storeu_si128((__m128i *)(void *)dst, v);
+  }
+  return _mm_movemask_epi8(found);
+}
+
+/* Scan s[i, len) knowing that s[0, i) needs no escaping. */
+static size_t scan_sse2_from(const char *s, size_t i, size_t len, char *dst) {
+  char padded[16];
+  int mask = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    mask = block_sse2(s + i, (dst != NULL) ? dst + i : NULL);
+    if (mask != 0) {
+      return i + (size_t)first_bit((uint64_t)(unsigned int)mask);
+    }
+  }
+  if (i == len) {
+    return len;
+  }
+  if (len >= 16) {
+    /* the last 16 bytes overlap what is known to be fine */
+    mask = block_sse2(s + len - 16, (dst != NULL) ? dst + len - 16 : NULL);
+    return (mask != 0) ? len - 16 + (size_t)first_bit((uint64_t)(unsigned int)mask)
+                       : len;
+  }
+  /* short strings go through a copy padded with spaces */
+  memset(padded, ' ', sizeof(padded));
+  memcpy(padded, s, len);
+  mask = block_sse2(padded, NULL);
+  i = (mask != 0) ? (size_t)first_bit((uint64_t)(unsigned int)mask) : len;
+  if (dst != NULL) {
+    memcpy(dst, s, i);
+  }
+  return i;
+}
+
+static size_t scan_sse2(const char *s, size_t len, char *dst) {
+  return scan_sse2_from(s, 0, len, dst);
+}
+#endif /* JSON_HAVE_SSE2 */
+
+#ifdef JSON_HAVE_AVX2
+__attribute__((target("avx2")))
+static size_t scan_avx2(const char *s, size_t len, char *dst) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i control = _mm256_set1_epi8(0x1f);
+  size_t i = 0;
+
+  for (i = 0; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(const void *)(s + i));
+    __m256i found = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                        _mm256_cmpeq_epi8(v, backslash)),
+        _mm256_cmpeq_epi8(_mm256_min_epu8(v, control), v));
+    unsigned int mask = (unsigned int)_mm256_movemask_epi8(found);
+
+    if (dst != NULL) {
+      _mm256_storeu_si256((__m256i *)(void *)(dst + i), v);
+    }
+    if (mask != 0) {
+      return i + (size_t)first_bit(mask);
+    }
+  }
+  /* scan_sse2_from() is not VEX encoded, so avoid the transition penalty */
+  _mm256_zeroupper();
+  return scan_sse2_from(s, i, len, dst);
+}
+#endif /* JSON_HAVE_AVX2 */
+
+#ifdef JSON_HAVE_NEON
+/* mask with 4 bits for each of the 16 bytes at s which must be escaped */
+static uint64_t block_neon(const char *s, char *dst) {
+  const uint8x16_t quote = vdupq_n_u8('"');
+  const uint8x16_t backslash = vdupq_n_u8('\\');
+  const uint8x16_t space = vdupq_n_u8(0x20);
+  uint8x16_t v = vld1q_u8((const uint8_t *)s);
+  uint8x16_t found = vorrq_u8(
+      vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)),
+      vcltq_u8(v, space));
+
+  if (dst != NULL) {
+    vst1q_u8((uint8_t *)dst, v);
+  }
+  return vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(found), 4)), 0);
+}
+
+static size_t scan_neon(const char *s, size_t len, char *dst) {
+  char padded[16];
+  uint64_t mask = 0;
+  size_t i = 0;
+
+  for (i = 0; i + 16 <= len; i += 16) {
+    mask = block_neon(s + i, (dst != NULL) ? dst + i : NULL);
+    if (mask != 0) {
+      return i + (size_t)(first_bit(mask) >> 2);
+    }
+  }
+  if (i == len) {
+    return len;
+  }
+  if (len >= 16) {
+    /* the last 16 bytes overlap what is known to be fine */
+    mask = block_neon(s + len - 16, (dst != NULL) ? dst + len - 16 : NULL);
+    return (mask != 0) ? len - 16 + (size_t)(first_bit(mask) >> 2) : len;
+  }
+  /* short strings go through a copy padded with spaces */
+  memset(padded, ' ', sizeof(padded));
+  memcpy(padded, s, len);
+  mask = block_neon(padded, NULL);
+  i = (mask != 0) ? (size_t)(first_bit(mask) >> 2) : len;
+  if (dst != NULL) {
+    memcpy(dst, s, i);
+  }
+  return i;
+}
+#endif /* JSON_HAVE_NEON */
+
+static size_t scan(const char *s, size_t len, char *dst) {
+#if defined(JSON_HAVE_AVX2)
+#ifdef __AVX2__
+  return scan_avx2(s, len, dst);
+#else
+  if (len >= 32 && __builtin_cpu_supports("avx2")) {
+    return scan_avx2(s, len, dst);
+  }
+  return scan_sse2(s, len, dst);
+#endif
+#elif defined(JSON_HAVE_SSE2)
+  return scan_sse2(s, len, dst);
+#elif defined(JSON_HAVE_NEON)
+  return scan_neon(s, len, dst);
+#else
+  return scan_scalar(s, len, dst);
+#endif
+}
+
+size_t clogging_json_scan(const char *s, size_t len) {
+  return scan(s, len, NULL);
+}
+
+size_t clogging_json_copy(char *dst, const char *s, size_t len) {
+  return scan(s, len, dst);
+}
+
+int clogging_json_escape_char(unsigned char c,
+                              char out[CLOGGING_JSON_MAX_ESCAPE_LEN]) {
+  static const char hex[] = "0123456789abcdef";
+
+  out[0] = '\\';
+  switch (c) {
+  case '"':
+    out[1] = '"';
+    return 2;
+  case '\\':
+    out[1] = '\\';
+    return 2;
+  case '\b':
+    out[1] = 'b';
+    return 2;
+  case '\f':
+    out[1] = 'f';
+    return 2;
+  case '\n':
+    out[1] = 'n';
+    return 2;
+  case '\r':
+    out[1] = 'r';
+    return 2;
+  case '\t':
+    out[1] = 't';
+    return 2;
+  default:
+    out[1] = 'u';
+    out[2] = '0';
+    out[3] = '0';
+    out[4] = hex[(c >> 4) & 0x0f];
+    out[5] = hex[c & 0x0f];
+    return 6;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
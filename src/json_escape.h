@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifndef CLOGGING_JSON_ESCAPE_H
+#define CLOGGING_JSON_ESCAPE_H
+
+#include <stddef.h>
+
+/* Escaping of strings for the JSON log lines.
+ *
+ * Log messages rarely contain anything which must be escaped, so the
+ * string is scanned 16 or 32 bytes at a time (SSE2 or AVX2 on x86, NEON
+ * on aarch64, with a portable fallback) and only the bytes found by the
+ * scan are escaped one at a time. Bytes of 0x80 and above are passed
+ * through, so valid UTF-8 stays valid.
+ *
+ * This is an internal building block of the logging backends and is
+ * not installed.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Longest escape sequence of a single byte, "\u001f". */
+#define CLOGGING_JSON_MAX_ESCAPE_LEN 6
+
+/* Get the index of the first byte of s[0, len) which must be escaped in
+ * a JSON string, that is '"', '\\' or a control character below 0x20.
+ * Returns len when there is none.
+ */
+size_t clogging_json_scan(const char *s, size_t len);
+
+/* The same as clogging_json_scan() but also copy the bytes before the
+ * returned index to dst, which must have room for len bytes. Note that
+ * dst may be written beyond the returned index.
+ */
+size_t clogging_json_copy(char *dst, const char *s, size_t len);
+
+/* Write the escape sequence for the byte c, which must be one found by
+ * clogging_json_scan(), to out and return its length.
+ */
+int clogging_json_escape_char(unsigned char c,
+                              char out[CLOGGING_JSON_MAX_ESCAPE_LEN]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOGGING_JSON_ESCAPE_H */
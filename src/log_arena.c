@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "log_arena.h"
+
+#include <stdlib.h> /* realloc(), free() */
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h> /* FlsAlloc(), InitOnceExecuteOnce() */
+#else
+#include <pthread.h> /* pthread_key_create() and friends */
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The arenas themselves are thread local variables of the backends, so
+ * only their buffers are freed at thread exit.
+ */
+#ifdef _WIN32
+static INIT_ONCE g_arena_key_once = INIT_ONCE_STATIC_INIT;
+static DWORD g_arena_thread_key = FLS_OUT_OF_INDEXES;
+
+static void CALLBACK arena_thread_exit(PVOID value) {
+#else
+static pthread_once_t g_arena_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_arena_thread_key;
+
+static void arena_thread_exit(void *value) {
+#endif
+  clogging_arena_t *arena = (clogging_arena_t *)value;
+  clogging_arena_t *next = NULL;
+
+  while (arena != NULL) {
+    next = arena->thread_next;
+    free(arena->buf);
+    arena->buf = NULL;
+    arena->size = 0;
+    arena->thread_next = NULL;
+    arena = next;
+  }
+}
+
+#ifdef _WIN32
+static BOOL CALLBACK arena_key_init(PINIT_ONCE once, PVOID param,
+                                    PVOID *context) {
+  (void)once;
+  (void)param;
+  (void)context;
+  g_arena_thread_key = FlsAlloc(arena_thread_exit);
+  return TRUE;
+}
+#else
+static void arena_key_init(void) {
+  pthread_key_create(&g_arena_thread_key, arena_thread_exit);
+}
+#endif
+
+static void arena_register(clogging_arena_t *arena) {
+#ifdef _WIN32
+  InitOnceExecuteOnce(&g_arena_key_once, arena_key_init, NULL, NULL);
+  if (g_arena_thread_key != FLS_OUT_OF_INDEXES) {
+    arena->thread_next = (clogging_arena_t *)FlsGetValue(g_arena_thread_key);
+    FlsSetValue(g_arena_thread_key, arena);
+  }
+#else
+  pthread_once(&g_arena_key_once, arena_key_init);
+  arena->thread_next =
+      (clogging_arena_t *)pthread_getspecific(g_arena_thread_key);
+  pthread_setspecific(g_arena_thread_key, arena);
+#endif
+}
+
+int clogging_arena_max_bytes(uint32_t max_line_bytes) {
+  if (max_line_bytes == 0) {
+    return CLOGGING_DEFAULT_MAX_LINE_BYTES;
+  }
+  if (max_line_bytes > CLOGGING_MAX_LINE_BYTES) {
+    return CLOGGING_MAX_LINE_BYTES;
+  }
+  return (int)max_line_bytes;
+}
+
+void clogging_arena_init(clogging_arena_t *arena, uint32_t max_line_bytes) {
+  arena->max_size = clogging_arena_max_bytes(max_line_bytes);
+}
+
+int clogging_arena_reserve(clogging_arena_t *arena, int size) {
+  int new_size = (arena->size > 0) ? arena->size : CLOGGING_ARENA_MIN_BYTES;
+  char *buf = NULL;
+
+  if (size > arena->max_size) {
+    size = arena->max_size;
+  }
+  if (size <= arena->size) {
+    return (arena->size < arena->max_size) ? arena->size : arena->max_size;
+  }
+  while (new_size < size) {
+    new_size *= 2;
+  }
+  if (new_size > arena->max_size) {
+    new_size = arena->max_size;
+  }
+
+  buf = (char *)realloc(arena->buf, (size_t)new_size);
+  if (buf == NULL) {
+    return (arena->buf != NULL) ? arena->size : -1;
+  }
+  if (arena->buf == NULL) {
+    arena_register(arena);
+  }
+  arena->buf = buf;
+  arena->size = new_size;
+  return new_size;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifndef CLOGGING_LOG_ARENA_H
+#define CLOGGING_LOG_ARENA_H
+
+#include "logging_common.h"
+
+/* Per-thread line buffers of the text backends.
+ *
+ * A buffer is allocated on the first message of the thread with room
+ * for a short line only, and doubles whenever a longer line comes along,
+ * up to the max_line_bytes of the options. So a thread which never logs
+ * costs a few pointers of thread local storage, and one which logs
+ * short lines a small allocation. The buffer is freed when the thread
+ * exits. Binary logging keeps the bitmap of the call sites a thread has
+ * announced in one as well.
+ *
+ * This is an internal building block of the logging backends and is
+ * not installed.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* size of the first allocation, if max_size allows */
+#define CLOGGING_ARENA_MIN_BYTES 256
+
+typedef struct clogging_arena {
+  char *buf;
+  int size;
+  int max_size;
+  /* other arenas of the same thread, freed together at thread exit */
+  struct clogging_arena *thread_next;
+} clogging_arena_t;
+
+/* Get the size of a line buffer for max_line_bytes of the options,
+ * which is CLOGGING_DEFAULT_MAX_LINE_BYTES when 0 and never more than
+ * CLOGGING_MAX_LINE_BYTES.
+ */
+int clogging_arena_max_bytes(uint32_t max_line_bytes);
+
+/* Set the limit of the arena of the calling thread, without allocating
+ * anything yet.
+ */
+void clogging_arena_init(clogging_arena_t *arena, uint32_t max_line_bytes);
+
+/* Make sure arena->buf has room for size bytes, growing it when it is
+ * smaller and the limit allows.
+ *
+ * Returns the usable size of arena->buf, which is less than size when
+ * the limit (or a failed allocation) does not allow growing it that far,
+ * or -1 when there is no buffer at all.
+ */
+int clogging_arena_reserve(clogging_arena_t *arena, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOGGING_LOG_ARENA_H */
@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "log_clock.h"
+
+#include <stdatomic.h> /* atomic_load_explicit() and friends */
+#include <stdio.h>     /* snprintf() */
+#include <string.h>    /* memmove() */
+#include <time.h>      /* clock_gettime() */
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>  /* GetSystemTimePreciseAsFileTime(), Sleep() */
+#include <intrin.h>   /* __rdtsc(), __cpuid() */
+#else
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>     /* __get_cpuid() */
+#include <x86intrin.h> /* __rdtsc() */
+#endif
+#endif /* _WIN32 */
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) ||         \
+    defined(_M_IX86)
+#define CLOCK_HAVE_TSC 1
+#elif defined(__aarch64__)
+#define CLOCK_HAVE_TSC 1
+#else
+#define CLOCK_HAVE_TSC 0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NSEC_PER_SEC 1000000000LL
+
+/* between 1601-01-01 (FILETIME) and 1970-01-01 in 100ns intervals */
+#define FILETIME_UNIX_EPOCH 116444736000000000LL
+
+/* long enough to get the frequency right to a few ppm */
+#define TSC_CALIBRATION_NS 20000000LL
+
+enum tsc_state {
+  TSC_UNKNOWN = 0,
+  TSC_CALIBRATING,
+  TSC_READY,
+  TSC_UNUSABLE
+};
+
+static atomic_int g_clock_tsc_state = TSC_UNKNOWN;
+static clogging_tsc_calibration_t g_clock_tsc_calibration;
+
+/* 10^(9 - digits) for the digits of each precision */
+static const int64_t g_clock_precision_divisor[] = {
+    NSEC_PER_SEC, /* CLOGGING_TIME_PRECISION_SEC */
+    1000000,      /* CLOGGING_TIME_PRECISION_MS */
+    1000,         /* CLOGGING_TIME_PRECISION_US */
+    1             /* CLOGGING_TIME_PRECISION_NS */
+};
+static const int g_clock_precision_digits[] = {0, 3, 6, 9};
+
+static void clock_read_realtime(int coarse, clogging_timestamp_t *ts) {
+#ifdef _WIN32
+  FILETIME ft;
+  ULARGE_INTEGER val;
+  int64_t units = 0;
+
+  if (coarse) {
+    GetSystemTimeAsFileTime(&ft);
+  } else {
+    GetSystemTimePreciseAsFileTime(&ft);
+  }
+  val.LowPart = ft.dwLowDateTime;
+  val.HighPart = ft.dwHighDateTime;
+  units = (int64_t)val.QuadPart - FILETIME_UNIX_EPOCH;
+  ts->sec = units / 10000000LL;
+  ts->nsec = (uint32_t)((units % 10000000LL) * 100);
+#else
+  struct timespec now;
+
+#ifdef CLOCK_REALTIME_COARSE
+  clock_gettime(coarse ? CLOCK_REALTIME_COARSE : CLOCK_REALTIME, &now);
+#else
+  (void)coarse;
+  clock_gettime(CLOCK_REALTIME, &now);
+#endif
+  ts->sec = (int64_t)now.tv_sec;
+  ts->nsec = (uint32_t)now.tv_nsec;
+#endif /* _WIN32 */
+}
+
+uint64_t clogging_clock_read_ticks(void) {
+#if defined(__aarch64__)
+  uint64_t ticks = 0;
+
+  __asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r"(ticks));
+  return ticks;
+#elif CLOCK_HAVE_TSC
+  return (uint64_t)__rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/* Only a TSC which ticks at a constant rate in every power state and is
+ * in sync across cores can stand in for a clock.
+ */
+static int clock_tsc_is_invariant(void) {
+#if defined(__aarch64__)
+  return 1;
+#elif defined(_WIN32) && CLOCK_HAVE_TSC
+  int regs[4] = {0};
+
+  __cpuid(regs, 0x80000000);
+  if ((unsigned int)regs[0] < 0x80000007u) {
+    return 0;
+  }
+  __cpuid(regs, 0x80000007);
+  return (regs[3] >> 8) & 1;
+#elif CLOCK_HAVE_TSC
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+
+  if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+    return 0;
+  }
+  return (edx >> 8) & 1;
+#else
+  return 0;
+#endif
+}
+
+static int64_t clock_ns_between(const clogging_timestamp_t *from,
+                                const clogging_timestamp_t *to) {
+  return (to->sec - from->sec) * NSEC_PER_SEC +
+         ((int64_t)to->nsec - (int64_t)from->nsec);
+}
+
+/* Pair a tick count with the wall clock time by reading the counter on
+ * both sides of the clock.
+ */
+static uint64_t clock_sample(clogging_timestamp_t *ts) {
+  uint64_t before = clogging_clock_read_ticks();
+  uint64_t after = 0;
+
+  clock_read_realtime(0, ts);
+  after = clogging_clock_read_ticks();
+  return before + (after - before) / 2;
+}
+
+static int clock_calibrate_tsc(clogging_tsc_calibration_t *cal) {
+  clogging_timestamp_t start;
+  clogging_timestamp_t now;
+  uint64_t start_ticks = 0;
+  uint64_t ticks = 0;
+  int64_t elapsed_ns = 0;
+
+  if (!clock_tsc_is_invariant()) {
+    return -1;
+  }
+#if defined(__aarch64__)
+  {
+    uint64_t freq = 0;
+
+    /* the generic timer tells its own frequency */
+    __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(freq));
+    if (freq > 0) {
+      cal->base_ticks = clock_sample(&start);
+      cal->base_sec = start.sec;
+      cal->base_nsec = start.nsec;
+      cal->ticks_per_sec = freq;
+      return 0;
+    }
+  }
+#endif
+  start_ticks = clock_sample(&start);
+  do {
+    ticks = clock_sample(&now);
+    elapsed_ns = clock_ns_between(&start, &now);
+  } while (elapsed_ns >= 0 && elapsed_ns < TSC_CALIBRATION_NS);
+  if (elapsed_ns <= 0 || ticks <= start_ticks) {
+    /* the clock stepped backwards, trust neither */
+    return -1;
+  }
+  cal->ticks_per_sec = (uint64_t)((double)(ticks - start_ticks) *
+                                  (double)NSEC_PER_SEC / (double)elapsed_ns);
+  cal->base_ticks = ticks;
+  cal->base_sec = now.sec;
+  cal->base_nsec = now.nsec;
+  return cal->ticks_per_sec > 0 ? 0 : -1;
+}
+
+int clogging_clock_get_tsc_calibration(clogging_tsc_calibration_t *cal) {
+  int state = atomic_load_explicit(&g_clock_tsc_state, memory_order_acquire);
+  int expected = TSC_UNKNOWN;
+
+  if (state == TSC_UNKNOWN &&
+      atomic_compare_exchange_strong(&g_clock_tsc_state, &expected,
+                                     TSC_CALIBRATING)) {
+    state = clock_calibrate_tsc(&g_clock_tsc_calibration) == 0
+                ? TSC_READY
+                : TSC_UNUSABLE;
+    atomic_store_explicit(&g_clock_tsc_state, state, memory_order_release);
+  }
+  while (state == TSC_UNKNOWN || state == TSC_CALIBRATING) {
+    /* some other thread is calibrating, which does not take long */
+#ifdef _WIN32
+    Sleep(1);
+#else
+    struct timespec ts = {0, 1000000L};
+    nanosleep(&ts, NULL);
+#endif
+    state = atomic_load_explicit(&g_clock_tsc_state, memory_order_acquire);
+  }
+  if (state != TSC_READY) {
+    return -1;
+  }
+  if (cal != NULL) {
+    *cal = g_clock_tsc_calibration;
+  }
+  return 0;
+}
+
+void clogging_clock_ticks_to_timestamp(const clogging_tsc_calibration_t *cal,
+                                       uint64_t ticks,
+                                       clogging_timestamp_t *ts) {
+  uint64_t delta = 0;
+  int64_t sec = 0;
+  int64_t nsec = 0;
+
+  /* a core may be slightly behind the one which calibrated */
+  delta = ticks >= cal->base_ticks ? ticks - cal->base_ticks
+                                   : cal->base_ticks - ticks;
+  sec = (int64_t)(delta / cal->ticks_per_sec);
+  nsec = (int64_t)((delta % cal->ticks_per_sec) * (uint64_t)NSEC_PER_SEC /
+                   cal->ticks_per_sec);
+  if (ticks < cal->base_ticks) {
+    sec = -sec;
+    nsec = -nsec;
+  }
+  sec += cal->base_sec;
+  nsec += cal->base_nsec;
+  if (nsec < 0) {
+    nsec += NSEC_PER_SEC;
+    --sec;
+  } else if (nsec >= NSEC_PER_SEC) {
+    nsec -= NSEC_PER_SEC;
+    ++sec;
+  }
+  ts->sec = sec;
+  ts->nsec = (uint32_t)nsec;
+}
+
+void clogging_clock_now(uint8_t source, clogging_timestamp_t *ts) {
+  switch (source) {
+  case CLOGGING_CLOCK_REALTIME_COARSE:
+    clock_read_realtime(1, ts);
+    break;
+  case CLOGGING_CLOCK_TSC:
+    if (atomic_load_explicit(&g_clock_tsc_state, memory_order_acquire) ==
+            TSC_READY ||
+        clogging_clock_get_tsc_calibration(NULL) == 0) {
+      clogging_clock_ticks_to_timestamp(&g_clock_tsc_calibration,
+                                        clogging_clock_read_ticks(), ts);
+      break;
+    }
+    clock_read_realtime(0, ts);
+    break;
+  default:
+    clock_read_realtime(0, ts);
+    break;
+  }
+}
+
+int64_t clogging_timestamp_to_units(const clogging_timestamp_t *ts,
+                                    uint8_t precision) {
+  if (precision > CLOGGING_TIME_PRECISION_NS) {
+    precision = CLOGGING_TIME_PRECISION_NS;
+  }
+  return ts->sec * (NSEC_PER_SEC / g_clock_precision_divisor[precision]) +
+         (int64_t)ts->nsec / g_clock_precision_divisor[precision];
+}
+
+void clogging_timestamp_from_units(int64_t units, uint8_t precision,
+                                   clogging_timestamp_t *ts) {
+  int64_t per_sec = 0;
+  int64_t rem = 0;
+
+  if (precision > CLOGGING_TIME_PRECISION_NS) {
+    precision = CLOGGING_TIME_PRECISION_NS;
+  }
+  per_sec = NSEC_PER_SEC / g_clock_precision_divisor[precision];
+  /* round towards negative infinity for times before the Epoch */
+  rem = units % per_sec;
+  if (rem < 0) {
+    rem += per_sec;
+  }
+  ts->sec = (units - rem) / per_sec;
+  ts->nsec = (uint32_t)(rem * g_clock_precision_divisor[precision]);
+}
+
+int clogging_timestamp_to_cstr(const clogging_timestamp_t *ts,
+                               uint8_t precision, char *timestr, int maxlen) {
+  char buf[CLOGGING_MAX_TIME_STR_LEN + 16];
+  time_t t = (time_t)ts->sec;
+  int digits = 0;
+  int64_t frac = 0;
+  int len = 0;
+  int pos = 0;
+  int i = 0;
+
+  if (precision == CLOGGING_TIME_PRECISION_SEC) {
+    return time_to_cstr(&t, timestr, maxlen);
+  }
+  if (precision > CLOGGING_TIME_PRECISION_NS) {
+    precision = CLOGGING_TIME_PRECISION_NS;
+  }
+
+  len = time_to_cstr(&t, buf, sizeof(buf) - 10);
+  if (len < 6) {
+    return -1;
+  }
+  /* insert ".fff" in front of the trailing "+00:00" */
+  digits = g_clock_precision_digits[precision];
+  frac = (int64_t)ts->nsec / g_clock_precision_divisor[precision];
+  pos = len - 6;
+  memmove(&buf[pos + 1 + digits], &buf[pos], 7);
+  buf[pos] = '.';
+  for (i = digits; i > 0; --i) {
+    buf[pos + i] = (char)('0' + frac % 10);
+    frac /= 10;
+  }
+  len += 1 + digits;
+
+  if (len < maxlen) {
+    memcpy(timestr, buf, (size_t)len + 1);
+    return len;
+  }
+  return snprintf(timestr, maxlen, "%s", buf);
+}
+
+#ifdef __cplusplus
+}
+#endif
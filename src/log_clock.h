@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifndef CLOGGING_LOG_CLOCK_H
+#define CLOGGING_LOG_CLOCK_H
+
+#include "logging_common.h"
+
+#include <stdint.h>
+
+/* Clock sources and timestamp precision for the log records, see
+ * clock_source and time_precision in clogging_log_options_t.
+ *
+ * CLOGGING_CLOCK_TSC reads the CPU cycle counter (rdtsc on x86 with an
+ * invariant TSC, cntvct_el0 on aarch64) and turns it into wall clock time
+ * with a calibration done once per process. When the counter is not
+ * usable it silently falls back to CLOGGING_CLOCK_REALTIME.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Buffer size for the longest timestamp string including '\0',
+ * "YYYY-MM-DDTHH:MM:SS.nnnnnnnnn+00:00".
+ */
+#define CLOGGING_MAX_TIME_STR_LEN 36
+
+/* Wall clock time, nsec is always within [0, 1000000000). */
+typedef struct {
+  int64_t sec;
+  uint32_t nsec;
+} clogging_timestamp_t;
+
+/* Maps raw cycle counter ticks to wall clock time:
+ * time = base_sec/base_nsec + (ticks - base_ticks) / ticks_per_sec
+ */
+typedef struct {
+  uint64_t ticks_per_sec;
+  uint64_t base_ticks;
+  int64_t base_sec;
+  uint32_t base_nsec;
+} clogging_tsc_calibration_t;
+
+/* Read the current wall clock time from the CLOGGING_CLOCK_* source. */
+void clogging_clock_now(uint8_t source, clogging_timestamp_t *ts);
+
+/* Read the raw cycle counter, which is only meaningful when
+ * clogging_clock_get_tsc_calibration() succeeds.
+ */
+uint64_t clogging_clock_read_ticks(void);
+
+/* Get the calibration of the cycle counter, calibrating it first when
+ * this is the first use in the process (which takes a few milliseconds).
+ *
+ * Returns 0 on success and -1 when there is no usable cycle counter.
+ */
+int clogging_clock_get_tsc_calibration(clogging_tsc_calibration_t *cal);
+
+/* Convert raw ticks to wall clock time with cal. This is what a decoder
+ * of binary logs does with the calibration written to the stream.
+ */
+void clogging_clock_ticks_to_timestamp(const clogging_tsc_calibration_t *cal,
+                                       uint64_t ticks,
+                                       clogging_timestamp_t *ts);
+
+/* Get ts as a count of CLOGGING_TIME_PRECISION_* units since the Epoch. */
+int64_t clogging_timestamp_to_units(const clogging_timestamp_t *ts,
+                                    uint8_t precision);
+
+/* Inverse of clogging_timestamp_to_units(). */
+void clogging_timestamp_from_units(int64_t units, uint8_t precision,
+                                   clogging_timestamp_t *ts);
+
+/* Same as time_to_cstr() but with the fraction of the second for the
+ * CLOGGING_TIME_PRECISION_* precision, say "2026-01-02T03:04:05.678+00:00".
+ * Use a buffer of CLOGGING_MAX_TIME_STR_LEN bytes.
+ *
+ * Returns the length of the string or -1 on error.
+ */
+int clogging_timestamp_to_cstr(const clogging_timestamp_t *ts,
+                               uint8_t precision, char *timestr, int maxlen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOGGING_LOG_CLOCK_H */
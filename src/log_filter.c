@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "log_filter.h"
+
+#include <stdatomic.h> /* atomic_load_explicit() and friends */
+#include <stdlib.h>    /* malloc(), realloc(), free() */
+#include <string.h>    /* memcpy(), strlen(), strncmp() */
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h> /* SRWLOCK */
+#else
+#include <pthread.h> /* pthread_mutex_lock() and friends */
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The words are plain uint32_t in log_filter.h, which the log macros
+ * read with __atomic_load_n(), so they are accessed as atomics of the
+ * same size here.
+ */
+#define FILTER_ATOMIC(word) ((_Atomic uint32_t *)(word))
+
+#define FILTER_INITIAL_RULES 8
+#define FILTER_INITIAL_SITES 64
+
+/* The word of a site made stale by a wrap of the epoch, {0, 0xff}, which
+ * no epoch after the first change matches and no level + 1 is.
+ */
+#define FILTER_SITE_STALE 0xffu
+
+struct filter_rule {
+  int kind;
+  char *pattern;
+  size_t len;
+  enum LogLevel level;
+};
+
+/* Epoch 0 is the one of no filters at all, which the zeroed cache of a
+ * call site is already right for.
+ */
+uint32_t clogging_filter_epoch = 0;
+
+static struct filter_rule *g_filter_rules = NULL;
+static size_t g_filter_num_rules = 0;
+static size_t g_filter_capacity = 0;
+
+/* The sites which have cached a word, made stale when the epoch wraps
+ * around, as one of them could otherwise be cached at the epoch it comes
+ * back to and take its level as fresh.
+ */
+static uint32_t **g_filter_sites = NULL;
+static size_t g_filter_num_sites = 0;
+static size_t g_filter_sites_capacity = 0;
+
+#ifdef _WIN32
+static SRWLOCK g_filter_lock = SRWLOCK_INIT;
+#define FILTER_LOCK() AcquireSRWLockExclusive(&g_filter_lock)
+#define FILTER_UNLOCK() ReleaseSRWLockExclusive(&g_filter_lock)
+#else
+static pthread_mutex_t g_filter_lock = PTHREAD_MUTEX_INITIALIZER;
+#define FILTER_LOCK() pthread_mutex_lock(&g_filter_lock)
+#define FILTER_UNLOCK() pthread_mutex_unlock(&g_filter_lock)
+#endif
+
+/* Make every call site look up its filter again, with the lock held. */
+static void filter_bump_epoch(void) {
+  uint32_t epoch = atomic_load_explicit(FILTER_ATOMIC(&clogging_filter_epoch),
+                                        memory_order_relaxed);
+  size_t i = 0;
+
+  epoch = (epoch + 1) & 0x00ffffffu;
+  if (epoch == 0) {
+    epoch = 1;
+    for (i = 0; i < g_filter_num_sites; ++i) {
+      atomic_store_explicit(FILTER_ATOMIC(g_filter_sites[i]),
+                            FILTER_SITE_STALE, memory_order_relaxed);
+    }
+  }
+  atomic_store_explicit(FILTER_ATOMIC(&clogging_filter_epoch), epoch,
+                        memory_order_relaxed);
+}
+
+/* Remember site for filter_bump_epoch(), with the lock held.
+ * Returns 0 on success and -1 on error.
+ */
+static int filter_add_site(uint32_t *site) {
+  uint32_t **sites = NULL;
+  size_t capacity = 0;
+
+  if (g_filter_num_sites == g_filter_sites_capacity) {
+    capacity = g_filter_sites_capacity > 0 ? 2 * g_filter_sites_capacity
+                                           : FILTER_INITIAL_SITES;
+    sites = (uint32_t **)realloc(g_filter_sites, capacity * sizeof(*sites));
+    if (sites == NULL) {
+      return -1;
+    }
+    g_filter_sites = sites;
+    g_filter_sites_capacity = capacity;
+  }
+  g_filter_sites[g_filter_num_sites++] = site;
+  return 0;
+}
+
+static struct filter_rule *filter_find(int kind, const char *pattern,
+                                       size_t len) {
+  size_t i = 0;
+
+  for (i = 0; i < g_filter_num_rules; ++i) {
+    if (g_filter_rules[i].kind == kind && g_filter_rules[i].len == len &&
+        memcmp(g_filter_rules[i].pattern, pattern, len) == 0) {
+      return &g_filter_rules[i];
+    }
+  }
+  return NULL;
+}
+
+static int is_path_separator(char c) { return c == '/' || c == '\\'; }
+
+/* "net" matches "net", "net.tcp" and "net/tcp" */
+static int module_matches(const struct filter_rule *rule,
+                          const char *module) {
+  char c = 0;
+
+  if (module == NULL || strncmp(module, rule->pattern, rule->len) != 0) {
+    return 0;
+  }
+  c = module[rule->len];
+  return c == '\0' || c == '.' || c == '/';
+}
+
+/* The pattern is whole path components of filename */
+static int file_matches(const struct filter_rule *rule,
+                        const char *filename) {
+  const char *p = filename;
+
+  if (filename == NULL) {
+    return 0;
+  }
+  for (p = filename; *p != '\0'; ++p) {
+    if ((p == filename || is_path_separator(p[-1])) &&
+        strncmp(p, rule->pattern, rule->len) == 0 &&
+        (p[rule->len] == '\0' || is_path_separator(p[rule->len]))) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int rule_matches(const struct filter_rule *rule, const char *module,
+                        const char *filename, const char *funcname) {
+  switch (rule->kind) {
+  case CLOGGING_FILTER_MODULE:
+    return module_matches(rule, module);
+  case CLOGGING_FILTER_FILE:
+    return file_matches(rule, filename);
+  case CLOGGING_FILTER_FUNCTION:
+    return funcname != NULL && strcmp(funcname, rule->pattern) == 0;
+  default:
+    return 0;
+  }
+}
+
+int clogging_filter_set(int kind, const char *pattern, enum LogLevel level) {
+  struct filter_rule *rule = NULL;
+  struct filter_rule *rules = NULL;
+  size_t len = 0;
+  char *copy = NULL;
+
+  if (pattern == NULL || kind < CLOGGING_FILTER_MODULE ||
+      kind > CLOGGING_FILTER_FUNCTION || level < LOG_LEVEL_ERROR ||
+      level > LOG_LEVEL_DEBUG) {
+    return -1;
+  }
+  len = strlen(pattern);
+  FILTER_LOCK();
+  rule = filter_find(kind, pattern, len);
+  if (rule == NULL) {
+    if (g_filter_num_rules == g_filter_capacity) {
+      size_t capacity = g_filter_capacity > 0 ? 2 * g_filter_capacity
+                                              : FILTER_INITIAL_RULES;
+
+      rules = (struct filter_rule *)realloc(g_filter_rules,
+                                            capacity * sizeof(*rules));
+      if (rules == NULL) {
+        FILTER_UNLOCK();
+        return -1;
+      }
+      g_filter_rules = rules;
+      g_filter_capacity = capacity;
+    }
+    copy = (char *)malloc(len + 1);
+    if (copy == NULL) {
+      FILTER_UNLOCK();
+      return -1;
+    }
+    memcpy(copy, pattern, len + 1);
+    rule = &g_filter_rules[g_filter_num_rules++];
+    rule->kind = kind;
+    rule->pattern = copy;
+    rule->len = len;
+  }
+  rule->level = level;
+  filter_bump_epoch();
+  FILTER_UNLOCK();
+  return 0;
+}
+
+int clogging_filter_remove(int kind, const char *pattern) {
+  struct filter_rule *rule = NULL;
+
+  if (pattern == NULL) {
+    return -1;
+  }
+  FILTER_LOCK();
+  rule = filter_find(kind, pattern, strlen(pattern));
+  if (rule == NULL) {
+    FILTER_UNLOCK();
+    return -1;
+  }
+  free(rule->pattern);
+  *rule = g_filter_rules[--g_filter_num_rules];
+  filter_bump_epoch();
+  FILTER_UNLOCK();
+  return 0;
+}
+
+void clogging_filter_clear(void) {
+  size_t i = 0;
+
+  FILTER_LOCK();
+  for (i = 0; i < g_filter_num_rules; ++i) {
+    free(g_filter_rules[i].pattern);
+  }
+  g_filter_num_rules = 0;
+  filter_bump_epoch();
+  FILTER_UNLOCK();
+}
+
+uint32_t clogging_filter_resolve(uint32_t *site, const char *module,
+                                 const char *filename,
+                                 const char *funcname) {
+  const struct filter_rule *best = NULL;
+  uint32_t word = 0;
+  size_t i = 0;
+
+  FILTER_LOCK();
+  for (i = 0; i < g_filter_num_rules; ++i) {
+    const struct filter_rule *rule = &g_filter_rules[i];
+
+    if ((best == NULL || rule->kind > best->kind ||
+         (rule->kind == best->kind && rule->len > best->len)) &&
+        rule_matches(rule, module, filename, funcname)) {
+      best = rule;
+    }
+  }
+  /* the epoch only changes with the lock held */
+  word = atomic_load_explicit(FILTER_ATOMIC(&clogging_filter_epoch),
+                              memory_order_relaxed)
+         << 8;
+  if (best != NULL) {
+    word |= (uint32_t)best->level + 1;
+  }
+  /* a site is added the first time it caches a word other than 0, and
+   * one which cannot be added looks up its filter every time instead
+   */
+  if (atomic_load_explicit(FILTER_ATOMIC(site), memory_order_relaxed) != 0 ||
+      word == 0 || filter_add_site(site) == 0) {
+    atomic_store_explicit(FILTER_ATOMIC(site), word, memory_order_relaxed);
+  }
+  FILTER_UNLOCK();
+  return word;
+}
+
+int clogging_filter_site_level(uint32_t *site, int level, const char *module,
+                               const char *filename, const char *funcname) {
+  uint32_t epoch = atomic_load_explicit(FILTER_ATOMIC(&clogging_filter_epoch),
+                                        memory_order_relaxed);
+  uint32_t cached = atomic_load_explicit(FILTER_ATOMIC(site),
+                                         memory_order_relaxed);
+
+  if ((cached >> 8) != epoch) {
+    cached = clogging_filter_resolve(site, module, filename, funcname);
+  }
+  return (cached & 0xff) != 0 ? (int)(cached & 0xff) - 1 : level;
+}
+
+#ifdef __cplusplus
+}
+#endif
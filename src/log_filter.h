@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifndef CLOGGING_LOG_FILTER_H
+#define CLOGGING_LOG_FILTER_H
+
+#include "logging_common.h"
+
+#include <stdint.h>
+
+/* Log levels by module, source file or function.
+ *
+ * A filter sets the level of the log messages of the log macros of
+ * basic_logging.h, fd_logging.h and binary_logging.h which match it, in
+ * place of the level of the thread, so that DEBUG can be switched on for
+ * one subsystem without the rest of the process:
+ *
+ *   clogging_filter_set(CLOGGING_FILTER_MODULE, "net", LOG_LEVEL_DEBUG);
+ *
+ * Filters match hierarchically:
+ *
+ *   CLOGGING_FILTER_MODULE   "net" matches the modules "net", "net.tcp"
+ *                            and "net/tcp", see CLOGGING_MODULE below.
+ *   CLOGGING_FILTER_FILE     "net" matches source files in a directory
+ *                            "net" at any depth, "net/tcp.c" and "tcp.c"
+ *                            match that file, by whole path components.
+ *   CLOGGING_FILTER_FUNCTION "parse" matches the function of that name.
+ *
+ * A function filter wins over a file filter, which wins over a module
+ * filter, and of those of a kind the longest match wins.
+ *
+ * Every call site of the log macros caches the level of its filter, if
+ * any, in a static word of {epoch:24, level + 1:8}. Any change of the
+ * filters bumps the epoch, after which each site looks up its filter
+ * again once, so the check stays two relaxed loads and a compare. When
+ * the epoch wraps around every site cached so far is made stale too.
+ *
+ * Filters apply to the log macros only, not to direct calls of the
+ * logmsg() functions. Messages compiled out by CLOGGING_MIN_LEVEL stay
+ * compiled out.
+ */
+
+/* The module tag of the log macros, which is none by default. Define it
+ * before including the headers of the library, say
+ *
+ *   #define CLOGGING_MODULE "net.tcp"
+ */
+#ifndef CLOGGING_MODULE
+#define CLOGGING_MODULE ((const char *)0)
+#endif
+
+/* Kinds of filters */
+#define CLOGGING_FILTER_MODULE 0
+#define CLOGGING_FILTER_FILE 1
+#define CLOGGING_FILTER_FUNCTION 2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Set the level of the log messages matching pattern, a filter of kind,
+ * replacing the level of the same filter if there is one.
+ * Returns 0 on success and -1 on error.
+ *
+ * It is MT safe.
+ */
+int clogging_filter_set(int kind, const char *pattern, enum LogLevel level);
+
+/* Remove the filter of kind with pattern.
+ * Returns 0 on success and -1 when there is no such filter.
+ *
+ * It is MT safe.
+ */
+int clogging_filter_remove(int kind, const char *pattern);
+
+/* Remove all the filters.
+ *
+ * It is MT safe.
+ */
+void clogging_filter_clear(void);
+
+/* Look up the filter of a call site and cache it in *site, returning the
+ * word cached. Used by the log macros when the epoch of *site is stale.
+ */
+uint32_t clogging_filter_resolve(uint32_t *site, const char *module,
+                                 const char *filename, const char *funcname);
+
+/* The level of the messages of a call site, which is the one of its
+ * filter or else level, the one of the thread.
+ */
+int clogging_filter_site_level(uint32_t *site, int level, const char *module,
+                               const char *filename, const char *funcname);
+
+#ifdef _WIN32
+#define CLOGGING_FILTER_LEVEL(site, level)                                    \
+  clogging_filter_site_level((site), (level), CLOGGING_MODULE, __FILE__,      \
+                             __func__)
+#else
+extern uint32_t clogging_filter_epoch;
+
+/* clogging_filter_site_level() with the cached level inlined */
+static inline int clogging_filter_level_of(uint32_t *site, int level,
+                                           const char *module,
+                                           const char *filename,
+                                           const char *funcname) {
+  uint32_t epoch = __atomic_load_n(&clogging_filter_epoch, __ATOMIC_RELAXED);
+  uint32_t cached = __atomic_load_n(site, __ATOMIC_RELAXED);
+
+  if ((cached >> 8) != epoch) {
+    cached = clogging_filter_resolve(site, module, filename, funcname);
+  }
+  return (cached & 0xff) != 0 ? (int)(cached & 0xff) - 1 : level;
+}
+
+#define CLOGGING_FILTER_LEVEL(site, level)                                    \
+  clogging_filter_level_of((site), (level), CLOGGING_MODULE, __FILE__,        \
+                           __func__)
+#endif /* _WIN32 */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOGGING_LOG_FILTER_H */
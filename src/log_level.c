@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "log_level.h"
+
+#include <stdatomic.h> /* atomic_load_explicit() and friends */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The words are plain uint32_t in the installed headers, which the log
+ * macros read with __atomic_load_n(), so they are accessed as atomics
+ * of the same size here.
+ */
+#define LEVEL_ATOMIC(word) ((_Atomic uint32_t *)(word))
+
+#define LEVEL_GENERATION_MASK 0xffffff00u
+#define LEVEL_MASK 0x000000ffu
+
+void clogging_level_set_process(uint32_t *process, enum LogLevel level) {
+  uint32_t old = atomic_load_explicit(LEVEL_ATOMIC(process),
+                                      memory_order_relaxed);
+  uint32_t generation = 0;
+
+  do {
+    /* 0 is never a generation, see CLOGGING_LEVEL_WORD_INIT */
+    generation = ((old >> 8) + 1) & 0x00ffffffu;
+    if (generation == 0) {
+      generation = 1;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(
+      LEVEL_ATOMIC(process), &old, CLOGGING_LEVEL_WORD(generation, level),
+      memory_order_relaxed, memory_order_relaxed));
+}
+
+enum LogLevel clogging_level_get_process(uint32_t *process) {
+  return (enum LogLevel)(atomic_load_explicit(LEVEL_ATOMIC(process),
+                                              memory_order_relaxed) &
+                         LEVEL_MASK);
+}
+
+void clogging_level_set_thread(uint32_t *process, uint32_t *thread,
+                               enum LogLevel level) {
+  /* should the process level change meanwhile, that one wins */
+  *thread = (atomic_load_explicit(LEVEL_ATOMIC(process),
+                                  memory_order_relaxed) &
+             LEVEL_GENERATION_MASK) |
+            (uint32_t)level;
+}
+
+enum LogLevel clogging_level_get(uint32_t *process, uint32_t thread) {
+  uint32_t word = atomic_load_explicit(LEVEL_ATOMIC(process),
+                                       memory_order_relaxed);
+
+  if (((word ^ thread) & LEVEL_GENERATION_MASK) == 0) {
+    word = thread;
+  }
+  return (enum LogLevel)(word & LEVEL_MASK);
+}
+
+int clogging_level_filtered_out(enum LogLevel *level, uint32_t *process,
+                                uint32_t thread) {
+  if (((unsigned int)*level & CLOGGING_LEVEL_CHECKED) != 0) {
+    *level = (enum LogLevel)((unsigned int)*level & ~CLOGGING_LEVEL_CHECKED);
+    return 0;
+  }
+  return *level > clogging_level_get(process, thread);
+}
+
+#ifdef __cplusplus
+}
+#endif
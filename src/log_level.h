@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifndef CLOGGING_LOG_LEVEL_H
+#define CLOGGING_LOG_LEVEL_H
+
+#include "logging_common.h"
+
+#include <stdint.h>
+
+/* Process-wide log levels with an override per thread.
+ *
+ * The level of each of basic, fd and binary logging is a word of
+ * {generation:24, level:8} shared by the process, and a word of the same
+ * layout per thread. Setting the level of the process bumps the
+ * generation, so that every thread follows it with its next message.
+ * Setting the level of a thread tags it with the current generation, so
+ * that it holds until the level of the process is set again. See
+ * clogging_level_of() in logging_common.h for the check of the log
+ * macros.
+ *
+ * This is an internal building block of the logging backends and is
+ * not installed.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CLOGGING_LEVEL_WORD(generation, level)                               \
+  (((uint32_t)(generation) << 8) | (uint32_t)(level))
+
+/* The level of the process until it is set. The generation starts at 1,
+ * so that a thread which never set its own level has none.
+ */
+#define CLOGGING_LEVEL_WORD_INIT CLOGGING_LEVEL_WORD(1, DEFAULT_LOG_LEVEL)
+
+/* Set the level of the process in *process for all threads. */
+void clogging_level_set_process(uint32_t *process, enum LogLevel level);
+
+/* Get the level of the process in *process. */
+enum LogLevel clogging_level_get_process(uint32_t *process);
+
+/* Set the level of the calling thread in *thread, overriding the one in
+ * *process until that is set again.
+ */
+void clogging_level_set_thread(uint32_t *process, uint32_t *thread,
+                               enum LogLevel level);
+
+/* Get the level of the calling thread from *process and its own. */
+enum LogLevel clogging_level_get(uint32_t *process, uint32_t thread);
+
+/* Whether a message of *level is filtered out by the level of the
+ * calling thread, unless the log macros checked it already, see
+ * CLOGGING_LEVEL_CHECKED, which is taken off *level either way.
+ */
+int clogging_level_filtered_out(enum LogLevel *level, uint32_t *process,
+                                uint32_t thread);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOGGING_LOG_LEVEL_H */
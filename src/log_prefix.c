@@ -0,0 +1,528 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "log_prefix.h"
+#include "json_escape.h"
+
+#include <string.h> /* memcpy(), strlen() */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The hot path is a loop over the steps of the plan, which is only fast
+ * when the helpers below are inlined into it.
+ */
+#ifdef _MSC_VER
+#define ALWAYS_INLINE __forceinline
+#define NEVER_INLINE __declspec(noinline)
+#else
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#define NEVER_INLINE __attribute__((noinline))
+#endif
+
+/* Appends to a line and silently drops whatever does not fit, leaving
+ * room for the '\0'.
+ */
+struct line_writer {
+  char *buf;
+  int size;
+  int pos;
+};
+
+/* Kept out of line, so that the compiler never sees it reached with a
+ * source which is a short constant, which it would warn about.
+ */
+static NEVER_INLINE void copy_long_bytes(char *dst, const char *src,
+                                         int len) {
+  memcpy(dst, src, (size_t)len);
+}
+
+/* Most fragments of a line are a few bytes long, where a call to
+ * memcpy() costs more than the copy. Copy those with (possibly
+ * overlapping) fixed size moves instead.
+ */
+static ALWAYS_INLINE void copy_bytes(char *dst, const char *src, int len) {
+  if (len > 16) {
+    copy_long_bytes(dst, src, len);
+  } else if (len >= 8) {
+    memcpy(dst, src, 8);
+    memcpy(dst + len - 8, src + len - 8, 8);
+  } else if (len >= 4) {
+    memcpy(dst, src, 4);
+    memcpy(dst + len - 4, src + len - 4, 4);
+  } else {
+    while (len-- > 0) {
+      *dst++ = *src++;
+    }
+  }
+}
+
+static ALWAYS_INLINE void put(struct line_writer *w, const char *s, int len) {
+  int room = w->size - 1 - w->pos;
+
+  if (len > room) {
+    len = room;
+  }
+  if (len > 0) {
+    copy_bytes(&w->buf[w->pos], s, len);
+    w->pos += len;
+  }
+}
+
+static ALWAYS_INLINE void put_str(struct line_writer *w, const char *s) {
+  put(w, s, (int)strlen(s));
+}
+
+static ALWAYS_INLINE void put_json(struct line_writer *w, const char *s) {
+  char escaped[CLOGGING_JSON_MAX_ESCAPE_LEN];
+  size_t len = strlen(s);
+  size_t room = 0;
+  size_t run = 0;
+  int escaped_len = 0;
+
+  for (;;) {
+    /* scan and copy in one pass, up to what fits */
+    room = (size_t)(w->size - 1 - w->pos);
+    run = clogging_json_copy(&w->buf[w->pos], s, (len < room) ? len : room);
+    w->pos += (int)run;
+    if (run == len || run == room) {
+      break;
+    }
+    escaped_len = clogging_json_escape_char((unsigned char)s[run], escaped);
+    /* a truncated line never ends in half an escape sequence */
+    if (escaped_len > w->size - 1 - w->pos) {
+      break;
+    }
+    memcpy(&w->buf[w->pos], escaped, (size_t)escaped_len);
+    w->pos += escaped_len;
+    s += run + 1;
+    len -= run + 1;
+  }
+}
+
+/* Render value in decimal at the end of digits (of 12 bytes) and return
+ * the offset of the first character.
+ */
+static int int_to_digits(int value, char *digits) {
+  int i = 12;
+  unsigned int v = (value < 0) ? 0u - (unsigned int)value : (unsigned int)value;
+
+  do {
+    digits[--i] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v > 0);
+  if (value < 0) {
+    digits[--i] = '-';
+  }
+  return i;
+}
+
+static ALWAYS_INLINE void put_int(struct line_writer *w, int value) {
+  char digits[12];
+  int i = int_to_digits(value, digits);
+
+  put(w, &digits[i], (int)sizeof(digits) - i);
+}
+
+/* Plan building. Consecutive literals are merged into a single step. */
+
+static void add_step(clogging_prefix_t *prefix, uint8_t kind) {
+  if (prefix->num_steps < CLOGGING_PREFIX_MAX_STEPS) {
+    prefix->steps[prefix->num_steps].kind = kind;
+    prefix->steps[prefix->num_steps].offset = 0;
+    prefix->steps[prefix->num_steps].len = 0;
+    ++prefix->num_steps;
+  }
+}
+
+static void add_literal(clogging_prefix_t *prefix, const char *s, int len) {
+  clogging_prefix_step_t *last = NULL;
+
+  if (len > CLOGGING_PREFIX_LITERAL_BYTES - prefix->literals_len) {
+    len = CLOGGING_PREFIX_LITERAL_BYTES - prefix->literals_len;
+  }
+  if (len <= 0) {
+    return;
+  }
+  if (prefix->num_steps > 0) {
+    last = &prefix->steps[prefix->num_steps - 1];
+  }
+  if (last == NULL || last->kind != CLOGGING_PREFIX_STEP_LITERAL) {
+    add_step(prefix, CLOGGING_PREFIX_STEP_LITERAL);
+    last = &prefix->steps[prefix->num_steps - 1];
+    last->offset = (uint16_t)prefix->literals_len;
+  }
+  memcpy(&prefix->literals[prefix->literals_len], s, (size_t)len);
+  prefix->literals_len += len;
+  last->len = (uint16_t)(last->len + len);
+}
+
+static void add_str(clogging_prefix_t *prefix, const char *s) {
+  add_literal(prefix, s, (int)strlen(s));
+}
+
+static void add_int(clogging_prefix_t *prefix, int value) {
+  char digits[12];
+  int i = int_to_digits(value, digits);
+
+  add_literal(prefix, &digits[i], (int)sizeof(digits) - i);
+}
+
+/* Opens the JSON field name, with the separator unless it is the first
+ * field of the object.
+ */
+static void add_json_name(clogging_prefix_t *prefix, int *any,
+                          const char *sep, const char *name) {
+  if (*any) {
+    add_str(prefix, sep);
+  }
+  add_str(prefix, "\"");
+  add_str(prefix, name);
+  add_str(prefix, "\":");
+  *any = 1;
+}
+
+static void add_json_string(clogging_prefix_t *prefix, int *any,
+                            const char *sep, const char *name,
+                            const char *value) {
+  char escaped[CLOGGING_JSON_MAX_ESCAPE_LEN];
+  size_t len = strlen(value);
+  size_t run = 0;
+
+  add_json_name(prefix, any, sep, name);
+  add_str(prefix, "\"");
+  for (;;) {
+    run = clogging_json_scan(value, len);
+    add_literal(prefix, value, (int)run);
+    if (run == len) {
+      break;
+    }
+    add_literal(prefix, escaped,
+                clogging_json_escape_char((unsigned char)value[run], escaped));
+    value += run + 1;
+    len -= run + 1;
+  }
+  add_str(prefix, "\"");
+}
+
+static void compile_json(clogging_prefix_t *prefix, uint8_t fields,
+                         const char *hostname, const char *progname,
+                         const char *threadname, int pid) {
+  /* the default layout has always used a space after the comma */
+  const char *sep = (fields == CLOGGING_PREFIX_DEFAULT) ? ", " : ",";
+  int any = 0;
+
+  add_str(prefix, "{");
+  if (fields & CLOGGING_PREFIX_TIMESTAMP) {
+    add_json_name(prefix, &any, sep, "timestamp");
+    add_str(prefix, "\"");
+    add_step(prefix, CLOGGING_PREFIX_STEP_TIMESTAMP);
+    add_str(prefix, "\"");
+  }
+  if (fields & CLOGGING_PREFIX_HOSTNAME) {
+    add_json_string(prefix, &any, sep, "hostname", hostname);
+  }
+  if (fields & CLOGGING_PREFIX_PROGNAME) {
+    add_json_string(prefix, &any, sep, "progname", progname);
+  }
+  if (fields & (CLOGGING_PREFIX_PID | CLOGGING_PREFIX_PROGNAME)) {
+    add_json_string(prefix, &any, sep, "threadname", threadname);
+  }
+  if (fields & CLOGGING_PREFIX_PID) {
+    add_json_name(prefix, &any, sep, "pid");
+    add_int(prefix, pid);
+  }
+  if (fields & CLOGGING_PREFIX_LOGLEVEL) {
+    add_json_name(prefix, &any, sep, "level");
+    add_str(prefix, "\"");
+    add_step(prefix, CLOGGING_PREFIX_STEP_LEVEL);
+    add_str(prefix, "\"");
+  }
+  if (fields & CLOGGING_PREFIX_FUNCNAME) {
+    add_json_name(prefix, &any, sep, "funcname");
+    add_str(prefix, "\"");
+    add_step(prefix, CLOGGING_PREFIX_STEP_JSON_FUNCNAME);
+    add_str(prefix, "\"");
+  }
+  if (fields & CLOGGING_PREFIX_LINENUM) {
+    add_json_name(prefix, &any, sep, "linenum");
+    add_step(prefix, CLOGGING_PREFIX_STEP_LINENUM);
+  }
+  add_json_name(prefix, &any, sep, "message");
+  add_str(prefix, "\"");
+  add_step(prefix, CLOGGING_PREFIX_STEP_JSON_MESSAGE);
+  add_str(prefix, "\"}\n");
+}
+
+/* <HEADER> <MESSAGE>
+ *	<HEADER> = <TIMESTAMP> <HOSTNAME>
+ *	<MESSAGE> = <TAG> <LEVEL> <CONTENT>
+ *		<TAG> = <PROGRAM><THREAD>[<PID>]
+ *		<LEVEL> = DEBUG | INFO | WARNING | ERROR
+ *		<CONTENT> = <FUNCTION/MODULE>: <APPLICATION_MESSAGE>
+ */
+static void compile_text(clogging_prefix_t *prefix, uint8_t fields,
+                         const char *hostname, const char *progname,
+                         const char *threadname, int pid) {
+  if (fields & CLOGGING_PREFIX_TIMESTAMP) {
+    add_step(prefix, CLOGGING_PREFIX_STEP_TIMESTAMP);
+    add_str(prefix, " ");
+  }
+  if (fields & CLOGGING_PREFIX_HOSTNAME) {
+    add_str(prefix, hostname);
+    add_str(prefix, " ");
+  }
+  if (fields & CLOGGING_PREFIX_PROGNAME) {
+    add_str(prefix, progname);
+  }
+  if (fields & CLOGGING_PREFIX_PID) {
+    add_str(prefix, threadname);
+    add_str(prefix, "[");
+    add_int(prefix, pid);
+    add_str(prefix, "]");
+  } else if (fields & CLOGGING_PREFIX_PROGNAME) {
+    add_str(prefix, threadname);
+  }
+  if (fields & CLOGGING_PREFIX_LOGLEVEL) {
+    add_str(prefix, " ");
+    add_step(prefix, CLOGGING_PREFIX_STEP_LEVEL);
+  }
+  /* the header is empty when nothing was added so far */
+  if (prefix->num_steps > 0) {
+    add_str(prefix, " ");
+  }
+
+  if (fields & CLOGGING_PREFIX_LINENUM) {
+    if (fields & CLOGGING_PREFIX_FUNCNAME) {
+      add_step(prefix, CLOGGING_PREFIX_STEP_FUNCNAME);
+    }
+    add_str(prefix, "(");
+    add_step(prefix, CLOGGING_PREFIX_STEP_LINENUM);
+    add_str(prefix, "): ");
+  } else if (fields & CLOGGING_PREFIX_FUNCNAME) {
+    /* an empty function name leaves out the ": " as well */
+    add_step(prefix, CLOGGING_PREFIX_STEP_FUNCNAME_SEP);
+  }
+  add_step(prefix, CLOGGING_PREFIX_STEP_MESSAGE);
+  add_str(prefix, "\n");
+}
+
+/* JSON lines escape the message in place once it is in the line */
+static int is_json_special(unsigned char c) {
+  return c < 0x20 || c == '"' || c == '\\';
+}
+
+/* Get the length of the len bytes at s once escaped. */
+static int escaped_len(const char *s, int len) {
+  char escaped[CLOGGING_JSON_MAX_ESCAPE_LEN];
+  int src = 0;
+  int run = 0;
+  int n = 0;
+
+  while (src < len) {
+    run = (int)clogging_json_scan(&s[src], (size_t)(len - src));
+    src += run;
+    n += run;
+    if (src == len) {
+      break;
+    }
+    n += clogging_json_escape_char((unsigned char)s[src], escaped);
+    ++src;
+  }
+  return n;
+}
+
+/* Escape the len bytes of the message at s in place, growing it to at
+ * most room bytes. A message which no longer fits is cut off, but never
+ * in the middle of an escape sequence, and *needed is set to the length
+ * it would have had in full.
+ *
+ * Returns the length of the escaped message.
+ */
+static int escape_in_place(char *s, int len, int room, int *needed) {
+  char escaped[CLOGGING_JSON_MAX_ESCAPE_LEN];
+  int first = (int)clogging_json_scan(s, (size_t)len);
+  int src = first;
+  int dst = first;
+  int run = 0;
+  int n = 0;
+
+  *needed = len;
+  if (first == len) {
+    return len;
+  }
+
+  /* find how many bytes of the message fit once escaped */
+  while (src < len) {
+    run = (int)clogging_json_scan(&s[src], (size_t)(len - src));
+    if (run > room - dst) {
+      run = room - dst;
+    }
+    src += run;
+    dst += run;
+    if (src == len) {
+      break;
+    }
+    n = clogging_json_escape_char((unsigned char)s[src], escaped);
+    if (n > room - dst) {
+      break;
+    }
+    ++src;
+    dst += n;
+  }
+  *needed = dst + escaped_len(&s[src], len - src);
+
+  /* and move them into place from the back, so that nothing is
+   * overwritten before it is moved
+   */
+  len = dst;
+  while (src > first) {
+    unsigned char c = (unsigned char)s[--src];
+
+    if (is_json_special(c)) {
+      n = clogging_json_escape_char(c, escaped);
+      dst -= n;
+      memcpy(&s[dst], escaped, (size_t)n);
+    } else {
+      s[--dst] = (char)c;
+    }
+  }
+  return len;
+}
+
+void clogging_prefix_init(clogging_prefix_t *prefix,
+                          const clogging_log_options_t *opts,
+                          const char *hostname, const char *progname,
+                          const char *threadname, int pid) {
+  int i = 0;
+
+  prefix->num_steps = 0;
+  prefix->literals_len = 0;
+  if (opts->json) {
+    compile_json(prefix, opts->prefix_fields_flag, hostname, progname,
+                 threadname, pid);
+  } else {
+    compile_text(prefix, opts->prefix_fields_flag, hostname, progname,
+                 threadname, pid);
+  }
+
+  /* both layouts end with the message followed by literals only */
+  prefix->message_step = prefix->num_steps;
+  prefix->tail_len = 0;
+  for (i = 0; i < prefix->num_steps; ++i) {
+    if (prefix->steps[i].kind == CLOGGING_PREFIX_STEP_MESSAGE ||
+        prefix->steps[i].kind == CLOGGING_PREFIX_STEP_JSON_MESSAGE) {
+      prefix->message_step = i;
+    } else if (i > prefix->message_step) {
+      prefix->tail_len += prefix->steps[i].len;
+    }
+  }
+}
+
+int clogging_prefix_format_begin(const clogging_prefix_t *prefix, char *buf,
+                                 int size, const char *time_str, int time_len,
+                                 enum LogLevel level, const char *funcname,
+                                 int linenum, int *msg_room) {
+  struct line_writer w = {buf, size, 0};
+  const clogging_prefix_step_t *step = prefix->steps;
+  const clogging_prefix_step_t *end = &prefix->steps[prefix->message_step];
+
+  *msg_room = 0;
+  if (size <= 0) {
+    return 0;
+  }
+  for (; step < end; ++step) {
+    switch (step->kind) {
+    case CLOGGING_PREFIX_STEP_LITERAL:
+      put(&w, &prefix->literals[step->offset], step->len);
+      break;
+    case CLOGGING_PREFIX_STEP_TIMESTAMP:
+      put(&w, time_str, time_len);
+      break;
+    case CLOGGING_PREFIX_STEP_LEVEL:
+      put_str(&w, get_log_level_as_cstring(level));
+      break;
+    case CLOGGING_PREFIX_STEP_FUNCNAME:
+      put_str(&w, funcname);
+      break;
+    case CLOGGING_PREFIX_STEP_FUNCNAME_SEP:
+      if (funcname[0] != '\0') {
+        put_str(&w, funcname);
+        put(&w, ": ", 2);
+      }
+      break;
+    case CLOGGING_PREFIX_STEP_LINENUM:
+      put_int(&w, linenum);
+      break;
+    case CLOGGING_PREFIX_STEP_JSON_FUNCNAME:
+      put_json(&w, funcname);
+      break;
+    default:
+      break;
+    }
+  }
+  if (size - 1 - w.pos - prefix->tail_len > 0) {
+    *msg_room = size - 1 - w.pos - prefix->tail_len;
+  }
+  buf[w.pos] = '\0';
+  return w.pos;
+}
+
+int clogging_prefix_format_end(const clogging_prefix_t *prefix, char *buf,
+                               int size, int pos, int msg_len,
+                               int *msg_needed) {
+  struct line_writer w = {buf, size, pos};
+  const clogging_prefix_step_t *step = &prefix->steps[prefix->message_step];
+  const clogging_prefix_step_t *end = &prefix->steps[prefix->num_steps];
+
+  *msg_needed = msg_len;
+  if (size <= 0) {
+    return 0;
+  }
+  if (step < end && msg_len > 0) {
+    if (step->kind == CLOGGING_PREFIX_STEP_JSON_MESSAGE) {
+      msg_len = escape_in_place(&buf[pos], msg_len,
+                                size - 1 - pos - prefix->tail_len,
+                                msg_needed);
+    }
+    w.pos += msg_len;
+  }
+  for (++step; step < end; ++step) {
+    put(&w, &prefix->literals[step->offset], step->len);
+  }
+  buf[w.pos] = '\0';
+  return w.pos;
+}
+
+int clogging_prefix_format(const clogging_prefix_t *prefix, char *buf,
+                           int size, const char *time_str, int time_len,
+                           enum LogLevel level, const char *funcname,
+                           int linenum, const char *msg) {
+  int msg_room = 0;
+  int msg_needed = 0;
+  int msg_len = (int)strlen(msg);
+  int pos = clogging_prefix_format_begin(prefix, buf, size, time_str,
+                                         time_len, level, funcname, linenum,
+                                         &msg_room);
+
+  if (msg_len > msg_room) {
+    msg_len = msg_room;
+  }
+  memcpy(&buf[pos], msg, (size_t)msg_len);
+  return clogging_prefix_format_end(prefix, buf, size, pos, msg_len,
+                                    &msg_needed);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifndef CLOGGING_LOG_PREFIX_H
+#define CLOGGING_LOG_PREFIX_H
+
+#include "logging_common.h"
+
+/* Layout of the text and JSON log lines of the basic and fd backends.
+ *
+ * The layout only depends on the options given at init (text or JSON,
+ * and the prefix_fields_flag), so it is compiled once into a short plan
+ * of steps. A step either copies a literal fragment or emits one of the
+ * per-message fields. The hostname, program name, thread name and pid
+ * never change after init, so they are rendered into the literals as
+ * well, together with the punctuation around them.
+ *
+ * All strings in the JSON layout are escaped, see json_escape.h.
+ *
+ * This is an internal building block of the logging backends and is
+ * not installed.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* large enough for all literals of the JSON layout with every field */
+#define CLOGGING_PREFIX_LITERAL_BYTES 384
+#define CLOGGING_PREFIX_MAX_STEPS 16
+
+enum clogging_prefix_step_kind {
+  CLOGGING_PREFIX_STEP_LITERAL = 0,
+  CLOGGING_PREFIX_STEP_TIMESTAMP,
+  CLOGGING_PREFIX_STEP_LEVEL,
+  CLOGGING_PREFIX_STEP_FUNCNAME,
+  /* "<funcname>: " unless the function name is empty */
+  CLOGGING_PREFIX_STEP_FUNCNAME_SEP,
+  CLOGGING_PREFIX_STEP_LINENUM,
+  CLOGGING_PREFIX_STEP_MESSAGE,
+  /* the same escaped for a JSON string */
+  CLOGGING_PREFIX_STEP_JSON_FUNCNAME,
+  CLOGGING_PREFIX_STEP_JSON_MESSAGE
+};
+
+typedef struct {
+  uint8_t kind;    /* enum clogging_prefix_step_kind */
+  uint16_t offset; /* of the literal in literals */
+  uint16_t len;
+} clogging_prefix_step_t;
+
+typedef struct {
+  int num_steps;
+  clogging_prefix_step_t steps[CLOGGING_PREFIX_MAX_STEPS];
+  /* index of the message step, and the bytes of the literals after it */
+  int message_step;
+  int tail_len;
+  int literals_len;
+  char literals[CLOGGING_PREFIX_LITERAL_BYTES];
+} clogging_prefix_t;
+
+/* Compile the layout in opts into prefix. */
+void clogging_prefix_init(clogging_prefix_t *prefix,
+                          const clogging_log_options_t *opts,
+                          const char *hostname, const char *progname,
+                          const char *threadname, int pid);
+
+/* Format one complete log line (with the trailing '\n') into buf of size
+ * bytes, truncating it when it does not fit. buf is always '\0'
+ * terminated.
+ *
+ * Returns the length of the line excluding the '\0'.
+ */
+int clogging_prefix_format(const clogging_prefix_t *prefix, char *buf,
+                           int size, const char *time_str, int time_len,
+                           enum LogLevel level, const char *funcname,
+                           int linenum, const char *msg);
+
+/* The same as clogging_prefix_format() in two halves, so that the
+ * message can be formatted straight into buf rather than into a
+ * temporary buffer first.
+ *
+ * clogging_prefix_format_begin() emits everything before the message
+ * and returns the offset in buf at which the message goes. *msg_room is
+ * set to how many bytes of the message fit there, while still leaving
+ * room for the end of the line.
+ *
+ * clogging_prefix_format_end() completes the line once the msg_len
+ * bytes of the message are at offset pos, escaping them in place for
+ * the JSON layout, and returns the length of the line excluding the
+ * '\0'. *msg_needed is set to the bytes the message takes in the line,
+ * which is more than msg_len once escaped. When that is more than
+ * *msg_room the escaped message was cut off.
+ */
+int clogging_prefix_format_begin(const clogging_prefix_t *prefix, char *buf,
+                                 int size, const char *time_str, int time_len,
+                                 enum LogLevel level, const char *funcname,
+                                 int linenum, int *msg_room);
+int clogging_prefix_format_end(const clogging_prefix_t *prefix, char *buf,
+                               int size, int pos, int msg_len,
+                               int *msg_needed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOGGING_LOG_PREFIX_H */
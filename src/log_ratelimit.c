@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "log_ratelimit.h"
+
+#include <stdatomic.h> /* atomic_load_explicit() and friends */
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h> /* QueryPerformanceCounter() */
+#else
+#include <time.h> /* clock_gettime() */
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The words are plain integers in log_ratelimit.h, which the log macros
+ * keep as statics, so they are accessed as atomics of the same size here.
+ */
+#define RATELIMIT_ATOMIC64(word) ((_Atomic uint64_t *)(word))
+#define RATELIMIT_ATOMIC32(word) ((_Atomic uint32_t *)(word))
+
+_Static_assert(_Alignof(clogging_ratelimit_t) >= _Alignof(_Atomic uint64_t),
+               "full_ns of clogging_ratelimit_t is not aligned for atomics");
+
+#define NSEC_PER_SEC 1000000000ULL
+
+static uint64_t ratelimit_now_ns(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+
+  if (frequency.QuadPart == 0) {
+    QueryPerformanceFrequency(&frequency);
+  }
+  QueryPerformanceCounter(&counter);
+  return (uint64_t)(counter.QuadPart / frequency.QuadPart) * NSEC_PER_SEC +
+         (uint64_t)(counter.QuadPart % frequency.QuadPart) * NSEC_PER_SEC /
+             (uint64_t)frequency.QuadPart;
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* The bucket is kept as the time at which it is full again (the
+ * theoretical arrival time of the generic cell rate algorithm). Each
+ * token taken moves that time on by one interval, which is only allowed
+ * while it stays within burst intervals from now. An empty state, or one
+ * idle for long enough, is in the past and so is a full bucket.
+ *
+ * A bucket which is never refilled, per_second being 0, is the same on
+ * a clock which stands still at 0, so full_ns counts the tokens taken.
+ */
+int clogging_ratelimit_allow_at(clogging_ratelimit_t *rl, uint32_t burst,
+                                uint32_t per_second, uint64_t now_ns,
+                                uint32_t *suppressed) {
+  uint64_t interval = 0;
+  uint64_t capacity = 0;
+  uint64_t full = atomic_load_explicit(RATELIMIT_ATOMIC64(&rl->full_ns),
+                                       memory_order_relaxed);
+  uint64_t next = 0;
+
+  if (per_second > 0) {
+    interval = NSEC_PER_SEC / per_second;
+    if (interval == 0) {
+      interval = 1;
+    }
+    capacity = (uint64_t)(burst > 0 ? burst : 1) * interval;
+  } else {
+    interval = 1;
+    capacity = burst > 0 ? burst : 1;
+    now_ns = 0;
+  }
+  do {
+    next = (full > now_ns ? full : now_ns) + interval;
+    if (next - now_ns > capacity) {
+      atomic_fetch_add_explicit(RATELIMIT_ATOMIC32(&rl->suppressed), 1,
+                                memory_order_relaxed);
+      return 0;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(
+      RATELIMIT_ATOMIC64(&rl->full_ns), &full, next, memory_order_relaxed,
+      memory_order_relaxed));
+
+  *suppressed = atomic_exchange_explicit(RATELIMIT_ATOMIC32(&rl->suppressed),
+                                         0, memory_order_relaxed);
+  return 1;
+}
+
+int clogging_ratelimit_allow(clogging_ratelimit_t *rl, uint32_t burst,
+                             uint32_t per_second, uint32_t *suppressed) {
+  return clogging_ratelimit_allow_at(rl, burst, per_second, ratelimit_now_ns(),
+                                     suppressed);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifndef CLOGGING_LOG_RATELIMIT_H
+#define CLOGGING_LOG_RATELIMIT_H
+
+#include <stdint.h>
+
+/* Rate limits of call sites of the log macros.
+ *
+ * The *_RATELIMITED log macros of basic_logging.h, fd_logging.h and
+ * binary_logging.h log at most burst messages at once from a call site,
+ * and per_second more each second after that, or none with a per_second
+ * of 0, so that a hot loop cannot flood the log:
+ *
+ *   FD_LOG_WARN_RATELIMITED(10, 1, "queue full, dropping %d", id);
+ *
+ * The limit is checked after the level and before the arguments are
+ * evaluated or anything is formatted. The next message logged by a call
+ * site tells how many it suppressed in between, by appending
+ * CLOGGING_SUPPRESSED_FORMAT to its format, which therefore has to be a
+ * string literal.
+ *
+ * Each call site keeps a static clogging_ratelimit_t. Its bucket is the
+ * time at which it is full again, which is moved on with a compare and
+ * swap, so the limit is lock free and never shared between call sites.
+ */
+
+/* Appended to the format of a message with the count of the messages
+ * suppressed before it.
+ */
+#define CLOGGING_SUPPRESSED_FORMAT " [%u suppressed]"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* full_ns is swapped as a 64-bit atomic, which has to be aligned to 8
+ * bytes even where uint64_t alone is not, as on i386 and 32-bit ARM.
+ */
+#if defined(__cplusplus)
+#define CLOGGING_RATELIMIT_ALIGN alignas(8)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define CLOGGING_RATELIMIT_ALIGN _Alignas(8)
+#elif defined(_MSC_VER)
+#define CLOGGING_RATELIMIT_ALIGN __declspec(align(8))
+#else
+#define CLOGGING_RATELIMIT_ALIGN __attribute__((aligned(8)))
+#endif
+
+/* State of the rate limit of a call site, all zero to begin with. */
+typedef struct {
+  /* when the bucket is full, see log_ratelimit.c */
+  CLOGGING_RATELIMIT_ALIGN uint64_t full_ns;
+  uint32_t suppressed; /* messages suppressed since the last one logged */
+} clogging_ratelimit_t;
+
+/* Take a token from the bucket of rl, which holds burst tokens and gets
+ * per_second of them each second, or never gets any when it is 0, at the
+ * monotonic time now_ns.
+ * Returns 1 and sets *suppressed to the count of the messages suppressed
+ * since the last one when there was a token, otherwise 0.
+ *
+ * It is MT safe and lock free.
+ */
+int clogging_ratelimit_allow_at(clogging_ratelimit_t *rl, uint32_t burst,
+                                uint32_t per_second, uint64_t now_ns,
+                                uint32_t *suppressed);
+
+/* clogging_ratelimit_allow_at() at the current monotonic time. */
+int clogging_ratelimit_allow(clogging_ratelimit_t *rl, uint32_t burst,
+                             uint32_t per_second, uint32_t *suppressed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOGGING_LOG_RATELIMIT_H */
@@ -12,6 +12,7 @@
 
 #include "logging_common.h"
 
+#include <stdlib.h>   /* malloc(), free() */
 #include <string.h>   /* strncpy(), strnlen() */
 #include <stdio.h>    /* snprintf() */
 #include <time.h>     /* gmtime_r() */
@@ -23,6 +24,7 @@
 #else
 #include <unistd.h>   /* write() */
 #include <sys/stat.h> /* fstat(), S_ISSOCK, S_ISFIFO */
+#include <sys/uio.h>  /* writev() */
 #include <sys/socket.h> /* for socket detection on Unix */
 #endif
 
@@ -80,13 +82,72 @@ const char *get_log_level_as_cstring(enum LogLevel level) {
   return level_to_str[level];
 }
 
+/* "YYYY-MM-DDTHH:MM:SS+00:00" */
+#define TIME_STR_BYTES 25
+#define TIME_STR_HOUR_OFFSET 11
+#define TIME_STR_MINUTE_OFFSET 14
+#define TIME_STR_SECOND_OFFSET 17
+#define SECONDS_PER_DAY 86400
+
+/* The rendered timestamp of the last second seen by the thread.
+ * Consecutive log messages mostly fall within the same second, and then
+ * within the same day, so only the changed time of day digits are
+ * rewritten and gmtime_r() plus snprintf() is left for a new day.
+ */
+static THREAD_LOCAL time_t g_time_cache_day = 0;
+static THREAD_LOCAL int g_time_cache_second = -1; /* of the day, -1 if empty */
+static THREAD_LOCAL char g_time_cache_str[TIME_STR_BYTES + 1];
+
+static void put_2digits(char *dst, int val) {
+  dst[0] = (char)('0' + val / 10);
+  dst[1] = (char)('0' + val % 10);
+}
+
 int time_to_cstr(time_t *t, char *timestr, int maxlen) {
   struct tm tms;
+  time_t day = *t / SECONDS_PER_DAY;
+  int second = (int)(*t % SECONDS_PER_DAY);
+
+  if (maxlen <= TIME_STR_BYTES) {
+    /* truncated anyway, so keep the exact snprintf() semantics */
+    gmtime_r(t, &tms);
+    return snprintf(timestr, maxlen, "%04d-%02d-%02dT%02d:%02d:%02d+00:00",
+             tms.tm_year + 1900, tms.tm_mon + 1, tms.tm_mday, tms.tm_hour,
+             tms.tm_min, tms.tm_sec);
+  }
+
+  /* round towards negative infinity for times before the Epoch */
+  if (second < 0) {
+    second += SECONDS_PER_DAY;
+    --day;
+  }
 
-  gmtime_r(t, &tms);
-  return snprintf(timestr, maxlen, "%04d-%02d-%02dT%02d:%02d:%02d+00:00",
-           tms.tm_year + 1900, tms.tm_mon + 1, tms.tm_mday, tms.tm_hour,
-           tms.tm_min, tms.tm_sec);
+  if (day != g_time_cache_day || g_time_cache_second < 0) {
+    if (gmtime_r(t, &tms) == NULL) {
+      return -1;
+    }
+    if (snprintf(g_time_cache_str, sizeof(g_time_cache_str),
+                 "%04d-%02d-%02dT%02d:%02d:%02d+00:00", tms.tm_year + 1900,
+                 tms.tm_mon + 1, tms.tm_mday, tms.tm_hour, tms.tm_min,
+                 tms.tm_sec) != TIME_STR_BYTES) {
+      /* years beyond 9999 are not cached */
+      g_time_cache_second = -1;
+      return snprintf(timestr, maxlen, "%s", g_time_cache_str);
+    }
+    g_time_cache_day = day;
+    g_time_cache_second = second;
+  } else if (second != g_time_cache_second) {
+    if (second / 60 != g_time_cache_second / 60) {
+      put_2digits(&g_time_cache_str[TIME_STR_HOUR_OFFSET], second / 3600);
+      put_2digits(&g_time_cache_str[TIME_STR_MINUTE_OFFSET],
+                  (second / 60) % 60);
+    }
+    put_2digits(&g_time_cache_str[TIME_STR_SECOND_OFFSET], second % 60);
+    g_time_cache_second = second;
+  }
+
+  memcpy(timestr, g_time_cache_str, TIME_STR_BYTES + 1);
+  return TIME_STR_BYTES;
 }
 
 char *clogging_strtcpy(char *dest, const char *src, size_t dsize) {
@@ -256,6 +317,49 @@ ssize_t clogging_handle_write(clogging_handle_t handle, const void *buf,
   }
 }
 
+ssize_t clogging_handle_writev(clogging_handle_t handle,
+                               const clogging_iovec_t *iov, int cnt) {
+  ssize_t total = 0;
+  ssize_t written = 0;
+  size_t bytes = 0;
+  char *buf = NULL;
+  int i = 0;
+
+  if (cnt < 0 || cnt > CLOGGING_MAX_IOVECS) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (handle.type == CLOGGING_HANDLE_TYPE_SOCKET) {
+    /* one send() so that a datagram is not split */
+    for (i = 0; i < cnt; ++i) {
+      bytes += iov[i].len;
+    }
+    buf = (char *)malloc(bytes > 0 ? bytes : 1);
+    if (buf == NULL) {
+      errno = ENOMEM;
+      return -1;
+    }
+    for (i = 0, bytes = 0; i < cnt; ++i) {
+      memcpy(buf + bytes, iov[i].base, iov[i].len);
+      bytes += iov[i].len;
+    }
+    written = clogging_handle_write(handle, buf, bytes);
+    free(buf);
+    return written;
+  }
+  for (i = 0; i < cnt; ++i) {
+    written = clogging_handle_write(handle, iov[i].base, iov[i].len);
+    if (written < 0) {
+      return (total > 0) ? total : -1;
+    }
+    total += written;
+    if ((size_t)written < iov[i].len) {
+      break;
+    }
+  }
+  return total;
+}
+
 #else /* Unix/Linux */
 
 clogging_handle_t clogging_create_handle_from_fd(int fd) {
@@ -287,6 +391,22 @@ ssize_t clogging_handle_write(clogging_handle_t handle, const void *buf,
   return write(handle, buf, count);
 }
 
+ssize_t clogging_handle_writev(clogging_handle_t handle,
+                               const clogging_iovec_t *iov, int cnt) {
+  struct iovec v[CLOGGING_MAX_IOVECS];
+  int i = 0;
+
+  if (cnt < 0 || cnt > CLOGGING_MAX_IOVECS) {
+    errno = EINVAL;
+    return -1;
+  }
+  for (i = 0; i < cnt; ++i) {
+    v[i].iov_base = (void *)iov[i].base;
+    v[i].iov_len = iov[i].len;
+  }
+  return writev(handle, v, cnt);
+}
+
 #endif /* _WIN32 */
 
 
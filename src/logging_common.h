@@ -43,9 +43,19 @@ typedef SSIZE_T ssize_t;
 /* Maximum size of message in bytes which can be logged. Note that this
  * do not include the prefix size where timestamp and other details
  * might be present.
+ *
+ * The text and JSON lines of the basic and fd logging are limited by
+ * max_line_bytes of the options instead, see below.
  */
 #define MAX_LOG_MSG_LEN 256
 
+/* Size limit of a text or JSON log line (max_line_bytes) by default and
+ * at most, including the prefix. The message gets whatever room the
+ * prefix leaves and is truncated beyond that.
+ */
+#define CLOGGING_DEFAULT_MAX_LINE_BYTES 1024
+#define CLOGGING_MAX_LINE_BYTES 65535
+
 /* DONT change the values because there is a lookup
  * implemented in specific logging implementation
  * based on these values. See logging_common.c for
@@ -68,6 +78,73 @@ enum LogLevel {
  */
 #define DEFAULT_LOG_LEVEL LOG_LEVEL_INFO
 
+/* Messages less severe than CLOGGING_MIN_LEVEL, a number from 0 (ERROR)
+ * to 3 (DEBUG), are compiled out of the log macros of basic_logging.h,
+ * fd_logging.h and binary_logging.h, along with their format strings and
+ * arguments, and cannot be switched on at run time. A value of -1 compiles
+ * out every message. All are kept by default, and defining
+ * DISABLE_DEBUG_LOGS is the same as a CLOGGING_MIN_LEVEL of 2 (INFO).
+ *
+ * Set it with cmake -DCLOGGING_MIN_LEVEL=INFO (or NONE, ERROR, WARN,
+ * DEBUG), which passes it on to everything built against the library.
+ */
+#ifndef CLOGGING_MIN_LEVEL
+#ifdef DISABLE_DEBUG_LOGS
+#define CLOGGING_MIN_LEVEL 2
+#else
+#define CLOGGING_MIN_LEVEL 3
+#endif /* DISABLE_DEBUG_LOGS */
+#endif /* CLOGGING_MIN_LEVEL */
+
+/* CLOGGING_KEEP_<LEVEL>(statement) is the statement when messages of
+ * that level are kept by CLOGGING_MIN_LEVEL and nothing otherwise, so that
+ * the preprocessor drops them whatever the optimization level.
+ */
+#if CLOGGING_MIN_LEVEL >= 0
+#define CLOGGING_KEEP_ERROR(statement) statement
+#else
+#define CLOGGING_KEEP_ERROR(statement) do { } while (0)
+#endif
+#if CLOGGING_MIN_LEVEL >= 1
+#define CLOGGING_KEEP_WARN(statement) statement
+#else
+#define CLOGGING_KEEP_WARN(statement) do { } while (0)
+#endif
+#if CLOGGING_MIN_LEVEL >= 2
+#define CLOGGING_KEEP_INFO(statement) statement
+#else
+#define CLOGGING_KEEP_INFO(statement) do { } while (0)
+#endif
+#if CLOGGING_MIN_LEVEL >= 3
+#define CLOGGING_KEEP_DEBUG(statement) statement
+#else
+#define CLOGGING_KEEP_DEBUG(statement) do { } while (0)
+#endif
+
+/* Or'ed into the level passed to the logmsg() functions by the log
+ * macros, which have checked it already along with the filters of
+ * log_filter.h, so that it is not checked against the level of the
+ * thread again.
+ */
+#define CLOGGING_LEVEL_CHECKED 0x100
+#define CLOGGING_CHECKED_LEVEL(level)                                         \
+  ((enum LogLevel)((level) | CLOGGING_LEVEL_CHECKED))
+
+#ifndef _WIN32
+/* The level of the calling thread from the {generation:24, level:8}
+ * words of the process and of the thread, as the log macros check it.
+ * The level of the thread holds while it has the generation of the
+ * process, see clogging_fd_set_process_loglevel(). This is one relaxed
+ * load of the shared word and a read of the thread's own.
+ */
+static inline int clogging_level_of(const uint32_t *process,
+                                    uint32_t thread) {
+  uint32_t word = __atomic_load_n(process, __ATOMIC_RELAXED);
+
+  return (int)((((word ^ thread) >> 8) == 0 ? thread : word) & 0xff);
+}
+#endif /* _WIN32 */
+
 /* Log output prefix field flags (bitmap).
  * These flags control which fields are included in the log line prefix.
  */
@@ -85,6 +162,19 @@ enum LogLevel {
                                 CLOGGING_PREFIX_LOGLEVEL | CLOGGING_PREFIX_FUNCNAME | \
                                 CLOGGING_PREFIX_LINENUM)
 
+/* Clock sources for the timestamp of log records (clock_source).
+ * See log_clock.h for details.
+ */
+#define CLOGGING_CLOCK_REALTIME        0  /* CLOCK_REALTIME (default) */
+#define CLOGGING_CLOCK_REALTIME_COARSE 1  /* cheaper, jiffy resolution */
+#define CLOGGING_CLOCK_TSC             2  /* calibrated CPU cycle counter */
+
+/* Precision of the timestamp of log records (time_precision). */
+#define CLOGGING_TIME_PRECISION_SEC 0  /* seconds (default) */
+#define CLOGGING_TIME_PRECISION_MS  1  /* milliseconds */
+#define CLOGGING_TIME_PRECISION_US  2  /* microseconds */
+#define CLOGGING_TIME_PRECISION_NS  3  /* nanoseconds */
+
 /* Logging options structure
  * This structure is passed to init functions to configure logging behavior.
  */
@@ -92,6 +182,17 @@ typedef struct {
   uint8_t color;               /* 1 to enable colored output, 0 to disable */
   uint8_t json;                /* 1 to enable JSONL output, 0 to disable */
   uint8_t prefix_fields_flag;  /* Bitmap of prefix fields to display (use CLOGGING_PREFIX_* flags) */
+  uint8_t async;               /* 1 to hand records to a background writer thread (fd logging only) */
+  uint8_t deferred;            /* 1 to format records in the background writer thread, implies async (fd logging only) */
+  uint8_t clock_source;        /* One of CLOGGING_CLOCK_* */
+  uint8_t time_precision;      /* One of CLOGGING_TIME_PRECISION_* */
+  uint32_t max_line_bytes;     /* Size limit of a log line, 0 for CLOGGING_DEFAULT_MAX_LINE_BYTES (basic and fd logging only) */
+  uint8_t intern_formats;      /* 1 to send each format once in a FORMAT frame and refer to it by id (binary logging only) */
+  uint8_t binary_version;      /* One of CLOGGING_BINARY_VERSION_*, 0 for the default (binary logging only) */
+  uint8_t intern_identity;     /* 1 to send hostname, progname, threadname and pid once in an IDENTITY frame (binary logging only) */
+  uint8_t delta_timestamps;    /* 1 for nanosecond deltas from a TIMEBASE frame, implies intern_identity (binary logging only) */
+  uint8_t native_endian;       /* 1 to store values in host byte order, told by a STREAM frame (binary logging only) */
+  uint8_t chunk_records;       /* 1 to split records too large for a frame into CONTINUATION frames (binary logging only) */
 } clogging_log_options_t;
 
 /* Platform-agnostic file descriptor/handle type for cross-platform I/O.
@@ -167,6 +268,9 @@ const char *get_log_level_as_cstring(enum LogLevel level);
  * The current implementation follows the ISO 8601 date and time
  * combined format with a resolution of seconds in the UTC timezone.
  * In case of error -1 is retured.
+ *
+ * The string of the last second is cached per thread, so that only the
+ * changed digits are rendered for consecutive calls within the same day.
  */
 int time_to_cstr(time_t *t, char *timestr, int maxlen);
 
@@ -223,6 +327,25 @@ int clogging_handle_is_pipe(clogging_handle_t handle);
 ssize_t clogging_handle_write(clogging_handle_t handle, const void *buf,
                              size_t count);
 
+/* One piece of the data of clogging_handle_writev(). */
+typedef struct {
+  const void *base;
+  size_t len;
+} clogging_iovec_t;
+
+/* Most pieces clogging_handle_writev() takes at once. */
+#define CLOGGING_MAX_IOVECS 32
+
+/* Platform-agnostic gather write of the cnt pieces of iov, in order and
+ * as a single write (writev() on POSIX), so a datagram socket gets them
+ * in one datagram.
+ * Returns number of bytes written, which can be less than the total of
+ * the pieces, or -1 on error.
+ * Sets errno on error.
+ */
+ssize_t clogging_handle_writev(clogging_handle_t handle,
+                               const clogging_iovec_t *iov, int cnt);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "shm_ring.h"
+
+#include <errno.h>     /* errno */
+#include <stdatomic.h> /* atomic_load_explicit() and friends */
+#include <stdlib.h>    /* malloc(), free() */
+#include <string.h>    /* memcpy(), memset() */
+
+#ifndef _WIN32
+#include <fcntl.h>     /* O_CREAT and friends */
+#include <sys/mman.h>  /* shm_open(), mmap() */
+#include <sys/stat.h>  /* fstat() */
+#include <time.h>      /* clock_gettime(), nanosleep() */
+#include <unistd.h>    /* ftruncate(), close() */
+#ifdef __linux__
+#include <linux/futex.h> /* FUTEX_WAIT, FUTEX_WAKE */
+#include <sys/syscall.h> /* SYS_futex */
+#endif /* __linux__ */
+#endif /* _WIN32 */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef _WIN32
+
+/* The layout of the shared memory, which is the same in every process
+ * mapping it:
+ *
+ * <shm_ring_header> (one page) <data> (capacity bytes)
+ *
+ * Every record in data starts with an 8 byte header whose first 32 bits
+ * hold the length of the record with SHM_COMMITTED set once the record
+ * is complete. A header with SHM_PAD_MARKER means skip to the start of
+ * the ring because the next record did not fit at the end. The reader
+ * zeroes everything it consumes, so a header of 0 always means the
+ * record is not there yet.
+ */
+#define SHM_MAGIC 0x434c5352u /* "CLSR" */
+#define SHM_VERSION 1
+#define SHM_HEADER_PAGE 4096
+#define SHM_RECORD_HEADER_BYTES 8
+#define SHM_COMMITTED 0x80000000u
+#define SHM_PAD_MARKER UINT32_MAX
+#define SHM_RECORD_BYTES(len)                                                \
+  ((((len) + SHM_RECORD_HEADER_BYTES) + 7) & ~((uint64_t)7))
+
+/* keep producer and consumer owned fields on separate cache lines */
+#define SHM_CACHE_LINE 64
+
+/* how often the reader looks at the ring when it cannot sleep on a futex */
+#define SHM_POLL_WAIT_MS 1
+
+struct shm_ring_header {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t capacity;
+  char pad_config[SHM_CACHE_LINE - 16];
+
+  /* producers claim space by moving this forward */
+  _Atomic uint64_t reserve;
+  _Atomic uint64_t drops;
+  char pad_producer[SHM_CACHE_LINE - 16];
+
+  /* reader owned */
+  _Atomic uint64_t tail;
+  _Atomic uint32_t wake_seq;       /* futex word */
+  _Atomic uint32_t reader_waiting; /* 1 while the reader may sleep */
+};
+
+struct clogging_shm_ring {
+  struct shm_ring_header *hdr;
+  char *data;
+  uint64_t capacity;
+  uint64_t mask;
+  size_t map_bytes;
+};
+
+static _Atomic uint32_t *shm_record_header(clogging_shm_ring_t *ring,
+                                           uint64_t pos) {
+  return (_Atomic uint32_t *)(void *)&ring->data[pos];
+}
+
+static void shm_wake_reader(clogging_shm_ring_t *ring) {
+  atomic_fetch_add_explicit(&ring->hdr->wake_seq, 1, memory_order_release);
+#ifdef __linux__
+  /* not FUTEX_PRIVATE_FLAG since the reader is in another process */
+  syscall(SYS_futex, &ring->hdr->wake_seq, FUTEX_WAKE, 1, NULL, NULL, 0);
+#endif
+}
+
+/* Sleep till the wake_seq moves on from seq or timeout_ms elapses. */
+static void shm_wait_writer(clogging_shm_ring_t *ring, uint32_t seq,
+                            int timeout_ms) {
+#ifdef __linux__
+  struct timespec ts = {timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000L};
+
+  syscall(SYS_futex, &ring->hdr->wake_seq, FUTEX_WAIT, seq,
+          timeout_ms < 0 ? NULL : &ts, NULL, 0);
+#else
+  struct timespec ts = {0, (long)SHM_POLL_WAIT_MS * 1000000L};
+
+  (void)ring;
+  (void)seq;
+  (void)timeout_ms;
+  nanosleep(&ts, NULL);
+#endif
+}
+
+static int64_t shm_now_ms(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000L;
+}
+
+static clogging_shm_ring_t *shm_ring_map(int fd, size_t map_bytes) {
+  clogging_shm_ring_t *ring = NULL;
+  void *addr = NULL;
+  int flags = MAP_SHARED;
+
+  if (fd < 0) {
+    flags |= MAP_ANONYMOUS;
+  }
+  addr = mmap(NULL, map_bytes, PROT_READ | PROT_WRITE, flags, fd, 0);
+  if (addr == MAP_FAILED) {
+    return NULL;
+  }
+  ring = (clogging_shm_ring_t *)malloc(sizeof(*ring));
+  if (ring == NULL) {
+    munmap(addr, map_bytes);
+    errno = ENOMEM;
+    return NULL;
+  }
+  ring->hdr = (struct shm_ring_header *)addr;
+  ring->data = (char *)addr + SHM_HEADER_PAGE;
+  ring->map_bytes = map_bytes;
+  return ring;
+}
+
+clogging_shm_ring_t *clogging_shm_ring_create(const char *name,
+                                              size_t capacity) {
+  clogging_shm_ring_t *ring = NULL;
+  uint64_t ring_bytes = 4096;
+  int fd = -1;
+  int err = 0;
+
+  /* round up to a power of 2 so that positions can be masked */
+  while (ring_bytes < capacity) {
+    ring_bytes <<= 1;
+  }
+
+  if (name != NULL) {
+    fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      return NULL;
+    }
+    if (ftruncate(fd, (off_t)(SHM_HEADER_PAGE + ring_bytes)) != 0) {
+      err = errno;
+      close(fd);
+      shm_unlink(name);
+      errno = err;
+      return NULL;
+    }
+  }
+  ring = shm_ring_map(fd, (size_t)(SHM_HEADER_PAGE + ring_bytes));
+  err = errno;
+  if (fd >= 0) {
+    /* the mapping keeps the memory alive */
+    close(fd);
+  }
+  if (ring == NULL) {
+    if (name != NULL) {
+      shm_unlink(name);
+    }
+    errno = err;
+    return NULL;
+  }
+
+  /* fresh shared memory is zero filled, which is an empty ring */
+  ring->capacity = ring_bytes;
+  ring->mask = ring_bytes - 1;
+  atomic_init(&ring->hdr->reserve, 0);
+  atomic_init(&ring->hdr->drops, 0);
+  atomic_init(&ring->hdr->tail, 0);
+  atomic_init(&ring->hdr->wake_seq, 0);
+  atomic_init(&ring->hdr->reader_waiting, 0);
+  ring->hdr->capacity = ring_bytes;
+  ring->hdr->version = SHM_VERSION;
+  /* last, since this is what clogging_shm_ring_open() checks */
+  atomic_thread_fence(memory_order_release);
+  ring->hdr->magic = SHM_MAGIC;
+  return ring;
+}
+
+clogging_shm_ring_t *clogging_shm_ring_open(const char *name) {
+  clogging_shm_ring_t *ring = NULL;
+  struct stat st;
+  int fd = -1;
+  int err = 0;
+
+  fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0) {
+    return NULL;
+  }
+  if (fstat(fd, &st) != 0) {
+    err = errno;
+    close(fd);
+    errno = err;
+    return NULL;
+  }
+  if (st.st_size <= SHM_HEADER_PAGE) {
+    close(fd);
+    errno = EINVAL;
+    return NULL;
+  }
+  ring = shm_ring_map(fd, (size_t)st.st_size);
+  err = errno;
+  close(fd);
+  if (ring == NULL) {
+    errno = err;
+    return NULL;
+  }
+  if (ring->hdr->magic != SHM_MAGIC || ring->hdr->version != SHM_VERSION ||
+      ring->hdr->capacity + SHM_HEADER_PAGE != (uint64_t)st.st_size) {
+    clogging_shm_ring_close(ring);
+    errno = EINVAL;
+    return NULL;
+  }
+  atomic_thread_fence(memory_order_acquire);
+  ring->capacity = ring->hdr->capacity;
+  ring->mask = ring->capacity - 1;
+  return ring;
+}
+
+void clogging_shm_ring_close(clogging_shm_ring_t *ring) {
+  if (ring == NULL) {
+    return;
+  }
+  munmap(ring->hdr, ring->map_bytes);
+  free(ring);
+}
+
+int clogging_shm_ring_unlink(const char *name) { return shm_unlink(name); }
+
+int clogging_shm_ring_write(clogging_shm_ring_t *ring, const void *rec,
+                            size_t len) {
+  struct shm_ring_header *hdr = ring->hdr;
+  uint64_t need = SHM_RECORD_BYTES((uint64_t)len);
+  uint64_t claim = atomic_load_explicit(&hdr->reserve, memory_order_relaxed);
+  uint64_t tail = 0;
+  uint64_t pos = 0;
+  uint64_t pad = 0;
+
+  /* a record must fit even after skipping the end of the ring */
+  if (need > ring->capacity / 2 || len >= SHM_COMMITTED) {
+    atomic_fetch_add_explicit(&hdr->drops, 1, memory_order_relaxed);
+    return -1;
+  }
+
+  do {
+    pos = claim & ring->mask;
+    pad = (pos + need > ring->capacity) ? ring->capacity - pos : 0;
+    /* acquire, so that the reader zeroing the space happens before */
+    tail = atomic_load_explicit(&hdr->tail, memory_order_acquire);
+    if (claim + pad + need - tail > ring->capacity) {
+      atomic_fetch_add_explicit(&hdr->drops, 1, memory_order_relaxed);
+      return -1;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(
+      &hdr->reserve, &claim, claim + pad + need, memory_order_relaxed,
+      memory_order_relaxed));
+
+  if (pad > 0) {
+    atomic_store_explicit(shm_record_header(ring, pos), SHM_PAD_MARKER,
+                          memory_order_release);
+    pos = 0;
+  }
+  memcpy(&ring->data[pos + SHM_RECORD_HEADER_BYTES], rec, len);
+  atomic_store_explicit(shm_record_header(ring, pos),
+                        (uint32_t)len | SHM_COMMITTED, memory_order_release);
+
+  /* pairs with the reader publishing reader_waiting before it looks at
+   * the ring one last time.
+   */
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&hdr->reader_waiting, memory_order_relaxed)) {
+    shm_wake_reader(ring);
+  }
+  return 0;
+}
+
+ssize_t clogging_shm_ring_read(clogging_shm_ring_t *ring, void *buf,
+                               size_t buflen, int timeout_ms) {
+  struct shm_ring_header *hdr = ring->hdr;
+  int64_t deadline = timeout_ms > 0 ? shm_now_ms() + timeout_ms : 0;
+  int64_t remaining_ms = timeout_ms;
+  uint64_t tail = atomic_load_explicit(&hdr->tail, memory_order_relaxed);
+  uint64_t pos = 0;
+  uint32_t word = 0;
+  uint32_t seq = 0;
+  size_t len = 0;
+
+  for (;;) {
+    pos = tail & ring->mask;
+    word = atomic_load_explicit(shm_record_header(ring, pos),
+                                memory_order_acquire);
+    if (word == SHM_PAD_MARKER) {
+      memset(&ring->data[pos], 0, (size_t)(ring->capacity - pos));
+      tail += ring->capacity - pos;
+      atomic_store_explicit(&hdr->tail, tail, memory_order_release);
+      continue;
+    }
+    if (word != 0) {
+      break;
+    }
+    if (timeout_ms == 0) {
+      return 0;
+    }
+    if (timeout_ms > 0) {
+      remaining_ms = deadline - shm_now_ms();
+      if (remaining_ms <= 0) {
+        return 0;
+      }
+    }
+
+    seq = atomic_load_explicit(&hdr->wake_seq, memory_order_acquire);
+    atomic_store_explicit(&hdr->reader_waiting, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(shm_record_header(ring, pos),
+                             memory_order_relaxed) == 0) {
+      shm_wait_writer(ring, seq, (int)remaining_ms);
+    }
+    atomic_store_explicit(&hdr->reader_waiting, 0, memory_order_relaxed);
+  }
+
+  len = word & ~SHM_COMMITTED;
+  memcpy(buf, &ring->data[pos + SHM_RECORD_HEADER_BYTES],
+         len < buflen ? len : buflen);
+  /* hand the space back to the producers */
+  memset(&ring->data[pos], 0, (size_t)SHM_RECORD_BYTES((uint64_t)len));
+  atomic_store_explicit(&hdr->tail, tail + SHM_RECORD_BYTES((uint64_t)len),
+                        memory_order_release);
+  return (ssize_t)(len < buflen ? len : buflen);
+}
+
+uint64_t clogging_shm_ring_get_drops(clogging_shm_ring_t *ring) {
+  return atomic_load_explicit(&ring->hdr->drops, memory_order_relaxed);
+}
+
+#else /* ?_WIN32 */
+
+/* Not supported on Windows (yet). */
+
+clogging_shm_ring_t *clogging_shm_ring_create(const char *name,
+                                              size_t capacity) {
+  (void)name;
+  (void)capacity;
+  errno = ENOSYS;
+  return NULL;
+}
+
+clogging_shm_ring_t *clogging_shm_ring_open(const char *name) {
+  (void)name;
+  errno = ENOSYS;
+  return NULL;
+}
+
+void clogging_shm_ring_close(clogging_shm_ring_t *ring) { (void)ring; }
+
+int clogging_shm_ring_unlink(const char *name) {
+  (void)name;
+  return -1;
+}
+
+int clogging_shm_ring_write(clogging_shm_ring_t *ring, const void *rec,
+                            size_t len) {
+  (void)ring;
+  (void)rec;
+  (void)len;
+  return -1;
+}
+
+ssize_t clogging_shm_ring_read(clogging_shm_ring_t *ring, void *buf,
+                               size_t buflen, int timeout_ms) {
+  (void)ring;
+  (void)buf;
+  (void)buflen;
+  (void)timeout_ms;
+  return -1;
+}
+
+uint64_t clogging_shm_ring_get_drops(clogging_shm_ring_t *ring) {
+  (void)ring;
+  return 0;
+}
+
+#endif /* _WIN32 */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifndef CLOGGING_SHM_RING_H
+#define CLOGGING_SHM_RING_H
+
+#include "logging_common.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Multi-producer/single-consumer record ring in shared memory.
+ *
+ * Any number of threads, in any number of processes which have the ring
+ * mapped, publish records with clogging_shm_ring_write() without making
+ * a system call (unless the reader is asleep, when one futex wake-up is
+ * issued). A single reader, typically a separate process, drains the
+ * records in the order they were claimed with clogging_shm_ring_read().
+ *
+ * See clogging_binary_init_shm() in binary_logging.h to have binary
+ * logging publish its records here instead of writing them to a handle.
+ *
+ * Available on POSIX platforms only, the functions fail on Windows.
+ * Wake-ups use a futex on Linux while other platforms fall back to
+ * polling in the reader.
+ *
+ * IMPORTANT: a producer which dies between claiming space and publishing
+ * the record stalls the reader at that record, so do not kill logging
+ * processes with SIGKILL while the ring is in use.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default size of the ring data in bytes. */
+#define CLOGGING_SHM_RING_BYTES (1024 * 1024)
+
+typedef struct clogging_shm_ring clogging_shm_ring_t;
+
+/* Create a ring of (at least) capacity bytes, which is rounded up to a
+ * power of two.
+ *
+ * When name is not NULL it is a POSIX shared memory object name (say
+ * "/myapp-log") which must not exist yet, so that unrelated processes can
+ * attach to it with clogging_shm_ring_open(). When name is NULL the ring
+ * is anonymous and is shared with the children forked afterwards only.
+ *
+ * Returns NULL on failure with errno set.
+ */
+clogging_shm_ring_t *clogging_shm_ring_create(const char *name,
+                                              size_t capacity);
+
+/* Attach to the ring created by another process under name.
+ *
+ * Returns NULL on failure with errno set.
+ */
+clogging_shm_ring_t *clogging_shm_ring_open(const char *name);
+
+/* Unmap the ring. It must not be used by any thread of the calling
+ * process afterwards.
+ */
+void clogging_shm_ring_close(clogging_shm_ring_t *ring);
+
+/* Remove the name of the ring, the memory is released once every process
+ * has closed it. Returns 0 on success and -1 on failure.
+ */
+int clogging_shm_ring_unlink(const char *name);
+
+/* Publish a record of len bytes. This is MT safe and safe across
+ * processes.
+ *
+ * Returns 0 on success and -1 when the ring is full (or the record is
+ * larger than half the ring), in which case the record is dropped and
+ * counted in clogging_shm_ring_get_drops().
+ */
+int clogging_shm_ring_write(clogging_shm_ring_t *ring, const void *rec,
+                            size_t len);
+
+/* Copy the oldest record into buf, of which at most buflen bytes are
+ * used (the rest of a longer record is discarded). Waits up to
+ * timeout_ms milliseconds for a record when there is none, a negative
+ * value waits forever.
+ *
+ * Only one thread of one process may read a ring.
+ *
+ * Returns the number of bytes copied, 0 on timeout and -1 on error.
+ */
+ssize_t clogging_shm_ring_read(clogging_shm_ring_t *ring, void *buf,
+                               size_t buflen, int timeout_ms);
+
+/* Get the number of records dropped by all the producers so far. */
+uint64_t clogging_shm_ring_get_drops(clogging_shm_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOGGING_SHM_RING_H */
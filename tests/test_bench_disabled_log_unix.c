@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef _WIN32
+#error This file is for non-Windows platforms only
+#endif /* _WIN32 */
+
+#include "../src/basic_logging.h"
+#include "../src/binary_logging.h"
+#include "../src/fd_logging.h"
+
+#include <fcntl.h>  /* open() */
+#include <stdio.h>
+#include <time.h>   /* clock_gettime() */
+#include <unistd.h> /* close() */
+
+#define NUM_BENCH_CALLS 10000000
+
+static int g_evaluations = 0;
+/* read on every message, so that the level check is not hoisted */
+static volatile enum LogLevel g_bench_level = LOG_LEVEL_DEBUG;
+
+/* stands for an argument which is costly to work out */
+static __attribute__((noinline)) int expensive_dump(int i) {
+  ++g_evaluations;
+  return i * 7;
+}
+
+static double elapsed_ns(const struct timespec *start,
+                         const struct timespec *end) {
+  return (double)(end->tv_sec - start->tv_sec) * 1e9 +
+         (double)(end->tv_nsec - start->tv_nsec);
+}
+
+/* Disabled messages must not evaluate their arguments, enabled ones must */
+static int test_evaluation(void) {
+  /* unless compiled out by CLOGGING_MIN_LEVEL */
+  int expected =
+      (CLOGGING_MIN_LEVEL >= LOG_LEVEL_DEBUG ? 3 : 0) +
+      (CLOGGING_MIN_LEVEL >= LOG_LEVEL_ERROR ? 1 : 0);
+  int failed = 0;
+
+  g_evaluations = 0;
+  BASIC_LOG_DEBUG("dump %d", expensive_dump(1));
+  FD_LOG_DEBUG("dump %d", expensive_dump(2));
+  BINARY_LOG_DEBUG("dump %d", expensive_dump(3));
+  CLOGGING_BINARY_LOG_TYPED(LOG_LEVEL_DEBUG, "dump %d", expensive_dump(4));
+  BASIC_LOG_INFO("dump %d", expensive_dump(5));
+  if (g_evaluations != 0) {
+    fprintf(stderr, "%d arguments of disabled messages evaluated\n",
+            g_evaluations);
+    failed = 1;
+  }
+
+  /* the level is per thread and the macros see a change at once */
+  clogging_fd_set_loglevel(LOG_LEVEL_DEBUG);
+  clogging_binary_set_loglevel(LOG_LEVEL_DEBUG);
+  FD_LOG_DEBUG("dump %d", expensive_dump(6));
+  BINARY_LOG_DEBUG("dump %d", expensive_dump(7));
+  CLOGGING_BINARY_LOG_TYPED(LOG_LEVEL_DEBUG, "dump %d", expensive_dump(8));
+  BASIC_LOG_ERROR("dump %d", expensive_dump(9));
+  if (g_evaluations != expected ||
+      clogging_fd_get_num_dropped_messages() != 0 ||
+      clogging_binary_get_num_dropped_messages() != 0) {
+    fprintf(stderr, "%d arguments of enabled messages evaluated\n",
+            g_evaluations);
+    failed = 1;
+  }
+  clogging_fd_set_loglevel(LOG_LEVEL_WARN);
+  clogging_binary_set_loglevel(LOG_LEVEL_WARN);
+  return failed;
+}
+
+/* The cost of a DEBUG message when the level is WARN, with the level
+ * checked in the library and in the macro
+ */
+static void bench(void) {
+  struct timespec start;
+  struct timespec end;
+  double call_ns = 0.0;
+  double basic_ns = 0.0;
+  double fd_ns = 0.0;
+  double binary_ns = 0.0;
+  int i = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < NUM_BENCH_CALLS; ++i) {
+    clogging_basic_logmsg(__func__, __LINE__, g_bench_level, "dump %d",
+                          expensive_dump(i));
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  call_ns = elapsed_ns(&start, &end) / NUM_BENCH_CALLS;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < NUM_BENCH_CALLS; ++i) {
+    CLOGGING_BASIC_LOG(g_bench_level, "dump %d", expensive_dump(i));
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  basic_ns = elapsed_ns(&start, &end) / NUM_BENCH_CALLS;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < NUM_BENCH_CALLS; ++i) {
+    CLOGGING_FD_LOG(g_bench_level, "dump %d", expensive_dump(i));
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  fd_ns = elapsed_ns(&start, &end) / NUM_BENCH_CALLS;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < NUM_BENCH_CALLS; ++i) {
+    /* the level of a site is a constant */
+    BINARY_LOG_DEBUG("dump %d", expensive_dump(i));
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  binary_ns = elapsed_ns(&start, &end) / NUM_BENCH_CALLS;
+
+  printf("disabled clogging_basic_logmsg: %.2f ns/call, CLOGGING_BASIC_LOG: "
+         "%.2f ns/call, CLOGGING_FD_LOG: %.2f ns/call, BINARY_LOG_DEBUG: "
+         "%.2f ns/call\n",
+         call_ns, basic_ns, fd_ns, binary_ns);
+}
+
+int main(int argc, char *argv[]) {
+  int fd = open("/dev/null", O_WRONLY);
+  int failed = 0;
+
+  (void)argc;
+  (void)argv;
+  if (fd < 0) {
+    perror("open");
+    return 1;
+  }
+  clogging_basic_init("test_bench_disabled_log", "-main", LOG_LEVEL_WARN,
+                      NULL);
+  clogging_fd_init("test_bench_disabled_log", "-main", LOG_LEVEL_WARN,
+                   clogging_create_handle_from_fd(fd), NULL);
+  clogging_binary_init("test_bench_disabled_log", "-main", LOG_LEVEL_WARN,
+                       clogging_create_handle_from_fd(fd), NULL);
+  failed |= test_evaluation();
+  bench();
+  close(fd);
+  return failed;
+}
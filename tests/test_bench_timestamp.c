@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#include "../src/logging_common.h"
+
+#include <stdio.h>
+#include <string.h> /* strcmp() */
+#include <time.h>   /* gmtime(), clock() */
+
+#define TIME_STR_LEN 26
+#define NUM_BENCH_CALLS 5000000
+/* log messages per second in the benchmark */
+#define CALLS_PER_SECOND 10000
+
+/* what time_to_cstr() did before it cached anything */
+static int reference_time_to_cstr(time_t t, char *timestr, int maxlen) {
+  struct tm *tms = gmtime(&t);
+
+  return snprintf(timestr, maxlen, "%04d-%02d-%02dT%02d:%02d:%02d+00:00",
+                  tms->tm_year + 1900, tms->tm_mon + 1, tms->tm_mday,
+                  tms->tm_hour, tms->tm_min, tms->tm_sec);
+}
+
+static int check(time_t t) {
+  char expected[TIME_STR_LEN];
+  char actual[TIME_STR_LEN];
+  int expected_len = reference_time_to_cstr(t, expected, TIME_STR_LEN);
+  int actual_len = time_to_cstr(&t, actual, TIME_STR_LEN);
+
+  if (expected_len != actual_len || strcmp(expected, actual) != 0) {
+    fprintf(stderr, "t=%lld: expected [%s] got [%s]\n", (long long)t,
+            expected, actual);
+    return 1;
+  }
+  return 0;
+}
+
+/* Walk second by second across minute, hour, day, month and (leap) year
+ * boundaries, and jump around to invalidate the cache.
+ */
+static int test_correctness(void) {
+  const time_t starts[] = {
+      0,          /* the Epoch */
+      951782390,  /* 2000-02-28T23:59:50, leap day follows */
+      1709251190, /* 2024-02-29T23:59:50 */
+      1735689590, /* 2024-12-31T23:59:50 */
+      1767225590, /* 2025-12-31T23:59:50 */
+      -10,        /* just before the Epoch */
+  };
+  time_t t = 0;
+  size_t i = 0;
+  int failed = 0;
+
+  for (i = 0; i < sizeof(starts) / sizeof(starts[0]); ++i) {
+    for (t = starts[i]; t < starts[i] + 7300; ++t) {
+      failed |= check(t);
+    }
+    /* same second again and a jump back in time */
+    failed |= check(t - 1);
+    failed |= check(starts[i]);
+  }
+  return failed;
+}
+
+static double elapsed_ns_per_call(clock_t start, clock_t end) {
+  return (double)(end - start) * 1e9 / CLOCKS_PER_SEC / NUM_BENCH_CALLS;
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc; /* unused parameter */
+  (void)argv; /* unused parameter */
+
+  char timestr[TIME_STR_LEN];
+  time_t base = time(NULL);
+  time_t t = 0;
+  clock_t start;
+  clock_t end;
+  double reference_ns = 0.0;
+  double cached_ns = 0.0;
+  long checksum = 0;
+  int i = 0;
+
+  if (test_correctness() != 0) {
+    return 1;
+  }
+
+  start = clock();
+  for (i = 0; i < NUM_BENCH_CALLS; ++i) {
+    t = base + i / CALLS_PER_SECOND;
+    checksum += reference_time_to_cstr(t, timestr, TIME_STR_LEN);
+    checksum += timestr[18];
+  }
+  end = clock();
+  reference_ns = elapsed_ns_per_call(start, end);
+
+  start = clock();
+  for (i = 0; i < NUM_BENCH_CALLS; ++i) {
+    t = base + i / CALLS_PER_SECOND;
+    checksum += time_to_cstr(&t, timestr, TIME_STR_LEN);
+    checksum += timestr[18];
+  }
+  end = clock();
+  cached_ns = elapsed_ns_per_call(start, end);
+
+  printf("gmtime_r+snprintf: %.1f ns/call, cached: %.1f ns/call "
+         "(%d calls per second, checksum %ld)\n",
+         reference_ns, cached_ns, CALLS_PER_SECOND, checksum);
+  return 0;
+}
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef _WIN32
+#error This file is for non-Windows platforms only
+#endif /* _WIN32 */
+
+#include "../src/binary_reader.h"
+
+#include <pthread.h>    /* pthread_create() and friends */
+#include <stdio.h>
+#include <stdlib.h>     /* malloc(), free() */
+#include <string.h>     /* memset(), memcmp() */
+#include <sys/socket.h> /* socketpair() */
+#include <unistd.h>     /* read(), close() */
+
+#define MAX_BUF_SIZE 4096
+#define BIG_STRING_BYTES 100000
+#define BIG_BLOB_BYTES 70000
+#define SEGMENT_BYTES 30000
+#define MAX_STREAM_BYTES (1024 * 1024)
+/* <length> and the largest header of a CONTINUATION frame */
+#define MAX_FRAME_BYTES (1024 + 20)
+
+static char big_string[BIG_STRING_BYTES + 1];
+static char big_blob[BIG_BLOB_BYTES];
+
+struct context {
+  clogging_shm_ring_t *ring;
+  int fd;
+  clogging_log_options_t opts;
+  uint64_t drops;
+};
+
+/* <type> <0x80|4> <big-endian length> of a long string or blob */
+static int check_long_arg(const char *p, int type, size_t len) {
+  const unsigned char *u = (const unsigned char *)p;
+
+  return u[0] == type && u[1] == 0x84 &&
+         (((size_t)u[2] << 24) | ((size_t)u[3] << 16) | ((size_t)u[4] << 8) |
+          u[5]) == len;
+}
+
+/* <type> <0x80|4> <big-endian value> of an int */
+static int check_int_arg(const char *p, unsigned int val) {
+  const unsigned char *u = (const unsigned char *)p;
+
+  return u[0] == BINARY_LOG_VAR_ARG_INTEGER && u[1] == 0x84 &&
+         (((unsigned int)u[2] << 24) | ((unsigned int)u[3] << 16) |
+          ((unsigned int)u[4] << 8) | u[5]) == val;
+}
+
+static void *log_big_records(void *data) {
+  struct context *ctx = (struct context *)data;
+
+  clogging_binary_init_shm("test_continuation", "-big", LOG_LEVEL_INFO,
+                           ctx->ring, &ctx->opts);
+  clogging_binary_logmsg("continuation.c", "big", 1, LOG_LEVEL_INFO,
+                         "big %s %d", big_string, 7);
+  clogging_binary_log_blob("continuation.c", "big", 2, LOG_LEVEL_INFO,
+                           big_blob, BIG_BLOB_BYTES, "blob %d", 8);
+  clogging_binary_logmsg("continuation.c", "big", 3, LOG_LEVEL_INFO,
+                         "small %d", 9);
+  ctx->drops = clogging_binary_get_num_dropped_messages();
+  return NULL;
+}
+
+static void run(void *(*work)(void *), struct context *ctx) {
+  pthread_t tid;
+
+  pthread_create(&tid, NULL, work, ctx);
+  pthread_join(tid, NULL);
+}
+
+/* Records too large for the store come back whole from their frames */
+static int test_ring(clogging_shm_ring_t *ring) {
+  struct context ctx = {ring, -1, {.chunk_records = 1}, 0};
+  clogging_binary_reader_t reader;
+  clogging_timestamp_t ts;
+  char buf[MAX_BUF_SIZE];
+  const char *end = NULL;
+  uint64_t stream_id = 0;
+  ssize_t n = 0;
+  int records = 0;
+  int chunks = 0;
+  int failed = 0;
+
+  run(log_big_records, &ctx);
+  clogging_binary_reader_init(&reader);
+  while ((n = clogging_shm_ring_read(ring, buf, sizeof(buf), 0)) > 0) {
+    if (n > MAX_FRAME_BYTES) {
+      fprintf(stderr, "frame of %zd bytes\n", n);
+      failed = 1;
+    }
+    if (CLOGGING_BINARY_FRAME_TYPE_OF(buf[2]) ==
+            CLOGGING_BINARY_FRAME_CONTINUATION &&
+        CLOGGING_BINARY_IS_FRAME(buf[2])) {
+      ++chunks;
+    }
+    if (clogging_binary_reader_feed(&reader, buf, (size_t)n, &stream_id,
+                                    &ts) < 0) {
+      fprintf(stderr, "reader failed on a frame of %zd bytes\n", n);
+      failed = 1;
+      break;
+    }
+    if (reader.record == NULL) {
+      continue;
+    }
+    end = reader.record + reader.record_len;
+    switch (records++) {
+    case 0:
+      if (reader.record_len < BIG_STRING_BYTES + 12 ||
+          !check_long_arg(end - 12 - BIG_STRING_BYTES,
+                          BINARY_LOG_VAR_ARG_STRING, BIG_STRING_BYTES) ||
+          memcmp(end - 6 - BIG_STRING_BYTES, big_string,
+                 BIG_STRING_BYTES) != 0 ||
+          !check_int_arg(end - 6, 7)) {
+        fprintf(stderr, "string record is broken\n");
+        failed = 1;
+      }
+      break;
+    case 1:
+      if (reader.record_len < BIG_BLOB_BYTES + 12 ||
+          !check_int_arg(end - 12 - BIG_BLOB_BYTES, 8) ||
+          !check_long_arg(end - 6 - BIG_BLOB_BYTES, BINARY_LOG_VAR_ARG_BLOB,
+                          BIG_BLOB_BYTES) ||
+          memcmp(end - BIG_BLOB_BYTES, big_blob, BIG_BLOB_BYTES) != 0) {
+        fprintf(stderr, "blob record is broken\n");
+        failed = 1;
+      }
+      break;
+    default:
+      /* a record which fits is a plain one as before */
+      if (reader.record != buf + 2 || !check_int_arg(end - 6, 9)) {
+        fprintf(stderr, "small record is broken\n");
+        failed = 1;
+      }
+      break;
+    }
+  }
+  clogging_binary_reader_free(&reader);
+  if (records != 3 || chunks < (BIG_STRING_BYTES + BIG_BLOB_BYTES) / 1024 ||
+      ctx.drops != 0) {
+    fprintf(stderr, "%d records from %d frames, %llu dropped\n", records,
+            chunks, (unsigned long long)ctx.drops);
+    failed = 1;
+  }
+
+  /* without chunk_records they are dropped, and the rest goes on */
+  ctx.opts.chunk_records = 0;
+  run(log_big_records, &ctx);
+  records = 0;
+  while ((n = clogging_shm_ring_read(ring, buf, sizeof(buf), 0)) > 0) {
+    if (!CLOGGING_BINARY_IS_FRAME(buf[2])) {
+      ++records;
+    }
+  }
+  if (records != 1 || ctx.drops != 2) {
+    fprintf(stderr, "%d records and %llu dropped without chunk_records\n",
+            records, (unsigned long long)ctx.drops);
+    failed = 1;
+  }
+  return failed;
+}
+
+static void *log_segments(void *data) {
+  struct context *ctx = (struct context *)data;
+  static char a[SEGMENT_BYTES + 1];
+  static char b[SEGMENT_BYTES + 1];
+  static char c[SEGMENT_BYTES + 1];
+
+  memset(a, 'a', SEGMENT_BYTES);
+  memset(b, 'b', SEGMENT_BYTES);
+  memset(c, 'c', SEGMENT_BYTES);
+  clogging_binary_init("test_continuation", "-segments", LOG_LEVEL_INFO,
+                       clogging_create_handle_from_fd(ctx->fd), &ctx->opts);
+  /* the first two are written from where they are in the first frame */
+  clogging_binary_logmsg("continuation.c", "segments", 4, LOG_LEVEL_INFO,
+                         "%s %s %s", a, b, c);
+  ctx->drops = clogging_binary_get_num_dropped_messages();
+  close(ctx->fd);
+  return NULL;
+}
+
+/* Long arguments written with writev() go out as CONTINUATION frames
+ * when they make a record longer than a frame
+ */
+static int test_handle(void) {
+  struct context ctx = {NULL, -1, {.chunk_records = 1}, 0};
+  clogging_binary_reader_t reader;
+  clogging_timestamp_t ts;
+  pthread_t tid;
+  char *stream = (char *)malloc(MAX_STREAM_BYTES);
+  const char *end = NULL;
+  uint64_t stream_id = 0;
+  size_t len = 0;
+  size_t pos = 0;
+  size_t rec_len = 0;
+  ssize_t n = 0;
+  int fds[2];
+  int records = 0;
+  int failed = 0;
+  int i = 0;
+
+  if (stream == NULL || socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+    perror("socketpair");
+    return 1;
+  }
+  ctx.fd = fds[0];
+  pthread_create(&tid, NULL, log_segments, &ctx);
+  while (len < MAX_STREAM_BYTES &&
+         (n = read(fds[1], stream + len, MAX_STREAM_BYTES - len)) > 0) {
+    len += (size_t)n;
+  }
+  pthread_join(tid, NULL);
+  close(fds[1]);
+
+  clogging_binary_reader_init(&reader);
+  while (pos + 2 <= len) {
+    rec_len =
+        2 + (((stream[pos] & 0x00ff) << 8) | (stream[pos + 1] & 0x00ff));
+    if (pos + rec_len > len ||
+        clogging_binary_reader_feed(&reader, stream + pos, rec_len,
+                                    &stream_id, &ts) < 0) {
+      break;
+    }
+    pos += rec_len;
+    if (reader.record == NULL) {
+      continue;
+    }
+    ++records;
+    /* <type> <15-bit length> <bytes> each */
+    end = reader.record + reader.record_len;
+    for (i = 0; i < 3; ++i) {
+      const char *arg = end - (3 - i) * (3 + SEGMENT_BYTES);
+
+      if (reader.record_len < 3 * (3 + SEGMENT_BYTES) ||
+          arg[0] != BINARY_LOG_VAR_ARG_STRING ||
+          (((arg[1] & 0x7f) << 8) | (arg[2] & 0x00ff)) != SEGMENT_BYTES ||
+          arg[3] != 'a' + i || arg[2 + SEGMENT_BYTES] != 'a' + i) {
+        fprintf(stderr, "string %d is broken\n", i);
+        failed = 1;
+      }
+    }
+  }
+  clogging_binary_reader_free(&reader);
+  free(stream);
+  if (pos != len || records != 1 || ctx.drops != 0) {
+    fprintf(stderr, "%d records in %zu of %zu bytes, %llu dropped\n",
+            records, pos, len, (unsigned long long)ctx.drops);
+    failed = 1;
+  }
+  return failed;
+}
+
+int main(int argc, char *argv[]) {
+  /* room for all the frames of the records */
+  clogging_shm_ring_t *ring = clogging_shm_ring_create(NULL, 512 * 1024);
+  int failed = 0;
+  int i = 0;
+
+  (void)argc;
+  (void)argv;
+  if (ring == NULL) {
+    perror("clogging_shm_ring_create");
+    return 1;
+  }
+  memset(big_string, 's', BIG_STRING_BYTES);
+  for (i = 0; i < BIG_BLOB_BYTES; ++i) {
+    big_blob[i] = (char)i;
+  }
+  failed |= test_ring(ring);
+  failed |= test_handle();
+  clogging_shm_ring_close(ring);
+  return failed;
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef _WIN32
+#error This file is for non-Windows platforms only
+#endif /* _WIN32 */
+
+#include "../src/binary_reader.h"
+
+#include <pthread.h> /* pthread_create() and friends */
+#include <stdio.h>
+#include <time.h>    /* nanosleep() */
+
+#define MAX_BUF_SIZE 4096
+#define NUM_THREADS 2
+#define NUM_RECORDS 20
+
+static int64_t now_ns(void) {
+  clogging_timestamp_t ts;
+
+  clogging_clock_now(CLOGGING_CLOCK_REALTIME, &ts);
+  return clogging_timestamp_to_units(&ts, CLOGGING_TIME_PRECISION_NS);
+}
+
+static void *work(void *data) {
+  clogging_shm_ring_t *ring = (clogging_shm_ring_t *)data;
+  clogging_log_options_t opts = {.delta_timestamps = 1};
+  struct timespec pause = {0, 100000};
+  int i = 0;
+
+  clogging_binary_init_shm("test_delta_time", "-worker", LOG_LEVEL_INFO,
+                           ring, &opts);
+  for (i = 0; i < NUM_RECORDS; ++i) {
+    if (i % 2) {
+      BINARY_LOG_INFO("typed %d", i);
+    } else {
+      clogging_binary_logmsg("delta.c", "work", 1, LOG_LEVEL_INFO,
+                             "plain %d", i);
+    }
+    nanosleep(&pause, NULL);
+  }
+  return NULL;
+}
+
+/* Bytes of the varint of value */
+static int varint_bytes(uint64_t value) {
+  int n = 1;
+
+  while (value >= 0x80) {
+    value >>= 7;
+    ++n;
+  }
+  return n;
+}
+
+/* Bytes of the varint at p, at most max of them */
+static int varint_len(const char *p, int max) {
+  int n = 1;
+
+  while (n < max && (p[n - 1] & 0x80)) {
+    ++n;
+  }
+  return n;
+}
+
+/* The times of interleaved streams come back in order within each of
+ * them and within the time they were logged in.
+ */
+static int test_threads(clogging_shm_ring_t *ring) {
+  clogging_binary_reader_t reader;
+  clogging_timestamp_t ts;
+  pthread_t tids[NUM_THREADS];
+  char buf[MAX_BUF_SIZE];
+  uint64_t stream_ids[NUM_THREADS] = {0};
+  int64_t last[NUM_THREADS] = {0};
+  int records[NUM_THREADS] = {0};
+  uint64_t stream_id = 0;
+  int64_t start = now_ns();
+  int64_t end = 0;
+  int64_t t = 0;
+  ssize_t n = 0;
+  int timebases = 0;
+  int failed = 0;
+  int i = 0;
+  int rc = 0;
+
+  for (i = 0; i < NUM_THREADS; ++i) {
+    pthread_create(&tids[i], NULL, work, ring);
+  }
+  for (i = 0; i < NUM_THREADS; ++i) {
+    pthread_join(tids[i], NULL);
+  }
+  end = now_ns();
+
+  clogging_binary_reader_init(&reader);
+  while ((n = clogging_shm_ring_read(ring, buf, sizeof(buf), 0)) > 0) {
+    if (CLOGGING_BINARY_FRAME_TYPE_OF(buf[2]) ==
+        CLOGGING_BINARY_FRAME_TIMEBASE) {
+      ++timebases;
+    }
+    rc = clogging_binary_reader_feed(&reader, buf, (size_t)n, &stream_id,
+                                     &ts);
+    if (rc < 0) {
+      fprintf(stderr, "reader failed on a record of %zd bytes\n", n);
+      failed = 1;
+      break;
+    } else if (rc == 0) {
+      continue;
+    }
+    for (i = 0; i < NUM_THREADS; ++i) {
+      if (stream_ids[i] == 0 || stream_ids[i] == stream_id) {
+        break;
+      }
+    }
+    if (i == NUM_THREADS) {
+      fprintf(stderr, "more streams than threads\n");
+      failed = 1;
+      break;
+    }
+    stream_ids[i] = stream_id;
+    t = clogging_timestamp_to_units(&ts, CLOGGING_TIME_PRECISION_NS);
+    if (t < start || t > end || t < last[i]) {
+      fprintf(stderr, "time %lld is out of order or outside [%lld, %lld]\n",
+              (long long)t, (long long)start, (long long)end);
+      failed = 1;
+    }
+    /* the delta, from the last record or a TIMEBASE frame after it,
+     * takes no more bytes than the gap to the last record needs
+     */
+    if (records[i] > 0 && t >= last[i] &&
+        varint_len(&buf[3], (int)n - 3) >
+            varint_bytes((uint64_t)(t - last[i]))) {
+      fprintf(stderr, "delta longer than the gap of %lld ns\n",
+              (long long)(t - last[i]));
+      failed = 1;
+    }
+    last[i] = t;
+    ++records[i];
+  }
+  clogging_binary_reader_free(&reader);
+
+  for (i = 0; i < NUM_THREADS; ++i) {
+    if (records[i] != NUM_RECORDS) {
+      fprintf(stderr, "stream %d has %d records\n", i, records[i]);
+      failed = 1;
+    }
+  }
+  if (timebases != NUM_THREADS) {
+    fprintf(stderr, "%d TIMEBASE frames\n", timebases);
+    failed = 1;
+  }
+  return failed;
+}
+
+static void *work_slowly(void *data) {
+  clogging_shm_ring_t *ring = (clogging_shm_ring_t *)data;
+  clogging_log_options_t opts = {.delta_timestamps = 1};
+  struct timespec pause = {
+      CLOGGING_BINARY_TIMEBASE_INTERVAL_NS / 1000000000LL, 100000000};
+
+  clogging_binary_init_shm("test_delta_time", "-slow", LOG_LEVEL_INFO, ring,
+                           &opts);
+  BINARY_LOG_INFO("before");
+  nanosleep(&pause, NULL);
+  BINARY_LOG_INFO("after");
+  /* a stream which starts over has a new base */
+  clogging_binary_restart_stream();
+  BINARY_LOG_INFO("restarted");
+  return NULL;
+}
+
+/* A delta which would be too long is replaced by a new TIMEBASE frame */
+static int test_timebase_interval(clogging_shm_ring_t *ring) {
+  clogging_binary_reader_t reader;
+  clogging_timestamp_t ts;
+  pthread_t tid;
+  char buf[MAX_BUF_SIZE];
+  uint64_t stream_id = 0;
+  int64_t times[3] = {0};
+  ssize_t n = 0;
+  int timebases = 0;
+  int records = 0;
+
+  pthread_create(&tid, NULL, work_slowly, ring);
+  pthread_join(tid, NULL);
+
+  clogging_binary_reader_init(&reader);
+  while ((n = clogging_shm_ring_read(ring, buf, sizeof(buf), 0)) > 0) {
+    if (CLOGGING_BINARY_FRAME_TYPE_OF(buf[2]) ==
+        CLOGGING_BINARY_FRAME_TIMEBASE) {
+      ++timebases;
+    }
+    if (clogging_binary_reader_feed(&reader, buf, (size_t)n, &stream_id,
+                                    &ts) == 1 &&
+        records < 3) {
+      times[records++] =
+          clogging_timestamp_to_units(&ts, CLOGGING_TIME_PRECISION_NS);
+    }
+  }
+  clogging_binary_reader_free(&reader);
+
+  if (records != 3 || timebases != 3 ||
+      times[1] - times[0] < CLOGGING_BINARY_TIMEBASE_INTERVAL_NS ||
+      times[2] < times[1]) {
+    fprintf(stderr, "%d records and %d TIMEBASE frames\n", records,
+            timebases);
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  clogging_shm_ring_t *ring = clogging_shm_ring_create(NULL, 64 * 1024);
+  int failed = 0;
+
+  (void)argc;
+  (void)argv;
+  if (ring == NULL) {
+    perror("clogging_shm_ring_create");
+    return 1;
+  }
+  failed |= test_threads(ring);
+  failed |= test_timebase_interval(ring);
+  clogging_shm_ring_close(ring);
+  return failed;
+}
@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef _WIN32
+#error This file is for non-Windows platforms only
+#endif /* _WIN32 */
+
+#include "../src/binary_logging.h"
+
+#include <pthread.h> /* pthread_create() and friends */
+#include <stdio.h>
+#include <string.h> /* memcmp() */
+#include <time.h>   /* clock_gettime() */
+
+#define MAX_BUF_SIZE 4096
+#define NUM_BENCH_LOOPS 100000
+#define NUM_THREADS 4
+#define NUM_THREAD_LOOPS 50
+
+/* <length> <0x80|8> <seconds>, the timestamp may differ between the two */
+#define TIMESTAMP_END (2 + 1 + 8)
+
+/* <length> <header> <0x80|8> <seconds> */
+#define FRAME_TIMESTAMP_END (2 + 1 + 1 + 8)
+
+/* Log the same thing both ways from the same line, so that the records
+ * only differ in the timestamp.
+ */
+#define LOG_BOTH(format, ...)                                                 \
+  do {                                                                        \
+    clogging_binary_logmsg(__FILE__, __func__, __LINE__, LOG_LEVEL_INFO,      \
+                           format, ##__VA_ARGS__);                            \
+    CLOGGING_BINARY_LOG_TYPED(LOG_LEVEL_INFO, format, ##__VA_ARGS__);         \
+  } while (0)
+
+static int compare_records(clogging_shm_ring_t *ring, const char *what) {
+  char expected[MAX_BUF_SIZE];
+  char actual[MAX_BUF_SIZE];
+  ssize_t expected_len = clogging_shm_ring_read(ring, expected,
+                                                sizeof(expected), 0);
+  ssize_t actual_len = clogging_shm_ring_read(ring, actual, sizeof(actual), 0);
+
+  if (expected_len <= TIMESTAMP_END || actual_len != expected_len ||
+      memcmp(expected, actual, 2) != 0 ||
+      memcmp(expected + TIMESTAMP_END, actual + TIMESTAMP_END,
+             (size_t)(expected_len - TIMESTAMP_END)) != 0) {
+    fprintf(stderr, "%s: records differ (%zd and %zd bytes)\n", what,
+            expected_len, actual_len);
+    return 1;
+  }
+  return 0;
+}
+
+/* The record of "slice %.*s of %.4s" ends with the two slices of
+ * request, each a <type> <15-bit length> <bytes>.
+ */
+static int check_slices(clogging_shm_ring_t *ring, const char *request) {
+  char buf[MAX_BUF_SIZE];
+  ssize_t n = clogging_shm_ring_read(ring, buf, sizeof(buf), 0);
+  const char *end = buf + n;
+
+  /* the typed one is the same, as compared above */
+  (void)clogging_shm_ring_read(ring, buf + n, sizeof(buf) - (size_t)n, 0);
+  if (n < 13 || end[-13] != BINARY_LOG_VAR_ARG_STRING || end[-12] != 0 ||
+      end[-11] != 3 || memcmp(end - 10, request, 3) != 0 ||
+      end[-7] != BINARY_LOG_VAR_ARG_STRING || end[-6] != 0 || end[-5] != 4 ||
+      memcmp(end - 4, request + 4, 4) != 0) {
+    fprintf(stderr, "slices are not bounded by their precision\n");
+    return 1;
+  }
+  return 0;
+}
+
+static int test_same_records(clogging_shm_ring_t *ring) {
+  int failures = 0;
+  int i = -42;
+  unsigned int u = 42u;
+  long l = -1234567890L;
+  long long ll = 0x0102030405060708LL;
+  unsigned long long ull = 0xfffefdfcfbfaf9f8ULL;
+  size_t z = 4096;
+  double d = 3.25;
+  float f = 1.5f;
+  short h = -3;
+  unsigned char hh = 200;
+  char name[] = "worker";
+  unsigned char bytes[] = "payload";
+  char request[] = {'G', 'E', 'T', ' ', '/', 'i', 'n', 'd', 'e', 'x'};
+
+  LOG_BOTH("no arguments at all");
+  failures += compare_records(ring, "none");
+  LOG_BOTH("int %d unsigned %u", i, u);
+  failures += compare_records(ring, "int");
+  LOG_BOTH("long %ld long long %lld %llu size %zu", l, ll, ull, z);
+  failures += compare_records(ring, "long");
+  LOG_BOTH("short %hd char %hhu", h, hh);
+  failures += compare_records(ring, "short");
+  /* not long double, whose padding bytes are whatever was there */
+  LOG_BOTH("double %f float %g", d, f);
+  failures += compare_records(ring, "double");
+  LOG_BOTH("string %s %s", name, "literal");
+  failures += compare_records(ring, "string");
+  LOG_BOTH("pointer %p", (void *)ring);
+  failures += compare_records(ring, "pointer");
+  /* the conversion tells an address from a string, not the C type */
+  LOG_BOTH("buffer %p", request);
+  failures += compare_records(ring, "char pointer");
+  LOG_BOTH("bytes %s", bytes);
+  failures += compare_records(ring, "unsigned char string");
+  /* only the bytes within the precision, the '*' is not stored */
+  LOG_BOTH("slice %.*s of %.4s", 3, request, request + 4);
+  failures += compare_records(ring, "slice");
+  LOG_BOTH("slice %.*s of %.4s", 3, request, request + 4);
+  failures += check_slices(ring, request);
+  LOG_BOTH("%d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5,
+           6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+  failures += compare_records(ring, "sixteen");
+  return failures;
+}
+
+static uint32_t read_u32(const char *p) {
+  const unsigned char *u = (const unsigned char *)p;
+
+  return ((uint32_t)u[0] << 24) | ((uint32_t)u[1] << 16) |
+         ((uint32_t)u[2] << 8) | (uint32_t)u[3];
+}
+
+/* Check <string> at *pos of buf against s and move past it. */
+static int check_site_string(const char *buf, size_t *pos, const char *s) {
+  size_t len = (((unsigned char)buf[*pos] & 0x7f) << 8) |
+               (unsigned char)buf[*pos + 1];
+
+  if (len != strlen(s) || memcmp(buf + *pos + 2, s, len) != 0) {
+    return 1;
+  }
+  *pos += 2 + len;
+  return 0;
+}
+
+static int check_site_frame(const char *buf, ssize_t n, uint32_t *id,
+                            int linenum) {
+  size_t pos = 3;
+
+  if (n < 3 || buf[2] != CLOGGING_BINARY_FRAME_HEADER(
+                             CLOGGING_BINARY_FRAME_VERSION,
+                             CLOGGING_BINARY_FRAME_SITE)) {
+    fprintf(stderr, "no SITE frame before the first record of the site\n");
+    return 1;
+  }
+  if ((unsigned char)buf[pos] != (0x80 | 4)) {
+    return 1;
+  }
+  *id = read_u32(buf + pos + 1);
+  pos += 5;
+  if ((unsigned char)buf[pos] != (0x80 | sizeof(enum LogLevel)) ||
+      read_u32(buf + pos + 1) != LOG_LEVEL_INFO) {
+    fprintf(stderr, "SITE frame has the wrong level\n");
+    return 1;
+  }
+  pos += 5;
+  if (check_site_string(buf, &pos, __FILE__) ||
+      check_site_string(buf, &pos, "log_site")) {
+    fprintf(stderr, "SITE frame has the wrong file or func\n");
+    return 1;
+  }
+  if (read_u32(buf + pos + 1) != (uint32_t)linenum) {
+    fprintf(stderr, "SITE frame has the wrong line\n");
+    return 1;
+  }
+  pos += 5;
+  if (check_site_string(buf, &pos, "site record %d of %s") ||
+      (ssize_t)pos != n) {
+    fprintf(stderr, "SITE frame has the wrong format\n");
+    return 1;
+  }
+  return 0;
+}
+
+/* A RECORD frame has the same <hostname> ... <pid> as the record of
+ * clogging_binary_logmsg(), then <site id> and the same arguments.
+ */
+static int check_record_frame(const char *buf, ssize_t n, const char *full,
+                              ssize_t full_n, uint32_t id) {
+  size_t identity_len = 0;
+  size_t full_args = 0;
+  size_t pos = 0;
+  int i = 0;
+
+  if (buf[2] != CLOGGING_BINARY_FRAME_HEADER(CLOGGING_BINARY_FRAME_VERSION,
+                                             CLOGGING_BINARY_FRAME_RECORD)) {
+    fprintf(stderr, "not a RECORD frame\n");
+    return 1;
+  }
+  /* <hostname> <progname> <threadname> <pid> */
+  pos = TIMESTAMP_END;
+  for (i = 0; i < 3; ++i) {
+    pos += 2 + ((((unsigned char)full[pos] & 0x7f) << 8) |
+                (unsigned char)full[pos + 1]);
+  }
+  pos += 5;
+  identity_len = pos - TIMESTAMP_END;
+  /* <loglevel> <file> <func> <linenum> */
+  pos += 5;
+  for (i = 0; i < 2; ++i) {
+    pos += 2 + ((((unsigned char)full[pos] & 0x7f) << 8) |
+                (unsigned char)full[pos + 1]);
+  }
+  full_args = pos + 5;
+
+  pos = FRAME_TIMESTAMP_END + identity_len;
+  if (memcmp(buf + FRAME_TIMESTAMP_END, full + TIMESTAMP_END,
+             identity_len) != 0 ||
+      (unsigned char)buf[pos] != (0x80 | 4) || read_u32(buf + pos + 1) != id) {
+    fprintf(stderr, "RECORD frame has the wrong identity or site id\n");
+    return 1;
+  }
+  pos += 5;
+  if (n - (ssize_t)pos != full_n - (ssize_t)full_args ||
+      memcmp(buf + pos, full + full_args, (size_t)(n - pos)) != 0) {
+    fprintf(stderr, "RECORD frame has the wrong arguments\n");
+    return 1;
+  }
+  return 0;
+}
+
+static void log_site(int i, const char *what, int *linenum) {
+  *linenum = __LINE__ + 1;
+  BINARY_LOG_INFO("site record %d of %s", i, what);
+}
+
+static int test_site_records(clogging_shm_ring_t *ring) {
+  char site[MAX_BUF_SIZE];
+  char record[MAX_BUF_SIZE];
+  char full[MAX_BUF_SIZE];
+  ssize_t site_n = 0;
+  ssize_t record_n = 0;
+  ssize_t full_n = 0;
+  uint32_t id = 0;
+  uint32_t other_id = 0;
+  int linenum = 0;
+  int i = 0;
+
+  for (i = 0; i < 3; ++i) {
+    log_site(i, "loop", &linenum);
+    if (i == 0) {
+      site_n = clogging_shm_ring_read(ring, site, sizeof(site), 0);
+      if (check_site_frame(site, site_n, &id, linenum)) {
+        return 1;
+      }
+    }
+    record_n = clogging_shm_ring_read(ring, record, sizeof(record), 0);
+    clogging_binary_logmsg(__FILE__, "log_site", linenum, LOG_LEVEL_INFO,
+                           "site record %d of %s", i, "loop");
+    full_n = clogging_shm_ring_read(ring, full, sizeof(full), 0);
+    if (check_record_frame(record, record_n, full, full_n, id)) {
+      return 1;
+    }
+  }
+  printf("record: %zd bytes with clogging_binary_logmsg(), %zd bytes with "
+         "BINARY_LOG_INFO\n",
+         full_n, record_n);
+
+  /* a different site gets a different id */
+  BINARY_LOG_INFO("other site");
+  site_n = clogging_shm_ring_read(ring, site, sizeof(site), 0);
+  record_n = clogging_shm_ring_read(ring, record, sizeof(record), 0);
+  if (site_n < 8 || record_n <= 0 ||
+      (other_id = read_u32(site + 4)) == id || other_id == 0) {
+    fprintf(stderr, "second site is not announced with its own id\n");
+    return 1;
+  }
+  return 0;
+}
+
+static void *work(void *data) {
+  clogging_shm_ring_t *ring = (clogging_shm_ring_t *)data;
+  int i = 0;
+
+  clogging_binary_init_shm("test_binary_log_macros", "-worker",
+                           LOG_LEVEL_INFO, ring, NULL);
+  for (i = 0; i < NUM_THREAD_LOOPS; ++i) {
+    BINARY_LOG_INFO("shared site %d", i);
+  }
+  return NULL;
+}
+
+/* Each thread announces the site it shares with the others once, and
+ * they all agree on its id.
+ */
+static int test_threads(clogging_shm_ring_t *ring) {
+  pthread_t tids[NUM_THREADS];
+  char buf[MAX_BUF_SIZE];
+  ssize_t n = 0;
+  uint32_t id = 0;
+  int sites = 0;
+  int records = 0;
+  int i = 0;
+
+  for (i = 0; i < NUM_THREADS; ++i) {
+    pthread_create(&tids[i], NULL, work, ring);
+  }
+  for (i = 0; i < NUM_THREADS; ++i) {
+    pthread_join(tids[i], NULL);
+  }
+  while ((n = clogging_shm_ring_read(ring, buf, sizeof(buf), 0)) > 0) {
+    if (buf[2] == CLOGGING_BINARY_FRAME_HEADER(CLOGGING_BINARY_FRAME_VERSION,
+                                               CLOGGING_BINARY_FRAME_SITE)) {
+      if (id != 0 && read_u32(buf + 4) != id) {
+        fprintf(stderr, "threads disagree on the site id\n");
+        return 1;
+      }
+      id = read_u32(buf + 4);
+      ++sites;
+    } else {
+      ++records;
+    }
+  }
+  if (sites != NUM_THREADS || records != NUM_THREADS * NUM_THREAD_LOOPS) {
+    fprintf(stderr, "%d SITE and %d RECORD frames from the threads\n", sites,
+            records);
+    return 1;
+  }
+  return 0;
+}
+
+static double elapsed_ns(const struct timespec *start,
+                         const struct timespec *end) {
+  return (double)(end->tv_sec - start->tv_sec) * 1e9 +
+         (double)(end->tv_nsec - start->tv_nsec);
+}
+
+static void drain(clogging_shm_ring_t *ring) {
+  char buf[MAX_BUF_SIZE];
+
+  while (clogging_shm_ring_read(ring, buf, sizeof(buf), 0) > 0) {
+  }
+}
+
+static void bench(clogging_shm_ring_t *ring) {
+  struct timespec start;
+  struct timespec end;
+  double format_ns = 0.0;
+  double typed_ns = 0.0;
+  int i = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < NUM_BENCH_LOOPS; ++i) {
+    clogging_binary_logmsg(__FILE__, __func__, __LINE__, LOG_LEVEL_INFO,
+                           "request %d took %lld us for %s at %.2f", i,
+                           (long long)i * 3, "client", 0.5);
+    if ((i & 63) == 63) {
+      drain(ring);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  format_ns = elapsed_ns(&start, &end) / NUM_BENCH_LOOPS;
+  drain(ring);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < NUM_BENCH_LOOPS; ++i) {
+    BINARY_LOG_INFO("request %d took %lld us for %s at %.2f", i,
+                    (long long)i * 3, "client", 0.5);
+    if ((i & 63) == 63) {
+      drain(ring);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  typed_ns = elapsed_ns(&start, &end) / NUM_BENCH_LOOPS;
+  drain(ring);
+
+  printf("clogging_binary_logmsg: %.1f ns/record, BINARY_LOG_INFO: %.1f "
+         "ns/record\n",
+         format_ns, typed_ns);
+}
+
+int main(int argc, char *argv[]) {
+  clogging_shm_ring_t *ring = clogging_shm_ring_create(NULL, 64 * 1024);
+  char buf[MAX_BUF_SIZE];
+  int failures = 0;
+
+  (void)argc;
+  (void)argv;
+  if (ring == NULL) {
+    perror("clogging_shm_ring_create");
+    return 1;
+  }
+  clogging_binary_init_shm("test_binary_log_macros", "", LOG_LEVEL_INFO, ring,
+                           NULL);
+
+  failures = test_same_records(ring);
+  failures += test_site_records(ring);
+  failures += test_threads(ring);
+
+  /* filtered out before anything is looked at */
+  BINARY_LOG_DEBUG("not logged %d", 1);
+  if (clogging_shm_ring_read(ring, buf, sizeof(buf), 0) > 0) {
+    fprintf(stderr, "a filtered out record was logged\n");
+    ++failures;
+  }
+
+  if (failures == 0) {
+    bench(ring);
+  }
+  clogging_shm_ring_close(ring);
+  return failures;
+}
@@ -158,6 +158,38 @@ int validate_variable_arguments(const char *format,
   return 0;
 }
 
+#define MAX_NUM_IDENTITIES 16
+
+/* the IDENTITY frames analyzed so far */
+static struct binary_identity g_identities[MAX_NUM_IDENTITIES];
+static int g_num_identities = 0;
+
+static const struct binary_identity *find_identity(unsigned long long id) {
+  int i = 0;
+
+  for (i = 0; i < g_num_identities; ++i) {
+    if (g_identities[i].stream_id == id) {
+      return &g_identities[i];
+    }
+  }
+  return NULL;
+}
+
+/* copy the string at offset as a C string into dst of dst_size bytes */
+static int read_string(const char *buf, int buflen, int *offset, char *dst,
+                       int dst_size) {
+  int bytes = 0;
+
+  read_length(buf, offset, &bytes);
+  if (*offset + bytes > buflen || bytes >= dst_size) {
+    return -1;
+  }
+  memcpy(dst, &buf[*offset], bytes);
+  dst[bytes] = '\0';
+  *offset += bytes;
+  return 0;
+}
+
 int analyze_received_binary_message(const char *format, const char *buf,
                                     int buflen) {
   int msglen = 0;
@@ -178,6 +210,9 @@ int analyze_received_binary_message(const char *format, const char *buf,
   const char *funcname = NULL;
   int funcname_len = 0;
   int linenum = 0;
+  int is_format_record = 0;
+  int format_id = 0;
+  const struct binary_identity *identity = NULL;
   int offset = 0;
   int bytes = 0;
   int rc = 0;
@@ -193,31 +228,65 @@ int analyze_received_binary_message(const char *format, const char *buf,
 
   /* <length> <timestamp> <hostname> <progname> <threadname> <pid> <loglevel>
    *   <file> <func> <linenum> [<arg1>, <arg2>, ...]
+   * where <hostname> <progname> <threadname> <pid> is a <stream id> once
+   * the stream has an IDENTITY frame.
    */
   rc = read_nbytes(&buf[offset], 2, &llval);
   offset += 2;
   msglen = (int)(llval & 0xffff);
 
+  /* the same record with a <format id> after <linenum> */
+  if (CLOGGING_BINARY_IS_FRAME(buf[offset])) {
+    if (CLOGGING_BINARY_FRAME_TYPE_OF(buf[offset]) !=
+        CLOGGING_BINARY_FRAME_FORMAT_RECORD) {
+      fprintf(stderr, "unexpected frame %02x\n", buf[offset] & 0x00ff);
+      return -1;
+    }
+    is_format_record = 1;
+    ++offset;
+  }
+
   rc = read_length(buf, &offset, &bytes);
   rc = read_nbytes(&buf[offset], bytes, &timeval);
   offset += bytes;
 
-  rc = read_length(buf, &offset, &hostname_len);
-  hostname = &buf[offset];
-  offset += hostname_len;
+  if (buf[offset] & 0x80) {
+    /* <stream id> of an IDENTITY frame instead of the strings, which
+     * always start with a 15-bit length
+     */
+    rc = read_length(buf, &offset, &bytes);
+    rc = read_nbytes(&buf[offset], bytes, &llval);
+    offset += bytes;
+    identity = find_identity(llval);
+    if (identity == NULL) {
+      fprintf(stderr, "record of unknown stream %llx\n", llval);
+      return -1;
+    }
+    hostname = identity->hostname;
+    hostname_len = (int)strlen(identity->hostname);
+    programname = identity->progname;
+    programname_len = (int)strlen(identity->progname);
+    threadname = identity->threadname;
+    threadname_len = (int)strlen(identity->threadname);
+    pid = identity->pid;
+  } else {
+    rc = read_length(buf, &offset, &hostname_len);
+    hostname = &buf[offset];
+    offset += hostname_len;
 
-  rc = read_length(buf, &offset, &programname_len);
-  programname = &buf[offset];
-  offset += programname_len;
+    rc = read_length(buf, &offset, &programname_len);
+    programname = &buf[offset];
+    offset += programname_len;
 
-  rc = read_length(buf, &offset, &threadname_len);
-  threadname = &buf[offset];
-  offset += threadname_len;
+    rc = read_length(buf, &offset, &threadname_len);
+    threadname = &buf[offset];
+    offset += threadname_len;
 
-  rc = read_length(buf, &offset, &bytes);
-  rc = read_nbytes(&buf[offset], bytes, &llval);
-  pid = (int)llval;
-  offset += bytes;
+    rc = read_length(buf, &offset, &bytes);
+    rc = read_nbytes(&buf[offset], bytes, &llval);
+    pid = (int)llval;
+    offset += bytes;
+  }
 
   rc = read_length(buf, &offset, &bytes);
   rc = read_nbytes(&buf[offset], bytes, &llval);
@@ -237,6 +306,13 @@ int analyze_received_binary_message(const char *format, const char *buf,
   linenum = (int)llval;
   offset += bytes;
 
+  if (is_format_record) {
+    rc = read_length(buf, &offset, &bytes);
+    rc = read_nbytes(&buf[offset], bytes, &llval);
+    format_id = (int)llval;
+    offset += bytes;
+  }
+
   i = 0;
   /* read variable arguments */
   while (offset < buflen) {
@@ -314,5 +390,98 @@ int analyze_received_binary_message(const char *format, const char *buf,
   printf("filename=[%.*s], funcname=[%.*s]\n", filename_len, filename,
          funcname_len, funcname);
   printf("linenum = %d\n", linenum);
+  if (is_format_record) {
+    printf("format id = %d\n", format_id);
+  }
+  return offset;
+}
+
+int analyze_received_format_frame(const char *buf, int buflen, int *id,
+                                  char *format, int format_size) {
+  unsigned long long llval = 0LLU;
+  int offset = 2;
+  int bytes = 0;
+
+  /* <length> <header> <format id> <format> */
+  if (buflen < 3 || !CLOGGING_BINARY_IS_FRAME(buf[offset]) ||
+      CLOGGING_BINARY_FRAME_TYPE_OF(buf[offset]) !=
+          CLOGGING_BINARY_FRAME_FORMAT) {
+    fprintf(stderr, "not a FORMAT frame\n");
+    return -1;
+  }
+  ++offset;
+  read_length(buf, &offset, &bytes);
+  if (read_nbytes(&buf[offset], bytes, &llval) < 0) {
+    return -1;
+  }
+  *id = (int)llval;
+  offset += bytes;
+  read_length(buf, &offset, &bytes);
+  if (offset + bytes != buflen || bytes >= format_size) {
+    fprintf(stderr, "FORMAT frame of %d bytes is malformed\n", buflen);
+    return -1;
+  }
+  memcpy(format, &buf[offset], bytes);
+  format[bytes] = '\0';
+  printf("format id = %d, format = [%s]\n", *id, format);
+  return offset + bytes;
+}
+
+int analyze_received_identity_frame(const char *buf, int buflen,
+                                    struct binary_identity *identity) {
+  unsigned long long llval = 0LLU;
+  int offset = 2;
+  int bytes = 0;
+  int i = 0;
+
+  /* <length> <header> <stream id> <hostname> <progname> <threadname> <pid> */
+  if (buflen < 3 || !CLOGGING_BINARY_IS_FRAME(buf[offset]) ||
+      CLOGGING_BINARY_FRAME_TYPE_OF(buf[offset]) !=
+          CLOGGING_BINARY_FRAME_IDENTITY) {
+    fprintf(stderr, "not an IDENTITY frame\n");
+    return -1;
+  }
+  ++offset;
+  read_length(buf, &offset, &bytes);
+  if (read_nbytes(&buf[offset], bytes, &llval) < 0) {
+    return -1;
+  }
+  identity->stream_id = llval;
+  offset += bytes;
+  if (read_string(buf, buflen, &offset, identity->hostname,
+                  sizeof(identity->hostname)) < 0 ||
+      read_string(buf, buflen, &offset, identity->progname,
+                  sizeof(identity->progname)) < 0 ||
+      read_string(buf, buflen, &offset, identity->threadname,
+                  sizeof(identity->threadname)) < 0) {
+    fprintf(stderr, "IDENTITY frame of %d bytes is malformed\n", buflen);
+    return -1;
+  }
+  read_length(buf, &offset, &bytes);
+  if (offset + bytes != buflen ||
+      read_nbytes(&buf[offset], bytes, &llval) < 0) {
+    fprintf(stderr, "IDENTITY frame of %d bytes is malformed\n", buflen);
+    return -1;
+  }
+  identity->pid = (int)llval;
+  offset += bytes;
+
+  /* a stream which starts over announces the same id again */
+  for (i = 0; i < g_num_identities; ++i) {
+    if (g_identities[i].stream_id == identity->stream_id) {
+      break;
+    }
+  }
+  if (i == MAX_NUM_IDENTITIES) {
+    return -1;
+  }
+  g_identities[i] = *identity;
+  if (i == g_num_identities) {
+    ++g_num_identities;
+  }
+  printf("stream id = %llx, hostname=[%s], programname=[%s], "
+         "threadname=[%s], pid = %d\n",
+         identity->stream_id, identity->hostname, identity->progname,
+         identity->threadname, identity->pid);
   return offset;
 }
@@ -47,6 +47,15 @@ struct variable_arg {
   };
 };
 
+/* what an IDENTITY frame tells about a stream */
+struct binary_identity {
+  unsigned long long stream_id;
+  char hostname[256];
+  char progname[256];
+  char threadname[256];
+  int pid;
+};
+
 /* Convert big-endian bytes to native endianness */
 int bigendian_to_native(const char *buf, int bytes, char *dst);
 
@@ -70,4 +79,17 @@ int validate_variable_arguments(const char *format,
 int analyze_received_binary_message(const char *format, const char *buf,
                                     int buflen);
 
+/* Analyze a received FORMAT frame, see CLOGGING_BINARY_FRAME_FORMAT, and
+ * get its id and its format as a C string in format.
+ */
+int analyze_received_format_frame(const char *buf, int buflen, int *id,
+                                  char *format, int format_size);
+
+/* Analyze a received IDENTITY frame, see CLOGGING_BINARY_FRAME_IDENTITY,
+ * and remember it so that analyze_received_binary_message() can decode
+ * the records which refer to it by its stream id.
+ */
+int analyze_received_identity_frame(const char *buf, int buflen,
+                                    struct binary_identity *identity);
+
 #endif /* CLOGGING_TEST_BINARY_LOGGING_COMMON_H */
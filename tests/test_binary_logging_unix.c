@@ -19,11 +19,13 @@
 #include <arpa/inet.h> /* inet_aton(), htons() */
 #include <assert.h>    /* assert() */
 #include <fcntl.h>     /* fcntl() */
+#include <pthread.h>   /* pthread_create() and friends */
 #include <stdio.h>
 #include <string.h>     /* strlen() */
 #include <sys/prctl.h>  /* prctl() */
 #include <sys/socket.h> /* socket(), connect() */
 #include <time.h>       /* time_t */
+#include <unistd.h>     /* getpid() */
 
 /* as per man prctl(2) the size should be at least 16 bytes */
 #define MAX_SIZE 32
@@ -114,7 +116,7 @@ int test_static_string(int argc, char *argv[]) {
 
   /* printf("pname = %s\n", pname); */
   /* printf("argv[0] = %s\n", argv[0]); */
-  clogging_binary_init(pname, "", LOG_LEVEL_DEBUG, clogging_create_handle_from_fd(clientfd));
+  clogging_binary_init(pname, "", LOG_LEVEL_DEBUG, clogging_create_handle_from_fd(clientfd), NULL);
   assert(clogging_binary_get_loglevel() == LOG_LEVEL_DEBUG);
   LOG_DEBUG(format);
 
@@ -165,7 +167,7 @@ int test_variable_arguments(int argc, char *argv[]) {
 
   /* printf("pname = %s\n", pname); */
   /* printf("argv[0] = %s\n", argv[0]); */
-  clogging_binary_init(pname, "", LOG_LEVEL_DEBUG, clogging_create_handle_from_fd(clientfd));
+  clogging_binary_init(pname, "", LOG_LEVEL_DEBUG, clogging_create_handle_from_fd(clientfd), NULL);
   assert(clogging_binary_get_loglevel() == LOG_LEVEL_DEBUG);
   LOG_DEBUG(format, argint, argchar, arguint, arglongint, arglonglongint,
                    argulonglongint, argptr, argstr);
@@ -184,7 +186,156 @@ int test_variable_arguments(int argc, char *argv[]) {
   return 0;
 }
 
+#define NUM_FORMATS 100
+
+static char many_formats[NUM_FORMATS][16];
+
+/* With intern_formats the receiver learns the format from the stream */
+static void *test_interned_formats(void *data) {
+  clogging_log_options_t opts = {.intern_formats = 1};
+  char pname[MAX_SIZE] = {0};
+  char buf[MAX_BUF_LEN];
+  char format[MAX_BUF_LEN];
+  const char *sent_format = "interned format, int=%d, str=%s";
+  struct sockaddr_in clientaddr;
+  int serverfd = 0;
+  int clientfd = 0;
+  int port = 21003;
+  int bytes_received = 0;
+  int format_id = 0;
+  int num_format_frames = 0;
+  int num_records = 0;
+  int round = 0;
+  int i = 0;
+
+  (void)data;
+  prctl(PR_GET_NAME, (unsigned long)(pname), 0, 0, 0);
+  serverfd = create_udp_server(port);
+  clientfd = create_client_socket("127.0.0.1", port);
+  clogging_binary_init(pname, "-interned", LOG_LEVEL_DEBUG,
+                       clogging_create_handle_from_fd(clientfd), &opts);
+
+  for (i = 0; i < 2; ++i) {
+    LOG_INFO(sent_format, i, "abc");
+    bytes_received =
+        receive_msg_from_client(serverfd, buf, MAX_BUF_LEN, &clientaddr);
+    /* only the first message of the format is preceded by FORMAT */
+    if (i == 0) {
+      if (analyze_received_format_frame(buf, bytes_received, &format_id,
+                                        format, sizeof(format)) < 0 ||
+          strcmp(format, sent_format) != 0) {
+        return (void *)1;
+      }
+      bytes_received =
+          receive_msg_from_client(serverfd, buf, MAX_BUF_LEN, &clientaddr);
+    }
+    if (analyze_received_binary_message(format, buf, bytes_received) !=
+        bytes_received) {
+      return (void *)1;
+    }
+  }
+
+  /* enough formats to grow the table a few times, each of them is
+   * interned once and then only referred to
+   */
+  for (i = 0; i < NUM_FORMATS; ++i) {
+    snprintf(&many_formats[i][0], sizeof(many_formats[i]), "format %d", i);
+  }
+  for (round = 0; round < 2; ++round) {
+    for (i = 0; i < NUM_FORMATS; ++i) {
+      LOG_INFO(&many_formats[i][0]);
+    }
+    while ((bytes_received = receive_msg_from_client(
+                serverfd, buf, MAX_BUF_LEN, &clientaddr)) > 0) {
+      if (CLOGGING_BINARY_FRAME_TYPE_OF(buf[2]) ==
+          CLOGGING_BINARY_FRAME_FORMAT) {
+        ++num_format_frames;
+      } else {
+        ++num_records;
+      }
+    }
+  }
+  if (num_format_frames != NUM_FORMATS || num_records != 2 * NUM_FORMATS) {
+    fprintf(stderr, "%d FORMAT frames and %d records for %d formats\n",
+            num_format_frames, num_records, NUM_FORMATS);
+    return (void *)1;
+  }
+  if (clogging_binary_get_num_dropped_messages() != 0) {
+    return (void *)1;
+  }
+  return NULL;
+}
+
+/* With intern_identity the records carry a stream id instead of the
+ * names and the pid, which come once in an IDENTITY frame
+ */
+static void *test_interned_identity(void *data) {
+  clogging_log_options_t opts = {.intern_identity = 1};
+  struct binary_identity identity;
+  char pname[MAX_SIZE] = {0};
+  char buf[MAX_BUF_LEN];
+  const char *sent_format = "identity, int=%d, str=%s";
+  struct sockaddr_in clientaddr;
+  unsigned long long stream_id = 0;
+  int serverfd = 0;
+  int clientfd = 0;
+  int port = 21004;
+  int bytes_received = 0;
+  int round = 0;
+
+  (void)data;
+  prctl(PR_GET_NAME, (unsigned long)(pname), 0, 0, 0);
+  serverfd = create_udp_server(port);
+  clientfd = create_client_socket("127.0.0.1", port);
+  clogging_binary_init(pname, "-identity", LOG_LEVEL_DEBUG,
+                       clogging_create_handle_from_fd(clientfd), &opts);
+
+  /* the stream is announced again when it starts over */
+  for (round = 0; round < 2; ++round) {
+    bytes_received =
+        receive_msg_from_client(serverfd, buf, MAX_BUF_LEN, &clientaddr);
+    if (analyze_received_identity_frame(buf, bytes_received, &identity) !=
+            bytes_received ||
+        strcmp(identity.threadname, "-identity") != 0 ||
+        identity.pid != (int)getpid() ||
+        (round > 0 && identity.stream_id != stream_id)) {
+      return (void *)1;
+    }
+    stream_id = identity.stream_id;
+
+    LOG_INFO(sent_format, round, "abc");
+    bytes_received =
+        receive_msg_from_client(serverfd, buf, MAX_BUF_LEN, &clientaddr);
+    if (analyze_received_binary_message(sent_format, buf, bytes_received) !=
+        bytes_received) {
+      return (void *)1;
+    }
+    clogging_binary_restart_stream();
+  }
+  if (clogging_binary_get_num_dropped_messages() != 0) {
+    return (void *)1;
+  }
+  return NULL;
+}
+
 int main(int argc, char *argv[]) {
-  return test_variable_arguments(argc, argv);
-  // return test_static_string(argc, argv);
+  pthread_t tid;
+  void *failed = NULL;
+  int rc = test_variable_arguments(argc, argv);
+  // rc = test_static_string(argc, argv);
+
+  /* binary logging is initialized once per thread */
+  pthread_create(&tid, NULL, test_interned_formats, NULL);
+  pthread_join(tid, &failed);
+  if (failed != NULL) {
+    fprintf(stderr, "interned formats test failed\n");
+    return 1;
+  }
+  pthread_create(&tid, NULL, test_interned_identity, NULL);
+  pthread_join(tid, &failed);
+  if (failed != NULL) {
+    fprintf(stderr, "interned identity test failed\n");
+    return 1;
+  }
+  return rc;
 }
@@ -119,7 +119,7 @@ int test_static_string(int argc, char *argv[]) {
   /* printf("pname = %s\n", pname); */
   /* printf("argv[0] = %s\n", argv[0]); */
   /* On Windows, use the proper socket handle API */
-  clogging_binary_init(pname, "", LOG_LEVEL_DEBUG, clogging_create_handle_from_socket((uint64_t)clientfd));
+  clogging_binary_init(pname, "", LOG_LEVEL_DEBUG, clogging_create_handle_from_socket((uint64_t)clientfd), NULL);
   assert(clogging_binary_get_loglevel() == LOG_LEVEL_DEBUG);
   LOG_DEBUG(msg);
 
@@ -182,7 +182,7 @@ int test_variable_arguments(int argc, char *argv[]) {
   /* printf("pname = %s\n", pname); */
   /* printf("argv[0] = %s\n", argv[0]); */
   /* On Windows, use the proper socket handle API */
-  clogging_binary_init(pname, "", LOG_LEVEL_DEBUG, clogging_create_handle_from_socket((uint64_t)clientfd));
+  clogging_binary_init(pname, "", LOG_LEVEL_DEBUG, clogging_create_handle_from_socket((uint64_t)clientfd), NULL);
   assert(clogging_binary_get_loglevel() == LOG_LEVEL_DEBUG);
   LOG_DEBUG(format, argint, argchar, arguint, arglongint, arglonglongint,
                    argulonglongint, argptr, argstr);
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef _WIN32
+#error This file is for non-Windows platforms only
+#endif /* _WIN32 */
+
+#include "../src/binary_logging.h"
+
+#include <pthread.h> /* pthread_create() and friends */
+#include <stdio.h>
+#include <string.h> /* memcpy() */
+#include <unistd.h> /* getpid() */
+
+#define MAX_BUF_SIZE 4096
+#define SAMPLE_INT 0x01020304
+#define SAMPLE_DOUBLE 1.5
+#define SAMPLE_POINTER ((void *)0x1234)
+
+static int host_byte_order(void) {
+  const uint16_t one = 1;
+  uint8_t first = 0;
+
+  memcpy(&first, &one, 1);
+  return (first == 1) ? CLOGGING_BINARY_LITTLE_ENDIAN
+                      : CLOGGING_BINARY_BIG_ENDIAN;
+}
+
+/* copy bytes from src to dst, reversing them when they are not in the
+ * byte order of the host
+ */
+static void read_raw(const char *src, size_t bytes, int order, void *dst) {
+  char *d = (char *)dst;
+  size_t i = 0;
+
+  if (order == host_byte_order()) {
+    memcpy(dst, src, bytes);
+    return;
+  }
+  for (i = 0; i < bytes; ++i) {
+    d[i] = src[bytes - 1 - i];
+  }
+}
+
+/* <0x80|size> <value> */
+static unsigned long long read_uint(const char *buf, ssize_t *pos,
+                                    int order) {
+  int bytes = buf[*pos] & 0x0f;
+  uint8_t u8 = 0;
+  uint16_t u16 = 0;
+  uint32_t u32 = 0;
+  uint64_t u64 = 0;
+  const char *src = &buf[*pos + 1];
+
+  *pos += 1 + bytes;
+  switch (bytes) {
+  case 1:
+    read_raw(src, bytes, order, &u8);
+    return u8;
+  case 2:
+    read_raw(src, bytes, order, &u16);
+    return u16;
+  case 4:
+    read_raw(src, bytes, order, &u32);
+    return u32;
+  default:
+    read_raw(src, bytes, order, &u64);
+    return u64;
+  }
+}
+
+/* <15-bit big-endian length> <bytes>, whatever the byte order */
+static void skip_string(const char *buf, ssize_t *pos) {
+  *pos += 2 + (((buf[*pos] & 0x7f) << 8) | (buf[*pos + 1] & 0x00ff));
+}
+
+/* Decode the record of the sample written with the given byte order. */
+static int check_record(const char *buf, ssize_t n, int order) {
+  ssize_t pos = 2;
+  unsigned int val = 0;
+  double dbl = 0.0;
+  void *ptr = NULL;
+
+  (void)read_uint(buf, &pos, order); /* timestamp */
+  skip_string(buf, &pos);            /* hostname */
+  skip_string(buf, &pos);            /* progname */
+  skip_string(buf, &pos);            /* threadname */
+  if (read_uint(buf, &pos, order) != (unsigned int)getpid()) {
+    fprintf(stderr, "wrong pid for byte order %d\n", order);
+    return 1;
+  }
+  (void)read_uint(buf, &pos, order); /* loglevel */
+  skip_string(buf, &pos);            /* file */
+  skip_string(buf, &pos);            /* func */
+  if (read_uint(buf, &pos, order) != 42) {
+    fprintf(stderr, "wrong line for byte order %d\n", order);
+    return 1;
+  }
+  /* <type> <0x80|size> <value> for each of the arguments */
+  ++pos;
+  val = (unsigned int)read_uint(buf, &pos, order);
+  pos += 2;
+  read_raw(&buf[pos], sizeof(dbl), order, &dbl);
+  pos += sizeof(dbl) + 2;
+  read_raw(&buf[pos], sizeof(ptr), order, &ptr);
+  pos += sizeof(ptr);
+  if (val != SAMPLE_INT || dbl != SAMPLE_DOUBLE || ptr != SAMPLE_POINTER ||
+      pos != n) {
+    fprintf(stderr, "wrong arguments for byte order %d\n", order);
+    return 1;
+  }
+  return 0;
+}
+
+struct context {
+  clogging_shm_ring_t *ring;
+  int native_endian;
+};
+
+static void *work(void *data) {
+  struct context *ctx = (struct context *)data;
+  clogging_log_options_t opts = {.native_endian = (uint8_t)ctx->native_endian};
+
+  clogging_binary_init_shm("test_native_endian", "-worker", LOG_LEVEL_INFO,
+                           ctx->ring, &opts);
+  clogging_binary_logmsg("server.c", "handle", 42, LOG_LEVEL_INFO,
+                         "%x %f %p", SAMPLE_INT, SAMPLE_DOUBLE,
+                         SAMPLE_POINTER);
+  return NULL;
+}
+
+/* log the sample from a thread of its own, binary logging is initialized
+ * once per thread
+ */
+static void log_sample(clogging_shm_ring_t *ring, int native_endian) {
+  struct context ctx = {ring, native_endian};
+  pthread_t tid;
+
+  pthread_create(&tid, NULL, work, &ctx);
+  pthread_join(tid, NULL);
+}
+
+int main(int argc, char *argv[]) {
+  clogging_shm_ring_t *ring = clogging_shm_ring_create(NULL, 64 * 1024);
+  char buf[MAX_BUF_SIZE];
+  ssize_t n = 0;
+  int order = CLOGGING_BINARY_BIG_ENDIAN;
+  int failed = 0;
+
+  (void)argc;
+  (void)argv;
+  if (ring == NULL) {
+    perror("clogging_shm_ring_create");
+    return 1;
+  }
+
+  /* the default stream is big-endian and has no STREAM frame */
+  log_sample(ring, 0);
+  n = clogging_shm_ring_read(ring, buf, sizeof(buf), 0);
+  if (n <= 2 || CLOGGING_BINARY_IS_FRAME(buf[2])) {
+    fprintf(stderr, "default stream does not start with a record\n");
+    return 1;
+  }
+  failed |= check_record(buf, n, CLOGGING_BINARY_BIG_ENDIAN);
+
+  /* the native stream tells its byte order first */
+  log_sample(ring, 1);
+  n = clogging_shm_ring_read(ring, buf, sizeof(buf), 0);
+  if (n != 5 ||
+      buf[2] != CLOGGING_BINARY_FRAME_HEADER(CLOGGING_BINARY_FRAME_VERSION,
+                                             CLOGGING_BINARY_FRAME_STREAM) ||
+      (buf[3] & 0x00ff) != 0x81) {
+    fprintf(stderr, "native stream does not start with a STREAM frame\n");
+    return 1;
+  }
+  order = buf[4];
+  if (order != host_byte_order()) {
+    fprintf(stderr, "STREAM frame tells byte order %d\n", order);
+    return 1;
+  }
+  n = clogging_shm_ring_read(ring, buf, sizeof(buf), 0);
+  failed |= check_record(buf, n, order);
+
+  clogging_shm_ring_close(ring);
+  return failed;
+}
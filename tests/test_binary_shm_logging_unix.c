@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef _WIN32
+#error This file is for non-Windows platforms only
+#endif /* _WIN32 */
+
+#include "../src/binary_logging.h"
+
+#include <pthread.h>  /* pthread_create() and friends */
+#include <stdio.h>
+#include <string.h>   /* memcmp() */
+#include <sys/wait.h> /* waitpid() */
+#include <unistd.h>   /* fork(), getpid() */
+
+#define LOG_INFO(format, ...)                                                \
+  clogging_binary_logmsg(__FILE__, __func__, __LINE__, LOG_LEVEL_INFO,      \
+                         format, ##__VA_ARGS__)
+
+#define NUM_PROCESSES 3
+#define NUM_THREADS 4
+#define NUM_LOOPS 500
+#define MAX_BUF_SIZE 4096
+
+struct context {
+  clogging_shm_ring_t *ring;
+  int threadindex;
+};
+
+static void *work(void *data) {
+  struct context *ctx = (struct context *)data;
+  char threadname[20] = {0};
+  int i = 0;
+
+  snprintf(threadname, sizeof(threadname), "-thread%d", ctx->threadindex);
+  clogging_binary_init_shm("test_binary_shm", threadname, LOG_LEVEL_INFO,
+                           ctx->ring, NULL);
+  for (i = 0; i < NUM_LOOPS; ++i) {
+    LOG_INFO("shm record %d from thread %d of %s", i, ctx->threadindex,
+             "child");
+  }
+  return NULL;
+}
+
+/* Runs in a forked child which attaches to the ring by name, just like
+ * an unrelated process would.
+ */
+static int run_child(const char *name) {
+  pthread_t tids[NUM_THREADS];
+  struct context contexts[NUM_THREADS];
+  clogging_shm_ring_t *ring = clogging_shm_ring_open(name);
+  int i = 0;
+
+  if (ring == NULL) {
+    perror("clogging_shm_ring_open");
+    return 1;
+  }
+  for (i = 0; i < NUM_THREADS; ++i) {
+    contexts[i].ring = ring;
+    contexts[i].threadindex = i;
+    pthread_create(&tids[i], NULL, work, &contexts[i]);
+  }
+  for (i = 0; i < NUM_THREADS; ++i) {
+    pthread_join(tids[i], NULL);
+  }
+  clogging_shm_ring_close(ring);
+  return 0;
+}
+
+/* Every record must be what binary logging writes to a handle, that is
+ * the big-endian length of the payload followed by the payload.
+ */
+static int is_valid_record(const char *buf, ssize_t n) {
+  int len = ((buf[0] & 0x00ff) << 8) | (buf[1] & 0x00ff);
+
+  return n > 2 && len == n - 2;
+}
+
+static int test_multi_process(void) {
+  char name[64];
+  char buf[MAX_BUF_SIZE];
+  clogging_shm_ring_t *ring = NULL;
+  pid_t pids[NUM_PROCESSES];
+  int num_records = 0;
+  int num_bad_records = 0;
+  int expected = NUM_PROCESSES * NUM_THREADS * NUM_LOOPS;
+  int status = 0;
+  int failed = 0;
+  ssize_t n = 0;
+  int i = 0;
+
+  snprintf(name, sizeof(name), "/clogging-test-%d", (int)getpid());
+  /* large enough for every record, so nothing may be dropped */
+  ring = clogging_shm_ring_create(name, CLOGGING_SHM_RING_BYTES);
+  if (ring == NULL) {
+    perror("clogging_shm_ring_create");
+    return 1;
+  }
+
+  for (i = 0; i < NUM_PROCESSES; ++i) {
+    pids[i] = fork();
+    if (pids[i] == 0) {
+      _exit(run_child(name));
+    }
+  }
+
+  /* this process is the reader */
+  while (num_records < expected) {
+    n = clogging_shm_ring_read(ring, buf, sizeof(buf), 5000);
+    if (n <= 0) {
+      fprintf(stderr, "timed out after %d records\n", num_records);
+      break;
+    }
+    if (!is_valid_record(buf, n)) {
+      ++num_bad_records;
+    }
+    ++num_records;
+  }
+
+  for (i = 0; i < NUM_PROCESSES; ++i) {
+    waitpid(pids[i], &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      failed = 1;
+    }
+  }
+  printf("received %d records (%d malformed, %llu dropped), expected %d\n",
+         num_records, num_bad_records,
+         (unsigned long long)clogging_shm_ring_get_drops(ring), expected);
+  if (num_records != expected || num_bad_records != 0 ||
+      clogging_shm_ring_get_drops(ring) != 0) {
+    failed = 1;
+  }
+  clogging_shm_ring_close(ring);
+  clogging_shm_ring_unlink(name);
+  return failed;
+}
+
+/* A full ring drops records instead of blocking, and makes room again
+ * once the reader catches up.
+ */
+static int test_full_ring(void) {
+  char rec[100];
+  char buf[MAX_BUF_SIZE];
+  clogging_shm_ring_t *ring = clogging_shm_ring_create(NULL, 4096);
+  int written = 0;
+  int failed = 0;
+  int i = 0;
+
+  if (ring == NULL) {
+    perror("clogging_shm_ring_create");
+    return 1;
+  }
+  for (i = 0; i < 1000; ++i) {
+    memset(rec, 'a' + (i % 26), sizeof(rec));
+    if (clogging_shm_ring_write(ring, rec, sizeof(rec)) == 0) {
+      ++written;
+    }
+  }
+  if (written == 0 || clogging_shm_ring_get_drops(ring) == 0 ||
+      written + (int)clogging_shm_ring_get_drops(ring) != 1000) {
+    fprintf(stderr, "expected a full ring, wrote %d records\n", written);
+    failed = 1;
+  }
+  for (i = 0; i < written; ++i) {
+    memset(rec, 'a' + (i % 26), sizeof(rec));
+    if (clogging_shm_ring_read(ring, buf, sizeof(buf), 0) != sizeof(rec) ||
+        memcmp(buf, rec, sizeof(rec)) != 0) {
+      fprintf(stderr, "record %d is corrupt\n", i);
+      failed = 1;
+      break;
+    }
+  }
+  if (clogging_shm_ring_read(ring, buf, sizeof(buf), 10) != 0) {
+    fprintf(stderr, "expected an empty ring\n");
+    failed = 1;
+  }
+  /* wrap around a couple of times */
+  for (i = 0; i < 200; ++i) {
+    if (clogging_shm_ring_write(ring, rec, sizeof(rec)) != 0 ||
+        clogging_shm_ring_read(ring, buf, sizeof(buf), 0) != sizeof(rec)) {
+      fprintf(stderr, "wrap around failed at %d\n", i);
+      failed = 1;
+      break;
+    }
+  }
+  clogging_shm_ring_close(ring);
+  return failed;
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc; /* unused parameter */
+  (void)argv; /* unused parameter */
+
+  if (test_full_ring() != 0) {
+    return 1;
+  }
+  if (test_multi_process() != 0) {
+    return 1;
+  }
+  return 0;
+}
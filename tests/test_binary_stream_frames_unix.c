@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef _WIN32
+#error This file is for non-Windows platforms only
+#endif /* _WIN32 */
+
+#include "../src/binary_logging.h"
+
+#include <fcntl.h>  /* fcntl() */
+#include <stdio.h>
+#include <string.h> /* memset() */
+#include <unistd.h> /* pipe(), read(), write(), close() */
+
+#define MAX_BUF_SIZE 4096
+
+/* Fill the pipe up to the last byte, so that no frame fits in it. */
+static void fill_pipe(int fd) {
+  char buf[MAX_BUF_SIZE];
+  size_t len = sizeof(buf);
+
+  memset(buf, 'x', sizeof(buf));
+  while (len > 0) {
+    if (write(fd, buf, len) < 0) {
+      len /= 2;
+    }
+  }
+}
+
+static void drain_pipe(int fd) {
+  char buf[MAX_BUF_SIZE];
+
+  while (read(fd, buf, sizeof(buf)) > 0) {
+  }
+}
+
+/* The frames which start a stream and are dropped, here on a full pipe,
+ * go out again before the next record, which cannot be decoded without
+ * them.
+ */
+int main(int argc, char *argv[]) {
+  clogging_log_options_t opts = {.binary_version = CLOGGING_BINARY_VERSION_2,
+                                 .native_endian = 1,
+                                 .intern_identity = 1};
+  const int expected[] = {CLOGGING_BINARY_FRAME_STREAM,
+                          CLOGGING_BINARY_FRAME_IDENTITY,
+                          CLOGGING_BINARY_FRAME_MESSAGE};
+  char buf[MAX_BUF_SIZE];
+  ssize_t n = 0;
+  ssize_t offset = 0;
+  int num_frames = 0;
+  int failed = 0;
+  int fds[2];
+
+  (void)argc;
+  (void)argv;
+  if (pipe(fds) != 0) {
+    perror("pipe");
+    return 1;
+  }
+  fcntl(fds[0], F_SETFL, O_NONBLOCK);
+  fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+  fill_pipe(fds[1]);
+  clogging_binary_init("test_stream_frames", "", LOG_LEVEL_INFO,
+                       clogging_create_handle_from_fd(fds[1]), &opts);
+  clogging_binary_logmsg("frames.c", "main", 1, LOG_LEVEL_INFO,
+                         "dropped %d", 1);
+  drain_pipe(fds[0]);
+  clogging_binary_logmsg("frames.c", "main", 2, LOG_LEVEL_INFO,
+                         "written %d", 2);
+
+  n = read(fds[0], buf, sizeof(buf));
+  while (offset + 3 <= n) {
+    if (num_frames < 3 && CLOGGING_BINARY_FRAME_TYPE_OF(buf[offset + 2]) !=
+                              expected[num_frames]) {
+      fprintf(stderr, "frame %d is of type %d, expected %d\n", num_frames,
+              CLOGGING_BINARY_FRAME_TYPE_OF(buf[offset + 2]),
+              expected[num_frames]);
+      failed = 1;
+    }
+    ++num_frames;
+    offset += 2 + (((buf[offset] & 0x00ff) << 8) | (buf[offset + 1] & 0x00ff));
+  }
+  if (num_frames != 3 || offset != n) {
+    fprintf(stderr, "%d frames in %zd bytes\n", num_frames, n);
+    failed = 1;
+  }
+  close(fds[0]);
+  close(fds[1]);
+  return failed;
+}
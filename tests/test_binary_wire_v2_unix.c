@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef _WIN32
+#error This file is for non-Windows platforms only
+#endif /* _WIN32 */
+
+#include "../src/binary_logging.h"
+
+#include <pthread.h> /* pthread_create() and friends */
+#include <stdio.h>
+#include <string.h> /* memcmp() */
+
+#define MAX_BUF_SIZE 4096
+
+/* the message both encodings are compared with */
+#define LOG_SAMPLE()                                                          \
+  clogging_binary_logmsg("server.c", "handle", 42, LOG_LEVEL_INFO,            \
+                         "request %d of %u took %lld us, %hhd %s at %p", 7,   \
+                         3u, -12LL, (signed char)-1, "ok", (void *)0x1234)
+
+struct reader {
+  const unsigned char *buf;
+  ssize_t len;
+  ssize_t pos;
+  int failed;
+};
+
+static unsigned long long read_varint(struct reader *r) {
+  unsigned long long val = 0;
+  int shift = 0;
+
+  while (r->pos < r->len && shift < 64) {
+    unsigned char b = r->buf[r->pos++];
+
+    val |= (unsigned long long)(b & 0x7f) << shift;
+    if ((b & 0x80) == 0) {
+      return val;
+    }
+    shift += 7;
+  }
+  r->failed = 1;
+  return 0;
+}
+
+static int read_bytes_are(struct reader *r, const char *s, size_t slen) {
+  size_t len = (size_t)read_varint(r);
+
+  if (r->pos + (ssize_t)len > r->len || len != slen ||
+      memcmp(r->buf + r->pos, s, len) != 0) {
+    r->failed = 1;
+    return 0;
+  }
+  r->pos += len;
+  return 1;
+}
+
+static int read_string_is(struct reader *r, const char *s) {
+  return read_bytes_are(r, s, strlen(s));
+}
+
+/* zigzag decode and cut back to bytes */
+static unsigned long long read_arg_integer(struct reader *r, int bytes) {
+  unsigned long long zz = read_varint(r);
+  unsigned long long val = (zz >> 1) ^ (0ULL - (zz & 1));
+
+  return (bytes < 8) ? (val & ((1ULL << (8 * bytes)) - 1)) : val;
+}
+
+static int expect_tag(struct reader *r, enum VarArgType type, int bytes) {
+  if (r->pos >= r->len ||
+      r->buf[r->pos] != CLOGGING_BINARY_ARG_DESC(type, bytes)) {
+    fprintf(stderr, "unexpected tag %02x at %zd\n",
+            (r->pos < r->len) ? r->buf[r->pos] : 0, r->pos);
+    r->failed = 1;
+    return 0;
+  }
+  ++r->pos;
+  return 1;
+}
+
+/* <length> <header> <timestamp> <hostname> <progname> <threadname> <pid>
+ *   <loglevel> <file> <func> <linenum> [<arg1>, <arg2>, ...]
+ */
+static int check_message(const char *buf, ssize_t n) {
+  struct reader r = {(const unsigned char *)buf, n, 2, 0};
+  unsigned long long ptr = 0;
+  int i = 0;
+
+  if (r.buf[r.pos++] != CLOGGING_BINARY_FRAME_HEADER(
+                            CLOGGING_BINARY_VERSION_2,
+                            CLOGGING_BINARY_FRAME_MESSAGE)) {
+    fprintf(stderr, "not a v2 MESSAGE frame\n");
+    return 1;
+  }
+  (void)read_varint(&r); /* timestamp */
+  r.pos += (ssize_t)read_varint(&r); /* hostname */
+  /* progname and threadname are sent with their terminating NUL */
+  read_bytes_are(&r, "test_wire_v2", sizeof("test_wire_v2"));
+  read_bytes_are(&r, "-v2", sizeof("-v2"));
+  (void)read_varint(&r); /* pid */
+  (void)read_varint(&r); /* loglevel */
+  read_string_is(&r, "server.c");
+  read_string_is(&r, "handle");
+  if (read_varint(&r) != 42 || r.failed) {
+    fprintf(stderr, "v2 MESSAGE frame has the wrong header fields\n");
+    return 1;
+  }
+
+  if (!expect_tag(&r, BINARY_LOG_VAR_ARG_INTEGER, sizeof(int)) ||
+      read_arg_integer(&r, sizeof(int)) != 7 ||
+      !expect_tag(&r, BINARY_LOG_VAR_ARG_INTEGER, sizeof(int)) ||
+      read_arg_integer(&r, sizeof(int)) != 3 ||
+      !expect_tag(&r, BINARY_LOG_VAR_ARG_INTEGER, sizeof(long long)) ||
+      read_arg_integer(&r, sizeof(long long)) != (unsigned long long)-12LL ||
+      !expect_tag(&r, BINARY_LOG_VAR_ARG_INTEGER, 1) ||
+      read_arg_integer(&r, 1) != 0xff ||
+      !expect_tag(&r, BINARY_LOG_VAR_ARG_STRING, 0) ||
+      !read_string_is(&r, "ok") ||
+      !expect_tag(&r, BINARY_LOG_VAR_ARG_POINTER, sizeof(void *))) {
+    fprintf(stderr, "v2 MESSAGE frame has the wrong arguments\n");
+    return 1;
+  }
+  for (i = 0; i < (int)sizeof(void *); ++i) {
+    ptr = (ptr << 8) | r.buf[r.pos++];
+  }
+  if (ptr != 0x1234 || r.pos != n) {
+    fprintf(stderr, "v2 MESSAGE frame has the wrong pointer or length\n");
+    return 1;
+  }
+  return 0;
+}
+
+/* the blob logged after the sample, shorter than 128 bytes so that its
+ * length is a varint of a byte
+ */
+static const char g_blob[] = {0x00, 0x01, 0x7f, (char)0x80, (char)0xff};
+
+/* The blob ends the last frame as <tag> <varint length> <bytes>, whose
+ * tag the macros of binary_logging.h decode.
+ */
+static int check_blob(const char *buf, ssize_t n) {
+  const char *tag = buf + n - sizeof(g_blob) - 2;
+
+  if (n < (ssize_t)sizeof(g_blob) + 3 ||
+      CLOGGING_BINARY_ARG_TYPE_OF((uint8_t)tag[0]) !=
+          BINARY_LOG_VAR_ARG_BLOB ||
+      CLOGGING_BINARY_ARG_SIZE_OF((uint8_t)tag[0]) != 0 ||
+      tag[1] != (char)sizeof(g_blob) ||
+      memcmp(tag + 2, g_blob, sizeof(g_blob)) != 0) {
+    fprintf(stderr, "v2 blob does not decode\n");
+    return 1;
+  }
+  return 0;
+}
+
+struct context {
+  clogging_shm_ring_t *ring;
+  int version;
+};
+
+static void *work(void *data) {
+  struct context *ctx = (struct context *)data;
+  clogging_log_options_t opts = {.binary_version = (uint8_t)ctx->version};
+
+  clogging_binary_init_shm("test_wire_v2", "-v2", LOG_LEVEL_INFO, ctx->ring,
+                           &opts);
+  LOG_SAMPLE();
+  BINARY_LOG_INFO("site %d", 5);
+  clogging_binary_log_blob("server.c", "dump", 43, LOG_LEVEL_INFO, g_blob,
+                           sizeof(g_blob), "blob of %d bytes",
+                           (int)sizeof(g_blob));
+  return NULL;
+}
+
+/* log the sample from a thread of its own, binary logging is initialized
+ * once per thread
+ */
+static void log_sample(clogging_shm_ring_t *ring, int version) {
+  struct context ctx = {ring, version};
+  pthread_t tid;
+
+  pthread_create(&tid, NULL, work, &ctx);
+  pthread_join(tid, NULL);
+}
+
+int main(int argc, char *argv[]) {
+  clogging_shm_ring_t *ring = clogging_shm_ring_create(NULL, 64 * 1024);
+  char v1[MAX_BUF_SIZE];
+  char v2[MAX_BUF_SIZE];
+  char buf[MAX_BUF_SIZE];
+  ssize_t v1_len = 0;
+  ssize_t v2_len = 0;
+  ssize_t last_len = 0;
+  ssize_t n = 0;
+  int failed = 0;
+
+  (void)argc;
+  (void)argv;
+  if (ring == NULL) {
+    perror("clogging_shm_ring_create");
+    return 1;
+  }
+
+  log_sample(ring, CLOGGING_BINARY_VERSION_1);
+  v1_len = clogging_shm_ring_read(ring, v1, sizeof(v1), 0);
+  while (clogging_shm_ring_read(ring, buf, sizeof(buf), 0) > 0) {
+  }
+  log_sample(ring, CLOGGING_BINARY_VERSION_2);
+  v2_len = clogging_shm_ring_read(ring, v2, sizeof(v2), 0);
+
+  failed = check_message(v2, v2_len);
+
+  /* the SITE and RECORD frames of the macro are v2 as well */
+  while ((n = clogging_shm_ring_read(ring, buf, sizeof(buf), 0)) > 0) {
+    if (CLOGGING_BINARY_FRAME_VERSION_OF(buf[2]) != CLOGGING_BINARY_VERSION_2) {
+      fprintf(stderr, "frame %02x is not v2\n", buf[2] & 0x00ff);
+      failed = 1;
+    }
+    last_len = n;
+  }
+  failed |= check_blob(buf, last_len);
+
+  printf("the same record takes %zd bytes in v1 and %zd bytes in v2\n",
+         v1_len, v2_len);
+  if (v2_len >= v1_len) {
+    failed = 1;
+  }
+  clogging_shm_ring_close(ring);
+  return failed;
+}
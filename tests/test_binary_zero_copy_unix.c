@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef _WIN32
+#error This file is for non-Windows platforms only
+#endif /* _WIN32 */
+
+#include "../src/binary_logging.h"
+
+#include <fcntl.h>      /* fcntl() */
+#include <stdio.h>
+#include <stdlib.h>     /* malloc(), free() */
+#include <string.h>     /* memset(), memcmp() */
+#include <sys/socket.h> /* socketpair(), recv() */
+#include <unistd.h>     /* read(), close() */
+
+#define PAYLOAD_BYTES 6000
+#define BLOB_BYTES 3000
+#define NUM_RECORDS 200
+#define MAX_RECORD_BYTES 65537
+
+static char payload[PAYLOAD_BYTES + 1];
+static char blob[BLOB_BYTES];
+
+/* Append whatever can be read from fd to buf without blocking. */
+static void drain(int fd, char *buf, size_t *len, size_t capacity) {
+  ssize_t n = 0;
+
+  while (*len < capacity &&
+         (n = recv(fd, buf + *len, capacity - *len, MSG_DONTWAIT)) > 0) {
+    *len += (size_t)n;
+  }
+}
+
+/* The record ends with <string> <blob>, as <type> <15-bit length>
+ * <bytes> each, and the string holds the index of the record first.
+ */
+static int check_record(const char *buf, ssize_t n, int *index) {
+  const char *end = buf + n;
+  const char *s = end - BLOB_BYTES - 3 - PAYLOAD_BYTES - 3;
+
+  if (s < buf || s[0] != BINARY_LOG_VAR_ARG_STRING ||
+      (((s[1] & 0x7f) << 8) | (s[2] & 0x00ff)) != PAYLOAD_BYTES ||
+      memcmp(s + 3 + 4, payload + 4, PAYLOAD_BYTES - 4) != 0) {
+    fprintf(stderr, "string argument is broken\n");
+    return 1;
+  }
+  s += 3 + PAYLOAD_BYTES;
+  if (s[0] != BINARY_LOG_VAR_ARG_BLOB ||
+      (((s[1] & 0x7f) << 8) | (s[2] & 0x00ff)) != BLOB_BYTES ||
+      memcmp(s + 3, blob, BLOB_BYTES) != 0) {
+    fprintf(stderr, "blob argument is broken\n");
+    return 1;
+  }
+  sscanf(end - BLOB_BYTES - 3 - PAYLOAD_BYTES, "%4d", index);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  size_t capacity = (NUM_RECORDS + 1) * MAX_RECORD_BYTES;
+  char *buf = (char *)malloc(capacity);
+  int fds[2];
+  int sndbuf = 16 * 1024;
+  uint64_t drops = 0;
+  size_t len = 0;
+  size_t pos = 0;
+  size_t rec_len = 0;
+  ssize_t n = 0;
+  int received = 0;
+  int last_index = -1;
+  int index = 0;
+  int done = 0;
+  int failed = 0;
+  int i = 0;
+
+  (void)argc;
+  (void)argv;
+  if (buf == NULL || socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+    perror("socketpair");
+    return 1;
+  }
+  /* a small nonblocking buffer, so that records are written partially */
+  setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+  fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+  clogging_binary_init("test_zero_copy", "-main", LOG_LEVEL_INFO,
+                       clogging_create_handle_from_fd(fds[0]), NULL);
+
+  memset(payload, 'p', PAYLOAD_BYTES);
+  for (i = 0; i < BLOB_BYTES; ++i) {
+    blob[i] = (char)i;
+  }
+
+  /* the arguments are longer than the store of the records, so they
+   * only fit when written from where they are
+   */
+  for (i = 0; i < NUM_RECORDS; ++i) {
+    snprintf(payload, 5, "%04d", i);
+    payload[4] = 'p';
+    clogging_binary_log_blob("zero_copy.c", "main", 1, LOG_LEVEL_INFO, blob,
+                             BLOB_BYTES, "record %s", payload);
+    /* the unsent rest of a record must not refer to the arguments */
+    memset(payload, 'x', 4);
+    if (i % 10 == 9) {
+      drain(fds[1], buf, &len, capacity);
+    }
+  }
+  /* a short record flushes the rest of the last one */
+  drain(fds[1], buf, &len, capacity);
+  clogging_binary_logmsg("zero_copy.c", "main", 2, LOG_LEVEL_INFO, "done");
+  drops = clogging_binary_get_num_dropped_messages();
+  close(fds[0]);
+  while (len < capacity && (n = read(fds[1], buf + len, capacity - len)) > 0) {
+    len += (size_t)n;
+  }
+  close(fds[1]);
+
+  while (pos + 2 <= len) {
+    rec_len = 2 + (((buf[pos] & 0x00ff) << 8) | (buf[pos + 1] & 0x00ff));
+    if (pos + rec_len > len) {
+      break;
+    }
+    if (rec_len < PAYLOAD_BYTES) {
+      done = 1;
+    } else if (done || check_record(buf + pos, (ssize_t)rec_len, &index) != 0 ||
+               index <= last_index) {
+      fprintf(stderr, "record at %zu is out of place\n", pos);
+      failed = 1;
+    } else {
+      last_index = index;
+      ++received;
+    }
+    pos += rec_len;
+  }
+  if (pos != len || !done) {
+    fprintf(stderr, "stream ends within a record\n");
+    failed = 1;
+  }
+  printf("%d records received and %llu dropped\n", received,
+         (unsigned long long)drops);
+  if (received == 0 || received + (int)drops != NUM_RECORDS) {
+    failed = 1;
+  }
+  free(buf);
+  return failed;
+}
@@ -0,0 +1,486 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef _WIN32
+#error This file is for non-Windows platforms only
+#endif /* _WIN32 */
+
+#include "../src/fd_logging.h"
+
+#include <pthread.h> /* pthread_create() and friends */
+#include <stddef.h>
+#include <stdint.h>  /* intptr_t */
+#include <stdio.h>
+#include <stdlib.h>  /* free() */
+#include <string.h>  /* memchr() */
+#include <unistd.h>  /* pipe(), read(), close() */
+
+#define LOG_WARN(format, ...)                                          \
+  clogging_fd_logmsg(__func__, __LINE__, LOG_LEVEL_WARN, format,       \
+                        ##__VA_ARGS__)
+#define LOG_INFO(format, ...)                                          \
+  clogging_fd_logmsg(__func__, __LINE__, LOG_LEVEL_INFO, format,       \
+                        ##__VA_ARGS__)
+
+#define NUM_THREADS 4
+#define NUM_LOOPS 200
+#define MAX_BUF_SIZE 4096
+#define MAX_LINES 32
+#define NUM_EXIT_ROUNDS 3
+/* longer than half of CLOGGING_FD_ASYNC_RING_BYTES */
+#define LONG_LINE_BYTES 40000
+/* quotes which only fit in CLOGGING_DEFAULT_MAX_LINE_BYTES unescaped */
+#define NUM_QUOTES 200
+#define NUM_QUOTES_TOO_MANY 600
+
+struct context {
+  int threadindex;
+  int fd;
+  uint64_t drops;
+};
+
+struct compare_context {
+  int json;
+  int deferred;
+  FILE *fp;
+};
+
+struct reader_result {
+  int fd;
+  int num_records;
+  int num_bad_records;
+};
+
+static pthread_barrier_t g_barrier;
+static pthread_key_t g_exit_key;
+static int g_num_exit_records = 0;
+
+/* Log from a destructor of a thread which is exiting, which comes again
+ * for a few rounds so that some come after its ring is released.
+ */
+static void log_on_exit(void *data) {
+  intptr_t round = (intptr_t)data;
+
+  LOG_INFO("exit record %d", (int)round);
+  __atomic_add_fetch(&g_num_exit_records, 1, __ATOMIC_RELAXED);
+  if (round < NUM_EXIT_ROUNDS) {
+    pthread_setspecific(g_exit_key, (void *)(round + 1));
+  }
+}
+
+static void *exit_work(void *data) {
+  struct context *ctx = (struct context *)data;
+  clogging_log_options_t opts = {
+    .color = 0,
+    .json = 0,
+    .prefix_fields_flag = CLOGGING_PREFIX_DEFAULT,
+    .async = 1
+  };
+
+  clogging_fd_init("test_fd_async", "-exit", LOG_LEVEL_INFO,
+                   clogging_create_handle_from_fd(ctx->fd), &opts);
+  LOG_INFO("async record before the exit");
+  pthread_setspecific(g_exit_key, (void *)1);
+  return NULL;
+}
+
+static void *work(void *data) {
+  struct context *ctx = (struct context *)data;
+  clogging_log_options_t opts = {
+    .color = 0,
+    .json = 0,
+    .prefix_fields_flag = CLOGGING_PREFIX_DEFAULT,
+    .async = 1
+  };
+  char threadname[20] = {0};
+  int i = 0;
+
+  snprintf(threadname, sizeof(threadname), "-thread%d", ctx->threadindex);
+  clogging_fd_init("test_fd_async", threadname, LOG_LEVEL_INFO,
+                   clogging_create_handle_from_fd(ctx->fd), &opts);
+  for (i = 0; i < NUM_LOOPS; ++i) {
+    /* the writer is stopped while the threads are still logging */
+    if (i == NUM_LOOPS / 2) {
+      pthread_barrier_wait(&g_barrier);
+    }
+    LOG_INFO("async record %d from thread %d", i, ctx->threadindex);
+  }
+  ctx->drops = clogging_fd_get_num_dropped_messages();
+  if (ctx->drops != 0) {
+    fprintf(stderr, "thread %d dropped %llu messages\n", ctx->threadindex,
+            (unsigned long long)ctx->drops);
+  }
+  return NULL;
+}
+
+/* Every call site is shared by the inline and the deferred run, so that
+ * funcname and linenum match as well.
+ */
+static void log_samples(void) {
+  static char long_string[300];
+  static char huge_string[2000];
+
+  memset(long_string, 'l', sizeof(long_string) - 1);
+  memset(huge_string, 'h', sizeof(huge_string) - 1);
+
+  LOG_INFO("plain message without arguments");
+  LOG_INFO("int %d neg %d hex %#x oct %o unsigned %u", 42, -7, 255, 8,
+           4000000000u);
+  LOG_INFO("short %hd char %hhd long %ld ll %lld size %zu ptrdiff %td",
+           (short)-3, (signed char)-1, -123456789L, -1234567890123LL,
+           (size_t)77, (ptrdiff_t)-5);
+  LOG_INFO("unsigned short %hu byte %hhx long %lx", (unsigned short)65535,
+           (unsigned char)200, 0xdeadbeefUL);
+  LOG_INFO("padded [%5d] [%-5d] [%05d] [%+d] [% d]", 1, 2, 3, 4, 5);
+  LOG_INFO("double %f %.3e %g %10.2f %a", 3.14159, 12345.678, 0.0001, -2.5,
+           1.0);
+  LOG_INFO("long double %Lf", (long double)1.5L);
+  LOG_INFO("string '%s' '%10s' '%-6s|' '%.2s' null %s", "abc", "right",
+           "left", "truncate", (char *)NULL);
+  LOG_INFO("char %c percent %% pointer %p", 'x', (void *)0x1234);
+  LOG_INFO("star width [%*d]", 6, 9);
+  LOG_INFO("slice '%.*s' '%-6.*s|' '%.*s'", 3, "GET /index", 2, "xyz", -1,
+           "negative");
+  LOG_INFO("truncated %s", long_string);
+  LOG_INFO("too large to capture %s", huge_string);
+  LOG_WARN("warning %s", "level");
+}
+
+static void *log_to_file(void *data) {
+  struct compare_context *ctx = (struct compare_context *)data;
+  clogging_log_options_t opts = {
+    .color = 0,
+    .json = ctx->json,
+    .prefix_fields_flag = CLOGGING_PREFIX_DEFAULT,
+    .async = 0,
+    .deferred = ctx->deferred
+  };
+
+  clogging_fd_init("test_fd_async", "-compare", LOG_LEVEL_INFO,
+                   clogging_create_handle_from_fd(fileno(ctx->fp)), &opts);
+  log_samples();
+  if (clogging_fd_flush(5000) != 0) {
+    fprintf(stderr, "flush timed out\n");
+  }
+  return NULL;
+}
+
+/* the timestamp may legitimately differ, so blank it out */
+static void strip_timestamp(char *line) {
+  char *start = NULL;
+  char *end = NULL;
+
+  if (line[0] == '{') {
+    start = strstr(line, "\"timestamp\":\"");
+    if (start == NULL) {
+      return;
+    }
+    start += strlen("\"timestamp\":\"");
+    end = strchr(start, '"');
+  } else {
+    start = line;
+    end = strchr(line, ' ');
+  }
+  if (end != NULL) {
+    memmove(start, end, strlen(end) + 1);
+  }
+}
+
+static int read_lines(FILE *fp, char lines[][MAX_BUF_SIZE]) {
+  int n = 0;
+
+  rewind(fp);
+  while (n < MAX_LINES && fgets(lines[n], MAX_BUF_SIZE, fp) != NULL) {
+    strip_timestamp(lines[n]);
+    ++n;
+  }
+  return n;
+}
+
+/* Log the same messages inline and deferred and expect the very same
+ * output, apart from the timestamp.
+ */
+static int compare_deferred_output(int json) {
+  static char inline_lines[MAX_LINES][MAX_BUF_SIZE];
+  static char deferred_lines[MAX_LINES][MAX_BUF_SIZE];
+  struct compare_context ctx[2];
+  pthread_t tid;
+  int num_inline = 0;
+  int num_deferred = 0;
+  int failed = 0;
+  int i = 0;
+
+  for (i = 0; i < 2; ++i) {
+    ctx[i].json = json;
+    ctx[i].deferred = i;
+    ctx[i].fp = tmpfile();
+    if (ctx[i].fp == NULL) {
+      perror("tmpfile");
+      return 1;
+    }
+    /* a fresh thread since init is once per thread */
+    pthread_create(&tid, NULL, log_to_file, &ctx[i]);
+    pthread_join(tid, NULL);
+  }
+
+  num_inline = read_lines(ctx[0].fp, inline_lines);
+  num_deferred = read_lines(ctx[1].fp, deferred_lines);
+  if (num_inline != num_deferred || num_inline == 0) {
+    fprintf(stderr, "json=%d: %d inline lines but %d deferred lines\n", json,
+            num_inline, num_deferred);
+    failed = 1;
+  }
+  for (i = 0; i < num_inline && i < num_deferred; ++i) {
+    if (strcmp(inline_lines[i], deferred_lines[i]) != 0) {
+      fprintf(stderr, "json=%d: mismatch\n  inline:   %s  deferred: %s",
+              json, inline_lines[i], deferred_lines[i]);
+      failed = 1;
+    }
+  }
+  fclose(ctx[0].fp);
+  fclose(ctx[1].fp);
+  return failed;
+}
+
+/* Lines of more than half of CLOGGING_FD_ASYNC_RING_BYTES fit in the
+ * ring of a thread whose max_line_bytes allows them.
+ */
+static void *log_long_line(void *data) {
+  struct compare_context *ctx = (struct compare_context *)data;
+  static char long_string[LONG_LINE_BYTES + 1];
+  clogging_log_options_t opts = {
+    .color = 0,
+    .json = 0,
+    .prefix_fields_flag = CLOGGING_PREFIX_DEFAULT,
+    .async = 1,
+    .deferred = ctx->deferred,
+    .max_line_bytes = 65535
+  };
+
+  memset(long_string, 'x', LONG_LINE_BYTES);
+  clogging_fd_init("test_fd_async", "-long", LOG_LEVEL_INFO,
+                   clogging_create_handle_from_fd(fileno(ctx->fp)), &opts);
+  LOG_INFO("long line %s", long_string);
+  if (clogging_fd_flush(5000) != 0) {
+    fprintf(stderr, "flush timed out\n");
+  }
+  if (clogging_fd_get_num_dropped_messages() != 0 ||
+      clogging_fd_get_num_truncated_messages() != 0) {
+    fprintf(stderr, "deferred=%d: long line dropped or truncated\n",
+            ctx->deferred);
+    return (void *)1;
+  }
+  return NULL;
+}
+
+static int test_long_lines(void) {
+  struct compare_context ctx = {0, 0, tmpfile()};
+  pthread_t tid;
+  void *failed = NULL;
+  char *line = NULL;
+  size_t cap = 0;
+  int num_lines = 0;
+
+  if (ctx.fp == NULL) {
+    perror("tmpfile");
+    return 1;
+  }
+  for (ctx.deferred = 0; ctx.deferred <= 1 && failed == NULL;
+       ++ctx.deferred) {
+    pthread_create(&tid, NULL, log_long_line, &ctx);
+    pthread_join(tid, &failed);
+  }
+  rewind(ctx.fp);
+  while (getline(&line, &cap, ctx.fp) > 0) {
+    if (strstr(line, "long line ") != NULL &&
+        strlen(strstr(line, "long line ")) == 10 + LONG_LINE_BYTES + 1) {
+      ++num_lines;
+    }
+  }
+  free(line);
+  fclose(ctx.fp);
+  if (failed != NULL || num_lines != 2) {
+    fprintf(stderr, "%d long lines logged\n", num_lines);
+    return 1;
+  }
+  return 0;
+}
+
+/* JSON messages grow once escaped, which should grow the line just as
+ * for a longer message, or else count a truncation.
+ */
+static void *log_escaped_lines(void *data) {
+  struct compare_context *ctx = (struct compare_context *)data;
+  char quotes[NUM_QUOTES_TOO_MANY + 1] = {0};
+  clogging_log_options_t opts = {
+    .color = 0,
+    .json = 1,
+    .prefix_fields_flag = CLOGGING_PREFIX_DEFAULT,
+    .async = 1,
+    .deferred = ctx->deferred
+  };
+
+  memset(quotes, '"', NUM_QUOTES_TOO_MANY);
+  clogging_fd_init("test_fd_async", "-escaped", LOG_LEVEL_INFO,
+                   clogging_create_handle_from_fd(fileno(ctx->fp)), &opts);
+  LOG_INFO("escaped %s", &quotes[NUM_QUOTES_TOO_MANY - NUM_QUOTES]);
+  LOG_INFO("escaped %s", quotes);
+  if (clogging_fd_flush(5000) != 0) {
+    fprintf(stderr, "flush timed out\n");
+  }
+  if (clogging_fd_get_num_dropped_messages() != 0 ||
+      clogging_fd_get_num_truncated_messages() != 1) {
+    fprintf(stderr, "deferred=%d: %d escaped lines truncated\n",
+            ctx->deferred, (int)clogging_fd_get_num_truncated_messages());
+    return (void *)1;
+  }
+  return NULL;
+}
+
+static int test_escaped_lines(void) {
+  struct compare_context ctx = {1, 0, tmpfile()};
+  char expected[8 + 2 * NUM_QUOTES + 2] = "escaped ";
+  pthread_t tid;
+  void *failed = NULL;
+  char *line = NULL;
+  size_t cap = 0;
+  int num_lines = 0;
+  int i = 0;
+
+  if (ctx.fp == NULL) {
+    perror("tmpfile");
+    return 1;
+  }
+  for (i = 0; i < NUM_QUOTES; ++i) {
+    strcat(expected, "\\\"");
+  }
+  strcat(expected, "\"");
+  for (ctx.deferred = 0; ctx.deferred <= 1 && failed == NULL;
+       ++ctx.deferred) {
+    pthread_create(&tid, NULL, log_escaped_lines, &ctx);
+    pthread_join(tid, &failed);
+  }
+  rewind(ctx.fp);
+  while (getline(&line, &cap, ctx.fp) > 0) {
+    if (strstr(line, expected) != NULL) {
+      ++num_lines;
+    }
+  }
+  free(line);
+  fclose(ctx.fp);
+  if (failed != NULL || num_lines != 2) {
+    fprintf(stderr, "%d escaped lines logged in full\n", num_lines);
+    return 1;
+  }
+  return 0;
+}
+
+/* The fd is a pipe so every record is prefixed with its big-endian
+ * length. Count the records till the write end is closed.
+ */
+static void *read_records(void *data) {
+  struct reader_result *result = (struct reader_result *)data;
+  char buf[MAX_BUF_SIZE];
+  int used = 0;
+  int offset = 0;
+  int reclen = 0;
+  ssize_t n = 0;
+
+  for (;;) {
+    n = read(result->fd, &buf[used], sizeof(buf) - used);
+    if (n <= 0) {
+      break;
+    }
+    used += (int)n;
+    offset = 0;
+    while (used - offset >= 2) {
+      reclen = ((buf[offset] & 0x00ff) << 8) | (buf[offset + 1] & 0x00ff);
+      if (used - offset - 2 < reclen) {
+        break;
+      }
+      if (reclen == 0 || buf[offset + 2 + reclen - 1] != '\n' ||
+          memchr(&buf[offset + 2], '\n', reclen) !=
+              &buf[offset + 2 + reclen - 1]) {
+        ++result->num_bad_records;
+      }
+      ++result->num_records;
+      offset += 2 + reclen;
+    }
+    memmove(buf, &buf[offset], used - offset);
+    used -= offset;
+  }
+  return NULL;
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc; /* unused parameter */
+  (void)argv; /* unused parameter */
+
+  pthread_t tids[NUM_THREADS];
+  pthread_t reader;
+  struct context contexts[NUM_THREADS];
+  struct context exit_context = {NUM_THREADS, -1, 0};
+  struct reader_result result = {0, 0, 0};
+  uint64_t drops = 0;
+  int expected = 0;
+  int fds[2];
+  int i = 0;
+
+  /* while the writer thread is still running */
+  if (compare_deferred_output(0) != 0 || compare_deferred_output(1) != 0) {
+    return 1;
+  }
+  printf("deferred output matches inline output\n");
+  if (test_long_lines() != 0 || test_escaped_lines() != 0) {
+    return 1;
+  }
+
+  if (pipe(fds) != 0) {
+    perror("pipe");
+    return 1;
+  }
+  result.fd = fds[0];
+  pthread_create(&reader, NULL, read_records, &result);
+
+  /* a thread logging after its ring is released writes inline */
+  pthread_key_create(&g_exit_key, log_on_exit);
+  exit_context.fd = fds[1];
+  pthread_create(&tids[0], NULL, exit_work, &exit_context);
+  pthread_join(tids[0], NULL);
+
+  pthread_barrier_init(&g_barrier, NULL, NUM_THREADS + 1);
+  for (i = 0; i < NUM_THREADS; ++i) {
+    contexts[i].threadindex = i;
+    contexts[i].fd = fds[1];
+    contexts[i].drops = 0;
+    pthread_create(&tids[i], NULL, work, &contexts[i]);
+  }
+
+  /* everything committed before it returns is written, the rest is
+   * written inline
+   */
+  pthread_barrier_wait(&g_barrier);
+  clogging_fd_async_shutdown();
+  for (i = 0; i < NUM_THREADS; ++i) {
+    pthread_join(tids[i], NULL);
+    drops += contexts[i].drops;
+  }
+  pthread_barrier_destroy(&g_barrier);
+  close(fds[1]);
+  pthread_join(reader, NULL);
+  close(fds[0]);
+
+  expected = NUM_THREADS * NUM_LOOPS + 1 + g_num_exit_records - (int)drops;
+  printf("received %d records (%d malformed), expected %d\n",
+         result.num_records, result.num_bad_records, expected);
+  if (result.num_records != expected || result.num_bad_records != 0 ||
+      g_num_exit_records != NUM_EXIT_ROUNDS) {
+    return 1;
+  }
+  return 0;
+}
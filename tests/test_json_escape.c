@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#include "../src/json_escape.h"
+#include "../src/log_prefix.h"
+
+#include <stdio.h>
+#include <stdlib.h> /* rand() */
+#include <string.h> /* strcmp() */
+#include <time.h>   /* clock() */
+
+#define TIME_STR "2026-01-02T03:04:05+00:00"
+#define MAX_BUF_SIZE 1024
+#define NUM_BENCH_CALLS 2000000
+
+static size_t reference_scan(const char *s, size_t len) {
+  size_t i = 0;
+
+  for (i = 0; i < len; ++i) {
+    unsigned char c = (unsigned char)s[i];
+    if (c < 0x20 || c == '"' || c == '\\') {
+      break;
+    }
+  }
+  return i;
+}
+
+/* Put a single special byte at every position of strings of every
+ * length up to a few vector widths, over a background of bytes which
+ * are close to the special ones.
+ */
+static int test_scan(void) {
+  const char specials[] = {'"', '\\', '\0', '\n', 0x1f, 0x01};
+  const char plain[] = {' ', '!', '#', '[', ']', 'a', (char)0x7f, (char)0x80,
+                        (char)0xc3, (char)0xff};
+  char buf[160] = {0};
+  size_t len = 0;
+  size_t pos = 0;
+  size_t i = 0;
+  size_t k = 0;
+
+  for (len = 0; len <= 130; ++len) {
+    for (i = 0; i < len; ++i) {
+      buf[i] = plain[rand() % sizeof(plain)];
+    }
+    if (clogging_json_scan(buf, len) != len) {
+      fprintf(stderr, "false positive in %d plain bytes\n", (int)len);
+      return 1;
+    }
+    for (pos = 0; pos < len; ++pos) {
+      for (k = 0; k < sizeof(specials); ++k) {
+        char saved = buf[pos];
+
+        buf[pos] = specials[k];
+        if (clogging_json_scan(buf, len) != reference_scan(buf, len)) {
+          fprintf(stderr, "missed 0x%02x at %d of %d\n",
+                  (unsigned char)specials[k], (int)pos, (int)len);
+          return 1;
+        }
+        buf[pos] = saved;
+      }
+    }
+  }
+  return 0;
+}
+
+static int test_escape_char(void) {
+  char out[CLOGGING_JSON_MAX_ESCAPE_LEN + 1];
+  char expected[8];
+  int len = 0;
+  int c = 0;
+
+  for (c = 0; c < 0x20; ++c) {
+    switch (c) {
+    case '\b': strcpy(expected, "\\b"); break;
+    case '\f': strcpy(expected, "\\f"); break;
+    case '\n': strcpy(expected, "\\n"); break;
+    case '\r': strcpy(expected, "\\r"); break;
+    case '\t': strcpy(expected, "\\t"); break;
+    default: snprintf(expected, sizeof(expected), "\\u%04x", c); break;
+    }
+    len = clogging_json_escape_char((unsigned char)c, out);
+    out[len] = '\0';
+    if (strcmp(out, expected) != 0) {
+      fprintf(stderr, "0x%02x: expected [%s] got [%s]\n", c, expected, out);
+      return 1;
+    }
+  }
+  len = clogging_json_escape_char('"', out);
+  out[len] = '\0';
+  if (strcmp(out, "\\\"") != 0) {
+    return 1;
+  }
+  len = clogging_json_escape_char('\\', out);
+  out[len] = '\0';
+  return strcmp(out, "\\\\") != 0;
+}
+
+/* Every string of a JSON line is escaped, the identity ones at init */
+static int test_json_line(void) {
+  clogging_log_options_t opts = {0};
+  clogging_prefix_t prefix;
+  const char *expected =
+      "{\"progname\":\"my\\\"prog\",\"threadname\":\"\\tthr\","
+      "\"funcname\":\"fn\",\"message\":\"a \\\"quoted\\\" C:\\\\path\\n"
+      "\\u0001 \xc3\xa9 and the end\"}\n";
+  char buf[MAX_BUF_SIZE];
+  char small[27];
+  int len = 0;
+
+  opts.json = 1;
+  opts.prefix_fields_flag = CLOGGING_PREFIX_PROGNAME | CLOGGING_PREFIX_FUNCNAME;
+  clogging_prefix_init(&prefix, &opts, "host", "my\"prog", "\tthr", 42);
+  len = clogging_prefix_format(&prefix, buf, sizeof(buf), TIME_STR,
+                               (int)strlen(TIME_STR), LOG_LEVEL_INFO, "fn", 7,
+                               "a \"quoted\" C:\\path\n\x01 \xc3\xa9 and the end");
+  if (len != (int)strlen(expected) || strcmp(buf, expected) != 0) {
+    fprintf(stderr, "expected [%s] got [%s]\n", expected, buf);
+    return 1;
+  }
+
+  /* "{\"message\":\"" is 12 bytes and "\"}\n" 3 more, which leaves room
+   * for 11 bytes of the message, and "\\u0001" would not fit after
+   * "abcdefghi"
+   */
+  opts.prefix_fields_flag = 0;
+  clogging_prefix_init(&prefix, &opts, "host", "prog", "-thr", 42);
+  len = clogging_prefix_format(&prefix, small, sizeof(small), TIME_STR,
+                               (int)strlen(TIME_STR), LOG_LEVEL_INFO, "fn", 7,
+                               "abcdefghi\x01xyz");
+  if (strcmp(small, "{\"message\":\"abcdefghi\"}\n") != 0) {
+    fprintf(stderr, "split escape sequence [%s]\n", small);
+    return 1;
+  }
+  return 0;
+}
+
+static double bench(uint8_t json, const char *msg) {
+  clogging_log_options_t opts = {0};
+  clogging_prefix_t prefix;
+  char buf[MAX_BUF_SIZE];
+  clock_t start;
+  long checksum = 0;
+  int i = 0;
+
+  opts.json = json;
+  opts.prefix_fields_flag = CLOGGING_PREFIX_DEFAULT;
+  clogging_prefix_init(&prefix, &opts, "host", "prog", "-thr", 42);
+  start = clock();
+  for (i = 0; i < NUM_BENCH_CALLS; ++i) {
+    checksum += clogging_prefix_format(&prefix, buf, sizeof(buf), TIME_STR,
+                                       (int)strlen(TIME_STR), LOG_LEVEL_INFO,
+                                       "handle_request", i, msg);
+  }
+  if (checksum == 0) {
+    printf("unexpected checksum\n");
+  }
+  return (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / NUM_BENCH_CALLS;
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc; /* unused parameter */
+  (void)argv; /* unused parameter */
+
+  const char *msg = "served GET /api/v1/items?page=2 for 10.0.0.7 in 1532 us "
+                    "with status 200 and 18342 bytes";
+  double text_ns = 0.0;
+  double json_ns = 0.0;
+
+  if (test_scan() != 0 || test_escape_char() != 0 || test_json_line() != 0) {
+    return 1;
+  }
+  text_ns = bench(0, msg);
+  json_ns = bench(1, msg);
+  printf("text: %.1f ns/line, escaped JSON: %.1f ns/line\n", text_ns, json_ns);
+  return 0;
+}
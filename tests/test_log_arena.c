@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#include "../src/log_arena.h"
+#include "fd_logging.h"
+
+#include <stdio.h>
+#include <string.h> /* memset(), strlen() */
+
+#define MAX_LINE_BYTES 8192
+#define LONG_MSG_LEN 3000
+
+static char g_long_msg[LONG_MSG_LEN + 1];
+static char g_huge_msg[2 * MAX_LINE_BYTES];
+static char g_line[2 * MAX_LINE_BYTES];
+
+/* The buffer starts small and doubles up to the limit */
+static int test_growth(void) {
+  clogging_arena_t arena = {0};
+  const int expected[][2] = {
+      {1, CLOGGING_ARENA_MIN_BYTES},
+      {CLOGGING_ARENA_MIN_BYTES, CLOGGING_ARENA_MIN_BYTES},
+      {CLOGGING_ARENA_MIN_BYTES + 1, 2 * CLOGGING_ARENA_MIN_BYTES},
+      {900, CLOGGING_DEFAULT_MAX_LINE_BYTES},
+      {5000, CLOGGING_DEFAULT_MAX_LINE_BYTES},
+      {10, CLOGGING_DEFAULT_MAX_LINE_BYTES},
+  };
+  size_t i = 0;
+  int size = 0;
+
+  if (clogging_arena_max_bytes(0) != CLOGGING_DEFAULT_MAX_LINE_BYTES ||
+      clogging_arena_max_bytes(1u << 20) != CLOGGING_MAX_LINE_BYTES) {
+    fprintf(stderr, "unexpected limits\n");
+    return 1;
+  }
+  clogging_arena_init(&arena, 0);
+  for (i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+    size = clogging_arena_reserve(&arena, expected[i][0]);
+    if (size != expected[i][1] || arena.buf == NULL) {
+      fprintf(stderr, "reserve %d: expected %d got %d\n", expected[i][0],
+                      expected[i][1], size);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* A message longer than MAX_LOG_MSG_LEN makes it to the line in full,
+ * and one beyond max_line_bytes is cut off and counted.
+ */
+static int test_fd_long_lines(void) {
+  clogging_log_options_t opts = {
+    .prefix_fields_flag = CLOGGING_PREFIX_LOGLEVEL,
+    .max_line_bytes = MAX_LINE_BYTES
+  };
+  FILE *fp = tmpfile();
+  size_t len = 0;
+  int failed = 0;
+
+  if (fp == NULL) {
+    perror("tmpfile");
+    return 1;
+  }
+  memset(g_long_msg, 'l', LONG_MSG_LEN);
+  memset(g_huge_msg, 'h', sizeof(g_huge_msg) - 1);
+  clogging_fd_init("test_log_arena", "", LOG_LEVEL_INFO,
+                   clogging_create_handle_from_fd(fileno(fp)), &opts);
+  clogging_fd_logmsg(__func__, __LINE__, LOG_LEVEL_INFO, "%s", "short");
+  clogging_fd_logmsg(__func__, __LINE__, LOG_LEVEL_INFO, "%s", g_long_msg);
+  if (clogging_fd_get_num_truncated_messages() != 0) {
+    fprintf(stderr, "unexpected truncation\n");
+    failed = 1;
+  }
+  clogging_fd_logmsg(__func__, __LINE__, LOG_LEVEL_INFO, "%s", g_huge_msg);
+  if (clogging_fd_get_num_truncated_messages() != 1) {
+    fprintf(stderr, "truncation is not counted\n");
+    failed = 1;
+  }
+
+  /* " INFO " <message> "\n" */
+  rewind(fp);
+  if (fgets(g_line, sizeof(g_line), fp) == NULL ||
+      strcmp(g_line, " INFO short\n") != 0) {
+    fprintf(stderr, "unexpected line [%s]\n", g_line);
+    failed = 1;
+  }
+  if (fgets(g_line, sizeof(g_line), fp) == NULL ||
+      strlen(g_line) != 6 + LONG_MSG_LEN + 1 ||
+      strncmp(&g_line[6], g_long_msg, LONG_MSG_LEN) != 0) {
+    fprintf(stderr, "long line has %d bytes\n", (int)strlen(g_line));
+    failed = 1;
+  }
+  len = (fgets(g_line, sizeof(g_line), fp) != NULL) ? strlen(g_line) : 0;
+  if (len != MAX_LINE_BYTES - 1 || g_line[len - 1] != '\n') {
+    fprintf(stderr, "truncated line has %d bytes\n", (int)len);
+    failed = 1;
+  }
+  fclose(fp);
+  return failed;
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc; /* unused parameter */
+  (void)argv; /* unused parameter */
+
+  int failed = 0;
+
+  failed |= test_growth();
+  failed |= test_fd_long_lines();
+  return failed;
+}
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#include "../src/binary_logging.h"
+#include "../src/fd_logging.h"
+#include "../src/log_clock.h"
+
+#include <stdio.h>
+#include <string.h> /* strcmp() */
+
+#define MAX_BUF_SIZE 4096
+
+static int test_format(void) {
+  /* 2026-01-02T03:04:05 plus a fraction */
+  clogging_timestamp_t ts = {1767323045, 123456789};
+  const char *expected[] = {
+      "2026-01-02T03:04:05+00:00",
+      "2026-01-02T03:04:05.123+00:00",
+      "2026-01-02T03:04:05.123456+00:00",
+      "2026-01-02T03:04:05.123456789+00:00",
+  };
+  char timestr[CLOGGING_MAX_TIME_STR_LEN];
+  char shortstr[24];
+  uint8_t precision = 0;
+  int failed = 0;
+  int len = 0;
+
+  for (precision = CLOGGING_TIME_PRECISION_SEC;
+       precision <= CLOGGING_TIME_PRECISION_NS; ++precision) {
+    len = clogging_timestamp_to_cstr(&ts, precision, timestr,
+                                     (int)sizeof(timestr));
+    if (len != (int)strlen(expected[precision]) ||
+        strcmp(timestr, expected[precision]) != 0) {
+      fprintf(stderr, "precision %d: expected [%s] got [%s]\n", precision,
+              expected[precision], timestr);
+      failed = 1;
+    }
+  }
+  /* truncates like snprintf() */
+  len = clogging_timestamp_to_cstr(&ts, CLOGGING_TIME_PRECISION_US, shortstr,
+                                   (int)sizeof(shortstr));
+  if (len != (int)strlen(expected[CLOGGING_TIME_PRECISION_US]) ||
+      strncmp(shortstr, expected[CLOGGING_TIME_PRECISION_US],
+              sizeof(shortstr) - 1) != 0) {
+    fprintf(stderr, "truncation: got [%s] len %d\n", shortstr, len);
+    failed = 1;
+  }
+  return failed;
+}
+
+static int test_units(void) {
+  clogging_timestamp_t ts = {-2, 250000000}; /* -1.75 s */
+  clogging_timestamp_t back;
+  int failed = 0;
+
+  if (clogging_timestamp_to_units(&ts, CLOGGING_TIME_PRECISION_MS) != -1750) {
+    fprintf(stderr, "unexpected ms for pre-Epoch time\n");
+    failed = 1;
+  }
+  clogging_timestamp_from_units(-1750, CLOGGING_TIME_PRECISION_MS, &back);
+  if (back.sec != ts.sec || back.nsec != ts.nsec) {
+    fprintf(stderr, "ms round trip gave %lld.%09u\n", (long long)back.sec,
+            back.nsec);
+    failed = 1;
+  }
+  clogging_timestamp_from_units(1767323045123456789LL,
+                                CLOGGING_TIME_PRECISION_NS, &back);
+  if (back.sec != 1767323045 || back.nsec != 123456789) {
+    fprintf(stderr, "ns round trip gave %lld.%09u\n", (long long)back.sec,
+            back.nsec);
+    failed = 1;
+  }
+  return failed;
+}
+
+static long long diff_ms(const clogging_timestamp_t *a,
+                         const clogging_timestamp_t *b) {
+  return (a->sec - b->sec) * 1000LL +
+         ((long long)a->nsec - (long long)b->nsec) / 1000000LL;
+}
+
+static int test_sources(void) {
+  clogging_tsc_calibration_t cal;
+  clogging_timestamp_t realtime;
+  clogging_timestamp_t other;
+  clogging_timestamp_t prev = {0, 0};
+  int failed = 0;
+  int i = 0;
+
+  clogging_clock_now(CLOGGING_CLOCK_REALTIME, &realtime);
+  clogging_clock_now(CLOGGING_CLOCK_REALTIME_COARSE, &other);
+  if (diff_ms(&other, &realtime) > 100 || diff_ms(&other, &realtime) < -100) {
+    fprintf(stderr, "coarse clock is off by %lld ms\n",
+            diff_ms(&other, &realtime));
+    failed = 1;
+  }
+
+  if (clogging_clock_get_tsc_calibration(&cal) != 0) {
+    printf("no usable cycle counter, TSC falls back to CLOCK_REALTIME\n");
+  } else {
+    printf("cycle counter runs at %llu ticks/s\n",
+           (unsigned long long)cal.ticks_per_sec);
+  }
+  /* with or without a cycle counter the result is wall clock time */
+  for (i = 0; i < 1000; ++i) {
+    clogging_clock_now(CLOGGING_CLOCK_TSC, &other);
+    if (i > 0 && diff_ms(&other, &prev) < 0) {
+      fprintf(stderr, "TSC clock went backwards\n");
+      failed = 1;
+      break;
+    }
+    prev = other;
+  }
+  clogging_clock_now(CLOGGING_CLOCK_REALTIME, &realtime);
+  if (diff_ms(&other, &realtime) > 50 || diff_ms(&other, &realtime) < -50) {
+    fprintf(stderr, "TSC clock is off by %lld ms\n", diff_ms(&other, &realtime));
+    failed = 1;
+  }
+  return failed;
+}
+
+/* The timestamp of a text line carries the configured fraction */
+static int test_fd_precision(void) {
+  clogging_log_options_t opts = {
+    .prefix_fields_flag = CLOGGING_PREFIX_DEFAULT,
+    .clock_source = CLOGGING_CLOCK_REALTIME,
+    .time_precision = CLOGGING_TIME_PRECISION_MS
+  };
+  char line[MAX_BUF_SIZE] = {0};
+  FILE *fp = tmpfile();
+  int failed = 0;
+
+  if (fp == NULL) {
+    perror("tmpfile");
+    return 1;
+  }
+  clogging_fd_init("test_log_clock", "", LOG_LEVEL_INFO,
+                   clogging_create_handle_from_fd(fileno(fp)), &opts);
+  clogging_fd_logmsg(__func__, __LINE__, LOG_LEVEL_INFO, "hello");
+  rewind(fp);
+  if (fgets(line, sizeof(line), fp) == NULL || line[19] != '.' ||
+      strncmp(&line[23], "+00:00 ", 7) != 0) {
+    fprintf(stderr, "unexpected line [%s]\n", line);
+    failed = 1;
+  }
+  fclose(fp);
+  return failed;
+}
+
+#ifndef _WIN32
+/* Binary logging writes the CLOCK frame first and then records whose
+ * timestamp is to be read with it.
+ */
+static int test_binary_clock_frame(uint8_t source) {
+  clogging_log_options_t opts = {
+    .clock_source = source,
+    .time_precision = CLOGGING_TIME_PRECISION_US
+  };
+  clogging_shm_ring_t *ring = clogging_shm_ring_create(NULL, 64 * 1024);
+  clogging_tsc_calibration_t cal;
+  clogging_timestamp_t logged;
+  clogging_timestamp_t now;
+  char buf[MAX_BUF_SIZE];
+  unsigned long long val = 0;
+  ssize_t n = 0;
+  int offset = 0;
+  int i = 0;
+  uint8_t frame_source = 0;
+  int failed = 0;
+
+  if (ring == NULL) {
+    perror("clogging_shm_ring_create");
+    return 1;
+  }
+  clogging_binary_init_shm("test_log_clock", "", LOG_LEVEL_INFO, ring, &opts);
+  clogging_binary_logmsg(__FILE__, __func__, __LINE__, LOG_LEVEL_INFO,
+                         "hello %d", 1);
+
+  /* <length> <header> <0x81> <source> <0x81> <precision> [calibration] */
+  n = clogging_shm_ring_read(ring, buf, sizeof(buf), 0);
+  if (n < 7 || !CLOGGING_BINARY_IS_FRAME(buf[2]) ||
+      CLOGGING_BINARY_FRAME_TYPE_OF(buf[2]) != CLOGGING_BINARY_FRAME_CLOCK ||
+      (buf[6] & 0x00ff) != CLOGGING_TIME_PRECISION_US) {
+    fprintf(stderr, "missing CLOCK frame\n");
+    clogging_shm_ring_close(ring);
+    return 1;
+  }
+  frame_source = buf[4] & 0x00ff;
+  if (frame_source == CLOGGING_CLOCK_TSC) {
+    uint64_t *fields[] = {&cal.ticks_per_sec, &cal.base_ticks,
+                          (uint64_t *)&cal.base_sec};
+
+    offset = 7;
+    for (i = 0; i < 3; ++i) {
+      offset += 1;
+      *fields[i] = 0;
+      for (n = 0; n < 8; ++n) {
+        *fields[i] = (*fields[i] << 8) | (buf[offset++] & 0x00ff);
+      }
+    }
+    offset += 1;
+    cal.base_nsec = 0;
+    for (n = 0; n < 4; ++n) {
+      cal.base_nsec = (cal.base_nsec << 8) | (buf[offset++] & 0x00ff);
+    }
+  }
+
+  /* <length> <0x88> <timestamp> ... */
+  n = clogging_shm_ring_read(ring, buf, sizeof(buf), 0);
+  if (n < 11 || (buf[2] & 0x00ff) != (0x80 | 8)) {
+    fprintf(stderr, "unexpected record\n");
+    clogging_shm_ring_close(ring);
+    return 1;
+  }
+  for (i = 0; i < 8; ++i) {
+    val = (val << 8) | (buf[3 + i] & 0x00ff);
+  }
+  if (frame_source == CLOGGING_CLOCK_TSC) {
+    clogging_clock_ticks_to_timestamp(&cal, val, &logged);
+  } else {
+    clogging_timestamp_from_units((int64_t)val, CLOGGING_TIME_PRECISION_US,
+                                  &logged);
+  }
+  clogging_clock_now(CLOGGING_CLOCK_REALTIME, &now);
+  if (diff_ms(&now, &logged) > 1000 || diff_ms(&now, &logged) < -50) {
+    fprintf(stderr, "source %d: logged time is off by %lld ms\n", source,
+            diff_ms(&now, &logged));
+    failed = 1;
+  }
+  clogging_shm_ring_close(ring);
+  return failed;
+}
+#endif /* _WIN32 */
+
+int main(int argc, char *argv[]) {
+  (void)argc; /* unused parameter */
+  (void)argv; /* unused parameter */
+
+  int failed = 0;
+
+  failed |= test_format();
+  failed |= test_units();
+  failed |= test_sources();
+  failed |= test_fd_precision();
+#ifndef _WIN32
+  failed |= test_binary_clock_frame(CLOGGING_CLOCK_TSC);
+#endif /* _WIN32 */
+  if (!failed) {
+    printf("all clock tests passed\n");
+  }
+  return failed;
+}
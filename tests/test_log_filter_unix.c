@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef _WIN32
+#error This file is for non-Windows platforms only
+#endif /* _WIN32 */
+
+#define CLOGGING_MODULE "net.tcp"
+
+#include "../src/binary_logging.h"
+#include "../src/fd_logging.h"
+#include "../src/log_filter.h"
+
+#include <fcntl.h>   /* open() */
+#include <pthread.h> /* pthread_create() and friends */
+#include <stdio.h>
+#include <unistd.h>  /* close() */
+
+#define NUM_WORKERS 4
+#define NUM_SPIN_MESSAGES 20000
+/* the changes of the filters which take the 24-bit epoch, which skips 0,
+ * back to where it was
+ */
+#define EPOCH_CYCLE ((1 << 24) - 1)
+
+static int g_evaluations = 0;
+
+static int count(void) { return ++g_evaluations; }
+
+/* The call sites below are called again and again, so that their cache
+ * has to follow every change of the filters.
+ */
+static int debug_site(void) {
+  int before = g_evaluations;
+
+  FD_LOG_DEBUG("debug %d", count());
+  BINARY_LOG_DEBUG("debug %d", count());
+  return (g_evaluations - before) / 2;
+}
+
+static int info_site(void) {
+  int before = g_evaluations;
+
+  FD_LOG_INFO("info %d", count());
+  BINARY_LOG_INFO("info %d", count());
+  return (g_evaluations - before) / 2;
+}
+
+static int g_failed = 0;
+
+static void expect(const char *what, int got, int enabled,
+                   enum LogLevel level) {
+  /* messages compiled out stay compiled out */
+  int expected = enabled && level <= CLOGGING_MIN_LEVEL;
+
+  if (got != expected) {
+    fprintf(stderr, "%s: %s, expected %s\n", what,
+            got ? "enabled" : "disabled", expected ? "enabled" : "disabled");
+    g_failed = 1;
+  }
+}
+
+static void expect_debug(const char *what, int enabled) {
+  expect(what, debug_site(), enabled, LOG_LEVEL_DEBUG);
+}
+
+static void expect_info(const char *what, int enabled) {
+  expect(what, info_site(), enabled, LOG_LEVEL_INFO);
+}
+
+static void *spin(void *data) {
+  int fd = *(int *)data;
+  int i = 0;
+
+  clogging_fd_init("test_log_filter", "-worker", LOG_LEVEL_INFO,
+                   clogging_create_handle_from_fd(fd), NULL);
+  clogging_binary_init("test_log_filter", "-worker", LOG_LEVEL_INFO,
+                       clogging_create_handle_from_fd(fd), NULL);
+  for (i = 0; i < NUM_SPIN_MESSAGES; ++i) {
+    FD_LOG_DEBUG("spin %d", i);
+    BINARY_LOG_DEBUG("spin %d", i);
+  }
+  return NULL;
+}
+
+int main(int argc, char *argv[]) {
+  pthread_t tids[NUM_WORKERS];
+  int fd = open("/dev/null", O_WRONLY);
+  int i = 0;
+
+  (void)argc;
+  (void)argv;
+  if (fd < 0) {
+    perror("open");
+    return 1;
+  }
+  clogging_fd_init("test_log_filter", "", LOG_LEVEL_INFO,
+                   clogging_create_handle_from_fd(fd), NULL);
+  clogging_binary_init("test_log_filter", "", LOG_LEVEL_INFO,
+                       clogging_create_handle_from_fd(fd), NULL);
+
+  expect_debug("no filters", 0);
+  expect_info("no filters", 1);
+
+  /* modules match by whole components */
+  clogging_filter_set(CLOGGING_FILTER_MODULE, "net", LOG_LEVEL_DEBUG);
+  expect_debug("module net", 1);
+  clogging_filter_clear();
+  expect_debug("after clear", 0);
+  clogging_filter_set(CLOGGING_FILTER_MODULE, "ne", LOG_LEVEL_DEBUG);
+  expect_debug("module ne", 0);
+  clogging_filter_set(CLOGGING_FILTER_MODULE, "net.tcp.syn", LOG_LEVEL_DEBUG);
+  expect_debug("module net.tcp.syn", 0);
+  clogging_filter_set(CLOGGING_FILTER_MODULE, "net.tcp", LOG_LEVEL_DEBUG);
+  expect_debug("module net.tcp", 1);
+  clogging_filter_clear();
+
+  /* files match by whole path components */
+  clogging_filter_set(CLOGGING_FILTER_FILE, "est", LOG_LEVEL_DEBUG);
+  expect_debug("file est", 0);
+  clogging_filter_set(CLOGGING_FILTER_FILE, "tests", LOG_LEVEL_DEBUG);
+  expect_debug("file tests", 1);
+  clogging_filter_clear();
+  clogging_filter_set(CLOGGING_FILTER_FILE, "tests/test_log_filter_unix.c",
+                      LOG_LEVEL_DEBUG);
+  expect_debug("file tests/test_log_filter_unix.c", 1);
+  clogging_filter_clear();
+
+  /* functions match by name */
+  clogging_filter_set(CLOGGING_FILTER_FUNCTION, "debug_sit", LOG_LEVEL_DEBUG);
+  expect_debug("function debug_sit", 0);
+  clogging_filter_set(CLOGGING_FILTER_FUNCTION, "debug_site",
+                      LOG_LEVEL_DEBUG);
+  expect_debug("function debug_site", 1);
+  expect_info("function debug_site", 1);
+  clogging_filter_clear();
+
+  /* a filter lowers the level as well */
+  clogging_filter_set(CLOGGING_FILTER_MODULE, "net", LOG_LEVEL_WARN);
+  expect_info("module net at WARN", 0);
+
+  /* the longest match of a kind wins, then the most specific kind */
+  clogging_filter_set(CLOGGING_FILTER_MODULE, "net.tcp", LOG_LEVEL_DEBUG);
+  expect_debug("module net.tcp over net", 1);
+  clogging_filter_set(CLOGGING_FILTER_FILE, "tests", LOG_LEVEL_ERROR);
+  expect_debug("file over module", 0);
+  expect_info("file over module", 0);
+  clogging_filter_set(CLOGGING_FILTER_FUNCTION, "info_site", LOG_LEVEL_INFO);
+  expect_info("function over file", 1);
+  expect_debug("function info_site", 0);
+
+  /* which a removal undoes */
+  if (clogging_filter_remove(CLOGGING_FILTER_FILE, "tests") != 0) {
+    fprintf(stderr, "removing file tests failed\n");
+    g_failed = 1;
+  }
+  expect_debug("module net.tcp after removal", 1);
+  clogging_filter_remove(CLOGGING_FILTER_MODULE, "net.tcp");
+  expect_debug("module net after removal", 0);
+  expect_info("function info_site after removal", 1);
+
+  /* the same filter again replaces its level */
+  clogging_filter_set(CLOGGING_FILTER_MODULE, "net", LOG_LEVEL_DEBUG);
+  expect_debug("module net again", 1);
+
+  if (clogging_filter_remove(CLOGGING_FILTER_FILE, "tests") != -1 ||
+      clogging_filter_set(3, "net", LOG_LEVEL_DEBUG) != -1 ||
+      clogging_filter_set(CLOGGING_FILTER_MODULE, NULL, LOG_LEVEL_DEBUG) !=
+          -1) {
+    fprintf(stderr, "bad filters accepted\n");
+    g_failed = 1;
+  }
+
+  /* without filters the level of the thread holds again */
+  clogging_filter_clear();
+  expect_debug("after clear", 0);
+  clogging_fd_set_loglevel(LOG_LEVEL_DEBUG);
+  clogging_binary_set_loglevel(LOG_LEVEL_DEBUG);
+  expect_debug("thread at DEBUG", 1);
+  clogging_filter_set(CLOGGING_FILTER_MODULE, "net", LOG_LEVEL_INFO);
+  expect_debug("module net over the thread", 0);
+  clogging_filter_clear();
+
+  /* a site cached at the epoch the filters come back to after the epoch
+   * has wrapped around is not taken as fresh
+   */
+  clogging_fd_set_loglevel(LOG_LEVEL_INFO);
+  clogging_binary_set_loglevel(LOG_LEVEL_INFO);
+  clogging_filter_set(CLOGGING_FILTER_MODULE, "net", LOG_LEVEL_DEBUG);
+  expect_debug("module net before the wrap", 1);
+  for (i = 0; i < EPOCH_CYCLE; ++i) {
+    clogging_filter_clear();
+  }
+  expect_debug("no filters after the wrap", 0);
+
+  /* change the filters while other threads log through them */
+  for (i = 0; i < NUM_WORKERS; ++i) {
+    pthread_create(&tids[i], NULL, spin, &fd);
+  }
+  for (i = 0; i < 1000; ++i) {
+    clogging_filter_set(CLOGGING_FILTER_MODULE, "net",
+                        i % 2 ? LOG_LEVEL_DEBUG : LOG_LEVEL_INFO);
+  }
+  for (i = 0; i < NUM_WORKERS; ++i) {
+    pthread_join(tids[i], NULL);
+  }
+  expect_debug("module net at DEBUG", 1);
+  clogging_filter_clear();
+
+  close(fd);
+  return g_failed;
+}
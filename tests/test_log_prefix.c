@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#include "../src/log_prefix.h"
+
+#include <stdio.h>
+#include <string.h> /* strcmp() */
+
+#define TIME_STR "2026-01-02T03:04:05+00:00"
+#define MAX_BUF_SIZE 1024
+
+struct layout {
+  uint8_t json;
+  uint8_t fields;
+  const char *funcname;
+  const char *expected;
+};
+
+static const struct layout g_layouts[] = {
+    {0, CLOGGING_PREFIX_DEFAULT, "fn",
+     TIME_STR " host prog-thr[42] INFO fn(7): hello\n"},
+    {1, CLOGGING_PREFIX_DEFAULT, "fn",
+     "{\"timestamp\":\"" TIME_STR "\", \"hostname\":\"host\", "
+     "\"progname\":\"prog\", \"threadname\":\"-thr\", \"pid\":42, "
+     "\"level\":\"INFO\", \"funcname\":\"fn\", \"linenum\":7, "
+     "\"message\":\"hello\"}\n"},
+    {0, 0, "fn", "hello\n"},
+    {1, 0, "fn", "{\"message\":\"hello\"}\n"},
+    {0, CLOGGING_PREFIX_TIMESTAMP, "fn", TIME_STR "  hello\n"},
+    {0, CLOGGING_PREFIX_PROGNAME | CLOGGING_PREFIX_LOGLEVEL, "fn",
+     "prog-thr INFO hello\n"},
+    {0, CLOGGING_PREFIX_PID | CLOGGING_PREFIX_FUNCNAME, "fn",
+     "-thr[42] fn: hello\n"},
+    {0, CLOGGING_PREFIX_FUNCNAME, "", "hello\n"},
+    {0, CLOGGING_PREFIX_LINENUM, "fn", "(7): hello\n"},
+    {1, CLOGGING_PREFIX_HOSTNAME | CLOGGING_PREFIX_PID, "fn",
+     "{\"hostname\":\"host\",\"threadname\":\"-thr\",\"pid\":42,"
+     "\"message\":\"hello\"}\n"},
+    {1, CLOGGING_PREFIX_TIMESTAMP | CLOGGING_PREFIX_LINENUM, "fn",
+     "{\"timestamp\":\"" TIME_STR "\",\"linenum\":7,\"message\":\"hello\"}\n"},
+};
+
+static int test_layouts(void) {
+  clogging_log_options_t opts = {0};
+  clogging_prefix_t prefix;
+  char buf[MAX_BUF_SIZE];
+  size_t i = 0;
+  int failed = 0;
+  int len = 0;
+
+  for (i = 0; i < sizeof(g_layouts) / sizeof(g_layouts[0]); ++i) {
+    opts.json = g_layouts[i].json;
+    opts.prefix_fields_flag = g_layouts[i].fields;
+    clogging_prefix_init(&prefix, &opts, "host", "prog", "-thr", 42);
+    len = clogging_prefix_format(&prefix, buf, sizeof(buf), TIME_STR,
+                                 (int)strlen(TIME_STR), LOG_LEVEL_INFO,
+                                 g_layouts[i].funcname, 7, "hello");
+    if (len != (int)strlen(g_layouts[i].expected) ||
+        strcmp(buf, g_layouts[i].expected) != 0) {
+      fprintf(stderr, "layout %d: expected [%s] got [%s]\n", (int)i,
+              g_layouts[i].expected, buf);
+      failed = 1;
+    }
+  }
+  return failed;
+}
+
+/* Every layout compiles to a plan in which the literals between two
+ * fields are merged into a single step.
+ */
+static int test_plans(void) {
+  clogging_log_options_t opts = {0};
+  clogging_prefix_t prefix;
+  int fields = 0;
+  int json = 0;
+  int i = 0;
+
+  for (json = 0; json <= 1; ++json) {
+    for (fields = 0; fields <= CLOGGING_PREFIX_DEFAULT; ++fields) {
+      opts.json = (uint8_t)json;
+      opts.prefix_fields_flag = (uint8_t)fields;
+      clogging_prefix_init(&prefix, &opts, "host", "prog", "-thr", 42);
+      for (i = 1; i < prefix.num_steps; ++i) {
+        if (prefix.steps[i].kind == CLOGGING_PREFIX_STEP_LITERAL &&
+            prefix.steps[i - 1].kind == CLOGGING_PREFIX_STEP_LITERAL) {
+          fprintf(stderr, "fields 0x%02x json %d: unmerged literals\n",
+                  fields, json);
+          return 1;
+        }
+      }
+    }
+  }
+  /* <timestamp> " host prog-thr[42] " <level> " " <funcname> "(" <linenum>
+   * "): " <message> "\n"
+   */
+  opts.json = 0;
+  opts.prefix_fields_flag = CLOGGING_PREFIX_DEFAULT;
+  clogging_prefix_init(&prefix, &opts, "host", "prog", "-thr", 42);
+  if (prefix.num_steps != 10) {
+    fprintf(stderr, "default layout has %d steps\n", prefix.num_steps);
+    return 1;
+  }
+  return 0;
+}
+
+/* A line which does not fit is cut off and still '\0' terminated */
+static int test_truncation(void) {
+  clogging_log_options_t opts = {0};
+  clogging_prefix_t prefix;
+  char buf[16];
+  int len = 0;
+
+  opts.prefix_fields_flag = CLOGGING_PREFIX_DEFAULT;
+  clogging_prefix_init(&prefix, &opts, "host", "prog", "-thr", 42);
+  len = clogging_prefix_format(&prefix, buf, sizeof(buf), TIME_STR,
+                               (int)strlen(TIME_STR), LOG_LEVEL_INFO, "fn", 7,
+                               "hello");
+  if (len != (int)sizeof(buf) - 1 || strcmp(buf, "2026-01-02T03:0") != 0) {
+    fprintf(stderr, "unexpected truncation [%s] len %d\n", buf, len);
+    return 1;
+  }
+  return 0;
+}
+
+/* The message is formatted in place between the two halves of the line,
+ * and a long one is cut off before the end of the line rather than the
+ * end of the line being cut off.
+ */
+static int test_in_place(void) {
+  clogging_log_options_t opts = {0};
+  clogging_prefix_t prefix;
+  const char *msg = "a message too long to fit";
+  char buf[32];
+  int msg_room = 0;
+  int msg_needed = 0;
+  int pos = 0;
+  int len = 0;
+
+  opts.prefix_fields_flag = CLOGGING_PREFIX_LOGLEVEL;
+  clogging_prefix_init(&prefix, &opts, "host", "prog", "-thr", 42);
+  pos = clogging_prefix_format_begin(&prefix, buf, sizeof(buf), TIME_STR,
+                                     (int)strlen(TIME_STR), LOG_LEVEL_INFO,
+                                     "fn", 7, &msg_room);
+  /* " INFO " and "\n" */
+  if (pos != 6 || msg_room != (int)sizeof(buf) - 1 - 6 - 1) {
+    fprintf(stderr, "unexpected message at %d with room %d\n", pos, msg_room);
+    return 1;
+  }
+  len = (int)strlen(msg);
+  if (len > msg_room) {
+    len = msg_room;
+  }
+  memcpy(&buf[pos], msg, (size_t)len);
+  len = clogging_prefix_format_end(&prefix, buf, sizeof(buf), pos, len,
+                                   &msg_needed);
+  if (len != (int)sizeof(buf) - 1 || msg_needed != msg_room ||
+      strcmp(buf, " INFO a message too long to fi\n") != 0) {
+    fprintf(stderr, "unexpected line [%s] len %d\n", buf, len);
+    return 1;
+  }
+
+  /* the escaped message grows in place */
+  opts.json = 1;
+  opts.prefix_fields_flag = 0;
+  clogging_prefix_init(&prefix, &opts, "host", "prog", "-thr", 42);
+  pos = clogging_prefix_format_begin(&prefix, buf, sizeof(buf), TIME_STR,
+                                     (int)strlen(TIME_STR), LOG_LEVEL_INFO,
+                                     "fn", 7, &msg_room);
+  memcpy(&buf[pos], "\"a\"\nb", 5);
+  len = clogging_prefix_format_end(&prefix, buf, sizeof(buf), pos, 5,
+                                   &msg_needed);
+  if (msg_needed != 8 ||
+      strcmp(buf, "{\"message\":\"\\\"a\\\"\\nb\"}\n") != 0) {
+    fprintf(stderr, "unexpected line [%s] len %d\n", buf, len);
+    return 1;
+  }
+
+  /* and is cut off when it no longer fits, telling how much it needed */
+  pos = clogging_prefix_format_begin(&prefix, buf, sizeof(buf), TIME_STR,
+                                     (int)strlen(TIME_STR), LOG_LEVEL_INFO,
+                                     "fn", 7, &msg_room);
+  memcpy(&buf[pos], "\"\"\"\"\"\"\"\"\"\"", 10);
+  len = clogging_prefix_format_end(&prefix, buf, sizeof(buf), pos, 10,
+                                   &msg_needed);
+  if (msg_room != 16 || msg_needed != 20 ||
+      strcmp(buf, "{\"message\":\""
+                  "\\\"\\\"\\\"\\\"\\\"\\\"\\\"\\\"\"}\n") != 0) {
+    fprintf(stderr, "unexpected line [%s] len %d needed %d\n", buf, len,
+            msg_needed);
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc; /* unused parameter */
+  (void)argv; /* unused parameter */
+
+  int failed = 0;
+
+  failed |= test_layouts();
+  failed |= test_plans();
+  failed |= test_truncation();
+  failed |= test_in_place();
+  return failed;
+}
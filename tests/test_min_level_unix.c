@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef _WIN32
+#error This file is for non-Windows platforms only
+#endif /* _WIN32 */
+
+/* keep ERROR and WARN only, whatever the build passes on */
+#undef CLOGGING_MIN_LEVEL
+#define CLOGGING_MIN_LEVEL 1
+
+#include "../src/basic_logging.h"
+#include "../src/binary_logging.h"
+#include "../src/fd_logging.h"
+
+#include <ctype.h>  /* tolower() */
+#include <fcntl.h>  /* open() */
+#include <stdio.h>
+#include <stdlib.h> /* malloc(), free() */
+#include <string.h> /* memcmp() */
+#include <unistd.h> /* read(), close() */
+
+#define MAX_EXE_BYTES (16 * 1024 * 1024)
+
+static int g_evaluations = 0;
+
+static __attribute__((noinline)) int expensive_dump(int i) {
+  ++g_evaluations;
+  return i;
+}
+
+/* Whether the executable holds text, given in upper case so that the
+ * needle itself is not what is found.
+ */
+static int exe_contains(const char *exe, size_t len, const char *upper) {
+  char needle[64];
+  size_t n = strlen(upper);
+  size_t i = 0;
+
+  for (i = 0; i < n; ++i) {
+    needle[i] = (char)tolower((unsigned char)upper[i]);
+  }
+  for (i = 0; i + n <= len; ++i) {
+    if (exe[i] == needle[0] && memcmp(exe + i, needle, n) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Messages of INFO and DEBUG are gone even with the level at DEBUG */
+static int test_evaluation(void) {
+  enum LogLevel level = LOG_LEVEL_DEBUG;
+  int failed = 0;
+
+  BASIC_LOG_DEBUG("stripped-basic-debug %d", expensive_dump(1));
+  BASIC_LOG_INFO("stripped-basic-info %d", expensive_dump(2));
+  FD_LOG_DEBUG("stripped-fd-debug %d", expensive_dump(3));
+  FD_LOG_INFO("stripped-fd-info %d", expensive_dump(4));
+  BINARY_LOG_DEBUG("stripped-binary-debug %d", expensive_dump(5));
+  BINARY_LOG_INFO("stripped-binary-info %d", expensive_dump(6));
+  CLOGGING_BASIC_LOG(level, "runtime level %d", expensive_dump(7));
+  CLOGGING_FD_LOG(LOG_LEVEL_INFO, "constant level %d", expensive_dump(8));
+  if (g_evaluations != 0) {
+    fprintf(stderr, "%d arguments of compiled out messages evaluated\n",
+            g_evaluations);
+    failed = 1;
+  }
+
+  BASIC_LOG_WARN("kept-basic-warn %d", expensive_dump(9));
+  FD_LOG_ERROR("kept-fd-error %d", expensive_dump(10));
+  BINARY_LOG_WARN("kept-binary-warn %d", expensive_dump(11));
+  if (g_evaluations != 3) {
+    fprintf(stderr, "%d arguments of kept messages evaluated\n",
+            g_evaluations);
+    failed = 1;
+  }
+  return failed;
+}
+
+/* The format strings of compiled out messages are not in the executable */
+static int test_strings(void) {
+  const char *stripped[] = {"STRIPPED-BASIC-DEBUG", "STRIPPED-BASIC-INFO",
+                            "STRIPPED-FD-DEBUG",    "STRIPPED-FD-INFO",
+                            "STRIPPED-BINARY-DEBUG", "STRIPPED-BINARY-INFO"};
+  const char *kept[] = {"KEPT-BASIC-WARN", "KEPT-FD-ERROR",
+                        "KEPT-BINARY-WARN"};
+  char *exe = (char *)malloc(MAX_EXE_BYTES);
+  int fd = open("/proc/self/exe", O_RDONLY);
+  size_t len = 0;
+  size_t i = 0;
+  ssize_t n = 0;
+  int failed = 0;
+
+  if (fd < 0 || exe == NULL) {
+    /* nothing to look at */
+    free(exe);
+    return 0;
+  }
+  while (len < MAX_EXE_BYTES &&
+         (n = read(fd, exe + len, MAX_EXE_BYTES - len)) > 0) {
+    len += (size_t)n;
+  }
+  close(fd);
+  for (i = 0; i < sizeof(stripped) / sizeof(stripped[0]); ++i) {
+    if (exe_contains(exe, len, stripped[i])) {
+      fprintf(stderr, "%s is in the executable\n", stripped[i]);
+      failed = 1;
+    }
+  }
+  for (i = 0; i < sizeof(kept) / sizeof(kept[0]); ++i) {
+    if (!exe_contains(exe, len, kept[i])) {
+      fprintf(stderr, "%s is not in the executable\n", kept[i]);
+      failed = 1;
+    }
+  }
+  free(exe);
+  return failed;
+}
+
+int main(int argc, char *argv[]) {
+  int fd = open("/dev/null", O_WRONLY);
+  int failed = 0;
+
+  (void)argc;
+  (void)argv;
+  if (fd < 0) {
+    perror("open");
+    return 1;
+  }
+  clogging_basic_init("test_min_level", "-main", LOG_LEVEL_DEBUG, NULL);
+  clogging_fd_init("test_min_level", "-main", LOG_LEVEL_DEBUG,
+                   clogging_create_handle_from_fd(fd), NULL);
+  clogging_binary_init("test_min_level", "-main", LOG_LEVEL_DEBUG,
+                       clogging_create_handle_from_fd(fd), NULL);
+  failed |= test_evaluation();
+  failed |= test_strings();
+  close(fd);
+  return failed;
+}
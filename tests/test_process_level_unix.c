@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef _WIN32
+#error This file is for non-Windows platforms only
+#endif /* _WIN32 */
+
+#include "../src/basic_logging.h"
+#include "../src/binary_logging.h"
+#include "../src/fd_logging.h"
+
+#include <fcntl.h>   /* open() */
+#include <pthread.h> /* pthread_create() and friends */
+#include <stdio.h>
+#include <unistd.h>  /* close() */
+
+#define NUM_WORKERS 8
+#define NUM_SPIN_MESSAGES 20000
+
+struct worker {
+  int index;
+  int fd;
+  int evaluations;
+  int failed;
+};
+
+static pthread_barrier_t g_barrier;
+
+static int expensive_dump(struct worker *w) {
+  ++w->evaluations;
+  return w->index;
+}
+
+static void check_levels(struct worker *w, enum LogLevel expected,
+                         const char *when) {
+  if (clogging_basic_get_loglevel() != expected ||
+      clogging_fd_get_loglevel() != expected ||
+      clogging_binary_get_loglevel() != expected) {
+    fprintf(stderr, "worker %d: levels %d %d %d %s, expected %d\n", w->index,
+            clogging_basic_get_loglevel(), clogging_fd_get_loglevel(),
+            clogging_binary_get_loglevel(), when, expected);
+    w->failed = 1;
+  }
+}
+
+static void *work(void *data) {
+  struct worker *w = (struct worker *)data;
+  int i = 0;
+
+  clogging_basic_init("test_process_level", "-worker", LOG_LEVEL_DEBUG, NULL);
+  clogging_fd_init("test_process_level", "-worker", LOG_LEVEL_DEBUG,
+                   clogging_create_handle_from_fd(w->fd), NULL);
+  clogging_binary_init("test_process_level", "-worker", LOG_LEVEL_DEBUG,
+                       clogging_create_handle_from_fd(w->fd), NULL);
+  check_levels(w, LOG_LEVEL_DEBUG, "after init");
+
+  /* log while the level of the process changes under our feet */
+  pthread_barrier_wait(&g_barrier);
+  for (i = 0; i < NUM_SPIN_MESSAGES; ++i) {
+    FD_LOG_DEBUG("spin %d", i);
+    BINARY_LOG_DEBUG("spin %d", i);
+  }
+
+  /* the level of the process overrides the one set by init */
+  pthread_barrier_wait(&g_barrier);
+  check_levels(w, LOG_LEVEL_WARN, "after the process level");
+  w->evaluations = 0;
+  BASIC_LOG_INFO("dump %d", expensive_dump(w));
+  FD_LOG_DEBUG("dump %d", expensive_dump(w));
+  BINARY_LOG_INFO("dump %d", expensive_dump(w));
+  if (w->evaluations != 0) {
+    fprintf(stderr, "worker %d: disabled messages evaluated\n", w->index);
+    w->failed = 1;
+  }
+
+  /* one worker takes its own level again, the others keep the process'
+   * one
+   */
+  if (w->index == 0) {
+    clogging_fd_set_loglevel(LOG_LEVEL_DEBUG);
+  }
+  pthread_barrier_wait(&g_barrier);
+  FD_LOG_DEBUG("dump %d", expensive_dump(w));
+  if (w->evaluations != (w->index == 0 ? 1 : 0) ||
+      clogging_fd_get_loglevel() !=
+          (w->index == 0 ? LOG_LEVEL_DEBUG : LOG_LEVEL_WARN)) {
+    fprintf(stderr, "worker %d: override of the thread is off\n", w->index);
+    w->failed = 1;
+  }
+
+  /* until the level of the process is set again */
+  pthread_barrier_wait(&g_barrier);
+  pthread_barrier_wait(&g_barrier);
+  check_levels(w, LOG_LEVEL_ERROR, "after the process level again");
+  return NULL;
+}
+
+/* A thread which never sets a level has the one of the process */
+static void *idle(void *data) {
+  struct worker *w = (struct worker *)data;
+
+  check_levels(w, LOG_LEVEL_ERROR, "without a level of its own");
+  return NULL;
+}
+
+static void set_process_loglevel(enum LogLevel level) {
+  clogging_basic_set_process_loglevel(level);
+  clogging_fd_set_process_loglevel(level);
+  clogging_binary_set_process_loglevel(level);
+}
+
+int main(int argc, char *argv[]) {
+  pthread_t tids[NUM_WORKERS];
+  struct worker workers[NUM_WORKERS];
+  struct worker other = {NUM_WORKERS, -1, 0, 0};
+  int fd = open("/dev/null", O_WRONLY);
+  int failed = 0;
+  int i = 0;
+
+  (void)argc;
+  (void)argv;
+  if (fd < 0) {
+    perror("open");
+    return 1;
+  }
+  if (clogging_fd_get_process_loglevel() != DEFAULT_LOG_LEVEL) {
+    fprintf(stderr, "process level is not the default\n");
+    failed = 1;
+  }
+  pthread_barrier_init(&g_barrier, NULL, NUM_WORKERS + 1);
+  for (i = 0; i < NUM_WORKERS; ++i) {
+    workers[i].index = i;
+    workers[i].fd = fd;
+    workers[i].evaluations = 0;
+    workers[i].failed = 0;
+    pthread_create(&tids[i], NULL, work, &workers[i]);
+  }
+
+  pthread_barrier_wait(&g_barrier);
+  for (i = 0; i < 100; ++i) {
+    set_process_loglevel(i % 2 ? LOG_LEVEL_DEBUG : LOG_LEVEL_INFO);
+  }
+  set_process_loglevel(LOG_LEVEL_WARN);
+  pthread_barrier_wait(&g_barrier);
+  pthread_barrier_wait(&g_barrier);
+  pthread_barrier_wait(&g_barrier);
+  set_process_loglevel(LOG_LEVEL_ERROR);
+  pthread_barrier_wait(&g_barrier);
+
+  for (i = 0; i < NUM_WORKERS; ++i) {
+    pthread_join(tids[i], NULL);
+    failed |= workers[i].failed;
+  }
+  pthread_create(&tids[0], NULL, idle, &other);
+  pthread_join(tids[0], NULL);
+  failed |= other.failed;
+  if (clogging_fd_get_process_loglevel() != LOG_LEVEL_ERROR ||
+      clogging_fd_get_loglevel() != LOG_LEVEL_ERROR) {
+    fprintf(stderr, "process level is not ERROR\n");
+    failed = 1;
+  }
+  pthread_barrier_destroy(&g_barrier);
+  close(fd);
+  return failed;
+}
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2026 Neeraj Sharma <neerajsharma.9@outlook.com>
+ *
+ *  This file is part of clogging.
+ *
+ *  See LICENSE file for licensing information.
+ */
+
+#ifdef _WIN32
+#error This file is for non-Windows platforms only
+#endif /* _WIN32 */
+
+#include "../src/binary_logging.h"
+#include "../src/fd_logging.h"
+#include "../src/log_ratelimit.h"
+
+#include <fcntl.h>   /* open() */
+#include <pthread.h> /* pthread_create() and friends */
+#include <stdio.h>
+#include <stdlib.h>  /* mkstemp() */
+#include <string.h>  /* strstr() */
+#include <time.h>    /* nanosleep() */
+#include <unistd.h>  /* pread(), close(), unlink() */
+
+#define NUM_WORKERS 4
+#define NUM_STORM_MESSAGES 10000
+#define MS 1000000ULL
+
+static int g_failed = 0;
+static int g_evaluations = 0;
+
+static int count(int i) {
+  ++g_evaluations;
+  return i;
+}
+
+static void check(const char *what, int ok) {
+  if (!ok) {
+    fprintf(stderr, "%s\n", what);
+    g_failed = 1;
+  }
+}
+
+static void sleep_ms(long ms) {
+  struct timespec ts = {0, ms * 1000000L};
+
+  nanosleep(&ts, NULL);
+}
+
+/* The bucket on a clock of our own */
+static void test_bucket(void) {
+  clogging_ratelimit_t rl = {0, 0};
+  uint64_t now = 1000 * MS;
+  uint32_t suppressed = 0;
+  int allowed = 0;
+  int i = 0;
+
+  /* a burst of 3 and one more every 100ms */
+  for (i = 0; i < 10; ++i) {
+    allowed += clogging_ratelimit_allow_at(&rl, 3, 10, now, &suppressed);
+  }
+  check("burst not taken at once", allowed == 3 && suppressed == 0);
+
+  allowed = clogging_ratelimit_allow_at(&rl, 3, 10, now + 50 * MS,
+                                        &suppressed);
+  check("token before its refill", allowed == 0);
+  allowed = clogging_ratelimit_allow_at(&rl, 3, 10, now + 100 * MS,
+                                        &suppressed);
+  check("refilled token", allowed == 1 && suppressed == 8);
+  allowed = clogging_ratelimit_allow_at(&rl, 3, 10, now + 100 * MS,
+                                        &suppressed);
+  check("refilled token taken twice", allowed == 0);
+
+  /* however long idle, the bucket holds no more than the burst */
+  allowed = 0;
+  for (i = 0; i < 10; ++i) {
+    allowed += clogging_ratelimit_allow_at(&rl, 3, 10, now + 60000 * MS,
+                                           &suppressed);
+    if (i == 0) {
+      check("suppressed after idle", suppressed == 1);
+    }
+  }
+  check("bucket over the burst", allowed == 3);
+
+  /* without a rate, only the burst is ever taken */
+  rl.full_ns = 0;
+  rl.suppressed = 0;
+  allowed = 0;
+  for (i = 0; i < 10; ++i) {
+    allowed += clogging_ratelimit_allow_at(&rl, 3, 0, now + i * 60000 * MS,
+                                           &suppressed);
+  }
+  check("bucket without a rate refilled", allowed == 3);
+}
+
+struct worker {
+  clogging_ratelimit_t *rl;
+  int allowed;
+  uint32_t suppressed;
+};
+
+static void *storm(void *data) {
+  struct worker *w = (struct worker *)data;
+  uint32_t suppressed = 0;
+  int i = 0;
+
+  for (i = 0; i < NUM_STORM_MESSAGES; ++i) {
+    if (clogging_ratelimit_allow(w->rl, 100, 1, &suppressed)) {
+      ++w->allowed;
+      w->suppressed += suppressed;
+    }
+  }
+  return NULL;
+}
+
+/* Every message is either allowed or counted as suppressed once */
+static void test_threads(void) {
+  pthread_t tids[NUM_WORKERS];
+  struct worker workers[NUM_WORKERS];
+  clogging_ratelimit_t rl = {0, 0};
+  int allowed = 0;
+  uint32_t suppressed = 0;
+  int i = 0;
+
+  for (i = 0; i < NUM_WORKERS; ++i) {
+    workers[i].rl = &rl;
+    workers[i].allowed = 0;
+    workers[i].suppressed = 0;
+    pthread_create(&tids[i], NULL, storm, &workers[i]);
+  }
+  for (i = 0; i < NUM_WORKERS; ++i) {
+    pthread_join(tids[i], NULL);
+    allowed += workers[i].allowed;
+    suppressed += workers[i].suppressed;
+  }
+  suppressed += rl.suppressed;
+  if (allowed < 100 || allowed > 110 ||
+      allowed + (int)suppressed != NUM_WORKERS * NUM_STORM_MESSAGES) {
+    fprintf(stderr, "threads: %d allowed, %u suppressed\n", allowed,
+            suppressed);
+    g_failed = 1;
+  }
+}
+
+static void fd_storm(int i) {
+  FD_LOG_WARN_RATELIMITED(2, 50, "storm %d", count(i));
+}
+
+static void binary_storm(int i) {
+  BINARY_LOG_WARN_RATELIMITED(2, 50, "storm %d", count(i));
+}
+
+/* The most arguments a binary call site may have, the count of the
+ * suppressed messages being one more
+ */
+static void binary_storm_max_args(int i) {
+  BINARY_LOG_WARN_RATELIMITED(1, 50,
+                              "%d %d %d %d %d %d %d %d %d %d %d %d %d %d %d",
+                              i, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                              15);
+}
+
+/* The macros on top of it, with the count of suppressed messages */
+static void test_macros(void) {
+  char path[] = "/tmp/test_ratelimit_XXXXXX";
+  char buf[4096];
+  ssize_t n = 0;
+  int fd = mkstemp(path);
+  int null_fd = open("/dev/null", O_WRONLY);
+  uint64_t drops = 0;
+  int i = 0;
+
+  if (fd < 0 || null_fd < 0) {
+    perror("open");
+    g_failed = 1;
+    return;
+  }
+  unlink(path);
+  clogging_fd_init("test_ratelimit", "", LOG_LEVEL_INFO,
+                   clogging_create_handle_from_fd(fd), NULL);
+  clogging_binary_init("test_ratelimit", "", LOG_LEVEL_INFO,
+                       clogging_create_handle_from_fd(null_fd), NULL);
+
+  for (i = 0; i < 10; ++i) {
+    fd_storm(i);
+  }
+  check("fd arguments of suppressed messages evaluated",
+        g_evaluations == 2);
+  sleep_ms(60);
+  fd_storm(10);
+  check("fd message after the refill not logged", g_evaluations == 3);
+
+  g_evaluations = 0;
+  for (i = 0; i < 10; ++i) {
+    binary_storm(i);
+  }
+  check("binary arguments of suppressed messages evaluated",
+        g_evaluations == 2);
+  sleep_ms(60);
+  binary_storm(10);
+  check("binary message after the refill not logged", g_evaluations == 3);
+
+  drops = clogging_binary_get_num_dropped_messages();
+  for (i = 0; i < 10; ++i) {
+    binary_storm_max_args(i);
+  }
+  sleep_ms(60);
+  binary_storm_max_args(10);
+  check("binary message with the most arguments dropped",
+        clogging_binary_get_num_dropped_messages() == drops);
+
+  n = pread(fd, buf, sizeof(buf) - 1, 0);
+  buf[n > 0 ? n : 0] = '\0';
+  check("storm 0 missing", strstr(buf, "storm 0") != NULL);
+  check("storm 2 logged", strstr(buf, "storm 2") == NULL);
+  check("suppressed count missing",
+        strstr(buf, "storm 10 [8 suppressed]") != NULL);
+  close(fd);
+  close(null_fd);
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+  test_bucket();
+  test_threads();
+  /* unless WARN is compiled out */
+  if (LOG_LEVEL_WARN <= CLOGGING_MIN_LEVEL) {
+    test_macros();
+  }
+  return g_failed;
+}